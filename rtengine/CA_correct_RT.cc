@@ -124,7 +124,7 @@ float* RawImageSource::CA_correct_RT(
     double cablue,
     bool avoidColourshift,
     const array2D<float> &rawData,
-    double* fitParamsTransfer,
+    std::vector<double>* fitParamsTransfer,
     bool fitParamsIn,
     bool fitParamsOut,
     float* buffer,
@@ -210,22 +210,18 @@ float* RawImageSource::CA_correct_RT(
     bool processpasstwo = true;
     double fitparams[2][2][16];
 
+    // the transfer holds the order of the fit and the fit parameters of each iteration which corrected the image
+    constexpr size_t fitParamsSize = 1 + 2 * 2 * 16;
+    const bool fitParamsSet = autoCA && fitParamsTransfer && fitParamsIn && fitParamsTransfer->size() >= fitParamsSize;
+
     const size_t iterations =
         autoCA
-            ? std::max<size_t>(autoIterations, 1)
+            ? (fitParamsSet ? fitParamsTransfer->size() / fitParamsSize : std::max<size_t>(autoIterations, 1))
             : 1;
 
-    const bool fitParamsSet = fitParamsTransfer && fitParamsIn && iterations < 2;
-    if (autoCA && fitParamsSet) {
-        // use stored parameters
-        int index = 0;
-        for (int c = 0; c < 2; ++c) {
-            for (int d = 0; d < 2; ++d) {
-                for (int e = 0; e < 16; ++e) {
-                    fitparams[c][d][e] = fitParamsTransfer[index++];
-                }
-            }
-        }
+    const bool storeFitParams = autoCA && fitParamsTransfer && fitParamsOut && !fitParamsSet;
+    if (storeFitParams) {
+        fitParamsTransfer->clear();
     }
 
     for (size_t it = 0; it < iterations && processpasstwo; ++it) {
@@ -237,6 +233,14 @@ float* RawImageSource::CA_correct_RT(
         //order of 2d polynomial fit (polyord), and numpar=polyord^2
         int polyord = 4, numpar = 16;
 
+        if (fitParamsSet) {
+            // use stored parameters
+            const double* const params = fitParamsTransfer->data() + it * fitParamsSize;
+            polyord = params[0];
+            numpar = SQR(polyord);
+            std::copy(params + 1, params + fitParamsSize, &fitparams[0][0][0]);
+        }
+
         constexpr float eps = 1e-5f, eps2 = 1e-10f; //tolerance to avoid dividing by zero
 
 #ifdef _OPENMP
@@ -999,7 +1003,7 @@ float* RawImageSource::CA_correct_RT(
                         }
                         //end of border fill
 
-                        if (!autoCA || fitParamsIn) {
+                        if (!autoCA || fitParamsSet) {
 #ifdef __SSE2__
                             const vfloat onev = F2V(1.f);
                             const vfloat epsv = F2V(eps);
@@ -1271,6 +1275,12 @@ float* RawImageSource::CA_correct_RT(
             // clean up
             free(bufferThr);
         }
+
+        if (storeFitParams && processpasstwo) {
+            fitParamsTransfer->push_back(polyord);
+            fitParamsTransfer->insert(fitParamsTransfer->end(), &fitparams[0][0][0], &fitparams[0][0][0] + 2 * 2 * 16);
+        }
+
         if (avoidColourshift) {
             // to avoid or at least reduce the colour shift caused by raw ca correction we compute the per pixel difference factors
             // of red and blue channel and apply a gaussian blur to them.
@@ -1352,18 +1362,6 @@ float* RawImageSource::CA_correct_RT(
         }
     }
 
-    if (autoCA && fitParamsTransfer && fitParamsOut) {
-        // store calculated parameters
-        int index = 0;
-        for (int c = 0; c < 2; ++c) {
-            for (int d = 0; d < 2; ++d) {
-                for (int e = 0; e < 16; ++e) {
-                    fitParamsTransfer[index++] = fitparams[c][d][e];
-                }
-            }
-        }
-    }
-
     if (freeBuffer) {
         free(buffer);
         buffer = nullptr;
@@ -22,7 +22,9 @@
 //
 ////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include <fftw3.h>
 
@@ -31,6 +33,7 @@
 #include "cplx_wavelet_dec.h"
 #include "color.h"
 #include "curves.h"
+#include "fftwplancache.h"
 #include "iccmatrices.h"
 #include "iccstore.h"
 #include "imagefloat.h"
@@ -38,6 +41,7 @@
 #include "labimage.h"
 #include "LUT.h"
 #include "median.h"
+#include "memorylimit.h"
 #include "mytime.h"
 #include "opthelper.h"
 #include "procparams.h"
@@ -84,6 +88,122 @@ extern MyMutex *fftwMutex;
 namespace
 {
 
+#ifdef __SSE2__
+// Median filter of the (2 * radius + 1)^2 windows of pairs of rows, 4 columns at a time. The rows shared by the windows
+// of a pair are sorted per column into a buffer, then the medians of each pair are computed by medianPair.
+// Returns the first row which has not been filtered, at most one row is left when height - 2 * radius is odd.
+template <int radius, bool useUpperBound>
+int median_row_pairs(float **src, float **dst, float upperBound, int width, int height, int numThreads)
+{
+    constexpr int size = 2 * radius + 1;
+    const int pairs = std::max(0, (height - 2 * radius) / 2);
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(numThreads) if (numThreads>1)
+#endif
+    {
+        // the shared rows, sorted per column
+        std::vector<float> columnBuffer((size - 1) * width);
+        float *columns[size - 1];
+
+        for (int k = 0; k < size - 1; ++k) {
+            columns[k] = columnBuffer.data() + k * width;
+        }
+
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic,8)
+#endif
+
+        for (int pair = 0; pair < pairs; ++pair) {
+            const int i = radius + 2 * pair;
+            int j = 0;
+
+            for (; j < width - 3; j += 4) {
+                std::array<vfloat, size - 1> column;
+
+                for (int k = 0; k < size - 1; ++k) {
+                    column[k] = LVFU(src[i - radius + 1 + k][j]);
+                }
+
+                sortColumn(column);
+
+                for (int k = 0; k < size - 1; ++k) {
+                    STVFU(columns[k][j], column[k]);
+                }
+            }
+
+            for (; j < width; ++j) {
+                std::array<float, size - 1> column;
+
+                for (int k = 0; k < size - 1; ++k) {
+                    column[k] = src[i - radius + 1 + k][j];
+                }
+
+                std::sort(column.begin(), column.end());
+
+                for (int k = 0; k < size - 1; ++k) {
+                    columns[k][j] = column[k];
+                }
+            }
+
+            for (int row = i; row <= i + 1; ++row) {
+                for (j = 0; j < radius; ++j) {
+                    dst[row][j] = src[row][j];
+                }
+            }
+
+            for (; j < width - radius - 3; j += 4) {
+                std::array<vfloat, size * (size - 1) + 2 * size> window;
+
+                for (int c = 0; c < size; ++c) {
+                    for (int k = 0; k < size - 1; ++k) {
+                        window[(size - 1) * c + k] = LVFU(columns[k][j - radius + c]);
+                    }
+
+                    window[size * (size - 1) + c] = LVFU(src[i - radius][j - radius + c]);
+                    window[size * size + c] = LVFU(src[i + radius + 1][j - radius + c]);
+                }
+
+                const std::array<vfloat, 2> medians = medianPair(window);
+
+                for (int k = 0; k < 2; ++k) {
+                    if (useUpperBound) {
+                        const vfloat value = LVFU(src[i + k][j]);
+                        STVFU(dst[i + k][j], vself(vmaskf_gt(value, F2V(upperBound)), value, medians[k]));
+                    } else {
+                        STVFU(dst[i + k][j], medians[k]);
+                    }
+                }
+            }
+
+            for (int row = i; row <= i + 1; ++row) {
+                std::array<float, size * size> window;
+
+                for (int jj = j; jj < width - radius; ++jj) {
+                    if (!useUpperBound || src[row][jj] <= upperBound) {
+                        for (int kk = 0, ii = -radius; ii <= radius; ++ii) {
+                            for (int ll = -radius; ll <= radius; ++ll, ++kk) {
+                                window[kk] = src[row + ii][jj + ll];
+                            }
+                        }
+
+                        dst[row][jj] = median(window);
+                    } else {
+                        dst[row][jj] = src[row][jj];
+                    }
+                }
+
+                for (int jj = width - radius; jj < width; ++jj) {
+                    dst[row][jj] = src[row][jj];
+                }
+            }
+        }
+    }
+
+    return radius + 2 * pairs;
+}
+#endif
+
 template <bool useUpperBound>
 void do_median_denoise(float **src, float **dst, float upperBound, int width, int height, ImProcFunctions::Median medianType, int iterations, int numThreads, float **buffer)
 {
@@ -157,11 +277,22 @@ void do_median_denoise(float **src, float **dst, float upperBound, int width, in
             }
         }
 
+        int firstRow = border;
+
+#ifdef __SSE2__
+        // the large windows are filtered by pairs of rows, the remaining row if any is filtered below
+        if (medianType == Median::TYPE_7X7) {
+            firstRow = median_row_pairs<3, useUpperBound>(medianIn, medianOut, upperBound, width, height, numThreads);
+        } else if (medianType == Median::TYPE_9X9) {
+            firstRow = median_row_pairs<4, useUpperBound>(medianIn, medianOut, upperBound, width, height, numThreads);
+        }
+
+#endif
 #ifdef _OPENMP
         #pragma omp parallel for num_threads(numThreads) if (numThreads>1) schedule(dynamic,16)
 #endif
 
-        for (int i = border; i < height - border; ++i) {
+        for (int i = firstRow; i < height - border; ++i) {
             int j = 0;
 
             for (; j < border; ++j) {
@@ -477,6 +608,74 @@ void ImProcFunctions::Tile_calc(int tilesize, int overlap, int kall, int imwidth
     //  printf("Nw=%d NH=%d tileW=%d tileH=%d\n",numtiles_W,numtiles_H,tileWskip,tileHskip);
 }
 
+void ImProcFunctions::RGB_denoise_tiling(int imwidth, int imheight, bool denoiseLuminance, bool fixedTiles, int &tilesize, int &overlap, int &kall, int &numthreads)
+{
+#ifdef _OPENMP
+    int maxThreads = omp_get_max_threads();
+
+    if (options.rgbDenoiseThreadLimit > 0) {
+        maxThreads = MIN(maxThreads, options.rgbDenoiseThreadLimit);
+    }
+
+#else
+    constexpr int maxThreads = 1;
+#endif
+
+    const std::size_t budget = options.rgbDenoiseMemoryBudget > 0 ? static_cast<std::size_t>(options.rgbDenoiseMemoryBudget) << 20 : getMemoryLimit() / 2;
+
+    // Peak memory of the tiles when numthreads tiles are processed at the same time. Each tile holds its Lab copy, its noise
+    // variances, the L and a (or b) wavelet decompositions with the buffers of the shrinkage and, for the luminance, the
+    // L copy, the detail and weight arrays and the DCT blocks of the nested threads. Several tiles are added to an output image.
+    const auto footprint = [&](int tkall, int tsize, int toverlap, int tthreads) {
+        int numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip;
+        Tile_calc(tsize, toverlap, tkall, imwidth, imheight, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
+        const std::size_t pixels = static_cast<std::size_t>(tilewidth) * tileheight;
+        const std::size_t nestedThreads = MAX(1, maxThreads / tthreads);
+        const std::size_t numblox_W = ceil(static_cast<float>(tilewidth) / offset) + 2 * blkrad;
+        // the L details stored as half floats save 12 bytes per pixel
+        std::size_t tileBytes = pixels * (12 + 2 + (options.rgbDenoiseHalfFloatWavelets ? 52 : 64));
+
+        if (denoiseLuminance) {
+            tileBytes += pixels * 12 + nestedThreads * 2 * numblox_W * TS * TS * sizeof(float);
+        }
+
+        return tthreads * tileBytes + (numtiles_W * numtiles_H > 1 ? static_cast<std::size_t>(imwidth) * imheight * 12 : 0);
+    };
+
+    numthreads = 1;
+
+    if (!fixedTiles && options.rgbDenoiseThreadLimit == 0 && (budget == 0 || footprint(0, tilesize, overlap, 1) <= budget)) {
+        // the whole image in a single tile
+        kall = 0;
+        return;
+    }
+
+    kall = 2;
+
+    while (true) {
+        int numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip;
+        Tile_calc(tilesize, overlap, kall, imwidth, imheight, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
+
+        numthreads = MIN(numtiles_W * numtiles_H, maxThreads);
+
+        while (numthreads > 1 && budget > 0 && footprint(kall, tilesize, overlap, numthreads) > budget) {
+            --numthreads;
+        }
+
+        // the tiles of the automatic multizone chroma must not change, the others are reduced down to 256 pixels
+        if (budget == 0 || footprint(kall, tilesize, overlap, numthreads) <= budget || fixedTiles || tilesize <= 256) {
+            break;
+        }
+
+        tilesize = MAX(256, (tilesize * 3 / 4) & ~1);
+        overlap = tilesize / 8;
+    }
+
+    if (budget > 0 && footprint(kall, tilesize, overlap, numthreads) > budget && settings->verbose) {
+        printf("Denoise memory budget of %d MiB too low, using the smallest tiles\n", static_cast<int>(budget >> 20));
+    }
+}
+
 int denoiseNestedLevels = 1;
 enum nrquality {QUALITY_STANDARD, QUALITY_HIGH};
 
@@ -705,25 +904,19 @@ BENCHFUN
             overlap = 96;
         }
 
-        int numTries = 0;
-
         if (ponder) {
             printf("Tiled denoise processing caused by Automatic Multizone mode\n");
         }
 
         bool memoryAllocationFailed = false;
 
-        do {
-            ++numTries;
-
-            if (numTries == 2) {
-                printf("1st denoise pass failed due to insufficient memory, starting 2nd (tiled) pass now...\n");
-            }
+        {
+            int tilekall, numthreads;
+            RGB_denoise_tiling(imwidth, imheight, denoiseLuminance, ponder, tilesize, overlap, tilekall, numthreads);
 
             int numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip;
 
-            Tile_calc(tilesize, overlap, (options.rgbDenoiseThreadLimit == 0 && !ponder) ? (numTries == 1 ? 0 : 2) : 2, imwidth, imheight, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
-            memoryAllocationFailed = false;
+            Tile_calc(tilesize, overlap, tilekall, imwidth, imheight, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
             const int numtiles = numtiles_W * numtiles_H;
 
             //output buffer
@@ -757,7 +950,7 @@ BENCHFUN
             // calculate min size of numblox_W.
             int min_numblox_W = ceil((static_cast<float>((MIN(imwidth, ((numtiles_W - 1) * tileWskip) + tilewidth)) - ((numtiles_W - 1) * tileWskip))) / (offset)) + 2 * blkrad;
 
-            // these are needed only for creation of the plans and will be freed before entering the parallel loop
+            // the plans are owned by the plan cache, they are created once per size of the tiles
             fftwf_plan plan_forward_blox[2];
             fftwf_plan plan_backward_blox[2];
 
@@ -771,25 +964,15 @@ BENCHFUN
                 fftw_r2r_kind fwdkind[2] = {FFTW_REDFT10, FFTW_REDFT10};
                 fftw_r2r_kind bwdkind[2] = {FFTW_REDFT01, FFTW_REDFT01};
 
-                // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit
-                plan_forward_blox[0]  = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_backward_blox[0] = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_forward_blox[1]  = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_backward_blox[1] = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit, the measurements are kept in the wisdom
+                plan_forward_blox[0]  = getR2RPlan(2, nfwd, max_numblox_W, Lbloxtmp, fLbloxtmp, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_backward_blox[0] = getR2RPlan(2, nfwd, max_numblox_W, fLbloxtmp, Lbloxtmp, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_forward_blox[1]  = getR2RPlan(2, nfwd, min_numblox_W, Lbloxtmp, fLbloxtmp, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_backward_blox[1] = getR2RPlan(2, nfwd, min_numblox_W, fLbloxtmp, Lbloxtmp, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
                 fftwf_free(Lbloxtmp);
                 fftwf_free(fLbloxtmp);
             }
 
-#ifndef _OPENMP
-            int numthreads = 1;
-#else
-            // Calculate number of tiles. If less than omp_get_max_threads(), then limit num_threads to number of tiles
-            int numthreads = MIN(numtiles, omp_get_max_threads());
-
-            if (options.rgbDenoiseThreadLimit > 0) {
-                numthreads = MIN(numthreads, options.rgbDenoiseThreadLimit);
-            }
-
 #ifdef _OPENMP
             denoiseNestedLevels = omp_get_max_threads() / numthreads;
             bool oldNested = omp_get_nested();
@@ -805,8 +988,6 @@ BENCHFUN
                     denoiseNestedLevels--;
                 }
 
-#endif
-
             if (settings->verbose) {
                 printf("RGB_denoise uses %d main thread(s) and up to %d nested thread(s) for each main thread\n", numthreads, denoiseNestedLevels);
             }
@@ -956,13 +1137,8 @@ BENCHFUN
                                         labdn->b[i1][j1] = B_ < 65535.f ? gamcurve[B_] : Color::gammanf(B_ / 65535.f, gam) * 32768.f;
 
                                         if (((i1 | j1) & 1) == 0) {
-                                            if (numTries == 1) {
-                                                noisevarlum[(i1 >> 1) * width2 + (j1 >> 1)] = useNoiseLCurve ? lumcalc[i >> 1][j >> 1] : noisevarL;
-                                                noisevarchrom[(i1 >> 1) * width2 + (j1 >> 1)] = useNoiseCCurve ? maxNoiseVarab * ccalc[i >> 1][j >> 1] : 1.f;
-                                            } else {
-                                                noisevarlum[(i1 >> 1) * width2 + (j1 >> 1)] = lumcalc[i >> 1][j >> 1];
-                                                noisevarchrom[(i1 >> 1) * width2 + (j1 >> 1)] = ccalc[i >> 1][j >> 1];
-                                            }
+                                            noisevarlum[(i1 >> 1) * width2 + (j1 >> 1)] = useNoiseLCurve ? lumcalc[i >> 1][j >> 1] : noisevarL;
+                                            noisevarchrom[(i1 >> 1) * width2 + (j1 >> 1)] = useNoiseCCurve ? maxNoiseVarab * ccalc[i >> 1][j >> 1] : 1.f;
                                         }
 
                                         //end chroma
@@ -994,13 +1170,8 @@ BENCHFUN
                                         labdn->b[i1][j1] = (Y - Z);
 
                                         if (((i1 | j1) & 1) == 0) {
-                                            if (numTries == 1) {
-                                                noisevarlum[(i1 >> 1)*width2 + (j1 >> 1)] = useNoiseLCurve ? lumcalc[i >> 1][j >> 1] : noisevarL;
-                                                noisevarchrom[(i1 >> 1)*width2 + (j1 >> 1)] = useNoiseCCurve ? maxNoiseVarab * ccalc[i >> 1][j >> 1] : 1.f;
-                                            } else {
-                                                noisevarlum[(i1 >> 1)*width2 + (j1 >> 1)] = lumcalc[i >> 1][j >> 1];
-                                                noisevarchrom[(i1 >> 1)*width2 + (j1 >> 1)] = ccalc[i >> 1][j >> 1];
-                                            }
+                                            noisevarlum[(i1 >> 1)*width2 + (j1 >> 1)] = useNoiseLCurve ? lumcalc[i >> 1][j >> 1] : noisevarL;
+                                            noisevarchrom[(i1 >> 1)*width2 + (j1 >> 1)] = useNoiseCCurve ? maxNoiseVarab * ccalc[i >> 1][j >> 1] : 1.f;
                                         }
                                     }
                                 }
@@ -1185,6 +1356,11 @@ BENCHFUN
                                         }
                                     }
                                 }
+
+                                // the L details are only read by the chroma shrinkage until the luminance is denoised
+                                if (options.rgbDenoiseHalfFloatWavelets) {
+                                    Ldecomp->compress_details();
+                                }
                             }
 
                             float chresid = 0.f;
@@ -1268,6 +1444,10 @@ BENCHFUN
 
                                 delete bdecomp;
 
+                                if (!memoryAllocationFailed && denoiseLuminance && !Ldecomp->expand_details()) {
+                                    memoryAllocationFailed = true;
+                                }
+
                                 if (!memoryAllocationFailed) {
                                     if (denoiseLuminance) {
                                         int edge = 0;
@@ -1761,18 +1941,10 @@ BENCHFUN
                     }
                 }
             }
-
-            if (denoiseLuminance) {
-                // destroy the plans
-                fftwf_destroy_plan(plan_forward_blox[0]);
-                fftwf_destroy_plan(plan_backward_blox[0]);
-                fftwf_destroy_plan(plan_forward_blox[1]);
-                fftwf_destroy_plan(plan_backward_blox[1]);
-            }
-        } while (memoryAllocationFailed && numTries < 2 && (options.rgbDenoiseThreadLimit == 0) && !ponder);
+        }
 
         if (memoryAllocationFailed) {
-            printf("tiled denoise failed due to isufficient memory. Output is not denoised!\n");
+            printf("denoise failed due to insufficient memory. Output is not denoised!\n");
         }
 
     }
@@ -2389,7 +2561,6 @@ bool ImProcFunctions::WaveletDenoiseAll_BiShrinkAB(const wavelet_decomposition &
                     int Wlvl_ab = WaveletCoeffs_ab.level_W(lvl);
                     int Hlvl_ab = WaveletCoeffs_ab.level_H(lvl);
 
-                    float ** WavCoeffs_L = WaveletCoeffs_L.level_coeffs(lvl);
                     float ** WavCoeffs_ab = WaveletCoeffs_ab.level_coeffs(lvl);
 
                     if (lvl == maxlvl - 1) {
@@ -2397,6 +2568,7 @@ bool ImProcFunctions::WaveletDenoiseAll_BiShrinkAB(const wavelet_decomposition &
                     } else {
                         //simple wavelet shrinkage
 
+                        const float * WavCoeffs_L = WaveletCoeffs_L.level_subband(lvl, dir, buffer[2] + 96);
                         float mad_Lr = madL[lvl][dir - 1];
                         float mad_abr = useNoiseCCurve ? noisevar_ab * madab[lvl][dir - 1] : SQR(noisevar_ab) * madab[lvl][dir - 1];
 
@@ -2415,7 +2587,7 @@ bool ImProcFunctions::WaveletDenoiseAll_BiShrinkAB(const wavelet_decomposition &
                                 mad_abv = LVFU(noisevarchrom[coeffloc_ab]) * mad_abrv;
 
                                 tempabv = LVFU(WavCoeffs_ab[dir][coeffloc_ab]);
-                                mag_Lv = LVFU(WavCoeffs_L[dir][coeffloc_ab]);
+                                mag_Lv = LVFU(WavCoeffs_L[coeffloc_ab]);
                                 mag_abv = SQRV(tempabv);
                                 mag_Lv = SQRV(mag_Lv) * rmad_Lm9v;
                                 STVFU(WavCoeffs_ab[dir][coeffloc_ab], tempabv * SQRV((onev - xexpf(-(mag_abv / mad_abv) - (mag_Lv)))));
@@ -2423,7 +2595,7 @@ bool ImProcFunctions::WaveletDenoiseAll_BiShrinkAB(const wavelet_decomposition &
 
                             // few remaining pixels
                             for (; coeffloc_ab < Hlvl_ab * Wlvl_ab; ++coeffloc_ab) {
-                                float mag_L = SQR(WavCoeffs_L[dir][coeffloc_ab ]);
+                                float mag_L = SQR(WavCoeffs_L[coeffloc_ab ]);
                                 float mag_ab = SQR(WavCoeffs_ab[dir][coeffloc_ab]);
                                 WavCoeffs_ab[dir][coeffloc_ab] *= SQR(1.f - xexpf(-(mag_ab / (noisevarchrom[coeffloc_ab] * mad_abr)) - (mag_L / (9.f * mad_Lr)))/*satfactor_a*/);
                             }//now chrominance coefficients are denoised
@@ -2434,7 +2606,7 @@ bool ImProcFunctions::WaveletDenoiseAll_BiShrinkAB(const wavelet_decomposition &
                                 for (int j = 0; j < Wlvl_ab; ++j) {
                                     int coeffloc_ab = i * Wlvl_ab + j;
 
-                                    float mag_L = SQR(WavCoeffs_L[dir][coeffloc_ab ]);
+                                    float mag_L = SQR(WavCoeffs_L[coeffloc_ab ]);
                                     float mag_ab = SQR(WavCoeffs_ab[dir][coeffloc_ab]);
 
                                     WavCoeffs_ab[dir][coeffloc_ab] *= SQR(1.f - xexpf(-(mag_ab / (noisevarchrom[coeffloc_ab] * mad_abr)) - (mag_L / (9.f * mad_Lr)))/*satfactor_a*/);
@@ -2655,7 +2827,8 @@ void ImProcFunctions::ShrinkAllAB(const wavelet_decomposition &WaveletCoeffs_L,
     int W_ab = WaveletCoeffs_ab.level_W(level);
     int H_ab = WaveletCoeffs_ab.level_H(level);
 
-    float ** WavCoeffs_L = WaveletCoeffs_L.level_coeffs(level);
+    // the L details may be stored as half floats, buffer[2] is not used by the shrinkage
+    const float * WavCoeffs_L = WaveletCoeffs_L.level_subband(level, dir, buffer[2] + 96);
     float ** WavCoeffs_ab = WaveletCoeffs_ab.level_coeffs(level);
 
     float madab;
@@ -2685,7 +2858,7 @@ void ImProcFunctions::ShrinkAllAB(const wavelet_decomposition &WaveletCoeffs_L,
         for (coeffloc_ab = 0; coeffloc_ab < H_ab * W_ab - 3; coeffloc_ab += 4) {
             mad_abv = LVFU(noisevarchrom[coeffloc_ab]) * mad_abrv;
 
-            mag_Lv = LVFU(WavCoeffs_L[dir][coeffloc_ab]);
+            mag_Lv = LVFU(WavCoeffs_L[coeffloc_ab]);
             mag_abv = SQRV(LVFU(WavCoeffs_ab[dir][coeffloc_ab]));
             mag_Lv = (SQRV(mag_Lv)) * rmadLm9v;
             STVFU(sfaveab[coeffloc_ab], (onev - xexpf(-(mag_abv / mad_abv) - (mag_Lv))));
@@ -2693,7 +2866,7 @@ void ImProcFunctions::ShrinkAllAB(const wavelet_decomposition &WaveletCoeffs_L,
 
         // few remaining pixels
         for (; coeffloc_ab < H_ab * W_ab; ++coeffloc_ab) {
-            float mag_L = SQR(WavCoeffs_L[dir][coeffloc_ab]);
+            float mag_L = SQR(WavCoeffs_L[coeffloc_ab]);
             float mag_ab = SQR(WavCoeffs_ab[dir][coeffloc_ab]);
             sfaveab[coeffloc_ab] = (1.f - xexpf(-(mag_ab / (noisevarchrom[coeffloc_ab] * madab)) - (mag_L / (9.f * mad_L))));
         }//now chrominance coefficients are denoised
@@ -2703,7 +2876,7 @@ void ImProcFunctions::ShrinkAllAB(const wavelet_decomposition &WaveletCoeffs_L,
         for (int i = 0; i < H_ab; ++i) {
             for (int j = 0; j < W_ab; ++j) {
                 int coeffloc_ab = i * W_ab + j;
-                float mag_L = SQR(WavCoeffs_L[dir][coeffloc_ab]);
+                float mag_L = SQR(WavCoeffs_L[coeffloc_ab]);
                 float mag_ab = SQR(WavCoeffs_ab[dir][coeffloc_ab]);
                 sfaveab[coeffloc_ab] = (1.f - xexpf(-(mag_ab / (noisevarchrom[coeffloc_ab] * madab)) - (mag_L / (9.f * mad_L))));
             }
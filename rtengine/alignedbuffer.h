@@ -22,6 +22,8 @@
 #include <cstdlib>
 #include <utility>
 
+#include "instrumentation.h"
+
 inline size_t padToAlignment(size_t size, size_t align = 16) {
     return align * ((size + align - 1) / align);
 }
@@ -55,6 +57,7 @@ public:
     {
         if (real) {
             free(real);
+            rtengine::instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(allocatedSize));
         }
     }
 
@@ -77,6 +80,7 @@ public:
                 // The user want to free the memory
                 if (real) {
                     free(real);
+                    rtengine::instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(allocatedSize));
                 }
 
                 real = nullptr;
@@ -114,7 +118,9 @@ public:
                 if (real) {
                     data = (T*)( ( uintptr_t(real) + uintptr_t(alignment - 1)) / alignment * alignment);
                     inUse = true;
+                    rtengine::instrumentation::bufferBytesChanged(static_cast<std::ptrdiff_t>(allocatedSize) - static_cast<std::ptrdiff_t>(oldAllocatedSize));
                 } else {
+                    rtengine::instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(oldAllocatedSize));
                     allocatedSize = 0;
                     unitSize = 0;
                     data = nullptr;
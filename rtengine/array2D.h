@@ -66,6 +66,7 @@
 #include <cstring>
 #include <cstdio>
 
+#include "instrumentation.h"
 #include "noncopyable.h"
 
 template<typename T>
@@ -78,7 +79,21 @@ private:
     unsigned int flags;
     T ** ptr;
     T * data;
+    std::size_t dataSize; // elements of the owned data, accounted in the instrumentation
     bool lock; // useful lock to ensure data is not changed anymore.
+    void allocData(std::size_t size)
+    {
+        data = new T[size];
+        dataSize = size;
+        rtengine::instrumentation::bufferBytesChanged(size * sizeof(T));
+    }
+    void freeData()
+    {
+        delete[] data;
+        data = nullptr;
+        rtengine::instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(dataSize * sizeof(T)));
+        dataSize = 0;
+    }
     void ar_realloc(int w, int h, int offset = 0)
     {
         if ((ptr) && ((h > y) || (4 * h < y))) {
@@ -87,8 +102,7 @@ private:
         }
 
         if ((data) && (((h * w) > (x * y)) || ((h * w) < ((x * y) / 4)))) {
-            delete[] data;
-            data = nullptr;
+            freeData();
         }
 
         if (ptr == nullptr) {
@@ -96,7 +110,7 @@ private:
         }
 
         if (data == nullptr) {
-            data = new T[h * w + offset];
+            allocData(h * w + offset);
         }
 
         x = w;
@@ -113,7 +127,7 @@ public:
     // use as empty declaration, resize before use!
     // very useful as a member object
     array2D() :
-        x(0), y(0), owner(0), flags(0), ptr(nullptr), data(nullptr), lock(false)
+        x(0), y(0), owner(0), flags(0), ptr(nullptr), data(nullptr), dataSize(0), lock(false)
     {
         //printf("got empty array2D init\n");
     }
@@ -123,7 +137,7 @@ public:
     {
         flags = flgs;
         lock = flags & ARRAY2D_LOCK_DATA;
-        data = new T[h * w];
+        allocData(h * w);
         owner = 1;
         x = w;
         y = h;
@@ -149,9 +163,10 @@ public:
         owner = (flags & ARRAY2D_BYREFERENCE) ? 0 : 1;
 
         if (owner) {
-            data = new T[h * w];
+            allocData(h * w);
         } else {
             data = nullptr;
+            dataSize = 0;
         }
 
         x = w;
@@ -180,7 +195,7 @@ public:
         }
 
         if ((owner) && (data)) {
-            delete[] data;
+            freeData();
         }
 
         if (ptr) {
@@ -201,8 +216,7 @@ public:
     void free()
     {
         if ((owner) && (data)) {
-            delete[] data;
-            data = nullptr;
+            freeData();
         }
 
         if (ptr) {
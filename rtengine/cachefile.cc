@@ -0,0 +1,105 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glibmm/checksum.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+
+#include "cachefile.h"
+#include "settings.h"
+
+namespace rtengine
+{
+
+void CacheFileHeader::init(const char (&fileMagic)[4], std::uint32_t fileVersion)
+{
+    memset(this, 0, sizeof(*this));
+    memcpy(magic, fileMagic, sizeof(magic));
+    version = fileVersion;
+}
+
+bool CacheFileHeader::matches(const char (&fileMagic)[4], std::uint32_t fileVersion) const
+{
+    return !memcmp(magic, fileMagic, sizeof(magic)) && version == fileVersion;
+}
+
+Glib::ustring getCacheFileName(const char* folder, const std::string& baseName)
+{
+    if (settings->cacheDirectory.empty()) {
+        return {};
+    }
+
+    return Glib::build_filename(settings->cacheDirectory, folder, baseName);
+}
+
+Glib::ustring getSourceCacheFileName(const char* folder, const std::string& source, const std::string& tag, const char* extension, std::int64_t& sourceSize, std::int64_t& sourceTime)
+{
+    if (settings->cacheDirectory.empty()) {
+        return {};
+    }
+
+    GStatBuf stat;
+
+    if (g_stat(source.c_str(), &stat)) {
+        return {};
+    }
+
+    sourceSize = stat.st_size;
+    sourceTime = stat.st_mtime;
+
+    Glib::ustring identifier = Glib::ustring::compose("%1-%2-%3", source, sourceSize, sourceTime);
+
+    if (!tag.empty()) {
+        identifier += "-" + tag;
+    }
+
+    const std::string baseName = Glib::path_get_basename(source) + "." + Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_MD5, identifier) + "." + extension;
+    return getCacheFileName(folder, baseName);
+}
+
+bool writeCacheFileAs(const Glib::ustring& name, const std::function<bool (const Glib::ustring&)>& writer)
+{
+    g_mkdir_with_parents(Glib::path_get_dirname(name).c_str(), 0777);
+
+    const Glib::ustring tempName = Glib::ustring::compose("%1.%2.tmp", name, g_random_int());
+
+    if (!writer(tempName) || g_rename(tempName.c_str(), name.c_str())) {
+        g_remove(tempName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool writeCacheFile(const Glib::ustring& name, const std::function<bool (FILE*)>& writer)
+{
+    return writeCacheFileAs(name, [&writer](const Glib::ustring& tempName) {
+        FILE* const file = g_fopen(tempName.c_str(), "wb");
+
+        if (!file) {
+            return false;
+        }
+
+        const bool written = writer(file);
+        return !fclose(file) && written;
+    });
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include <glibmm/ustring.h>
+
+/* Files stored by the engine in the cache folder (raw analyses, restart indexes, calibration masters, FFTW wisdom).
+ *
+ * The binary files start with a CacheFileHeader. The files derived from a source file are named after the basename of the
+ * source and the md5 of its name, size and modification time, so a modified source gets new files. They are all written
+ * through a temporary file renamed at the end: a reader never sees a partial file, and among concurrent writers the last
+ * one wins. */
+
+namespace rtengine
+{
+
+struct CacheFileHeader {
+    char magic[4];
+    std::uint32_t version;
+
+    /** Zeroes the header, padding included, and sets the magic and the version */
+    void init (const char (&fileMagic)[4], std::uint32_t fileVersion);
+    bool matches (const char (&fileMagic)[4], std::uint32_t fileVersion) const;
+};
+
+/** Returns the name of a file of a sub-folder of the cache, or an empty string if the cache is disabled */
+Glib::ustring getCacheFileName (const char* folder, const std::string& baseName);
+
+/** Returns the name of the file of a sub-folder of the cache derived from a source file, or an empty string if the cache is
+  * disabled or the source can not be read
+  * @param source is the name of the source file
+  * @param tag distinguishes several files derived from the same source, may be empty
+  * @param extension is the extension of the file, without the dot
+  * @param sourceSize receives the size of the source
+  * @param sourceTime receives the modification time of the source */
+Glib::ustring getSourceCacheFileName (const char* folder, const std::string& source, const std::string& tag, const char* extension, std::int64_t& sourceSize, std::int64_t& sourceTime);
+
+/** Writes a file of the cache, creating its folder if needed
+  * @param writer writes the content to the temporary file it gets the name of, returns false on failure
+  * @return false if the file could not be written, the previous content is then left untouched */
+bool writeCacheFileAs (const Glib::ustring& name, const std::function<bool (const Glib::ustring&)>& writer);
+
+/** Same as writeCacheFileAs, the writer gets the temporary file opened for binary writing */
+bool writeCacheFile (const Glib::ustring& name, const std::function<bool (FILE*)>& writer);
+
+}
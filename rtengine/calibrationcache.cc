@@ -0,0 +1,389 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include <glib/gstdio.h>
+#include <glibmm/checksum.h>
+#include <glibmm/keyfile.h>
+
+#include "cachefile.h"
+#include "calibrationcache.h"
+#include "rawimage.h"
+#include "settings.h"
+
+namespace
+{
+
+constexpr char masterMagic[4] = {'R', 'T', 'C', 'M'};
+constexpr std::uint32_t masterVersion = 1;
+
+struct MasterHeader {
+    rtengine::CacheFileHeader file;
+    char identity[33];          // md5 of the kind and of the names, sizes and modification times of the frames
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t rowSize;
+    std::uint32_t frameCount;
+    std::uint32_t hotPixelCount;
+};
+
+Glib::ustring getMasterName(const std::string& identity)
+{
+    if (identity.empty()) {
+        return {};
+    }
+
+    return rtengine::getCacheFileName("calibration", identity + ".rtm");
+}
+
+unsigned int getRowSize(const rtengine::RawImage* ri)
+{
+    return ri->get_width() * (ri->isBayer() || ri->isXtrans() || ri->get_colors() == 1 ? 1 : 3);
+}
+
+// Loads the pixel data of a frame, the rows of data[] are contiguous
+rtengine::RawImage* loadFrame(const Glib::ustring& name)
+{
+    std::unique_ptr<rtengine::RawImage> ri(new rtengine::RawImage(name));
+
+    if (ri->loadRaw(true, 0, true, nullptr, 1.0, true) || !ri->compress_image(0)) {
+        return nullptr;
+    }
+
+    return ri.release();
+}
+
+// Loads the information of a frame other than the pixels, data[] is allocated but not filled
+rtengine::RawImage* loadFrameInfo(const Glib::ustring& name)
+{
+    std::unique_ptr<rtengine::RawImage> ri(new rtengine::RawImage(name));
+
+    if (ri->loadRaw(false) || !ri->allocate_data(0)) {
+        return nullptr;
+    }
+
+    return ri.release();
+}
+
+bool readMaster(const std::string& identity, rtengine::RawImage* ri, unsigned int frameCount, std::vector<rtengine::badPix>* hotPixels)
+{
+    const Glib::ustring masterName = getMasterName(identity);
+
+    if (masterName.empty()) {
+        return false;
+    }
+
+    FILE* const file = g_fopen(masterName.c_str(), "rb");
+
+    if (!file) {
+        return false;
+    }
+
+    MasterHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && header.file.matches(masterMagic, masterVersion)
+                 && !strncmp(header.identity, identity.c_str(), sizeof(header.identity))
+                 && header.width == static_cast<unsigned int>(ri->get_width())
+                 && header.height == static_cast<unsigned int>(ri->get_height())
+                 && header.rowSize == getRowSize(ri)
+                 && header.frameCount == frameCount;
+
+    if (valid) {
+        const std::size_t size = static_cast<std::size_t>(header.height) * header.rowSize;
+        valid = fread(ri->data[0], sizeof(float), size, file) == size;
+    }
+
+    if (valid && hotPixels) {
+        std::vector<std::uint16_t> positions(2 * header.hotPixelCount);
+        valid = fread(positions.data(), sizeof(std::uint16_t), positions.size(), file) == positions.size();
+
+        if (valid) {
+            hotPixels->clear();
+            hotPixels->reserve(header.hotPixelCount);
+
+            for (std::size_t i = 0; i < positions.size(); i += 2) {
+                hotPixels->emplace_back(positions[i], positions[i + 1]);
+            }
+        }
+    }
+
+    fclose(file);
+
+    if (rtengine::settings->verbose) {
+        printf(valid ? "Loaded the master %s\n" : "Ignoring the outdated master %s\n", masterName.c_str());
+    }
+
+    return valid;
+}
+
+}
+
+namespace rtengine
+{
+
+CalibrationIndex::CalibrationIndex(const std::string& name) :
+    name(name)
+{
+}
+
+void CalibrationIndex::load()
+{
+    entries.clear();
+
+    const Glib::ustring indexName = getCacheFileName("calibration", name + ".ini");
+
+    if (indexName.empty()) {
+        return;
+    }
+
+    try {
+        Glib::KeyFile keyFile;
+
+        if (!keyFile.load_from_file(indexName)) {
+            return;
+        }
+
+        for (const auto& group : keyFile.get_groups()) {
+            Entry entry;
+            entry.size = keyFile.get_int64(group, "Size");
+            entry.mtime = keyFile.get_int64(group, "MTime");
+            entry.used = false;
+
+            CalibrationFileInfo& info = entry.info;
+            info.isRaw = keyFile.get_boolean(group, "Raw");
+
+            if (info.isRaw) {
+                info.make = keyFile.get_string(group, "Make");
+                info.model = keyFile.get_string(group, "Model");
+                info.lens = keyFile.get_string(group, "Lens");
+                info.iso = keyFile.get_integer(group, "ISO");
+                info.shutter = keyFile.get_double(group, "Shutter");
+                info.aperture = keyFile.get_double(group, "Aperture");
+                info.focalLength = keyFile.get_double(group, "FocalLength");
+                info.timestamp = keyFile.get_int64(group, "Timestamp");
+                info.rawTimestamp = keyFile.get_int64(group, "RawTimestamp");
+            }
+
+            entries[keyFile.get_string(group, "Path")] = entry;
+        }
+    } catch (Glib::Error&) {
+        // an unreadable index is rebuilt by the next scan of the folder
+        entries.clear();
+    }
+}
+
+bool CalibrationIndex::lookup(const Glib::ustring& filename, std::int64_t size, std::int64_t mtime, CalibrationFileInfo& info)
+{
+    const auto entry = entries.find(filename);
+
+    if (entry == entries.end() || entry->second.size != size || entry->second.mtime != mtime) {
+        return false;
+    }
+
+    entry->second.used = true;
+    info = entry->second.info;
+    return true;
+}
+
+void CalibrationIndex::store(const Glib::ustring& filename, std::int64_t size, std::int64_t mtime, const CalibrationFileInfo& info)
+{
+    entries[filename] = {size, mtime, info, true};
+}
+
+void CalibrationIndex::save()
+{
+    const Glib::ustring indexName = getCacheFileName("calibration", name + ".ini");
+
+    if (indexName.empty()) {
+        return;
+    }
+
+    Glib::KeyFile keyFile;
+    unsigned int count = 0;
+
+    for (const auto& entry : entries) {
+        if (!entry.second.used) {
+            continue;
+        }
+
+        const Glib::ustring group = Glib::ustring::compose("File %1", count++);
+        const CalibrationFileInfo& info = entry.second.info;
+        keyFile.set_string(group, "Path", entry.first);
+        keyFile.set_int64(group, "Size", entry.second.size);
+        keyFile.set_int64(group, "MTime", entry.second.mtime);
+        keyFile.set_boolean(group, "Raw", info.isRaw);
+
+        if (info.isRaw) {
+            keyFile.set_string(group, "Make", info.make);
+            keyFile.set_string(group, "Model", info.model);
+            keyFile.set_string(group, "Lens", info.lens);
+            keyFile.set_integer(group, "ISO", info.iso);
+            keyFile.set_double(group, "Shutter", info.shutter);
+            keyFile.set_double(group, "Aperture", info.aperture);
+            keyFile.set_double(group, "FocalLength", info.focalLength);
+            keyFile.set_int64(group, "Timestamp", info.timestamp);
+            keyFile.set_int64(group, "RawTimestamp", info.rawTimestamp);
+        }
+    }
+
+    const std::string data = keyFile.to_data();
+    writeCacheFile(indexName, [&data](FILE* file) {
+        return fwrite(data.c_str(), 1, data.size(), file) == data.size();
+    });
+}
+
+std::string getCalibrationIdentity(const char* kind, const std::list<Glib::ustring>& names)
+{
+    Glib::ustring identifier(kind);
+
+    for (const auto& name : names) {
+        GStatBuf stat;
+
+        if (g_stat(name.c_str(), &stat)) {
+            return {};
+        }
+
+        identifier += Glib::ustring::compose("|%1-%2-%3", name, static_cast<std::int64_t>(stat.st_size), static_cast<std::int64_t>(stat.st_mtime));
+    }
+
+    return Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_MD5, identifier);
+}
+
+RawImage* loadCalibrationTemplate(const char* kind, const std::list<Glib::ustring>& names, std::vector<badPix>* hotPixels, bool& fromMaster)
+{
+    fromMaster = false;
+
+    // the first loadable file provides the information other than the pixels (width, height, filters etc.), its pixels
+    // are only decoded if there is no master
+    if (names.size() > 1) {
+        std::unique_ptr<RawImage> info;
+
+        for (auto name = names.begin(); name != names.end() && !info; ++name) {
+            info.reset(loadFrameInfo(*name));
+        }
+
+        if (info && readMaster(getCalibrationIdentity(kind, names), info.get(), names.size(), hotPixels)) {
+            fromMaster = true;
+            return info.release();
+        }
+    }
+
+    auto name = names.begin();
+    RawImage* ri = nullptr;
+
+    for (; name != names.end() && !ri; ++name) {
+        ri = loadFrame(*name);
+    }
+
+    if (!ri || name == names.end()) {
+        return ri;
+    }
+
+    // the frames are added to the first one as they are decoded, only one more frame is held in memory
+    const int height = ri->get_height();
+    const unsigned int rowSize = getRowSize(ri);
+    int nFiles = 1;
+
+    for (; name != names.end(); ++name) {
+        const std::unique_ptr<RawImage> frame(loadFrame(*name));
+
+        if (!frame || frame->get_height() != height || getRowSize(frame.get()) != rowSize) {
+            if (settings->verbose) {
+                printf("Ignoring %s, it can not be loaded or does not match the size of %s\n", name->c_str(), ri->get_filename().c_str());
+            }
+
+            continue;
+        }
+
+#ifdef _OPENMP
+        #pragma omp parallel for
+#endif
+
+        for (int row = 0; row < height; ++row) {
+            float* const dst = ri->data[row];
+            const float* const src = frame->data[row];
+
+            for (unsigned int col = 0; col < rowSize; ++col) {
+                dst[col] += src[col];
+            }
+        }
+
+        ++nFiles;
+    }
+
+    const float scale = 1.f / nFiles;
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+
+    for (int row = 0; row < height; ++row) {
+        float* const dst = ri->data[row];
+
+        for (unsigned int col = 0; col < rowSize; ++col) {
+            dst[col] *= scale;
+        }
+    }
+
+    return ri;
+}
+
+void saveCalibrationMaster(const char* kind, const std::list<Glib::ustring>& names, const RawImage* ri, const std::vector<rtengine::badPix>* hotPixels)
+{
+    if (!ri || names.size() < 2) {
+        return;
+    }
+
+    const std::string identity = getCalibrationIdentity(kind, names);
+    const Glib::ustring masterName = getMasterName(identity);
+
+    if (masterName.empty()) {
+        return;
+    }
+
+    MasterHeader header;
+    memset(&header, 0, sizeof(header));
+    header.file.init(masterMagic, masterVersion);
+    strncpy(header.identity, identity.c_str(), sizeof(header.identity) - 1);
+    header.width = ri->get_width();
+    header.height = ri->get_height();
+    header.rowSize = getRowSize(ri);
+    header.frameCount = names.size();
+
+    std::vector<std::uint16_t> positions;
+
+    if (hotPixels) {
+        header.hotPixelCount = hotPixels->size();
+        positions.reserve(2 * hotPixels->size());
+
+        for (const auto& pixel : *hotPixels) {
+            positions.push_back(pixel.x);
+            positions.push_back(pixel.y);
+        }
+    }
+
+    writeCacheFile(masterName, [&](FILE* file) {
+        const std::size_t size = static_cast<std::size_t>(header.height) * header.rowSize;
+        return fwrite(&header, sizeof(header), 1, file) == 1
+               && fwrite(ri->data[0], sizeof(float), size, file) == size
+               && fwrite(positions.data(), sizeof(std::uint16_t), positions.size(), file) == positions.size();
+    });
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glibmm/ustring.h>
+
+#include "pixelsmap.h"
+
+/* Cache of the dark frame and flat field folders, in the "calibration" folder of the cache.
+ *
+ * The index keeps the shooting information of each file of a folder, identified by its size and modification time, so the
+ * managers only open the new or changed files when they scan the folder. The average of a template (several frames of the
+ * same shot) is stored as a master file, with the hot pixels extracted from it, and reused as long as none of its frames
+ * changed. */
+
+namespace rtengine
+{
+
+class RawImage;
+
+struct CalibrationFileInfo {
+    bool isRaw = false;
+    std::string make;
+    std::string model;
+    std::string lens;
+    int iso = 0;
+    double shutter = 0.0;
+    double aperture = 0.0;
+    double focalLength = 0.0;
+    std::int64_t timestamp = 0;     // from the exif data
+    std::int64_t rawTimestamp = 0;  // from the raw decoder
+};
+
+class CalibrationIndex final
+{
+public:
+    explicit CalibrationIndex (const std::string &name);
+
+    /** Reads the index, the entries which are not looked up or stored until the next save() are dropped */
+    void load();
+
+    /** @return true if filename is in the index with the same size and modification time, info then receives its entry */
+    bool lookup (const Glib::ustring &filename, std::int64_t size, std::int64_t mtime, CalibrationFileInfo &info);
+    void store (const Glib::ustring &filename, std::int64_t size, std::int64_t mtime, const CalibrationFileInfo &info);
+    void save();
+
+private:
+    struct Entry {
+        std::int64_t size;
+        std::int64_t mtime;
+        CalibrationFileInfo info;
+        bool used;
+    };
+
+    const std::string name;
+    std::map<Glib::ustring, Entry> entries;
+};
+
+/** Identifies the current version of a dark frame or flat field: md5 of the kind and of the names, sizes and modification
+  * times of the frames of the template, or of the single file
+  * @return an empty string if one of the frames can not be read */
+std::string getCalibrationIdentity (const char *kind, const std::list<Glib::ustring> &names);
+
+/** Loads the average of the frames of a template
+  * @param kind identifies the manager ("dark" or "flat"), it is part of the identity of the master file
+  * @param names are the frames, the first one which can be loaded provides the metadata of the result
+  * @param hotPixels if not null, receives the hot pixels stored with the master file
+  * @param fromMaster is set to true if the average was read from the master file, the caller should else store it
+  * @return nullptr if no frame can be loaded */
+RawImage* loadCalibrationTemplate (const char *kind, const std::list<Glib::ustring> &names, std::vector<badPix> *hotPixels, bool &fromMaster);
+
+/** Stores the average of a template and its hot pixels (if not null) as master file, does nothing if the cache is disabled */
+void saveCalibrationMaster (const char *kind, const std::list<Glib::ustring> &names, const RawImage *ri, const std::vector<badPix> *hotPixels);
+
+}
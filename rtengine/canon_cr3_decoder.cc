@@ -60,8 +60,13 @@ it under the terms of the one of two licenses as you choose:
 #include <algorithm>
 #include <cstdint>
 #include <cstdlib>
-#include <exception>
+#include <cstring>
 #include <iostream>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "dcraw.h"
 
@@ -648,9 +653,6 @@ unsigned int sgetn(int n, unsigned char* s)
     return result;
 }
 
-// this should be divisible by 4
-constexpr std::uint64_t CRX_BUF_SIZE = 0x10000;
-
 #if !defined (_WIN32) || (defined (__GNUC__) && !defined (__INTRINSIC_SPECIAL__BitScanReverse))
 /* __INTRINSIC_SPECIAL__BitScanReverse found in MinGW32-W64 v7.30 headers, may be there is a better solution? */
 inline void _BitScanReverse(std::uint32_t* Index, unsigned long Mask)
@@ -686,15 +688,14 @@ struct LibRaw_abstract_datastream {
     }
 };
 
+// The bitstream of a subband reads directly from the file data (memory mapped or in memory), so that the subbands can be
+// decoded concurrently without locking
 struct CrxBitstream {
-    std::uint8_t mdatBuf[CRX_BUF_SIZE];
-    std::uint64_t mdatSize;
-    std::uint64_t curBufOffset;
+    const std::uint8_t* mdatBuf;
     std::uint32_t curPos;
     std::uint32_t curBufSize;
     std::uint32_t bitData;
     std::int32_t bitsLeft;
-    LibRaw_abstract_datastream* input;
 };
 
 struct CrxBandParam {
@@ -739,6 +740,8 @@ struct CrxSubband {
     std::uint16_t height;
     std::int32_t paramK;
     std::int64_t dataOffset;
+    std::int32_t* decodedBuf; // all the lines of the subband when it has been decoded ahead of the wavelet transform
+    std::int32_t decodedLine;
 };
 
 struct CrxPlaneComp {
@@ -822,31 +825,11 @@ const std::uint32_t J[32] = {
     0x7, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF
 };
 
-inline void crxFillBuffer(CrxBitstream* bitStrm)
+inline std::uint32_t crxBitstreamGetWord(const CrxBitstream* bitStrm)
 {
-    if (bitStrm->curPos >= bitStrm->curBufSize && bitStrm->mdatSize) {
-        bitStrm->curPos = 0;
-        bitStrm->curBufOffset += bitStrm->curBufSize;
-#ifdef _OPENMP
-        #pragma omp critical
-#endif
-        {
-#ifndef _OPENMP
-            bitStrm->input->lock();
-#endif
-            bitStrm->input->seek(bitStrm->curBufOffset, SEEK_SET);
-            bitStrm->curBufSize = bitStrm->input->read(bitStrm->mdatBuf, 1, std::min(bitStrm->mdatSize, CRX_BUF_SIZE));
-#ifndef _OPENMP
-            bitStrm->input->unlock();
-#endif
-
-            if (bitStrm->curBufSize < 1) {  // nothing read
-                throw std::exception();
-            }
-
-            bitStrm->mdatSize -= bitStrm->curBufSize;
-        }
-    }
+    std::uint32_t word;
+    memcpy(&word, bitStrm->mdatBuf + bitStrm->curPos, sizeof(word)); // the data is not aligned
+    return _byteswap_ulong(word);
 }
 
 inline int crxBitstreamGetZeros(CrxBitstream* bitStrm)
@@ -866,9 +849,8 @@ inline int crxBitstreamGetZeros(CrxBitstream* bitStrm)
 
         while (true) {
             while (bitStrm->curPos + 4 <= bitStrm->curBufSize) {
-                nextData = _byteswap_ulong(*reinterpret_cast<std::uint32_t*>(bitStrm->mdatBuf + bitStrm->curPos));
+                nextData = crxBitstreamGetWord(bitStrm);
                 bitStrm->curPos += 4;
-                crxFillBuffer(bitStrm);
 
                 if (nextData) {
                     _BitScanReverse(&nonZeroBit, static_cast<std::uint32_t>(nextData));
@@ -886,7 +868,6 @@ inline int crxBitstreamGetZeros(CrxBitstream* bitStrm)
             }
 
             nextData = bitStrm->mdatBuf[bitStrm->curPos++];
-            crxFillBuffer(bitStrm);
 
             if (nextData) {
                 break;
@@ -915,9 +896,8 @@ inline std::uint32_t crxBitstreamGetBits(CrxBitstream* bitStrm, int bits)
     if (bitsLeft < bits) {
         // get them from stream
         if (bitStrm->curPos + 4 <= bitStrm->curBufSize) {
-            nextWord = _byteswap_ulong(*reinterpret_cast<std::uint32_t*>(bitStrm->mdatBuf + bitStrm->curPos));
+            nextWord = crxBitstreamGetWord(bitStrm);
             bitStrm->curPos += 4;
-            crxFillBuffer(bitStrm);
             bitStrm->bitsLeft = 32 - (bits - bitsLeft);
             result = ((nextWord >> bitsLeft) | bitData) >> (32 - bits);
             bitStrm->bitData = nextWord << (bits - bitsLeft);
@@ -932,7 +912,6 @@ inline std::uint32_t crxBitstreamGetBits(CrxBitstream* bitStrm, int bits)
 
             bitsLeft += 8;
             nextByte = bitStrm->mdatBuf[bitStrm->curPos++];
-            crxFillBuffer(bitStrm);
             bitData |= nextByte << (32 - bitsLeft);
         } while (bitsLeft < bits);
     }
@@ -1757,6 +1736,12 @@ bool crxDecodeLineWithIQuantization(CrxSubband* subband)
 {
     constexpr std::int32_t q_step_tbl[6] = {0x28, 0x2D, 0x33, 0x39, 0x40, 0x48};
 
+    if (subband->decodedBuf && subband->decodedLine < subband->height) {
+        memcpy(subband->bandBuf, subband->decodedBuf + subband->decodedLine * subband->width, subband->width * sizeof(std::int32_t));
+        ++subband->decodedLine;
+        return true;
+    }
+
     if (!subband->dataSize) {
         memset(subband->bandBuf, 0, subband->bandSize);
         return true;
@@ -1804,6 +1789,29 @@ bool crxDecodeLineWithIQuantization(CrxSubband* subband)
     return true;
 }
 
+// Decodes all the lines of a subband, they are then read by crxDecodeLineWithIQuantization()
+bool crxPredecodeSubband(CrxSubband* subband)
+{
+    std::int32_t* const decodedBuf = static_cast<std::int32_t*>(malloc(sizeof(std::int32_t) * subband->width * subband->height));
+
+    if (!decodedBuf) {
+        return true; // the lines will be decoded along with the wavelet transform
+    }
+
+    for (int line = 0; line < subband->height; ++line) {
+        if (!crxDecodeLineWithIQuantization(subband)) {
+            free(decodedBuf);
+            return false;
+        }
+
+        memcpy(decodedBuf + line * subband->width, subband->bandBuf, subband->width * sizeof(std::int32_t));
+    }
+
+    subband->decodedBuf = decodedBuf;
+    subband->decodedLine = 0;
+    return true;
+}
+
 void crxHorizontal53(
     std::int32_t* lineBufLA,
     std::int32_t* lineBufLB,
@@ -2298,6 +2306,11 @@ void crxFreeSubbandData(CrxImage* image, CrxPlaneComp* comp)
             comp->subBands[i].bandParam = nullptr;
         }
 
+        if (comp->subBands[i].decodedBuf) {
+            free(comp->subBands[i].decodedBuf);
+            comp->subBands[i].decodedBuf = nullptr;
+        }
+
         comp->subBands[i].bandBuf = nullptr;
         comp->subBands[i].bandSize = 0;
     }
@@ -2394,6 +2407,10 @@ bool crxParamInit(
     LibRaw_abstract_datastream* input
 )
 {
+    if (subbandMdatOffset >= static_cast<std::uint64_t>(input->ifp->size)) {
+        return false;
+    }
+
     const std::int32_t progrDataSize =
         supportsPartial
             ? 0
@@ -2423,13 +2440,9 @@ bool crxParamInit(
     (*param)->supportsPartial = supportsPartial;
     (*param)->bitStream.bitData = 0;
     (*param)->bitStream.bitsLeft = 0;
-    (*param)->bitStream.mdatSize = subbandDataSize;
+    (*param)->bitStream.mdatBuf = reinterpret_cast<const std::uint8_t*>(input->ifp->data) + subbandMdatOffset;
     (*param)->bitStream.curPos = 0;
-    (*param)->bitStream.curBufSize = 0;
-    (*param)->bitStream.curBufOffset = subbandMdatOffset;
-    (*param)->bitStream.input = input;
-
-    crxFillBuffer(&(*param)->bitStream);
+    (*param)->bitStream.curBufSize = static_cast<std::uint32_t>(std::min<std::uint64_t>(subbandDataSize, input->ifp->size - subbandMdatOffset));
 
     return true;
 }
@@ -2564,60 +2577,54 @@ bool crxSetupSubbandData(
 
 } // namespace
 
-bool DCraw::crxDecodePlane(void* p, std::uint32_t planeNumber)
+bool DCraw::crxDecodeTile(void* p, std::uint32_t tileNumber, std::uint32_t planeNumber)
 {
     CrxImage* const img = static_cast<CrxImage*>(p);
-    int imageRow = 0;
+    const CrxTile* const tile = img->tiles + tileNumber;
+    CrxPlaneComp* const planeComp = tile->comps + planeNumber;
+
+    // all the tiles but the last ones of a row or column have the size of the first one
+    const int imageRow = tileNumber / img->tileCols * img->tiles[0].height;
+    const int imageCol = tileNumber % img->tileCols * img->tiles[0].width;
 
-    for (int tRow = 0; tRow < img->tileRows; ++tRow) {
-        int imageCol = 0;
+    // the subbands have already been set up when they have been decoded ahead
+    if (!planeComp->compBuf && !crxSetupSubbandData(img, planeComp, tile, tile->dataOffset + planeComp->dataOffset)) {
+        return false;
+    }
 
-        for (int tCol = 0; tCol < img->tileCols; ++tCol) {
-            const CrxTile* const tile = img->tiles + tRow * img->tileRows + tCol;
-            CrxPlaneComp* const planeComp = tile->comps + planeNumber;
-            const std::uint64_t tileMdatOffset = tile->dataOffset + planeComp->dataOffset;
+    if (img->levels) {
+        if (!crxIdwt53FilterInitialize(planeComp, img->levels - 1)) {
+            return false;
+        }
 
-            // decode single tile
-            if (!crxSetupSubbandData(img, planeComp, tile, tileMdatOffset)) {
+        for (int i = 0; i < tile->height; ++i) {
+            if (!crxIdwt53FilterDecode(planeComp, img->levels - 1) || !crxIdwt53FilterTransform(planeComp, img->levels - 1)) {
                 return false;
             }
 
-            if (img->levels) {
-                if (!crxIdwt53FilterInitialize(planeComp, img->levels - 1)) {
-                    return false;
-                }
-
-                for (int i = 0; i < tile->height; ++i) {
-                    if (!crxIdwt53FilterDecode(planeComp, img->levels - 1) || !crxIdwt53FilterTransform(planeComp, img->levels - 1)) {
-                        return false;
-                    }
-
-                    const std::int32_t* const lineData = crxIdwt53FilterGetLine(planeComp, img->levels - 1);
-                    crxConvertPlaneLine(img, imageRow + i, imageCol, planeNumber, lineData, tile->width);
-                }
-            } else {
-                // we have the only subband in this case
-                if (!planeComp->subBands->dataSize) {
-                    memset(planeComp->subBands->bandBuf, 0, planeComp->subBands->bandSize);
-                    return true;
-                }
-
-                for (int i = 0; i < tile->height; ++i) {
-                    if (!crxDecodeLine(planeComp->subBands->bandParam, planeComp->subBands->bandBuf)) {
-                        return false;
-                    }
+            const std::int32_t* const lineData = crxIdwt53FilterGetLine(planeComp, img->levels - 1);
+            crxConvertPlaneLine(img, imageRow + i, imageCol, planeNumber, lineData, tile->width);
+        }
+    } else {
+        // we have the only subband in this case
+        if (!planeComp->subBands->dataSize) {
+            memset(planeComp->subBands->bandBuf, 0, planeComp->subBands->bandSize);
+            return true;
+        }
 
-                    const std::int32_t* const lineData = reinterpret_cast<std::int32_t*>(planeComp->subBands->bandBuf);
-                    crxConvertPlaneLine(img, imageRow + i, imageCol, planeNumber, lineData, tile->width);
-                }
+        for (int i = 0; i < tile->height; ++i) {
+            if (!crxDecodeLine(planeComp->subBands->bandParam, planeComp->subBands->bandBuf)) {
+                return false;
             }
 
-            imageCol += tile->width;
+            const std::int32_t* const lineData = reinterpret_cast<std::int32_t*>(planeComp->subBands->bandBuf);
+            crxConvertPlaneLine(img, imageRow + i, imageCol, planeNumber, lineData, tile->width);
         }
-
-        imageRow += img->tiles[tRow * img->tileRows].height;
     }
 
+    // release the buffers of the tile as soon as possible
+    crxFreeSubbandData(img, planeComp);
+
     return true;
 }
 
@@ -2845,6 +2852,8 @@ bool crxReadImageHeaders(
                             band->quantValue = 4;
                             band->bandParam = nullptr;
                             band->dataSize = 0;
+                            band->decodedBuf = nullptr;
+                            band->decodedLine = 0;
                         }
                     }
                 }
@@ -3047,9 +3056,9 @@ void crxFreeImageData(CrxImage* img)
 
     if (img->tiles) {
         for (std::int32_t curTile = 0; curTile < nTiles; curTile++, tile++) {
-            if (tile[curTile].comps) {
+            if (tile->comps) {
                 for (std::int32_t curPlane = 0; curPlane < img->nPlanes; ++curPlane) {
-                    crxFreeSubbandData(img, tile[curTile].comps + curPlane);
+                    crxFreeSubbandData(img, tile->comps + curPlane);
                 }
             }
         }
@@ -3066,31 +3075,61 @@ void crxFreeImageData(CrxImage* img)
 
 }   // namespace
 
-void DCraw::crxLoadDecodeLoop(void* img, int nPlanes)
+void DCraw::crxLoadDecodeLoop(void* p, int nPlanes)
 {
+    CrxImage* const img = static_cast<CrxImage*>(p);
+    const int nComps = img->tileRows * img->tileCols * nPlanes;
+    std::vector<char> results(nComps, true);
+
 #ifdef _OPENMP
-    bool results[4]; // nPlanes is always <= 4
-    #pragma omp parallel for
+    // With fewer tiles and planes than threads, the entropy decoding of the subbands, which is the most expensive part,
+    // is done ahead in parallel, then the wavelet transforms read the decoded lines. This costs a buffer of the size of the
+    // decoded image.
+    if (img->levels && nComps < omp_get_max_threads()) {
+        #pragma omp parallel for
 
-    for (std::int32_t plane = 0; plane < nPlanes; ++plane) {
-        results[plane] = crxDecodePlane(img, plane);
-    }
+        for (int comp = 0; comp < nComps; ++comp) {
+            const CrxTile* const tile = img->tiles + comp / nPlanes;
+            CrxPlaneComp* const planeComp = tile->comps + comp % nPlanes;
+            results[comp] = crxSetupSubbandData(img, planeComp, tile, tile->dataOffset + planeComp->dataOffset);
+        }
 
-    for (std::int32_t plane = 0; plane < nPlanes; ++plane) {
-        if (!results[plane]) {
-            derror();
+        const int nBands = nComps * img->subbandCount;
+        std::vector<char> bandResults(nBands, true);
+
+        // the largest subbands come last, start with them
+        #pragma omp parallel for schedule(dynamic)
+
+        for (int band = nBands - 1; band >= 0; --band) {
+            const int comp = band / img->subbandCount;
+
+            if (results[comp]) {
+                CrxSubband* const subband = img->tiles[comp / nPlanes].comps[comp % nPlanes].subBands + band % img->subbandCount;
+                bandResults[band] = !subband->dataSize || crxPredecodeSubband(subband);
+            }
+        }
+
+        for (int band = 0; band < nBands; ++band) {
+            if (!bandResults[band]) {
+                results[band / img->subbandCount] = false;
+            }
         }
     }
 
-#else
+    #pragma omp parallel for schedule(dynamic)
+#endif
 
-    for (std::int32_t plane = 0; plane < nPlanes; ++plane) {
-        if (!crxDecodePlane(img, plane)) {
-            derror();
+    for (int comp = 0; comp < nComps; ++comp) {
+        if (results[comp]) {
+            results[comp] = crxDecodeTile(img, comp / nPlanes, comp % nPlanes);
         }
     }
 
-#endif
+    for (int comp = 0; comp < nComps; ++comp) {
+        if (!results[comp]) {
+            derror();
+        }
+    }
 }
 
 void DCraw::crxConvertPlaneLineDf(void* p, int imageRow)
@@ -20,6 +20,7 @@
 #include <iostream>
 
 #include "rtengine.h"
+#include "rawanalysiscache.h"
 #include "rawimage.h"
 #include "rawimagesource.h"
 #include "rt_math.h"
@@ -1015,6 +1016,8 @@ void RawImageSource::captureSharpening(const procparams::CaptureSharpeningParams
     }
 BENCHFUN
 
+    finishBinnedDemosaic(true);
+
     constexpr float xyz_rgb[3][3] = {          // XYZ from RGB
                                     { 0.412453, 0.357580, 0.180423 },
                                     { 0.212671, 0.715160, 0.072169 },
@@ -1033,6 +1036,14 @@ BENCHFUN
     constexpr float clipLimit = 0.95f;
     constexpr float maxSigma = 2.f;
 
+    // the auto radius is measured once per raw file and preprocessing
+    std::vector<double> storedRadius;
+    const bool measureRadius = sharpeningParams.autoRadius && !loadRawAnalysis(ri->get_filename(), "CaptureSharpeningRadius", radiusKey, storedRadius);
+
+    if (sharpeningParams.autoRadius && !measureRadius) {
+        radius = storedRadius[0];
+    }
+
     if (getSensorType() == ST_BAYER) {
         const float whites[2][2] = {
                                     {(ri->get_white(FC(0,0)) - c_black[FC(0,0)]) * scale_mul[FC(0,0)] * clipLimit, (ri->get_white(FC(0,1)) - c_black[FC(0,1)]) * scale_mul[FC(0,1)] * clipLimit},
@@ -1040,7 +1051,7 @@ BENCHFUN
                                    };
         buildClipMaskBayer(rawData, W, H, clipMask, whites);
         const unsigned int fc[2] = {FC(0,0), FC(1,0)};
-        if (sharpeningParams.autoRadius) {
+        if (measureRadius) {
             radius = std::min(calcRadiusBayer(rawData, W, H, 1000.f, clipVal, fc), maxSigma);
         }
     } else if (getSensorType() == ST_FUJI_XTRANS) {
@@ -1068,13 +1079,13 @@ BENCHFUN
                 }
             }
         }
-        if (sharpeningParams.autoRadius) {
+        if (measureRadius) {
             radius = std::min(calcRadiusXtrans(rawData, W, H, 1000.f, clipVal, i, j), maxSigma);
         }
 
     } else if (ri->get_colors() == 1) {
         buildClipMaskMono(rawData, W, H, clipMask, (ri->get_white(0) - c_black[0]) * scale_mul[0] * clipLimit);
-        if (sharpeningParams.autoRadius) {
+        if (measureRadius) {
             const unsigned int fc[2] = {0, 0};
             radius = std::min(calcRadiusBayer(rawData, W, H, 1000.f, clipVal, fc), maxSigma);
         }
@@ -1084,6 +1095,10 @@ BENCHFUN
         return;
     }
 
+    if (measureRadius) {
+        saveRawAnalysis(ri->get_filename(), "CaptureSharpeningRadius", radiusKey, {radius});
+    }
+
     if (showMask) {
         array2D<float>& L = blue; // blue will be overridden anyway => we can use its buffer to store L
 #ifdef _OPENMP
@@ -0,0 +1,85 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cmath>
+
+#include "compactrawframe.h"
+
+namespace rtengine
+{
+
+CompactRawFrame::CompactRawFrame() :
+    width(0),
+    height(0),
+    scale(1.f)
+{
+}
+
+void CompactRawFrame::pack(array2D<float>& src)
+{
+    width = src.width();
+    height = src.height();
+
+    float maxVal = 0.f;
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(max:maxVal)
+#endif
+
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            maxVal = std::max(maxVal, src[row][col]);
+        }
+    }
+
+    scale = maxVal > 0.f ? maxVal / 65535.f : 1.f;
+    const float invScale = 1.f / scale;
+    data.resize(static_cast<std::size_t>(width) * height);
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+
+    for (int row = 0; row < height; ++row) {
+        std::uint16_t* const dst = data.data() + static_cast<std::size_t>(row) * width;
+
+        for (int col = 0; col < width; ++col) {
+            dst[col] = std::min(std::max(src[row][col], 0.f) * invScale + 0.5f, 65535.f);
+        }
+    }
+
+    src(0, 0);
+}
+
+void CompactRawFrame::unpack(array2D<float>& dst) const
+{
+    dst(width, height);
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+
+    for (int row = 0; row < height; ++row) {
+        unpackRow(row, dst[row]);
+    }
+}
+
+void CompactRawFrame::clear()
+{
+    std::vector<std::uint16_t>().swap(data);
+    width = height = 0;
+    scale = 1.f;
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "array2D.h"
+#include "noncopyable.h"
+
+namespace rtengine
+{
+
+/* A raw frame stored as 16 bit integers and a per frame scale, half the memory of an array2D<float>.
+ *
+ * Used for the frames of a multi-frame raw which are not the selected one. The values are clamped to [0, maximum of the
+ * frame] and quantized to 1/65535 of the maximum, which is finer than the 14 or 16 bit steps of the raw data they come from. */
+class CompactRawFrame :
+    public NonCopyable
+{
+public:
+    CompactRawFrame();
+
+    /** Stores src and releases its memory */
+    void pack (array2D<float>& src);
+
+    /** Restores the frame into dst, which is (re)allocated */
+    void unpack (array2D<float>& dst) const;
+
+    /** Converts row row of the frame into width floats at dst */
+    void unpackRow (int row, float* dst) const
+    {
+        const std::uint16_t* const src = data.data() + static_cast<std::size_t>(row) * width;
+
+        for (int col = 0; col < width; ++col) {
+            dst[col] = src[col] * scale;
+        }
+    }
+
+    bool empty() const
+    {
+        return data.empty();
+    }
+
+    void clear();
+
+    int getWidth() const
+    {
+        return width;
+    }
+
+    int getHeight() const
+    {
+        return height;
+    }
+
+private:
+    std::vector<std::uint16_t> data;
+    int width;
+    int height;
+    float scale;
+};
+
+}
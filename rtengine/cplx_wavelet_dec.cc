@@ -39,5 +39,42 @@ wavelet_decomposition::~wavelet_decomposition()
     }
 }
 
+bool wavelet_decomposition::compress_details()
+{
+    if(memoryAllocationFailed) {
+        return false;
+    }
+
+    for(int i = 0; i <= lvltot; i++) {
+        if(!wavelet_decomp[i]->compress()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool wavelet_decomposition::expand_details()
+{
+    for(int i = 0; i <= lvltot; i++) {
+        if(wavelet_decomp[i] != nullptr && !wavelet_decomp[i]->expand()) {
+            memoryAllocationFailed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const wavelet_decomposition::internal_type * wavelet_decomposition::level_subband(int level, int dir, internal_type * buffer) const
+{
+    if(!wavelet_decomp[level]->compressed()) {
+        return wavelet_decomp[level]->subbands()[dir];
+    }
+
+    wavelet_decomp[level]->subband(dir, buffer);
+    return buffer;
+}
+
 }
 
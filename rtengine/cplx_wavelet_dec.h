@@ -88,6 +88,18 @@ public:
     {
         return subsamp;
     }
+
+    /** Stores the detail subbands of all the levels as half floats, which halves their memory at the cost of a relative
+      * precision of 1/2048. Until expand_details is called they can only be read by level_subband.
+      * Returns false if the memory could not be allocated, the remaining levels are kept as floats. */
+    bool compress_details();
+
+    /** Converts back the detail subbands stored by compress_details. Returns false if the memory could not be allocated. */
+    bool expand_details();
+
+    /** Returns subband dir of level, it is converted into buffer (level_W * level_H floats) when the details are compressed */
+    const internal_type * level_subband(int level, int dir, internal_type * buffer) const;
+
     template<typename E>
     void reconstruct(E * dst, const float blend = 1.f);
 };
@@ -195,7 +207,7 @@ template<typename E>
 void wavelet_decomposition::reconstruct(E * dst, const float blend)
 {
 
-    if(memoryAllocationFailed) {
+    if(memoryAllocationFailed || !expand_details()) {
         return;
     }
 
@@ -34,6 +34,15 @@ const float Daub4_anal[2][6] ALIGNED16 = {//Daub4
     { -0.091506351f, -0.15849365f, 0.59150635f, -0.34150635f, 0.f, 0.f}
 };
 
+// lifting steps of Daub4_anal, with s = sqrt(3): predict the odd samples, update the even samples, predict the odd samples
+// again, then scale the lowpass (odd) and highpass (even) outputs
+const float Daub4_lift_predict1 = 0.57735027f; // 1 / s
+const float Daub4_lift_update0 = 0.20096189f;  // 3 * (2 - s) / 4
+const float Daub4_lift_update1 = 0.43301270f;  // s / 4
+const float Daub4_lift_predict2 = 1.f / 3.f;
+const float Daub4_lift_scaleLo = 0.63397460f;  // (3 - s) / 2
+const float Daub4_lift_scaleHi = 0.78867513f;  // (1 + 1 / s) / 2
+
 const float Daub4_anal8[2][8] ALIGNED16 = {//Daub6
     {0.f, 0.f, 0.235233605f, 0.57055846f, 0.3251825f, -0.09546721f, -0.060416105f, 0.02490875f},
     { -0.02490875f,  -0.060416105f, 0.09546721f, 0.3251825f, -0.57055846f , 0.235233605f, 0.f, 0.f}
@@ -20,9 +20,16 @@
 */
 #pragma once
 
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "rt_math.h"
 #include "opthelper.h"
+#include "cplx_wavelet_filter_coeffs.h"
+#include "halffloat.h"
 #include "stdio.h"
 namespace rtengine
 {
@@ -43,6 +50,11 @@ class wavelet_level
     int skip;
 
     bool bigBlockOfMemory;
+
+    // detail subbands stored as half floats by compress, and their scale factors
+    std::uint16_t * halfcoeffs;
+    float halfscale[4];
+
     // allocation and destruction of data storage
     T ** create(int n);
     void destroy(T ** subbands);
@@ -70,6 +82,27 @@ class wavelet_level
 #else
     void SynthesisFilterSubsampVertical (T * srcLo, T * srcHi, T * dst, float *filterLo, float *filterHi, const int taps, const int offset, const int width, const int srcheight, const int dstheight, const float blend);
 #endif
+
+    // Lifting scheme of the Daubechies 4 filters (Daub4_anal), which replaces their convolution when the taps are 1 pixel
+    // apart. The polyphase components go through a predict, an update and a second predict step, then a scaling. The clamped
+    // boundaries of the convolution are reproduced by clamping the rows and columns read by the steps. The vertical passes
+    // process consecutive rows, o1 and e1 (or e) carry the lifted rows from one call to the next and are initialized when
+    // first is true.
+    void AnalysisLiftingVertical (const T * const srcbuffer, T * dstLo, T * dstHi, T * o1, T * e1, const int width, const int height, const int row, const bool first);
+    void AnalysisLiftingHorizontal (const T * const srcbuffer, T * dstLo, T * dstHi, T * bufE, T * bufO, const int srcwidth, const int dstwidth, const int row);
+    void SynthesisLiftingHorizontal (const T * const srcLo, const T * const srcHi, T * dst, const int srcwidth, const int dstwidth, const int height);
+    void SynthesisLiftingVertical (const T * const srcLo, const T * const srcHi, T * dst, T * o1, T * e, const int width, const int srcheight, const int dstheight, const int row, const bool first, const float blend);
+
+    bool useLifting(int taps) const
+    {
+        return subsamp_out && skip == 1 && taps == 6;
+    }
+
+    template<typename E>
+    void decompose_lifting(E *src, E *dst);
+
+    template<typename E>
+    void reconstruct_lifting(E* tmpLo, E* tmpHi, E *src, E *dst, const float blend);
 public:
     bool memoryAllocationFailed;
 
@@ -82,7 +115,7 @@ public:
 
     template<typename E>
     wavelet_level(E * src, E * dst, int level, int subsamp, int w, int h, float *filterV, float *filterH, int len, int offset, int skipcrop, int numThreads)
-        : lvl(level), subsamp_out((subsamp >> level) & 1), numThreads(numThreads), skip(1 << level), bigBlockOfMemory(true), memoryAllocationFailed(false), wavcoeffs(nullptr), m_w(w), m_h(h), m_w2(w), m_h2(h)
+        : lvl(level), subsamp_out((subsamp >> level) & 1), numThreads(numThreads), skip(1 << level), bigBlockOfMemory(true), halfcoeffs(nullptr), memoryAllocationFailed(false), wavcoeffs(nullptr), m_w(w), m_h(h), m_w2(w), m_h2(h)
     {
         if (subsamp) {
             skip = 1;
@@ -113,6 +146,7 @@ public:
     ~wavelet_level()
     {
         destroy(wavcoeffs);
+        delete[] halfcoeffs;
     }
 
     T ** subbands() const
@@ -145,6 +179,18 @@ public:
         return bigBlockOfMemory;
     }
 
+    bool compressed() const
+    {
+        return halfcoeffs != nullptr;
+    }
+
+    // replaces the detail subbands by half floats, subbands() returns nullptr until expand is called
+    bool compress();
+    bool expand();
+
+    // converts detail subband dir of a compressed level into dst, single threaded
+    void subband(int dir, T * dst) const;
+
     template<typename E>
     void decompose_level(E *src, E *dst, float *filterV, float *filterH, int len, int offset);
 
@@ -197,18 +243,129 @@ void wavelet_level<T>::destroy(T ** subbands)
     }
 }
 
+template<typename T>
+bool wavelet_level<T>::compress()
+{
+    if (halfcoeffs || !wavcoeffs) {
+        return true;
+    }
+
+    const int n = m_w2 * m_h2;
+    halfcoeffs = new (std::nothrow) std::uint16_t[3 * n];
+
+    if (halfcoeffs == nullptr) {
+        return false;
+    }
+
+    for (int dir = 1; dir < 4; dir++) {
+        float maxabs = 0.f;
+#ifdef _OPENMP
+        #pragma omp parallel for reduction(max:maxabs) num_threads(numThreads) if(numThreads>1)
+#endif
+
+        for (int i = 0; i < n; i++) {
+            maxabs = max(maxabs, std::fabs(wavcoeffs[dir][i]));
+        }
+
+        // scale by a power of 2 which brings the largest coefficient between 16384 and 32768, far from the overflow of half floats
+        int exponent = 0;
+        halfscale[dir] = 1.f;
+
+        if (maxabs > 0.f && std::isfinite(maxabs)) {
+            std::frexp(maxabs, &exponent);
+            halfscale[dir] = std::ldexp(1.f, 15 - exponent);
+        }
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(numThreads) if(numThreads>1)
+#endif
+
+        for (int row = 0; row < m_h2; row++) {
+            floatToHalf(wavcoeffs[dir] + row * m_w2, halfcoeffs + (dir - 1) * n + row * m_w2, m_w2, halfscale[dir]);
+        }
+    }
+
+    destroy(wavcoeffs);
+    wavcoeffs = nullptr;
+    return true;
+}
+
+template<typename T>
+bool wavelet_level<T>::expand()
+{
+    if (!halfcoeffs) {
+        return true;
+    }
+
+    bigBlockOfMemory = true;
+    wavcoeffs = create(m_w2 * m_h2);
+
+    if (memoryAllocationFailed) {
+        destroy(wavcoeffs);
+        wavcoeffs = nullptr;
+        return false;
+    }
+
+    const int n = m_w2 * m_h2;
+
+    for (int dir = 1; dir < 4; dir++) {
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(numThreads) if(numThreads>1)
+#endif
+
+        for (int row = 0; row < m_h2; row++) {
+            halfToFloat(halfcoeffs + (dir - 1) * n + row * m_w2, wavcoeffs[dir] + row * m_w2, m_w2, 1.f / halfscale[dir]);
+        }
+    }
+
+    delete[] halfcoeffs;
+    halfcoeffs = nullptr;
+    return true;
+}
+
+template<typename T>
+void wavelet_level<T>::subband(int dir, T * dst) const
+{
+    const int n = m_w2 * m_h2;
+    halfToFloat(halfcoeffs + (dir - 1) * n, dst, n, 1.f / halfscale[dir]);
+}
+
 template<typename T>
 void wavelet_level<T>::AnalysisFilterHaarHorizontal (const T * const RESTRICT srcbuffer, T * RESTRICT dstLo, T * RESTRICT dstHi, const int width, const int row)
 {
     /* Basic convolution code
      * Applies a Haar filter
     */
-    for(int i = 0; i < (width - skip); i++) {
+    int i = 0;
+#ifdef __SSE2__
+
+    for(; i < (width - skip) - 3; i += 4) {
+        const vfloat srcv = LVFU(srcbuffer[i]);
+        const vfloat srcskipv = LVFU(srcbuffer[i + skip]);
+        STVFU(dstLo[row * width + i], srcv + srcskipv);
+        STVFU(dstHi[row * width + i], srcv - srcskipv);
+    }
+
+#endif
+
+    for(; i < (width - skip); i++) {
         dstLo[row * width + i] = (srcbuffer[i] + srcbuffer[i + skip]);
         dstHi[row * width + i] = (srcbuffer[i] - srcbuffer[i + skip]);
     }
 
-    for(int i = max(width - skip, skip); i < (width); i++) {
+    i = max(width - skip, skip);
+#ifdef __SSE2__
+
+    for(; i < width - 3; i += 4) {
+        const vfloat srcv = LVFU(srcbuffer[i]);
+        const vfloat srcskipv = LVFU(srcbuffer[i - skip]);
+        STVFU(dstLo[row * width + i], srcv + srcskipv);
+        STVFU(dstHi[row * width + i], srcv - srcskipv);
+    }
+
+#endif
+
+    for(; i < (width); i++) {
         dstLo[row * width + i] = (srcbuffer[i] + srcbuffer[i - skip]);
         dstHi[row * width + i] = (srcbuffer[i] - srcbuffer[i - skip]);
     }
@@ -219,16 +376,32 @@ template<typename T> void wavelet_level<T>::AnalysisFilterHaarVertical (const T
     /* Basic convolution code
      * Applies a Haar filter
     */
+    int rowskip;
+
     if(row < (height - skip)) {
-        for(int j = 0; j < width; j++) {
-            dstLo[j] = 0.25f * (srcbuffer[row * width + j] + srcbuffer[(row + skip) * width + j]);
-            dstHi[j] = 0.25f * (srcbuffer[row * width + j] - srcbuffer[(row + skip) * width + j]);
-        }
+        rowskip = row + skip;
     } else if(row >= max(height - skip, skip)) {
-        for(int j = 0; j < width; j++) {
-            dstLo[j] = 0.25f * (srcbuffer[row * width + j] + srcbuffer[(row - skip) * width + j]);
-            dstHi[j] = 0.25f * (srcbuffer[row * width + j] - srcbuffer[(row - skip) * width + j]);
-        }
+        rowskip = row - skip;
+    } else {
+        return;
+    }
+
+    int j = 0;
+#ifdef __SSE2__
+    const vfloat quarterv = F2V(0.25f);
+
+    for(; j < width - 3; j += 4) {
+        const vfloat srcv = LVFU(srcbuffer[row * width + j]);
+        const vfloat srcskipv = LVFU(srcbuffer[rowskip * width + j]);
+        STVFU(dstLo[j], quarterv * (srcv + srcskipv));
+        STVFU(dstHi[j], quarterv * (srcv - srcskipv));
+    }
+
+#endif
+
+    for(; j < width; j++) {
+        dstLo[j] = 0.25f * (srcbuffer[row * width + j] + srcbuffer[rowskip * width + j]);
+        dstHi[j] = 0.25f * (srcbuffer[row * width + j] - srcbuffer[rowskip * width + j]);
     }
 }
 
@@ -247,11 +420,21 @@ template<typename T> void wavelet_level<T>::SynthesisFilterHaarHorizontal (const
 #endif
 
     for (int k = 0; k < height; k++) {
-        for(int i = 0; i < skip; i++) {
+        for(int i = 0; i < min(skip, width); i++) {
             dst[k * width + i] = (srcLo[k * width + i] + srcHi[k * width + i]);
         }
 
-        for(int i = skip; i < width; i++) {
+        int i = skip;
+#ifdef __SSE2__
+        const vfloat halfv = F2V(0.5f);
+
+        for(; i < width - 3; i += 4) {
+            STVFU(dst[k * width + i], halfv * (LVFU(srcLo[k * width + i]) + LVFU(srcHi[k * width + i]) + LVFU(srcLo[k * width + i - skip]) - LVFU(srcHi[k * width + i - skip])));
+        }
+
+#endif
+
+        for(; i < width; i++) {
             dst[k * width + i] = 0.5f * (srcLo[k * width + i] + srcHi[k * width + i] + srcLo[k * width + i - skip] - srcHi[k * width + i - skip]);
         }
     }
@@ -285,7 +468,17 @@ template<typename T> void wavelet_level<T>::SynthesisFilterHaarVertical (const T
 
         for(int i = skip; i < height; i++)
         {
-            for(int j = 0; j < width; j++) {
+            int j = 0;
+#ifdef __SSE2__
+            const vfloat halfv = F2V(0.5f);
+
+            for(; j < width - 3; j += 4) {
+                STVFU(dst[width * i + j], halfv * (LVFU(srcLo[i * width + j]) + LVFU(srcHi[i * width + j]) + LVFU(srcLo[(i - skip) * width + j]) - LVFU(srcHi[(i - skip) * width + j])));
+            }
+
+#endif
+
+            for(; j < width; j++) {
                 dst[width * i + j] = 0.5f * (srcLo[i * width + j] + srcHi[i * width + j] + srcLo[(i - skip) * width + j] - srcHi[(i - skip) * width + j]);
             }
         }
@@ -627,9 +820,361 @@ template<typename T> void wavelet_level<T>::SynthesisFilterSubsampVertical (T *
 }
 #endif
 
+template<typename T> void wavelet_level<T>::AnalysisLiftingVertical (const T * const RESTRICT srcbuffer, T * RESTRICT dstLo, T * RESTRICT dstHi, T * RESTRICT o1, T * RESTRICT e1, const int width, const int height, const int row, const bool first)
+{
+    // output row 'row' is made of the input rows 2 * row - 3 to 2 * row + 2, clamped BC's
+    const auto srcRow = [srcbuffer, width, height](int i) {
+        return srcbuffer + max(0, min(i, height - 1)) * width;
+    };
+
+    const T * const even = srcRow(2 * row);
+
+    if (first) {
+        // lifted odd rows of row - 2 and row - 1, lifted even row of row - 1
+        const T * const oddPrev2 = srcRow(2 * row - 3);
+        const T * const evenPrev = srcRow(2 * row - 2);
+        const T * const oddPrev = srcRow(2 * row - 1);
+
+        for (int k = 0; k < width; k++) {
+            const float o1Prev2 = oddPrev2[k] + Daub4_lift_predict1 * evenPrev[k];
+            o1[k] = oddPrev[k] + Daub4_lift_predict1 * even[k];
+            e1[k] = evenPrev[k] - Daub4_lift_update0 * o1[k] - Daub4_lift_update1 * o1Prev2;
+        }
+    }
+
+    const T * const odd = srcRow(2 * row + 1);
+    const T * const evenNext = srcRow(2 * row + 2);
+    int k = 0;
+#ifdef __SSE2__
+    const vfloat predict1v = F2V(Daub4_lift_predict1);
+    const vfloat update0v = F2V(Daub4_lift_update0);
+    const vfloat update1v = F2V(Daub4_lift_update1);
+    const vfloat predict2v = F2V(Daub4_lift_predict2);
+    const vfloat scaleLov = F2V(Daub4_lift_scaleLo);
+    const vfloat scaleHiv = F2V(Daub4_lift_scaleHi);
+
+    for (; k < width - 3; k += 4) {
+        const vfloat o1v = LVFU(odd[k]) + predict1v * LVFU(evenNext[k]);
+        const vfloat e1v = LVFU(even[k]) - update0v * o1v - update1v * LVFU(o1[k]);
+        STVFU(dstLo[k], scaleLov * (LVFU(o1[k]) + predict2v * LVFU(e1[k])));
+        STVFU(dstHi[k], scaleHiv * e1v);
+        STVFU(o1[k], o1v);
+        STVFU(e1[k], e1v);
+    }
+
+#endif
+
+    for (; k < width; k++) {
+        const float o1k = odd[k] + Daub4_lift_predict1 * evenNext[k];
+        const float e1k = even[k] - Daub4_lift_update0 * o1k - Daub4_lift_update1 * o1[k];
+        dstLo[k] = Daub4_lift_scaleLo * (o1[k] + Daub4_lift_predict2 * e1[k]);
+        dstHi[k] = Daub4_lift_scaleHi * e1k;
+        o1[k] = o1k;
+        e1[k] = e1k;
+    }
+}
+
+template<typename T> void wavelet_level<T>::AnalysisLiftingHorizontal (const T * const RESTRICT srcbuffer, T * RESTRICT dstLo, T * RESTRICT dstHi, T * RESTRICT bufE, T * RESTRICT bufO, const int srcwidth, const int dstwidth, const int row)
+{
+    // bufE[j] and bufO[j] hold the input samples 2 * j - 2 and 2 * j - 3, clamped BC's
+    const int bufwidth = dstwidth + 2;
+    int j = 0;
+#ifdef __SSE2__
+
+    for (; j < min(2, bufwidth); j++) {
+        bufE[j] = srcbuffer[max(0, min(2 * j - 2, srcwidth - 1))];
+        bufO[j] = srcbuffer[max(0, min(2 * j - 3, srcwidth - 1))];
+    }
+
+    for (; j < bufwidth - 3 && 2 * j + 4 < srcwidth; j += 4) {
+        const vfloat srcv0 = LVFU(srcbuffer[2 * j - 3]);
+        const vfloat srcv1 = LVFU(srcbuffer[2 * j + 1]);
+        STVFU(bufE[j], _mm_shuffle_ps(srcv0, srcv1, _MM_SHUFFLE(3, 1, 3, 1)));
+        STVFU(bufO[j], _mm_shuffle_ps(srcv0, srcv1, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+
+#endif
+
+    for (; j < bufwidth; j++) {
+        bufE[j] = srcbuffer[max(0, min(2 * j - 2, srcwidth - 1))];
+        bufO[j] = srcbuffer[max(0, min(2 * j - 3, srcwidth - 1))];
+    }
+
+    j = 0;
+#ifdef __SSE2__
+    const vfloat predict1v = F2V(Daub4_lift_predict1);
+
+    for (; j < bufwidth - 3; j += 4) {
+        STVFU(bufO[j], LVFU(bufO[j]) + predict1v * LVFU(bufE[j]));
+    }
+
+#endif
+
+    for (; j < bufwidth; j++) {
+        bufO[j] += Daub4_lift_predict1 * bufE[j];
+    }
+
+    j = 0;
+#ifdef __SSE2__
+    const vfloat update0v = F2V(Daub4_lift_update0);
+    const vfloat update1v = F2V(Daub4_lift_update1);
+
+    for (; j < bufwidth - 4; j += 4) {
+        STVFU(bufE[j], LVFU(bufE[j]) - update0v * LVFU(bufO[j + 1]) - update1v * LVFU(bufO[j]));
+    }
+
+#endif
+
+    for (; j < bufwidth - 1; j++) {
+        bufE[j] = bufE[j] - Daub4_lift_update0 * bufO[j + 1] - Daub4_lift_update1 * bufO[j];
+    }
+
+    int m = 0;
+#ifdef __SSE2__
+    const vfloat predict2v = F2V(Daub4_lift_predict2);
+    const vfloat scaleLov = F2V(Daub4_lift_scaleLo);
+    const vfloat scaleHiv = F2V(Daub4_lift_scaleHi);
+
+    for (; m < dstwidth - 3; m += 4) {
+        STVFU(dstLo[row * dstwidth + m], scaleLov * (LVFU(bufO[m + 1]) + predict2v * LVFU(bufE[m])));
+        STVFU(dstHi[row * dstwidth + m], scaleHiv * LVFU(bufE[m + 1]));
+    }
+
+#endif
+
+    for (; m < dstwidth; m++) {
+        dstLo[row * dstwidth + m] = Daub4_lift_scaleLo * (bufO[m + 1] + Daub4_lift_predict2 * bufE[m]);
+        dstHi[row * dstwidth + m] = Daub4_lift_scaleHi * bufE[m + 1];
+    }
+}
+
+template<typename T> void wavelet_level<T>::SynthesisLiftingHorizontal (const T * const RESTRICT srcLo, const T * const RESTRICT srcHi, T * RESTRICT dst, const int srcwidth, const int dstwidth, const int height)
+{
+    // like the convolution, the output is half of the inverse transform
+    const float scaleLo = 0.5f / Daub4_lift_scaleLo;
+    const float scaleHi = 0.5f / Daub4_lift_scaleHi;
+    const int bufwidth = srcwidth + 2;
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(numThreads) if(numThreads>1)
+#endif
+    {
+        // bufE[j] and bufO[j] hold the lifted even and odd samples j - 1, clamped BC's
+        T bufE[bufwidth] ALIGNED64;
+        T bufO[bufwidth] ALIGNED64;
+#ifdef _OPENMP
+        #pragma omp for
+#endif
+
+        for (int k = 0; k < height; k++) {
+            const T * const lo = srcLo + k * srcwidth;
+            const T * const hi = srcHi + k * srcwidth;
+            int j = 0;
+#ifdef __SSE2__
+            const vfloat scaleLov = F2V(scaleLo);
+            const vfloat scaleHiv = F2V(scaleHi);
+            const vfloat predict2v = F2V(Daub4_lift_predict2);
+
+            for (; j < min(1, bufwidth); j++) {
+                bufE[j] = scaleHi * hi[max(0, min(j - 1, srcwidth - 1))];
+                bufO[j] = scaleLo * lo[max(0, min(j, srcwidth - 1))] - Daub4_lift_predict2 * bufE[j];
+            }
+
+            for (; j < srcwidth - 4; j += 4) {
+                const vfloat e1v = scaleHiv * LVFU(hi[j - 1]);
+                STVFU(bufE[j], e1v);
+                STVFU(bufO[j], scaleLov * LVFU(lo[j]) - predict2v * e1v);
+            }
+
+#endif
+
+            for (; j < bufwidth; j++) {
+                bufE[j] = scaleHi * hi[max(0, min(j - 1, srcwidth - 1))];
+                bufO[j] = scaleLo * lo[max(0, min(j, srcwidth - 1))] - Daub4_lift_predict2 * bufE[j];
+            }
+
+            j = 1;
+#ifdef __SSE2__
+            const vfloat update0v = F2V(Daub4_lift_update0);
+            const vfloat update1v = F2V(Daub4_lift_update1);
+
+            for (; j < bufwidth - 3; j += 4) {
+                STVFU(bufE[j], LVFU(bufE[j]) + update0v * LVFU(bufO[j]) + update1v * LVFU(bufO[j - 1]));
+            }
+
+#endif
+
+            for (; j < bufwidth; j++) {
+                bufE[j] = bufE[j] + Daub4_lift_update0 * bufO[j] + Daub4_lift_update1 * bufO[j - 1];
+            }
+
+            T * const out = dst + k * dstwidth;
+            int m = 0;
+#ifdef __SSE2__
+            const vfloat predict1v = F2V(Daub4_lift_predict1);
+
+            for (; 2 * m + 7 < dstwidth; m += 4) {
+                const vfloat evenv = LVFU(bufE[m + 1]);
+                const vfloat oddv = LVFU(bufO[m + 1]) - predict1v * LVFU(bufE[m + 2]);
+                STVFU(out[2 * m], _mm_unpacklo_ps(evenv, oddv));
+                STVFU(out[2 * m + 4], _mm_unpackhi_ps(evenv, oddv));
+            }
+
+#endif
+
+            for (; 2 * m + 1 < dstwidth; m++) {
+                out[2 * m] = bufE[m + 1];
+                out[2 * m + 1] = bufO[m + 1] - Daub4_lift_predict1 * bufE[m + 2];
+            }
+
+            if (2 * m < dstwidth) {
+                out[2 * m] = bufE[m + 1];
+            }
+        }
+    }
+}
+
+template<typename T> void wavelet_level<T>::SynthesisLiftingVertical (const T * const RESTRICT srcLo, const T * const RESTRICT srcHi, T * RESTRICT dst, T * RESTRICT o1, T * RESTRICT e, const int width, const int srcheight, const int dstheight, const int row, const bool first, const float blend)
+{
+    // output rows 2 * row and 2 * row + 1 are made of the input rows row - 1 to row + 2, clamped BC's. Like the convolution,
+    // the output is twice the inverse transform.
+    const auto loRow = [srcLo, width, srcheight](int i) {
+        return srcLo + max(0, min(i, srcheight - 1)) * width;
+    };
+    const auto hiRow = [srcHi, width, srcheight](int i) {
+        return srcHi + max(0, min(i, srcheight - 1)) * width;
+    };
+    const float scaleLo = 2.f / Daub4_lift_scaleLo;
+    const float scaleHi = 2.f / Daub4_lift_scaleHi;
+    const float srcFactor = 1.f - blend;
+
+    if (first) {
+        // lifted odd rows of row - 1 and row, even row of row
+        const T * const hiPrev = hiRow(row - 1);
+        const T * const lo = loRow(row);
+        const T * const hi = hiRow(row);
+        const T * const loNext = loRow(row + 1);
+
+        for (int k = 0; k < width; k++) {
+            const float o1Prev = scaleLo * lo[k] - Daub4_lift_predict2 * scaleHi * hiPrev[k];
+            const float e1k = scaleHi * hi[k];
+            o1[k] = scaleLo * loNext[k] - Daub4_lift_predict2 * e1k;
+            e[k] = e1k + Daub4_lift_update0 * o1[k] + Daub4_lift_update1 * o1Prev;
+        }
+    }
+
+    const T * const hiNext = hiRow(row + 1);
+    const T * const loNext2 = loRow(row + 2);
+    T * const dstEven = dst + 2 * row * width;
+    // an odd last row is computed and discarded
+    const bool oddRow = 2 * row + 1 < dstheight;
+    int k = 0;
+#ifdef __SSE2__
+    const vfloat scaleLov = F2V(scaleLo);
+    const vfloat scaleHiv = F2V(scaleHi);
+    const vfloat predict1v = F2V(Daub4_lift_predict1);
+    const vfloat update0v = F2V(Daub4_lift_update0);
+    const vfloat update1v = F2V(Daub4_lift_update1);
+    const vfloat predict2v = F2V(Daub4_lift_predict2);
+    const vfloat blendv = F2V(blend);
+    const vfloat srcFactorv = F2V(srcFactor);
+
+    for (; k < width - 3; k += 4) {
+        const vfloat e1v = scaleHiv * LVFU(hiNext[k]);
+        const vfloat o1v = scaleLov * LVFU(loNext2[k]) - predict2v * e1v;
+        const vfloat ev = e1v + update0v * o1v + update1v * LVFU(o1[k]);
+        STVFU(dstEven[k], LVFU(dstEven[k]) * srcFactorv + blendv * LVFU(e[k]));
+
+        if (oddRow) {
+            STVFU(dstEven[width + k], LVFU(dstEven[width + k]) * srcFactorv + blendv * (LVFU(o1[k]) - predict1v * ev));
+        }
+
+        STVFU(o1[k], o1v);
+        STVFU(e[k], ev);
+    }
+
+#endif
+
+    for (; k < width; k++) {
+        const float e1k = scaleHi * hiNext[k];
+        const float o1k = scaleLo * loNext2[k] - Daub4_lift_predict2 * e1k;
+        const float ek = e1k + Daub4_lift_update0 * o1k + Daub4_lift_update1 * o1[k];
+        dstEven[k] = dstEven[k] * srcFactor + blend * e[k];
+
+        if (oddRow) {
+            dstEven[width + k] = dstEven[width + k] * srcFactor + blend * (o1[k] - Daub4_lift_predict1 * ek);
+        }
+
+        o1[k] = o1k;
+        e[k] = ek;
+    }
+}
+
+template<typename T> template<typename E> void wavelet_level<T>::decompose_lifting(E *src, E *dst)
+{
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(numThreads) if(numThreads>1)
+#endif
+    {
+        // the vertical steps carry lifted rows from one output row to the next, each thread processes a band of consecutive rows
+#ifdef _OPENMP
+        const int numBands = omp_get_num_threads();
+        const int band = omp_get_thread_num();
+#else
+        const int numBands = 1;
+        const int band = 0;
+#endif
+        const int rowBegin = m_h2 * band / numBands;
+        const int rowEnd = m_h2 * (band + 1) / numBands;
+        T tmpLo[m_w] ALIGNED64;
+        T tmpHi[m_w] ALIGNED64;
+        T o1[m_w] ALIGNED64;
+        T e1[m_w] ALIGNED64;
+        T bufE[m_w2 + 2] ALIGNED64;
+        T bufO[m_w2 + 2] ALIGNED64;
+
+        for (int row = rowBegin; row < rowEnd; row++) {
+            AnalysisLiftingVertical (src, tmpLo, tmpHi, o1, e1, m_w, m_h, row, row == rowBegin);
+            AnalysisLiftingHorizontal (tmpLo, dst, wavcoeffs[1], bufE, bufO, m_w, m_w2, row);
+            AnalysisLiftingHorizontal (tmpHi, wavcoeffs[2], wavcoeffs[3], bufE, bufO, m_w, m_w2, row);
+        }
+    }
+}
+
+template<typename T> template<typename E> void wavelet_level<T>::reconstruct_lifting(E* tmpLo, E* tmpHi, E * src, E *dst, const float blend)
+{
+    SynthesisLiftingHorizontal (wavcoeffs[2], wavcoeffs[3], tmpHi, m_w2, m_w, m_h2);
+    SynthesisLiftingHorizontal (src, wavcoeffs[1], tmpLo, m_w2, m_w, m_h2);
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(numThreads) if(numThreads>1)
+#endif
+    {
+#ifdef _OPENMP
+        const int numBands = omp_get_num_threads();
+        const int band = omp_get_thread_num();
+#else
+        const int numBands = 1;
+        const int band = 0;
+#endif
+        const int rowBegin = m_h2 * band / numBands;
+        const int rowEnd = m_h2 * (band + 1) / numBands;
+        T o1[m_w] ALIGNED64;
+        T e[m_w] ALIGNED64;
+
+        for (int row = rowBegin; row < rowEnd; row++) {
+            SynthesisLiftingVertical (tmpLo, tmpHi, dst, o1, e, m_w, m_h2, m_h, row, row == rowBegin, blend);
+        }
+    }
+}
+
 #ifdef __SSE2__
 template<typename T> template<typename E> void wavelet_level<T>::decompose_level(E *src, E *dst, float *filterV, float *filterH, int taps, int offset)
 {
+    if (useLifting(taps)) {
+        decompose_lifting(src, dst);
+        return;
+    }
 
     /* filter along rows and columns */
     float filterVarray[2 * taps][4] ALIGNED64;
@@ -675,6 +1220,10 @@ template<typename T> template<typename E> void wavelet_level<T>::decompose_level
 #else
 template<typename T> template<typename E> void wavelet_level<T>::decompose_level(E *src, E *dst, float *filterV, float *filterH, int taps, int offset)
 {
+    if (useLifting(taps)) {
+        decompose_lifting(src, dst);
+        return;
+    }
 
 #ifdef _OPENMP
     #pragma omp parallel num_threads(numThreads) if(numThreads>1)
@@ -718,6 +1267,11 @@ template<typename T> template<typename E> void wavelet_level<T>::reconstruct_lev
         return;
     }
 
+    if (useLifting(taps)) {
+        reconstruct_lifting(tmpLo, tmpHi, src, dst, blend);
+        return;
+    }
+
     /* filter along rows and columns */
     if (subsamp_out) {
         float filterVarray[2 * taps][4] ALIGNED64;
@@ -744,6 +1298,11 @@ template<typename T> template<typename E> void wavelet_level<T>::reconstruct_lev
         return;
     }
 
+    if (useLifting(taps)) {
+        reconstruct_lifting(tmpLo, tmpHi, src, dst, blend);
+        return;
+    }
+
     /* filter along rows and columns */
     if (subsamp_out) {
         SynthesisFilterSubsampHorizontal (wavcoeffs[2], wavcoeffs[3], tmpHi, filterH, filterH + taps, taps, offset, m_w2, m_w, m_h2);
@@ -26,12 +26,17 @@
 /*RT*/#include <omp.h>
 /*RT*/#endif
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 #include "opthelper.h"
 //#define BENCHMARK
 #include "StopWatch.h"
+#include "rawunpack.h"
+#include "settings.h"
 #include "utils.h"
 #include <zlib.h>
 #include <stdint.h>
@@ -837,6 +842,13 @@ struct jhead {
 };
 
 int CLASS ljpeg_start (struct jhead *jh, int info_only)
+{
+  if (!ljpeg_start (jh, info_only, ifp)) return 0;
+  if (!info_only) zero_after_ff = 1;
+  return 1;
+}
+
+int CLASS ljpeg_start (struct jhead *jh, int info_only, IMFILE *ifp)
 {
   ushort c, tag, len;
   uchar data[0x10000];
@@ -890,7 +902,7 @@ int CLASS ljpeg_start (struct jhead *jh, int info_only)
   }
   jh->row = (ushort *) calloc (2 * jh->wide*jh->clrs, 4);
   merror (jh->row, "ljpeg_start()");
-  return zero_after_ff = 1;
+  return 1;
 }
 
 void CLASS ljpeg_end (struct jhead *jh)
@@ -901,6 +913,11 @@ void CLASS ljpeg_end (struct jhead *jh)
 }
 
 inline int CLASS ljpeg_diff (ushort *huff)
+{
+  return ljpeg_diff (huff, getbithuff);
+}
+
+inline int CLASS ljpeg_diff (ushort *huff, getbithuff_t &getbithuff)
 {
   int len, diff;
 
@@ -914,6 +931,17 @@ inline int CLASS ljpeg_diff (ushort *huff)
 }
 
 ushort * CLASS ljpeg_row (int jrow, struct jhead *jh)
+{
+  unsigned errors = 0;
+  ushort *row = ljpeg_row (jrow, jh, ifp, getbithuff, errors);
+  if (errors) {
+    derror();
+    data_error += errors - 1;
+  }
+  return row;
+}
+
+ushort * CLASS ljpeg_row (int jrow, struct jhead *jh, IMFILE *ifp, getbithuff_t &getbithuff, unsigned &errors)
 {
   int col, c, diff, pred, spred=0;
   ushort mark=0, *row[3];
@@ -930,7 +958,7 @@ ushort * CLASS ljpeg_row (int jrow, struct jhead *jh)
   FORC3 row[c] = (jh->row + ((jrow & 1) + 1) * (jh->wide*jh->clrs*((jrow+c) & 1)));
   for (col=0; col < jh->wide; col++)
     FORC(jh->clrs) {
-      diff = ljpeg_diff (jh->huff[c]);
+      diff = ljpeg_diff (jh->huff[c], getbithuff);
       if (jh->sraw && c <= jh->sraw && (col | c))
 		    pred = spred;
       else if (col) pred = row[0][-jh->clrs];
@@ -944,62 +972,218 @@ ushort * CLASS ljpeg_row (int jrow, struct jhead *jh)
 	case 7: pred = (pred + row[1][0]) >> 1;				break;
 	default: pred = 0;
       }
-      if (UNLIKELY((**row = pred + diff) >> jh->bits)) derror();
+      errors += UNLIKELY((**row = pred + diff) >> jh->bits) != 0;
       if (c <= jh->sraw) spred = **row;
       row[0]++; row[1]++;
     }
   return row[2];
 }
 
+/*
+   Decodes the rows [0, rows) of an image stored as a single Huffman-coded
+   stream (see rawrestartindex.h). When the file has a restart index, the
+   row ranges between its points are decoded in parallel, with per-thread
+   copies of the file and bit readers created by makeReader. Otherwise, or
+   if a range does not end in the state recorded for the next one, the rows
+   are decoded serially with reader, and the index is recorded.
+   decodeRows (reader, vpred, rowBegin, rowEnd, points) decodes a range of
+   rows, recording the restart points in points if it is not null. The errors
+   of an inconsistent parallel pass are dropped from data_error.
+ */
+template<class Reader, class MakeReader, class DecodeRows>
+void restart_index_decode (IMFILE *ifp, const char *ifname, const std::string &decoder, int rows, const unsigned short (&vpred)[2][2],
+                           Reader &reader, MakeReader makeReader, DecodeRows decodeRows, unsigned &data_error)
+{
+  std::vector<rtengine::RawRestartPoint> points;
+
+  if (rtengine::loadRawRestartIndex (ifname, decoder.c_str(), rows, ifp->size, points) && reader.hasState (points.front())) {
+    bool consistent = true;
+    const unsigned errorsBefore = data_error;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+{
+    IMFILE ifpthr = *ifp;
+    IMFILE *ifpptr = &ifpthr;
+    unsigned zero_after_ff_thr = 0;
+    Reader readerthr = makeReader (ifpptr, zero_after_ff_thr);
+    ifpthr.plistener = nullptr;
+#ifdef _OPENMP
+    #pragma omp master
+#endif
+    ifpthr.plistener = ifp->plistener;
+
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic) reduction(&&:consistent)
+#endif
+    for (size_t i = 0; i < points.size() - 1; i++) {
+      unsigned short vpredthr[2][2];
+      memcpy (vpredthr, points[i].vpred, sizeof vpredthr);
+      readerthr.restoreState (points[i]);
+      decodeRows (readerthr, vpredthr, points[i].row, points[i+1].row, nullptr);
+      consistent = consistent && readerthr.hasState (points[i+1]) && !memcmp (vpredthr, points[i+1].vpred, sizeof vpredthr);
+    }
+}
+    if (consistent) return;
+    if (rtengine::settings->verbose)
+      printf ("%s: the restart index does not match, decoding serially\n", ifname);
+    data_error = errorsBefore;
+    reader.restoreState (points.front());
+  }
+
+  unsigned short vpredser[2][2];
+  memcpy (vpredser, vpred, sizeof vpredser);
+  points.clear();
+  decodeRows (reader, vpredser, 0, rows, &points);
+  rtengine::RawRestartPoint last;
+  memset (&last, 0, sizeof last); // no uninitialized padding in the index file
+  last.row = rows;
+  reader.saveState (last);
+  memcpy (last.vpred, vpredser, sizeof last.vpred);
+  points.push_back (last);
+  if (!data_error)
+    rtengine::saveRawRestartIndex (ifname, decoder.c_str(), points);
+}
+
+template<class Reader>
+inline rtengine::RawRestartPoint restart_point (int row, const Reader &reader, const unsigned short (&vpred)[2][2])
+{
+  rtengine::RawRestartPoint point;
+  memset (&point, 0, sizeof point); // no uninitialized padding in the index file
+  point.row = row;
+  reader.saveState (point);
+  memcpy (point.vpred, vpred, sizeof point.vpred);
+  return point;
+}
+
 void CLASS lossless_jpeg_load_raw()
 {
   struct jhead jh;
-  int row=0, col=0;
 
   if (!ljpeg_start (&jh, 0)) return;
-  int jwide = jh.wide * jh.clrs;
-  ushort *rp[2];
-  rp[0] = ljpeg_row (0, &jh);
-
-  for (int jrow=0; jrow < jh.high; jrow++) {
+  const int jwide = jh.wide * jh.clrs;
+  ushort *jimage = (ushort *) malloc ((size_t) jh.high * jwide * sizeof *jimage);
+  merror (jimage, "lossless_jpeg_load_raw()");
+
+  // rows of the first predictor only depend on the previous pixel, they can be decoded from any restart point.
+  // The ranges are decoded concurrently, the errors are counted per range and summed (derror() is not thread safe)
+  const auto decodeRows = [&](getbithuff_t &getbithuff, ushort (&vpred)[2][2], int rowBegin, int rowEnd, std::vector<rtengine::RawRestartPoint> *points) {
+    unsigned errors = 0;
+    const unsigned readerErrors = getbithuff.errorCount();
+    for (int jrow=rowBegin; jrow < rowEnd; jrow++) {
+      if (points && jrow % rtengine::rowsPerRestartPoint == 0)
+        points->push_back (restart_point (jrow, getbithuff, vpred));
+      ushort *rp = jimage + (size_t) jrow * jwide;
+      for (int jcol=0; jcol < jwide; jcol++) {
+        const int c = jcol % jh.clrs;
+        const int diff = ljpeg_diff (jh.huff[c], getbithuff);
+        const int pred = jcol >= jh.clrs ? rp[jcol - jh.clrs] : (vpred[c >> 1][c & 1] += diff) - diff;
+        errors += UNLIKELY((rp[jcol] = pred + diff) >> jh.bits) != 0;
+      }
+    }
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
+    data_error += errors + getbithuff.errorCount() - readerErrors;
+  };
+  const bool firstPredictor = jh.psv == 1 && jh.clrs <= 4 && !jh.sraw;
+  bool decoded = false;
+
+  if (firstPredictor && jh.restart < INT_MAX && jh.restart % jh.wide == 0) {
+    // the restart markers split the scan into segments of whole rows, find them all before decoding
+    const int segmentRows = jh.restart / jh.wide;
+    const size_t count = (jh.high + segmentRows - 1) / segmentRows;
+    std::vector<INT64> segments (1, ftell(ifp));
+    for (INT64 pos = segments[0]; segments.size() < count && pos < ifp->size - 1; ) {
+      const char *mark = (const char *) memchr (ifp->data + pos, 0xff, ifp->size - 1 - pos);
+      if (!mark) break;
+      pos = mark - ifp->data + 1;
+      if (((uchar) ifp->data[pos] & 0xf8) == 0xd0)
+        segments.push_back (++pos);
+    }
+    if (segments.size() == count) {
 #ifdef _OPENMP
-#pragma omp parallel sections
+#pragma omp parallel
 #endif
 {
+      // per-thread copy of the file and bit reader, only the master thread updates the progress bar
+      IMFILE ifpthr = *ifp;
+      IMFILE *ifpptr = &ifpthr;
+      unsigned zero_after_ff_thr = 1;
+      getbithuff_t getbithuff(nullptr, ifpptr, zero_after_ff_thr);
+      ifpthr.plistener = nullptr;
 #ifdef _OPENMP
-    #pragma omp section
+      #pragma omp master
 #endif
-    {
-        if(jrow < jh.high - 1)
-            rp[(jrow + 1)&1] = ljpeg_row (jrow + 1, &jh);
-    }
+      ifpthr.plistener = ifp->plistener;
+
 #ifdef _OPENMP
-     #pragma omp section
+      #pragma omp for schedule(dynamic)
 #endif
-    {
-    if (load_flags & 1)
-      row = jrow & 1 ? height-1-jrow/2 : jrow/2;
-    for (int jcol=0; jcol < jwide; jcol++) {
-      int val = curve[*rp[jrow&1]++];
-      if (cr2_slice[0]) {
-	int jidx = jrow*jwide + jcol;
-	int i = jidx / (cr2_slice[1]*raw_height);
-	int j;
-	if ((j = i >= cr2_slice[0]))
-		 i  = cr2_slice[0];
-	jidx -= i * (cr2_slice[1]*raw_height);
-	row = jidx / cr2_slice[1+j];
-	col = jidx % cr2_slice[1+j] + i*cr2_slice[1];
+      for (size_t s = 0; s < count; s++) {
+        ushort vpred[2][2];
+        for (int c=0; c < 4; c++) vpred[c >> 1][c & 1] = 1 << (jh.bits-1);
+        fseek (&ifpthr, segments[s], SEEK_SET);
+        getbits(-1);
+        decodeRows (getbithuff, vpred, s * segmentRows, MIN((s + 1) * segmentRows, (size_t) jh.high), nullptr);
       }
-      if (raw_width == 3984 && (col -= 2) < 0)
-	col += (row--,raw_width);
-      if ((unsigned) row < raw_height) RAW(row,col) = val;
-      if (++col >= raw_width)
-	col = (row++,0);
+}
+      decoded = true;
     }
+  } else if (firstPredictor && jh.restart == INT_MAX) {
+    // a single stream, the restart index records the state of the decoder every few rows
+    ushort vpred[2][2];
+    for (int c=0; c < 4; c++) vpred[c >> 1][c & 1] = 1 << (jh.bits-1);
+    getbits(-1);
+    const auto makeReader = [this](IMFILE *&file, unsigned &zero) {
+      zero = zero_after_ff;
+      return getbithuff_t (nullptr, file, zero);
+    };
+    const std::string decoder = "ljpeg-" + std::to_string (ftell(ifp)) + "-" + std::to_string (jwide) + "-" + std::to_string (jh.high) + "-" + std::to_string (jh.bits);
+    restart_index_decode (ifp, ifname, decoder, jh.high, vpred, getbithuff, makeReader, decodeRows, data_error);
+    decoded = true;
+  }
+  if (!decoded)
+    for (int jrow=0; jrow < jh.high; jrow++)
+      memcpy (jimage + (size_t) jrow * jwide, ljpeg_row (jrow, &jh), jwide * sizeof *jimage);
+
+  if (cr2_slice[0] || (!(load_flags & 1) && raw_width != 3984)) {
+    // each slice is a contiguous run of raw_height rows of the scan, copy them row by row
+    const INT64 total = (INT64) jh.high * jwide;
+    const INT64 rawsize = (INT64) raw_height * raw_width;
+    const int slices = cr2_slice[0] ? cr2_slice[0] + 1 : 1;
+    const int shift = cr2_slice[0] && raw_width == 3984 ? 2 : 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,16)
+#endif
+    for (int row=0; row < raw_height; row++)
+      for (int i=0; i < slices; i++) {
+        const int w = cr2_slice[0] ? cr2_slice[1 + (i >= cr2_slice[0])] : raw_width;
+        const INT64 src = (INT64) i * cr2_slice[1] * raw_height + (INT64) row * w;
+        const INT64 dst = (INT64) row * raw_width + i * cr2_slice[1] - shift;
+        const ushort *in = jimage + src;
+        ushort *out = raw_image + dst;
+        const INT64 end = std::min<INT64> ({w, total - src, rawsize - dst});
+        for (INT64 k = std::max<INT64> (0, -dst); k < end; k++)
+          out[k] = curve[in[k]];
+      }
+  } else {
+    int row=0, col=0;
+    for (int jrow=0; jrow < jh.high; jrow++) {
+      const ushort *rp = jimage + (size_t) jrow * jwide;
+      if (load_flags & 1)
+        row = jrow & 1 ? height-1-jrow/2 : jrow/2;
+      for (int jcol=0; jcol < jwide; jcol++) {
+        const int val = curve[*rp++];
+        if (raw_width == 3984 && (col -= 2) < 0)
+          col += (row--,raw_width);
+        if ((unsigned) row < raw_height) RAW(row,col) = val;
+        if (++col >= raw_width)
+          col = (row++,0);
+      }
     }
-}
   }
+  free (jimage);
   ljpeg_end (&jh);
 }
 
@@ -1095,20 +1279,28 @@ void CLASS adobe_copy_pixel (unsigned row, unsigned col, ushort **rp)
 }
 
 void CLASS ljpeg_idct (struct jhead *jh)
+{
+  ljpeg_idct (jh, getbithuff);
+}
+
+void CLASS ljpeg_idct (struct jhead *jh, getbithuff_t &getbithuff)
 {
   int c, i, j, len, skip, coef;
   float work[3][8][8];
-  static float cs[106] = { 0 };
+  // initialized once, the tiles can be decoded concurrently
+  static const std::array<float, 106> cs = []() {
+    std::array<float, 106> table;
+    for (int n = 0; n < 106; ++n) table[n] = cos((n & 31)*rtengine::RT_PI/16)/2;
+    return table;
+  }();
   static const uchar zigzag[80] =
   {  0, 1, 8,16, 9, 2, 3,10,17,24,32,25,18,11, 4, 5,12,19,26,33,
     40,48,41,34,27,20,13, 6, 7,14,21,28,35,42,49,56,57,50,43,36,
     29,22,15,23,30,37,44,51,58,59,52,45,38,31,39,46,53,60,61,54,
     47,55,62,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63 };
 
-  if (!cs[0])
-    FORC(106) cs[c] = cos((c & 31)*rtengine::RT_PI/16)/2;
   memset (work, 0, sizeof work);
-  work[0][0][0] = jh->vpred[0] += ljpeg_diff (jh->huff[0]) * jh->quant[0];
+  work[0][0][0] = jh->vpred[0] += ljpeg_diff (jh->huff[0], getbithuff) * jh->quant[0];
   for (i=1; i < 64; i++ ) {
     len = gethuff (jh->huff[16]);
     i += skip = len >> 4;
@@ -1187,15 +1379,49 @@ void CLASS lossless_dnglj92_load_raw()
 
 void CLASS lossless_dng_load_raw()
 {
-  unsigned save, trow=0, tcol=0, jwide, jrow, jcol, row, col, i, j;
-  struct jhead jh;
-  ushort *rp;
+  struct tile { unsigned offset, trow, tcol; };
+  std::vector<tile> tiles;
+  unsigned trow=0, tcol=0;
 
+  // collect the tiles first, each one is a complete lossless JPEG stream
   while (trow < raw_height) {
-    save = ftell(ifp);
-    if (tile_length < INT_MAX)
-      fseek (ifp, get4(), SEEK_SET);
-    if (!ljpeg_start (&jh, 0)) break;
+    const unsigned save = ftell(ifp);
+    tiles.push_back ({tile_length < INT_MAX ? get4() : save, trow, tcol});
+    fseek (ifp, save+4, SEEK_SET);
+    if ((tcol += tile_width) >= raw_width)
+      trow += tile_length + (tcol = 0);
+  }
+  if (tiles.empty()) return;
+  unsigned errors = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(std::min<int>(tiles.size(), omp_get_max_threads()))
+#endif
+{
+  // per-thread copy of the file and bit reader, only the master thread updates the progress bar.
+  // The errors are counted per thread and summed (derror() is not thread safe)
+  IMFILE ifpthr = *ifp;
+  IMFILE *ifpptr = &ifpthr;
+  unsigned zero_after_ff_thr = 1;
+  unsigned errorsthr = 0;
+  getbithuff_t getbithuff(nullptr, ifpptr, zero_after_ff_thr);
+  ifpthr.plistener = nullptr;
+#ifdef _OPENMP
+  #pragma omp master
+#endif
+  ifpthr.plistener = ifp->plistener;
+
+#ifdef _OPENMP
+  #pragma omp for schedule(dynamic)
+#endif
+  for (size_t t = 0; t < tiles.size(); t++) {
+    unsigned jwide, jrow, jcol, row, col, i, j;
+    struct jhead jh;
+    ushort *rp;
+
+    fseek (&ifpthr, tiles[t].offset, SEEK_SET);
+    if (!ljpeg_start (&jh, 0, &ifpthr)) continue;
+    const unsigned trow = tiles[t].trow, tcol = tiles[t].tcol;
     jwide = jh.wide;
     if (filters || (colors == 1 && jh.clrs > 1)) jwide *= jh.clrs;
     jwide /= MIN (is_raw, tiff_samples);
@@ -1205,7 +1431,7 @@ void CLASS lossless_dng_load_raw()
 	getbits(-1);
 	for (jrow=0; jrow+7 < jh.high; jrow += 8) {
 	  for (jcol=0; jcol+7 < jh.wide; jcol += 8) {
-	    ljpeg_idct (&jh);
+	    ljpeg_idct (&jh, getbithuff);
 	    rp = jh.idct;
 	    row = trow + jcol/tile_width + jrow*2;
 	    col = tcol + jcol%tile_width;
@@ -1217,18 +1443,24 @@ void CLASS lossless_dng_load_raw()
 	break;
       case 0xc3:
 	for (row=col=jrow=0; jrow < jh.high; jrow++) {
-	  rp = ljpeg_row (jrow, &jh);
+	  rp = ljpeg_row (jrow, &jh, &ifpthr, getbithuff, errorsthr);
 	  for (jcol=0; jcol < jwide; jcol++) {
 	    adobe_copy_pixel (trow+row, tcol+col, &rp);
 	    if (++col >= tile_width || col >= raw_width)
 	      row += 1 + (col = 0);
 	  }
 	}    }
-    fseek (ifp, save+4, SEEK_SET);
-    if ((tcol += tile_width) >= raw_width)
-      trow += tile_length + (tcol = 0);
     ljpeg_end (&jh);
   }
+#ifdef _OPENMP
+  #pragma omp atomic
+#endif
+  errors += errorsthr + getbithuff.errorCount();
+}
+  if (errors) {
+    fprintf (stderr, "%s: decoded with %u errors. File possibly corrupted.\n", ifname, errors);
+    data_error += errors;
+  }
 }
 
 static uint32_t DNG_HalfToFloat(uint16_t halfValue);
@@ -1240,6 +1472,41 @@ void CLASS packed_dng_load_raw()
   int isfloat = (tiff_nifds == 1 && tiff_ifd[0].sample_format == 3 && (tiff_bps == 16 || tiff_bps == 32));
   if (isfloat) {
     float_raw_image = new float[raw_width * raw_height];
+  } else if (tiff_bps == 16 || (tiff_bps < 16 && !zero_after_ff)) {
+    // each row starts on a byte boundary, the rows are unpacked in place from the file data
+    const INT64 start = ftell(ifp);
+    const INT64 avail = MAX(ifp->size - start, 0);
+    const INT64 rowbytes = ((INT64) raw_width * tiff_samples * tiff_bps + 7) / 8;
+    const bool swap = (order == 0x4949) == (ntohs(0x1234) == 0x1234);
+    // a single sample per pixel goes to the raw image through the curve, adobe_copy_pixel() handles the other layouts
+    const bool direct = raw_image && tiff_samples == 1;
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+      std::vector<ushort> samples (direct ? 0 : raw_width * tiff_samples);
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic,16)
+#endif
+      for (int row=0; row < raw_height; row++) {
+        const INT64 offset = row * rowbytes;
+        if (offset >= avail) continue;
+        const uchar *src = (const uchar *) ifp->data + start + offset;
+        ushort *dst = direct ? raw_image + (size_t) row * raw_width : samples.data();
+        if (tiff_bps == 16)
+          rtengine::rawunpack::unpack16 (src, dst, MIN(raw_width * tiff_samples, (avail - offset) / 2), swap, 0, direct ? curve : nullptr);
+        else
+          rtengine::rawunpack::unpackBits (src, MIN(rowbytes, avail - offset), dst, raw_width * tiff_samples, tiff_bps,
+                                           rtengine::rawunpack::BitOrder::MSB, 1, direct ? curve : nullptr);
+        if (!direct) {
+          ushort *sp = samples.data();
+          for (int col=0; col < raw_width; col++)
+            adobe_copy_pixel (row, col, &sp);
+        }
+      }
+    }
+    if (avail < rowbytes * raw_height) derror();
+    return;
   }
 
   pixel = (ushort *) calloc (raw_width, tiff_samples*sizeof *pixel);
@@ -1278,8 +1545,8 @@ void CLASS packed_dng_load_raw()
 void CLASS pentax_load_raw()
 {
   ushort bit[2][15], huff[4097];
-  int dep, row, col, diff, c, i;
-  ushort vpred[2][2] = {{0,0},{0,0}}, hpred[2];
+  int dep, c, i;
+  ushort vpred[2][2] = {{0,0},{0,0}};
 
   fseek (ifp, meta_offset, SEEK_SET);
   dep = (get2() + 12) & 15;
@@ -1292,14 +1559,36 @@ void CLASS pentax_load_raw()
   huff[0] = 12;
   fseek (ifp, data_offset, SEEK_SET);
   getbits(-1);
-  for (row=0; row < raw_height; row++)
-    for (col=0; col < raw_width; col++) {
-      diff = ljpeg_diff (huff);
-      if (col < 2) hpred[col] = vpred[row & 1][col] += diff;
-      else	   hpred[col & 1] += diff;
-      RAW(row,col) = hpred[col & 1];
-      if (hpred[col & 1] >> tiff_bps) derror();
+
+  // the ranges are decoded concurrently, the errors are counted per range and summed (derror() is not thread safe)
+  const auto decodeRows = [&](getbithuff_t &getbithuff, ushort (&vpred)[2][2], int rowBegin, int rowEnd, std::vector<rtengine::RawRestartPoint> *points) {
+    ushort hpred[2];
+    unsigned errors = 0;
+    const unsigned readerErrors = getbithuff.errorCount();
+    for (int row=rowBegin; row < rowEnd; row++) {
+      if (points && row % rtengine::rowsPerRestartPoint == 0)
+        points->push_back (restart_point (row, getbithuff, vpred));
+      for (int col=0; col < raw_width; col++) {
+        const int diff = ljpeg_diff (huff, getbithuff);
+        if (col < 2) hpred[col] = vpred[row & 1][col] += diff;
+        else	   hpred[col & 1] += diff;
+        RAW(row,col) = hpred[col & 1];
+        errors += hpred[col & 1] >> tiff_bps != 0;
+      }
     }
+#ifdef _OPENMP
+    #pragma omp atomic
+#endif
+    data_error += errors + getbithuff.errorCount() - readerErrors;
+  };
+  const auto makeReader = [this](IMFILE *&file, unsigned &zero) {
+    zero = zero_after_ff;
+    return getbithuff_t (nullptr, file, zero);
+  };
+  const std::string decoder = "pentax-" + std::to_string (data_offset) + "-" + std::to_string (raw_width) + "-" + std::to_string (tiff_bps);
+  restart_index_decode (ifp, ifname, decoder, raw_height, vpred, getbithuff, makeReader, decodeRows, data_error);
+  if (data_error)
+    fprintf (stderr, "%s: decoded with %u errors. File possibly corrupted.\n", ifname, data_error);
 }
 
 void CLASS nikon_load_raw()
@@ -1317,7 +1606,7 @@ void CLASS nikon_load_raw()
         8,0x5c,0x4b,0x3a,0x29,7,6,5,4,3,2,1,0,13,14 },
       { 0,1,4,2,2,3,1,2,0,0,0,0,0,0,0,0,	/* 14-bit lossless */
         7,6,8,5,9,4,10,3,11,12,2,0,1,13,14 } };
-    ushort *huff, ver0, ver1, vpred[2][2], hpred[2], csize;
+    ushort *huff, ver0, ver1, vpred[2][2], csize;
     int max, step=0, tree=0, split=0;
 
     fseek (ifp, meta_offset, SEEK_SET);
@@ -1350,52 +1639,69 @@ void CLASS nikon_load_raw()
         curve[i] = curve[0];
 
     huff = make_decoder (nikon_tree[tree]);
+    ushort *huffSplit = split ? make_decoder (nikon_tree[tree+1]) : nullptr;
     fseek (ifp, data_offset, SEEK_SET);
     nikinit();
-    if (split) {
-        for (int min = 0, row = 0; row < height; row++) {
-            if (row == split) {
-                free (huff);
-                huff = make_decoder (nikon_tree[tree+1]);
-                max += (min = 16) << 1;
-            }
-            for (int col=0; col < raw_width; col++) {
-                int i = nikhuff(huff);
-                int len = i & 15;
-                int shl = i >> 4;
-                int diff = ((nikbits(len-shl) << 1) + 1) << shl >> 1;
-                if ((diff & (1 << (len-1))) == 0)
-                    diff -= (1 << len) - !shl;
-                if (col < 2) hpred[col] = vpred[row & 1][col] += diff;
-                else	     hpred[col & 1] += diff;
-                derror((ushort)(hpred[col & 1] + min) >= max);
-                RAW(row,col) = curve[hpred[col & 1]];
-            }
-        }
-    } else {
-        for (int row=0; row < height; row++) {
-            for (int col=0; col < 2; col++) {
-                int len = nikhuff(huff);
-                int diff = nikbits(len);
-                if ((diff & (1 << (len-1))) == 0)
-                    diff -= (1 << len) - 1;
-                hpred[col] = vpred[row & 1][col] += diff;
-                derror(hpred[col] >= max);
-                RAW(row,col) = curve[hpred[col]];
+
+    // the ranges are decoded concurrently, the errors are counted per range and summed (derror() is not thread safe)
+    const auto decodeRows = [&](nikbithuff_t &nikbithuff, ushort (&vpred)[2][2], int rowBegin, int rowEnd, std::vector<rtengine::RawRestartPoint> *points) {
+        ushort hpred[2];
+        unsigned errors = 0;
+        const unsigned readerErrors = nikbithuff.errorCount();
+        for (int row = rowBegin; row < rowEnd; row++) {
+            if (points && row % rtengine::rowsPerRestartPoint == 0) {
+                points->push_back (restart_point (row, nikbithuff, vpred));
             }
-            for (int col=2; col < raw_width; col++) {
-                int len = nikhuff(huff);
-                int diff = nikbits(len);
-                if ((diff & (1 << (len-1))) == 0)
-                    diff -= (1 << len) - 1;
-                hpred[col & 1] += diff;
-                derror(hpred[col & 1] >= max);
-                RAW(row,col) = curve[hpred[col & 1]];
+            if (split) {
+                // the rows from split on use another tree
+                ushort *rowHuff = row < split ? huff : huffSplit;
+                const int min = row < split ? 0 : 16;
+                const int rowMax = row < split ? max : max + 32;
+                for (int col=0; col < raw_width; col++) {
+                    int i = nikhuff(rowHuff);
+                    int len = i & 15;
+                    int shl = i >> 4;
+                    int diff = ((nikbits(len-shl) << 1) + 1) << shl >> 1;
+                    if ((diff & (1 << (len-1))) == 0)
+                        diff -= (1 << len) - !shl;
+                    if (col < 2) hpred[col] = vpred[row & 1][col] += diff;
+                    else	     hpred[col & 1] += diff;
+                    errors += (ushort)(hpred[col & 1] + min) >= rowMax;
+                    RAW(row,col) = curve[hpred[col & 1]];
+                }
+            } else {
+                for (int col=0; col < 2; col++) {
+                    int len = nikhuff(huff);
+                    int diff = nikbits(len);
+                    if ((diff & (1 << (len-1))) == 0)
+                        diff -= (1 << len) - 1;
+                    hpred[col] = vpred[row & 1][col] += diff;
+                    errors += hpred[col] >= max;
+                    RAW(row,col) = curve[hpred[col]];
+                }
+                for (int col=2; col < raw_width; col++) {
+                    int len = nikhuff(huff);
+                    int diff = nikbits(len);
+                    if ((diff & (1 << (len-1))) == 0)
+                        diff -= (1 << len) - 1;
+                    hpred[col & 1] += diff;
+                    errors += hpred[col & 1] >= max;
+                    RAW(row,col) = curve[hpred[col & 1]];
+                }
             }
         }
-    }
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        data_error += errors + nikbithuff.errorCount() - readerErrors;
+    };
+    const auto makeReader = [](IMFILE *&file, unsigned &) {
+        return nikbithuff_t (file);
+    };
+    const std::string decoder = "nikon-" + std::to_string (data_offset) + "-" + std::to_string (raw_width) + "-" + std::to_string (tree) + "-" + std::to_string (split);
+    restart_index_decode (ifp, ifname, decoder, height, vpred, nikbithuff, makeReader, decodeRows, data_error);
     free (huff);
-    data_error += nikbithuff.errorCount();
+    free (huffSplit);
     if(data_error) {
         std::cerr << ifname << " decoded with " << data_error << " errors. File possibly corrupted." << std::endl;
     }
@@ -2506,22 +2812,33 @@ void CLASS leaf_hdr_load_raw()
 
 void CLASS unpacked_load_raw()
 {
-  int row, col, bits=0;
+  int bits=0;
 
   while (1 << ++bits < maximum);
-  read_shorts (raw_image, raw_width*raw_height);
-  if (load_flags) {
-      for (row=0; row < raw_height; row++)
-        for (col=0; col < raw_width; col++)
-          if ((RAW(row,col) >>= load_flags) >> bits
-        && (unsigned) (row-top_margin) < height
-        && (unsigned) (col-left_margin) < width) derror();
-  } else if (bits < 16) {
-      for (row=0; row < raw_height; row++)
-        for (col=0; col < raw_width; col++)
-          if (RAW(row,col) >> bits
-        && (unsigned) (row-top_margin) < height
-        && (unsigned) (col-left_margin) < width) derror();
+  // the rows are unpacked and checked in place from the file data
+  const INT64 start = ftell(ifp);
+  const INT64 avail = MAX(ifp->size - start, 0);
+  const INT64 rowbytes = raw_width * 2;
+  const bool swap = (order == 0x4949) == (ntohs(0x1234) == 0x1234);
+  const bool check = load_flags || bits < 16;
+  unsigned errors = avail < rowbytes * raw_height;
+
+#ifdef _OPENMP
+  #pragma omp parallel for reduction(+:errors) schedule(dynamic,16)
+#endif
+  for (int row=0; row < raw_height; row++) {
+    const INT64 offset = row * rowbytes;
+    if (offset >= avail) continue;
+    const int count = MIN(raw_width, (avail - offset) / 2);
+    ushort *rp = raw_image + (size_t) row * raw_width;
+    rtengine::rawunpack::unpack16 ((const uchar *) ifp->data + start + offset, rp, count, swap, load_flags);
+    if (check && (unsigned) (row-top_margin) < height)
+      for (int col=left_margin; col < MIN(count, left_margin+width); col++)
+        errors += rp[col] >> bits != 0;
+  }
+  if (errors) {
+    derror();
+    data_error += errors - 1;
   }
 }
 
@@ -2612,6 +2929,34 @@ void CLASS packed_load_raw()
   if (load_flags & 1) bwide = bwide * 16 / 15;
   bite = 8 + (load_flags & 56);
   half = (raw_height+1) >> 1;
+  if (!(load_flags & 3) && rbits >= 0 && bite <= 32 && bwide % (bite / 8) == 0 && tiff_bps <= 16 &&
+      (!(load_flags >> 6 & 3) || raw_width % 4 == 0)) {
+    // each row starts on a word boundary, the rows are unpacked in place from the file data
+    const INT64 start = ftell(ifp);
+    const INT64 avail = MAX(ifp->size - start, 0);
+    const int colxor = load_flags >> 6 & 3;
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+      std::vector<ushort> pixel (colxor ? raw_width : 0);
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic,16)
+#endif
+      for (int row=0; row < raw_height; row++) {
+        const INT64 offset = (INT64) row * bwide;
+        if (offset >= avail) continue;
+        ushort *rp = raw_image + (size_t) row * raw_width;
+        rtengine::rawunpack::unpackBits ((const uchar *) ifp->data + start + offset, MIN(bwide, avail - offset), colxor ? pixel.data() : rp,
+                                         raw_width, tiff_bps, rtengine::rawunpack::BitOrder::MSB, bite / 8);
+        if (colxor)
+          for (int col=0; col < raw_width; col++)
+            rp[col ^ colxor] = pixel[col];
+      }
+    }
+    if (avail < (INT64) bwide * raw_height) derror();
+    return;
+  }
   for (irow=0; irow < raw_height; irow++) {
     row = irow;
     if (load_flags & 2 &&
@@ -3002,12 +3347,8 @@ void CLASS gamma_curve (double pwr, double ts, int mode, int imax);
 
 void CLASS lossy_dng_load_raw()
 {
-  struct jpeg_decompress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  JSAMPARRAY buf;
-  JSAMPLE (*pixel)[3];
   unsigned sorder=order, ntags, opcode, deg, i, j, c;
-  unsigned save=data_offset-4, trow=0, tcol=0, row, col;
+  unsigned save=data_offset-4, trow=0, tcol=0;
   ushort cur[3][256];
   double coeff[9], tot;
 
@@ -3036,31 +3377,52 @@ void CLASS lossy_dng_load_raw()
     gamma_curve (1/2.4, 12.92310, 1, 255);
     FORC3 memcpy (cur[c], curve, sizeof cur[0]);
   }
-  cinfo.err = jpeg_std_error (&jerr);
-  jpeg_create_decompress (&cinfo);
+  struct tile { unsigned offset, trow, tcol; };
+  std::vector<tile> tiles;
+
+  // collect the tiles first, each one is a complete JPEG image
   while (trow < raw_height) {
     fseek (ifp, save+=4, SEEK_SET);
-    if (tile_length < INT_MAX)
-      fseek (ifp, get4(), SEEK_SET);
-    /*RT jpeg_stdio_src (&cinfo, ifp); */
-    /*RT*/jpeg_memory_src(&cinfo, fdata(ftell(ifp), ifp), ifp->size - ftell(ifp));
+    const unsigned offset = tile_length < INT_MAX ? get4() : save;
+    if (offset < ifp->size)
+      tiles.push_back ({offset, trow, tcol});
+    if ((tcol += tile_width) >= raw_width)
+      trow += tile_length + (tcol = 0);
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel if (tiles.size() > 1)
+#endif
+{
+  // per-thread decompressor reading the tiles from the file data
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error (&jerr);
+  jpeg_create_decompress (&cinfo);
+
+#ifdef _OPENMP
+  #pragma omp for schedule(dynamic)
+#endif
+  for (size_t t = 0; t < tiles.size(); t++) {
+    const unsigned trow = tiles[t].trow, tcol = tiles[t].tcol;
+    jpeg_memory_src (&cinfo, fdata(tiles[t].offset, ifp), ifp->size - tiles[t].offset);
     jpeg_read_header (&cinfo, TRUE);
     jpeg_start_decompress (&cinfo);
-    buf = (*cinfo.mem->alloc_sarray)
+    JSAMPARRAY buf = (*cinfo.mem->alloc_sarray)
 	((j_common_ptr) &cinfo, JPOOL_IMAGE, cinfo.output_width*3, 1);
+    unsigned row;
     while (cinfo.output_scanline < cinfo.output_height &&
 	(row = trow + cinfo.output_scanline) < height) {
       jpeg_read_scanlines (&cinfo, buf, 1);
-      pixel = (JSAMPLE (*)[3]) buf[0];
-      for (col=0; col < cinfo.output_width && tcol+col < width; col++) {
-	FORC3 image[row*width+tcol+col][c] = cur[c][pixel[col][c]];
+      JSAMPLE (*pixel)[3] = (JSAMPLE (*)[3]) buf[0];
+      for (unsigned col=0; col < cinfo.output_width && tcol+col < width; col++) {
+	for (int c=0; c < 3; c++) image[row*width+tcol+col][c] = cur[c][pixel[col][c]];
       }
     }
     jpeg_abort_decompress (&cinfo);
-    if ((tcol += tile_width) >= raw_width)
-      trow += tile_length + (tcol = 0);
   }
   jpeg_destroy_decompress (&cinfo);
+}
   maximum = 0xffff;
 }
 /*RT #endif */
@@ -3393,9 +3755,14 @@ void CLASS sony_arw2_load_raw()
 #endif
 
     for (int row = 0; row < height; row++) {
-        fseek(&ifpthr, pos + row * raw_width, SEEK_SET);
-        fread(data, 1, raw_width, &ifpthr);
         uchar *dp = data;
+        if (pos + (INT64)(row + 1) * raw_width < ifpthr.size) {
+            // the row and the byte read past its end are in the file, decode it in place
+            dp = reinterpret_cast<uchar*>(ifpthr.data) + pos + (INT64)row * raw_width;
+        } else {
+            fseek(&ifpthr, pos + row * raw_width, SEEK_SET);
+            fread(data, 1, raw_width, &ifpthr);
+        }
         for (int col = 0; col < raw_width - 30; dp += 16) {
             int val = sget4(dp);
             int max = 0x7ff & val;
@@ -4457,7 +4824,7 @@ void CLASS crop_masked_pixels()
 	  BAYER(r,c) = RAW(row+top_margin,col+left_margin);
       }
     }
-  } else {
+  } else if (image) { // RT: without image the pixels are cropped from raw_image by RawImage::compress_image()
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
@@ -10985,33 +11352,23 @@ it under the terms of the one of two licenses as you choose:
    (See file LICENSE.CDDL provided in LibRaw distribution archive for details).
  */
 
-namespace {
-
-inline void unpack7bytesto4x16_nikon(unsigned char *src, unsigned short *dest)
-{
-    dest[3] = (src[6] << 6) | (src[5] >> 2);
-    dest[2] = ((src[5] & 0x3) << 12) | (src[4] << 4) | (src[3] >> 4);
-    dest[1] = (src[3] & 0xf) << 10 | (src[2] << 2) | (src[1] >> 6);
-    dest[0] = ((src[1] & 0x3f) << 8) | src[0];
-}
-
-} // namespace
-
 void CLASS nikon_14bit_load_raw()
 {
     const unsigned linelen = (unsigned)(ceilf((float)(raw_width * 7 / 4) / 16.0)) * 16; // 14512; // S.raw_width * 7 / 4;
     const unsigned pitch = raw_width; //S.raw_pitch ? S.raw_pitch / 2 : S.raw_width;
-    unsigned char *buf = (unsigned char *)malloc(linelen);
-    merror(buf, "nikon_14bit_load_raw()");
+    // the rows are unpacked in place from the file data
+    const INT64 start = ftell(ifp);
+    const INT64 avail = MAX(ifp->size - start, 0);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,16)
+#endif
     for (int row = 0; row < raw_height; row++)
     {
-        unsigned bytesread = fread(buf, 1, linelen, ifp);
-        unsigned short *dest = &raw_image[pitch * row];
-        //swab32arr((unsigned *)buf, bytesread / 4);
-        for (int sp = 0, dp = 0; dp < pitch - 3 && sp < linelen - 6 && sp < bytesread - 6; sp += 7, dp += 4)
-            unpack7bytesto4x16_nikon(buf + sp, dest + dp);
+        const INT64 offset = (INT64)row * linelen;
+        const unsigned bytesread = offset < avail ? MIN(linelen, avail - offset) : 0;
+        rtengine::rawunpack::unpackBits((const uchar *)ifp->data + start + offset, bytesread, &raw_image[pitch * row],
+                                        MIN(pitch / 4, bytesread / 7) * 4, 14, rtengine::rawunpack::BitOrder::LSB);
     }
-    free(buf);
 }
 
 /* RT: Delete from here */
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "myfile.h"
+#include "rawrestartindex.h"
 #include <csetjmp>
 
 
@@ -49,6 +50,7 @@ public:
     ,shot_select(0)
     ,multi_out(0)
     ,row_padding(0)
+    ,raw_image(nullptr)
 	,float_raw_image(nullptr)
     ,image(nullptr)
     ,bright(1.)
@@ -278,16 +280,27 @@ void parse_redcine();
 class getbithuff_t
 {
 public:
-   getbithuff_t(DCraw *p,IMFILE *&i, unsigned &z):parent(p),bitbuf(0),vbits(0),reset(0),ifp(i),zero_after_ff(z){}
+   // without parent, the errors are only counted (per-thread copies of the reader)
+   getbithuff_t(DCraw *p,IMFILE *&i, unsigned &z):parent(p),bitbuf(0),vbits(0),reset(0),errors(0),ifp(i),zero_after_ff(z){}
    unsigned operator()(int nbits, ushort *huff);
+   unsigned errorCount() const { return errors; }
+   // state of the reader at a restart point (see rawrestartindex.h)
+   void saveState(rtengine::RawRestartPoint &point) const { point.pos = ifp->pos; point.bitbuf = bitbuf; point.vbits = vbits; point.reset = reset; }
+   void restoreState(const rtengine::RawRestartPoint &point) { ifp->pos = point.pos; bitbuf = point.bitbuf; vbits = point.vbits; reset = point.reset; }
+   bool hasState(const rtengine::RawRestartPoint &point) const { return ifp->pos == point.pos && bitbuf == point.bitbuf && vbits == point.vbits && reset == point.reset; }
 
 private:
    void derror(){
-	   parent->derror();
+       if (parent) {
+           parent->derror();
+       } else {
+           ++errors;
+       }
    }
    DCraw *parent;
    unsigned bitbuf;
    int vbits, reset;
+   unsigned errors;
    IMFILE *&ifp;
    unsigned &zero_after_ff;
 };
@@ -300,6 +313,10 @@ public:
    void operator()() {bitbuf = vbits = 0;};
    unsigned operator()(int nbits, ushort *huff);
    unsigned errorCount() { return errors; }
+   // state of the reader at a restart point (see rawrestartindex.h)
+   void saveState(rtengine::RawRestartPoint &point) const { point.pos = ifp->pos; point.bitbuf = bitbuf; point.vbits = vbits; point.reset = 0; }
+   void restoreState(const rtengine::RawRestartPoint &point) { ifp->pos = point.pos; bitbuf = point.bitbuf; vbits = point.vbits; }
+   bool hasState(const rtengine::RawRestartPoint &point) const { return ifp->pos == point.pos && bitbuf == point.bitbuf && vbits == point.vbits; }
 private:
    inline bool derror(bool condition){
        if (UNLIKELY(condition)) {
@@ -324,6 +341,12 @@ int ljpeg_diff (ushort *huff);
 ushort * ljpeg_row (int jrow, struct jhead *jh);
 void lossless_jpeg_load_raw();
 void ljpeg_idct (struct jhead *jh);
+// thread-safe variants, reading from the given file (a per-thread copy of ifp) with the given bit reader
+int ljpeg_start (struct jhead *jh, int info_only, IMFILE *ifp);
+int ljpeg_diff (ushort *huff, getbithuff_t &getbithuff);
+// thread-safe: the corrupt values are counted in errors instead of calling derror()
+ushort * ljpeg_row (int jrow, struct jhead *jh, IMFILE *ifp, getbithuff_t &getbithuff, unsigned &errors);
+void ljpeg_idct (struct jhead *jh, getbithuff_t &getbithuff);
 
 
 void canon_sraw_load_raw();
@@ -433,7 +456,10 @@ public:
    pana_bits_t(IMFILE *i, unsigned &u, unsigned enc):
     ifp(i), load_flags(u), vbits(0), encoding(enc) {}
    unsigned operator()(int nbits, unsigned *bytes=nullptr);
+   // encoding 5 only: loads the block at the current position of the file and starts reading at byte offset of it
+   void seek(int offset);
 private:
+   void load();
    IMFILE *ifp;
    unsigned &load_flags;
    uchar buf[0x4000];
@@ -567,7 +593,7 @@ void selectCRXTrack(unsigned short maxTrack);
 int parseCR3(unsigned long long oAtomList,
              unsigned long long szAtomList, short &nesting,
              char *AtomNameStack, unsigned short &nTrack, short &TrackType);
-bool crxDecodePlane(void *p, uint32_t planeNumber);
+bool crxDecodeTile(void *p, uint32_t tileNumber, uint32_t planeNumber);
 void crxLoadDecodeLoop(void *img, int nPlanes);
 void crxConvertPlaneLineDf(void *p, int imageRow);
 void crxLoadFinalizeLoopE3(void *p, int planeHeight);
@@ -23,6 +23,7 @@
 #include <giomm.h>
 #include <glibmm/ustring.h>
 
+#include "calibrationcache.h"
 #include "dfmanager.h"
 #include "../rtgui/options.h"
 #include "rawimage.h"
@@ -116,7 +117,6 @@ RawImage* dfInfo::getRawImage()
     }
 
     updateRawImage();
-    updateBadPixelList( ri );
 
     return ri;
 }
@@ -125,90 +125,39 @@ std::vector<badPix>& dfInfo::getHotPixels()
 {
     if( !ri ) {
         updateRawImage();
-        updateBadPixelList( ri );
     }
 
     return badPixels;
 }
 /* updateRawImage() load into ri the actual pixel data from pathname if there is a single shot
  * otherwise load each file from the pathNames list and extract a template from the media;
- * the first file is used also for reading all information other than pixels
+ * the first file is used also for reading all information other than pixels.
+ * The template and its hot pixels are stored in the cache and reused until one of its files changes.
  */
 void dfInfo::updateRawImage()
 {
-    typedef unsigned int acc_t;
-
     if( !pathNames.empty() ) {
-        std::list<Glib::ustring>::iterator iName = pathNames.begin();
-        ri = new RawImage(*iName); // First file used also for extra pixels information (width,height, shutter, filters etc.. )
-
-        if( ri->loadRaw(true)) {
-            delete ri;
-            ri = nullptr;
-        } else {
-            int H = ri->get_height();
-            int W = ri->get_width();
-            ri->compress_image(0);
-            int rSize = W * ((ri->getSensorType() == ST_BAYER || ri->getSensorType() == ST_FUJI_XTRANS) ? 1 : 3);
-            acc_t **acc = new acc_t*[H];
-
-            for( int row = 0; row < H; row++) {
-                acc[row] = new acc_t[rSize ];
-            }
+        bool fromMaster;
+        ri = loadCalibrationTemplate("dark", pathNames, &badPixels, fromMaster);
 
-            // copy first image into accumulators
-            for (int row = 0; row < H; row++)
-                for (int col = 0; col < rSize; col++) {
-                    acc[row][col] = ri->data[row][col];
-                }
-
-            int nFiles = 1; // First file data already loaded
-
-            for( ++iName; iName != pathNames.end(); ++iName) {
-                RawImage* temp = new RawImage(*iName);
-
-                if( !temp->loadRaw(true)) {
-                    temp->compress_image(0);     //\ TODO would be better working on original, because is temporary
-                    nFiles++;
-
-                    if( ri->getSensorType() == ST_BAYER || ri->getSensorType() == ST_FUJI_XTRANS ) {
-                        for( int row = 0; row < H; row++) {
-                            for( int col = 0; col < W; col++) {
-                                acc[row][col] += temp->data[row][col];
-                            }
-                        }
-                    } else {
-                        for( int row = 0; row < H; row++) {
-                            for( int col = 0; col < W; col++) {
-                                acc[row][3 * col + 0] += temp->data[row][3 * col + 0];
-                                acc[row][3 * col + 1] += temp->data[row][3 * col + 1];
-                                acc[row][3 * col + 2] += temp->data[row][3 * col + 2];
-                            }
-                        }
-                    }
-                }
-
-                delete temp;
-            }
-
-            for (int row = 0; row < H; row++) {
-                for (int col = 0; col < rSize; col++) {
-                    ri->data[row][col] = acc[row][col] / nFiles;
-                }
-
-                delete [] acc[row];
-            }
+        if( ri && !fromMaster ) {
+            updateBadPixelList( ri );
+            saveCalibrationMaster("dark", pathNames, ri, &badPixels);
+        }
 
-            delete [] acc;
+        if( ri ) {
+            ri->calibrationIdentity = getCalibrationIdentity("dark", pathNames);
         }
     } else {
         ri = new RawImage(pathname);
 
-        if( ri->loadRaw(true)) {
+        if( ri->loadRaw(true, 0, true, nullptr, 1.0, true)) {
             delete ri;
             ri = nullptr;
         } else {
             ri->compress_image(0);
+            updateBadPixelList( ri );
+            ri->calibrationIdentity = getCalibrationIdentity("dark", {pathname});
         }
     }
 }
@@ -276,6 +225,8 @@ void dfInfo::updateBadPixelList( RawImage *df )
 
 void DFManager::init(const Glib::ustring& pathname)
 {
+    MyMutex::MyLock lock(mutex);
+
     if (pathname.empty()) {
         return;
     }
@@ -298,6 +249,7 @@ void DFManager::init(const Glib::ustring& pathname)
 
     dfList.clear();
     bpList.clear();
+    index.load();
 
     for (size_t i = 0; i < names.size(); i++) {
         size_t lastdot = names[i].find_last_of ('.');
@@ -317,6 +269,8 @@ void DFManager::init(const Glib::ustring& pathname)
         } catch( std::exception& e ) {}
     }
 
+    index.save();
+
     // Where multiple shots exist for same group, move filename to list
     for( dfList_t::iterator iter = dfList.begin(); iter != dfList.end(); ++iter ) {
         dfInfo &i = iter->second;
@@ -365,9 +319,9 @@ dfInfo* DFManager::addFileInfo (const Glib::ustring& filename, bool pool)
 
     try {
 
-        auto info = file->query_info("standard::name,standard::type,standard::is-hidden");
+        auto info = file->query_info("standard::name,standard::type,standard::is-hidden,standard::size,time::modified");
 
-        if (!info && info->get_file_type() == Gio::FILE_TYPE_DIRECTORY) {
+        if (!info || info->get_file_type() == Gio::FILE_TYPE_DIRECTORY) {
             return nullptr;
         }
 
@@ -375,10 +329,28 @@ dfInfo* DFManager::addFileInfo (const Glib::ustring& filename, bool pool)
             return nullptr;
         }
 
-        RawImage ri(filename);
-        int res = ri.loadRaw(false); // Read information about shot
+        // the information about the shot is read from the file only if it is new or changed since the last scan
+        CalibrationFileInfo fileInfo;
+        const std::int64_t size = info->get_size();
+        const std::int64_t mtime = info->modification_time().tv_sec;
+
+        if (!index.lookup(filename, size, mtime, fileInfo)) {
+            RawImage ri(filename);
+            fileInfo.isRaw = ri.loadRaw(false) == 0; // Read information about shot
+
+            if (fileInfo.isRaw) {
+                FramesData idata(filename, std::unique_ptr<RawMetaDataLocation>(new RawMetaDataLocation(ri.get_exifBase(), ri.get_ciffBase(), ri.get_ciffLen())), true);
+                fileInfo.make = ((Glib::ustring)idata.getMake()).uppercase();
+                fileInfo.model = ((Glib::ustring)idata.getModel()).uppercase();
+                fileInfo.iso = idata.getISOSpeed();
+                fileInfo.shutter = idata.getShutterSpeed();
+                fileInfo.timestamp = idata.getDateTimeAsTS();
+            }
 
-        if (res != 0) {
+            index.store(filename, size, mtime, fileInfo);
+        }
+
+        if (!fileInfo.isRaw) {
             return nullptr;
         }
 
@@ -390,23 +362,22 @@ dfInfo* DFManager::addFileInfo (const Glib::ustring& filename, bool pool)
             return &(iter->second);
         }
 
-        FramesData idata(filename, std::unique_ptr<RawMetaDataLocation>(new RawMetaDataLocation(ri.get_exifBase(), ri.get_ciffBase(), ri.get_ciffLen())), true);
         /* Files are added in the map, divided by same maker/model,ISO and shutter*/
-        std::string key(dfInfo::key(((Glib::ustring)idata.getMake()).uppercase(), ((Glib::ustring)idata.getModel()).uppercase(), idata.getISOSpeed(), idata.getShutterSpeed()));
+        std::string key(dfInfo::key(fileInfo.make, fileInfo.model, fileInfo.iso, fileInfo.shutter));
         iter = dfList.find(key);
 
         if(iter == dfList.end()) {
-            dfInfo n(filename, ((Glib::ustring)idata.getMake()).uppercase(), ((Glib::ustring)idata.getModel()).uppercase(), idata.getISOSpeed(), idata.getShutterSpeed(), idata.getDateTimeAsTS());
+            dfInfo n(filename, fileInfo.make, fileInfo.model, fileInfo.iso, fileInfo.shutter, fileInfo.timestamp);
             iter = dfList.emplace(key, n);
         } else {
-            while(iter != dfList.end() && iter->second.key() == key && ABS(iter->second.timestamp - idata.getDateTimeAsTS()) > 60 * 60 * 6) { // 6 hour difference
+            while(iter != dfList.end() && iter->second.key() == key && ABS(iter->second.timestamp - fileInfo.timestamp) > 60 * 60 * 6) { // 6 hour difference
                 ++iter;
             }
 
             if(iter != dfList.end()) {
                 iter->second.pathNames.push_back(filename);
             } else {
-                dfInfo n(filename, ((Glib::ustring)idata.getMake()).uppercase(), ((Glib::ustring)idata.getModel()).uppercase(), idata.getISOSpeed(), idata.getShutterSpeed(), idata.getDateTimeAsTS());
+                dfInfo n(filename, fileInfo.make, fileInfo.model, fileInfo.iso, fileInfo.shutter, fileInfo.timestamp);
                 iter = dfList.emplace(key, n);
             }
         }
@@ -420,6 +391,8 @@ dfInfo* DFManager::addFileInfo (const Glib::ustring& filename, bool pool)
 
 void DFManager::getStat( int &totFiles, int &totTemplates)
 {
+    MyMutex::MyLock lock(mutex);
+
     totFiles = 0;
     totTemplates = 0;
 
@@ -482,6 +455,8 @@ dfInfo* DFManager::find( const std::string &mak, const std::string &mod, int iso
 
 RawImage* DFManager::searchDarkFrame( const std::string &mak, const std::string &mod, int iso, double shut, time_t t )
 {
+    MyMutex::MyLock lock(mutex);
+
     dfInfo *df = find( ((Glib::ustring)mak).uppercase(), ((Glib::ustring)mod).uppercase(), iso, shut, t );
 
     if( df ) {
@@ -493,6 +468,8 @@ RawImage* DFManager::searchDarkFrame( const std::string &mak, const std::string
 
 RawImage* DFManager::searchDarkFrame( const Glib::ustring filename )
 {
+    MyMutex::MyLock lock(mutex);
+
     for ( dfList_t::iterator iter = dfList.begin(); iter != dfList.end(); ++iter ) {
         if( iter->second.pathname.compare( filename ) == 0  ) {
             return iter->second.getRawImage();
@@ -509,6 +486,8 @@ RawImage* DFManager::searchDarkFrame( const Glib::ustring filename )
 }
 std::vector<badPix> *DFManager::getHotPixels ( const Glib::ustring filename )
 {
+    MyMutex::MyLock lock(mutex);
+
     for ( dfList_t::iterator iter = dfList.begin(); iter != dfList.end(); ++iter ) {
         if( iter->second.pathname.compare( filename ) == 0  ) {
             return &iter->second.getHotPixels();
@@ -519,6 +498,8 @@ std::vector<badPix> *DFManager::getHotPixels ( const Glib::ustring filename )
 }
 std::vector<badPix> *DFManager::getHotPixels ( const std::string &mak, const std::string &mod, int iso, double shut, time_t t )
 {
+    MyMutex::MyLock lock(mutex);
+
     dfInfo *df = find( ((Glib::ustring)mak).uppercase(), ((Glib::ustring)mod).uppercase(), iso, shut, t );
 
     if( df ) {
@@ -592,6 +573,8 @@ int DFManager::scanBadPixelsFile( Glib::ustring filename )
 
 std::vector<badPix> *DFManager::getBadPixels ( const std::string &mak, const std::string &mod, const std::string &serial)
 {
+    MyMutex::MyLock lock(mutex);
+
     bpList_t::iterator iter;
     bool found = false;
 
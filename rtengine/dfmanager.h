@@ -25,8 +25,11 @@
 
 #include <glibmm/ustring.h>
 
+#include "calibrationcache.h"
 #include "pixelsmap.h"
 
+#include "../rtgui/threadutils.h"
+
 namespace rtengine
 {
 
@@ -96,6 +99,9 @@ protected:
     bpList_t bpList;
     bool initialized;
     Glib::ustring currentPath;
+    // concurrent batch jobs share the lists and the lazily loaded dark frames and hot pixels
+    MyMutex mutex;
+    CalibrationIndex index{"darkframes"};
     dfInfo *addFileInfo(const Glib::ustring &filename, bool pool = true );
     dfInfo *find( const std::string &mak, const std::string &mod, int isospeed, double shut, time_t t );
     int scanBadPixelsFile( Glib::ustring filename );
@@ -20,6 +20,7 @@
 #include <giomm/file.h>
 #include <glibmm/miscutils.h>
 
+#include "calibrationcache.h"
 #include "ffmanager.h"
 #include "../rtgui/options.h"
 #include "rawimage.h"
@@ -127,83 +128,33 @@ RawImage* ffInfo::getRawImage()
 
 /* updateRawImage() load into ri the actual pixel data from pathname if there is a single shot
  * otherwise load each file from the pathNames list and extract a template from the media;
- * the first file is used also for reading all information other than pixels
+ * the first file is used also for reading all information other than pixels.
+ * The template is stored in the cache and reused until one of its files changes.
  */
 void ffInfo::updateRawImage()
 {
-    typedef unsigned int acc_t;
-
     // averaging of flatfields if more than one is found matching the same key.
     // this may not be necessary, as flatfield is further blurred before being applied to the processed image.
     if( !pathNames.empty() ) {
-        std::list<Glib::ustring>::iterator iName = pathNames.begin();
-        ri = new RawImage(*iName); // First file used also for extra pixels information (width, height, shutter, filters etc.. )
-        if( ri->loadRaw(true)) {
-            delete ri;
-            ri = nullptr;
-        } else {
-            int H = ri->get_height();
-            int W = ri->get_width();
-            ri->compress_image(0);
-            int rSize = W * ((ri->getSensorType() == ST_BAYER || ri->getSensorType() == ST_FUJI_XTRANS || ri->get_colors() == 1) ? 1 : 3);
-            acc_t **acc = new acc_t*[H];
-
-            for( int row = 0; row < H; row++) {
-                acc[row] = new acc_t[rSize ];
-            }
-
-            // copy first image into accumulators
-            for (int row = 0; row < H; row++)
-                for (int col = 0; col < rSize; col++) {
-                    acc[row][col] = ri->data[row][col];
-                }
-
-            int nFiles = 1; // First file data already loaded
-
-            for( ++iName; iName != pathNames.end(); ++iName) {
-                RawImage* temp = new RawImage(*iName);
-
-                if( !temp->loadRaw(true)) {
-                    temp->compress_image(0);     //\ TODO would be better working on original, because is temporary
-                    nFiles++;
-
-                    if( ri->getSensorType() == ST_BAYER || ri->getSensorType() == ST_FUJI_XTRANS || ri->get_colors() == 1 ) {
-                        for( int row = 0; row < H; row++) {
-                            for( int col = 0; col < W; col++) {
-                                acc[row][col] += temp->data[row][col];
-                            }
-                        }
-                    } else {
-                        for( int row = 0; row < H; row++) {
-                            for( int col = 0; col < W; col++) {
-                                acc[row][3 * col + 0] += temp->data[row][3 * col + 0];
-                                acc[row][3 * col + 1] += temp->data[row][3 * col + 1];
-                                acc[row][3 * col + 2] += temp->data[row][3 * col + 2];
-                            }
-                        }
-                    }
-                }
-
-                delete temp;
-            }
+        // the cached template is stored after the median
+        bool fromMaster;
+        ri = loadCalibrationTemplate("flat", pathNames, nullptr, fromMaster);
 
-            for (int row = 0; row < H; row++) {
-                for (int col = 0; col < rSize; col++) {
-                    ri->data[row][col] = acc[row][col] / nFiles;
-                }
-
-                delete [] acc[row];
-            }
+        if( ri ) {
+            ri->calibrationIdentity = getCalibrationIdentity("flat", pathNames);
+        }
 
-            delete [] acc;
+        if( fromMaster ) {
+            return;
         }
     } else {
         ri = new RawImage(pathname);
-        if( ri->loadRaw(true)) {
+        if( ri->loadRaw(true, 0, true, nullptr, 1.0, true)) {
             delete ri;
             ri = nullptr;
         } else {
             ri->compress_image(0);
+            ri->calibrationIdentity = getCalibrationIdentity("flat", {pathname});
         }
     }
 
@@ -233,6 +184,7 @@ void ffInfo::updateRawImage()
 
         free (cfatmp);
 
+        saveCalibrationMaster("flat", pathNames, ri, nullptr);
     }
 }
 
@@ -240,6 +192,8 @@ void ffInfo::updateRawImage()
 
 void FFManager::init(const Glib::ustring& pathname)
 {
+    MyMutex::MyLock lock(mutex);
+
     if (pathname.empty()) {
         return;
     }
@@ -262,6 +216,7 @@ void FFManager::init(const Glib::ustring& pathname)
     } catch (Glib::Exception&) {}
 
     ffList.clear();
+    index.load();
 
     for (size_t i = 0; i < names.size(); i++) {
         try {
@@ -269,6 +224,8 @@ void FFManager::init(const Glib::ustring& pathname)
         } catch( std::exception& e ) {}
     }
 
+    index.save();
+
     // Where multiple shots exist for same group, move filename to list
     for( ffList_t::iterator iter = ffList.begin(); iter != ffList.end(); ++iter ) {
         ffInfo &i = iter->second;
@@ -317,7 +274,7 @@ ffInfo* FFManager::addFileInfo (const Glib::ustring& filename, bool pool)
 
     try {
 
-        auto info = file->query_info("standard::name,standard::type,standard::is-hidden");
+        auto info = file->query_info("standard::name,standard::type,standard::is-hidden,standard::size,time::modified");
 
         if (!info || info->get_file_type() == Gio::FILE_TYPE_DIRECTORY) {
             return nullptr;
@@ -327,10 +284,30 @@ ffInfo* FFManager::addFileInfo (const Glib::ustring& filename, bool pool)
             return nullptr;
         }
 
-        RawImage ri(filename);
-        int res = ri.loadRaw(false); // Read information about shot
+        // the information about the shot is read from the file only if it is new or changed since the last scan
+        CalibrationFileInfo fileInfo;
+        const std::int64_t size = info->get_size();
+        const std::int64_t mtime = info->modification_time().tv_sec;
+
+        if (!index.lookup(filename, size, mtime, fileInfo)) {
+            RawImage ri(filename);
+            fileInfo.isRaw = ri.loadRaw(false) == 0; // Read information about shot
+
+            if (fileInfo.isRaw) {
+                FramesData idata(filename, std::unique_ptr<RawMetaDataLocation>(new RawMetaDataLocation(ri.get_exifBase(), ri.get_ciffBase(), ri.get_ciffLen())), true);
+                fileInfo.make = idata.getMake();
+                fileInfo.model = idata.getModel();
+                fileInfo.lens = idata.getLens();
+                fileInfo.focalLength = idata.getFocalLen();
+                fileInfo.aperture = idata.getFNumber();
+                fileInfo.timestamp = idata.getDateTimeAsTS();
+                fileInfo.rawTimestamp = ri.get_timestamp();
+            }
+
+            index.store(filename, size, mtime, fileInfo);
+        }
 
-        if (res != 0) {
+        if (!fileInfo.isRaw) {
             return nullptr;
         }
 
@@ -342,23 +319,22 @@ ffInfo* FFManager::addFileInfo (const Glib::ustring& filename, bool pool)
             return &(iter->second);
         }
 
-        FramesData idata(filename, std::unique_ptr<RawMetaDataLocation>(new RawMetaDataLocation(ri.get_exifBase(), ri.get_ciffBase(), ri.get_ciffLen())), true);
         /* Files are added in the map, divided by same maker/model,lens and aperture*/
-        std::string key(ffInfo::key(idata.getMake(), idata.getModel(), idata.getLens(), idata.getFocalLen(), idata.getFNumber()));
+        std::string key(ffInfo::key(fileInfo.make, fileInfo.model, fileInfo.lens, fileInfo.focalLength, fileInfo.aperture));
         iter = ffList.find(key);
 
         if(iter == ffList.end()) {
-            ffInfo n(filename, idata.getMake(), idata.getModel(), idata.getLens(), idata.getFocalLen(), idata.getFNumber(), idata.getDateTimeAsTS());
+            ffInfo n(filename, fileInfo.make, fileInfo.model, fileInfo.lens, fileInfo.focalLength, fileInfo.aperture, fileInfo.timestamp);
             iter = ffList.emplace(key, n);
         } else {
-            while(iter != ffList.end() && iter->second.key() == key && ABS(iter->second.timestamp - ri.get_timestamp()) > 60 * 60 * 6) { // 6 hour difference
+            while(iter != ffList.end() && iter->second.key() == key && ABS(iter->second.timestamp - fileInfo.rawTimestamp) > 60 * 60 * 6) { // 6 hour difference
                 ++iter;
             }
 
             if(iter != ffList.end()) {
                 iter->second.pathNames.push_back(filename);
             } else {
-                ffInfo n(filename, idata.getMake(), idata.getModel(), idata.getLens(), idata.getFocalLen(), idata.getFNumber(), idata.getDateTimeAsTS());
+                ffInfo n(filename, fileInfo.make, fileInfo.model, fileInfo.lens, fileInfo.focalLength, fileInfo.aperture, fileInfo.timestamp);
                 iter = ffList.emplace(key, n);
             }
         }
@@ -372,6 +348,8 @@ ffInfo* FFManager::addFileInfo (const Glib::ustring& filename, bool pool)
 
 void FFManager::getStat( int &totFiles, int &totTemplates)
 {
+    MyMutex::MyLock lock(mutex);
+
     totFiles = 0;
     totTemplates = 0;
 
@@ -434,6 +412,8 @@ ffInfo* FFManager::find( const std::string &mak, const std::string &mod, const s
 
 RawImage* FFManager::searchFlatField( const std::string &mak, const std::string &mod, const std::string &len, double focal, double apert, time_t t )
 {
+    MyMutex::MyLock lock(mutex);
+
     ffInfo *ff = find( mak, mod, len, focal, apert, t );
 
     if( ff ) {
@@ -445,6 +425,8 @@ RawImage* FFManager::searchFlatField( const std::string &mak, const std::string
 
 RawImage* FFManager::searchFlatField( const Glib::ustring filename )
 {
+    MyMutex::MyLock lock(mutex);
+
     for ( ffList_t::iterator iter = ffList.begin(); iter != ffList.end(); ++iter ) {
         if( iter->second.pathname.compare( filename ) == 0  ) {
             return iter->second.getRawImage();
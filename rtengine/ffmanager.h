@@ -25,6 +25,10 @@
 
 #include <glibmm/ustring.h>
 
+#include "calibrationcache.h"
+
+#include "../rtgui/threadutils.h"
+
 namespace rtengine
 {
 
@@ -88,6 +92,9 @@ protected:
     ffList_t ffList;
     bool initialized;
     Glib::ustring currentPath;
+    // serializes the search and the lazy loading of the flat fields between concurrent batch jobs
+    MyMutex mutex;
+    CalibrationIndex index{"flatfields"};
     ffInfo *addFileInfo(const Glib::ustring &filename, bool pool = true );
     ffInfo *find( const std::string &mak, const std::string &mod, const std::string &len, double focal, double apert, time_t t );
 };
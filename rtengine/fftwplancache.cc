@@ -0,0 +1,136 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include <glibmm/fileutils.h>
+
+#include "cachefile.h"
+#include "fftwplancache.h"
+#include "settings.h"
+
+namespace
+{
+
+// the preview of Fattal needs a plan for each size of the image, the least recently used plans are destroyed past this count
+constexpr std::size_t maxCachedPlans = 32;
+
+struct CachedPlan {
+    fftwf_plan plan;
+    unsigned long lastUse;
+};
+
+std::map<std::vector<int>, CachedPlan> plans;
+unsigned long useCounter = 0;
+
+Glib::ustring getWisdomName()
+{
+    return rtengine::getCacheFileName("fftw", "wisdomf");
+}
+
+void saveWisdom()
+{
+    const Glib::ustring wisdomName = getWisdomName();
+
+    if (wisdomName.empty()) {
+        return;
+    }
+
+    // several instances of RT may store their wisdom at the same time, the last one wins
+    rtengine::writeCacheFileAs(wisdomName, [](const Glib::ustring& tempName) {
+        return fftwf_export_wisdom_to_filename(tempName.c_str()) != 0;
+    });
+}
+
+}
+
+namespace rtengine
+{
+
+fftwf_plan getR2RPlan(int rank, const int* n, int howmany, float* in, float* out, const fftwf_r2r_kind* kinds, unsigned flags, int nthreads)
+{
+#ifndef RT_FFTW3F_OMP
+    nthreads = 1;
+#endif
+
+    int dist = 1;
+    std::vector<int> key = {rank, howmany, static_cast<int>(flags), nthreads, in == out, fftwf_alignment_of(in), fftwf_alignment_of(out)};
+
+    for (int i = 0; i < rank; ++i) {
+        key.push_back(n[i]);
+        key.push_back(kinds[i]);
+        dist *= n[i];
+    }
+
+    const auto it = plans.find(key);
+
+    if (it != plans.end()) {
+        it->second.lastUse = ++useCounter;
+        return it->second.plan;
+    }
+
+    if (plans.size() >= maxCachedPlans) {
+        auto oldest = plans.begin();
+
+        for (auto p = plans.begin(); p != plans.end(); ++p) {
+            if (p->second.lastUse < oldest->second.lastUse) {
+                oldest = p;
+            }
+        }
+
+        fftwf_destroy_plan(oldest->second.plan);
+        plans.erase(oldest);
+    }
+
+#ifdef RT_FFTW3F_OMP
+    fftwf_plan_with_nthreads(nthreads);
+#endif
+
+    const fftwf_plan plan = fftwf_plan_many_r2r(rank, n, howmany, in, nullptr, 1, dist, out, nullptr, 1, dist, kinds, flags);
+    plans[key] = {plan, ++useCounter};
+
+    if (!(flags & FFTW_ESTIMATE)) {
+        saveWisdom();
+    }
+
+    return plan;
+}
+
+void initFftw()
+{
+#ifdef RT_FFTW3F_OMP
+    fftwf_init_threads();
+#endif
+
+    const Glib::ustring wisdomName = getWisdomName();
+
+    if (!wisdomName.empty() && Glib::file_test(wisdomName, Glib::FILE_TEST_EXISTS) && !fftwf_import_wisdom_from_filename(wisdomName.c_str()) && settings->verbose) {
+        printf("Ignoring the FFTW wisdom %s\n", wisdomName.c_str());
+    }
+}
+
+void cleanupFftwPlans()
+{
+    for (const auto& p : plans) {
+        fftwf_destroy_plan(p.second.plan);
+    }
+
+    plans.clear();
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <fftw3.h>
+
+/* Process-wide cache of the FFTW plans, and persistence of the FFTW wisdom.
+ *
+ * The plans are shared by all the callers and identified by the shape and kind of the transform, the planner flags, the
+ * number of threads and the alignment of the arrays. The wisdom is imported from the "fftw" folder of the cache at startup
+ * and exported there each time a measured plan is created, so the measurements are made once per machine.
+ *
+ * All the functions must be called with fftwMutex locked. */
+
+namespace rtengine
+{
+
+/** Returns a plan of howmany contiguous r2r transforms of rank rank and size n, the consecutive transforms are
+  * n[0] * ... * n[rank - 1] floats apart. The plan is owned by the cache and stays valid as long as fftwMutex is locked,
+  * it must be executed with fftwf_execute_r2r on arrays of the same alignment as in and out.
+  * @param in,out are the arrays the plan is created with, they are overwritten by the planner unless flags has FFTW_ESTIMATE
+  * @param nthreads is the number of threads of each execution */
+fftwf_plan getR2RPlan (int rank, const int* n, int howmany, float* in, float* out, const fftwf_r2r_kind* kinds, unsigned flags, int nthreads = 1);
+
+/** Initializes the threads of FFTW and imports the stored wisdom */
+void initFftw ();
+
+/** Destroys the cached plans */
+void cleanupFftwPlans ();
+
+}
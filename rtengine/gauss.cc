@@ -29,6 +29,12 @@
 namespace
 {
 
+constexpr auto GAUSS_SKIP = 0.25;
+constexpr auto GAUSS_3X3_LIMIT = 0.6;
+constexpr auto GAUSS_5X5_LIMIT = 0.84;
+constexpr auto GAUSS_7X7_LIMIT = 1.15;
+constexpr auto GAUSS_DOUBLE = 25.0;
+
 void compute7x7kernel(float sigma, float kernel[7][7]) {
     const double temp = -2.f * rtengine::SQR(sigma);
     float sum = 0.f;
@@ -1355,12 +1361,6 @@ template<class T> void gaussVerticalmult (T** src, T** dst, const int W, const i
 
 template<class T> void gaussianBlurImpl(T** src, T** dst, const int W, const int H, const double sigma, bool useBoxBlur, eGaussType gausstype = GAUSS_STANDARD, T** buffer2 = nullptr)
 {
-    static constexpr auto GAUSS_SKIP = 0.25;
-    static constexpr auto GAUSS_3X3_LIMIT = 0.6;
-    static constexpr auto GAUSS_5X5_LIMIT = 0.84;
-    static constexpr auto GAUSS_7X7_LIMIT = 1.15;
-    static constexpr auto GAUSS_DOUBLE = 25.0;
-
     if (useBoxBlur) {
         // special variant for very large sigma, currently only used by retinex algorithm
         // use iterated boxblur to approximate gaussian blur
@@ -1541,3 +1541,8 @@ void gaussianBlur(float** src, float** dst, const int W, const int H, const doub
     gaussianBlurImpl<float>(src, dst, W, H, sigma, useBoxBlur, gausstype, buffer2);
 }
 
+bool gaussianBlurIsFinite(const double sigma, eGaussType gausstype)
+{
+    // the 3x3 kernels, and the 5x5 and 7x7 ones of the multiplying and dividing variants, see gaussianBlurImpl()
+    return sigma < GAUSS_3X3_LIMIT || (gausstype != GAUSS_STANDARD && sigma <= GAUSS_7X7_LIMIT);
+}
@@ -21,3 +21,5 @@
 enum eGaussType {GAUSS_STANDARD, GAUSS_MULT, GAUSS_DIV};
 
 void gaussianBlur(float** src, float** dst, const int W, const int H, const double sigma, bool useBoxBlur = false, eGaussType gausstype = GAUSS_STANDARD, float** buffer2 = nullptr);
+// true if gaussianBlur() from src to dst != src uses a kernel of bounded support, the recursive filter used otherwise reaches the whole image
+bool gaussianBlurIsFinite(const double sigma, eGaussType gausstype = GAUSS_STANDARD);
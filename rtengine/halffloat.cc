@@ -0,0 +1,117 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#include "halffloat.h"
+
+namespace
+{
+
+inline std::uint16_t toHalf (float value)
+{
+    std::uint32_t f;
+    memcpy(&f, &value, sizeof(f));
+    const std::uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+    std::uint32_t h;
+
+    if (f >= (127u + 16u) << 23) {
+        // too large for a half float, infinity or NaN
+        h = f > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (f < 113u << 23) {
+        // subnormal half float or zero, the addition of 0.5 aligns the 10 mantissa bits and rounds them
+        float aligned;
+        memcpy(&aligned, &f, sizeof(aligned));
+        aligned += 0.5f;
+        memcpy(&h, &aligned, sizeof(h));
+        h -= 0x3f000000u;
+    } else {
+        // rebias the exponent and round to nearest even
+        f += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu + ((f >> 13) & 1u);
+        h = f >> 13;
+    }
+
+    return h | sign >> 16;
+}
+
+inline float fromHalf (std::uint16_t value)
+{
+    std::uint32_t f = static_cast<std::uint32_t>(value & 0x7fffu) << 13;
+    const std::uint32_t exponent = f & (0x7c00u << 13);
+    f += static_cast<std::uint32_t>(127 - 15) << 23;
+    float result;
+
+    if (exponent == 0x7c00u << 13) {
+        // infinity or NaN
+        f += static_cast<std::uint32_t>(128 - 16) << 23;
+        memcpy(&result, &f, sizeof(result));
+    } else if (exponent == 0) {
+        // subnormal half float or zero
+        f += 1u << 23;
+        memcpy(&result, &f, sizeof(result));
+        result -= 6.103515625e-05f; // 2^-14
+    } else {
+        memcpy(&result, &f, sizeof(result));
+    }
+
+    return value & 0x8000u ? -result : result;
+}
+
+}
+
+namespace rtengine
+{
+
+void floatToHalf (const float* src, std::uint16_t* dst, std::size_t count, float scale)
+{
+    std::size_t i = 0;
+
+#ifdef __F16C__
+    const __m128 scalev = _mm_set1_ps(scale);
+
+    for (; i + 4 <= count; i += 4) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_cvtps_ph(_mm_mul_ps(_mm_loadu_ps(src + i), scalev), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = toHalf(src[i] * scale);
+    }
+}
+
+void halfToFloat (const std::uint16_t* src, float* dst, std::size_t count, float scale)
+{
+    std::size_t i = 0;
+
+#ifdef __F16C__
+    const __m128 scalev = _mm_set1_ps(scale);
+
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i))), scalev));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = fromHalf(src[i]) * scale;
+    }
+}
+
+}
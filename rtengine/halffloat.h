@@ -0,0 +1,37 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Conversion of float arrays to IEEE half floats (1 sign, 5 exponent and 10 mantissa bits) and back.
+ *
+ * Used to hold large intermediate arrays in half of their memory. The conversion rounds to nearest even, a half float keeps
+ * a relative precision of 1/2048 for magnitudes from 2^-14 to 65504. It uses the F16C instructions when the build enables
+ * them. */
+
+namespace rtengine
+{
+
+/** Stores src[i] * scale as half floats, the values out of range become infinite */
+void floatToHalf (const float* src, std::uint16_t* dst, std::size_t count, float scale = 1.f);
+
+/** Stores src[i] * scale as floats */
+void halfToFloat (const std::uint16_t* src, float* dst, std::size_t count, float scale = 1.f);
+
+}
@@ -39,6 +39,7 @@
 #endif
 
 #include "imageio.h"
+#include "instrumentation.h"
 #include "iptcpairs.h"
 #include "iccjpeg.h"
 #include "color.h"
@@ -997,6 +998,8 @@ void PNGwriteRawProfile(png_struct *ping, png_info *ping_info, const char *profi
 
 int ImageIO::savePNG  (const Glib::ustring &fname, int bps) const
 {
+    instrumentation::Stage stage("savePNG", "save");
+
     if (getWidth() < 1 || getHeight() < 1) {
         return IMIO_HEADERERROR;
     }
@@ -1136,6 +1139,8 @@ int ImageIO::savePNG  (const Glib::ustring &fname, int bps) const
 // Quality 0..100, subsampling: 1=low quality, 2=medium, 3=high
 int ImageIO::saveJPEG (const Glib::ustring &fname, int quality, int subSamp) const
 {
+    instrumentation::Stage stage("saveJPEG", "save");
+
     if (getWidth() < 1 || getHeight() < 1) {
         return IMIO_HEADERERROR;
     }
@@ -1326,6 +1331,8 @@ int ImageIO::saveJPEG (const Glib::ustring &fname, int quality, int subSamp) con
 
 int ImageIO::saveTIFF (const Glib::ustring &fname, int bps, bool isFloat, bool uncompressed) const
 {
+    instrumentation::Stage stage("saveTIFF", "save");
+
     if (getWidth() < 1 || getHeight() < 1) {
         return IMIO_HEADERERROR;
     }
@@ -1632,6 +1639,106 @@ int ImageIO::load (const Glib::ustring &fname)
     }
 }
 
+int ImageIO::getImageSize (const Glib::ustring &fname, int &width, int &height)
+{
+    if (hasPngExtension(fname)) {
+        FILE *file = g_fopen (fname.c_str (), "rb");
+
+        if (!file) {
+            return IMIO_CANNOTREADFILE;
+        }
+
+        unsigned char header[8];
+
+        if (fread (header, 1, 8, file) != 8 || png_sig_cmp (header, 0, 8)) {
+            fclose(file);
+            return IMIO_HEADERERROR;
+        }
+
+        png_structp png = png_create_read_struct (PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+
+        if (!png) {
+            fclose (file);
+            return IMIO_HEADERERROR;
+        }
+
+        png_infop info = png_create_info_struct (png);
+
+        if (!info || setjmp (png_jmpbuf(png))) {
+            png_destroy_read_struct (&png, &info, nullptr);
+            fclose (file);
+            return IMIO_HEADERERROR;
+        }
+
+        png_set_read_fn (png, file, png_read_data);
+        png_set_sig_bytes (png, 8);
+        png_read_info(png, info);
+
+        width = png_get_image_width(png, info);
+        height = png_get_image_height(png, info);
+
+        png_destroy_read_struct (&png, &info, nullptr);
+        fclose (file);
+        return IMIO_SUCCESS;
+    } else if (hasJpegExtension(fname)) {
+        FILE *file = g_fopen(fname.c_str (), "rb");
+
+        if (!file) {
+            return IMIO_CANNOTREADFILE;
+        }
+
+        jpeg_decompress_struct cinfo;
+        jpeg_error_mgr jerr;
+        cinfo.err = my_jpeg_std_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+
+        my_jpeg_stdio_src (&cinfo, file);
+
+#if defined( WIN32 ) && defined( __x86_64__ ) && !defined(__clang__)
+        if ( __builtin_setjmp((reinterpret_cast<rt_jpeg_error_mgr*>(cinfo.src))->error_jmp_buf) == 0 ) {
+#else
+        if ( setjmp((reinterpret_cast<rt_jpeg_error_mgr*>(cinfo.src))->error_jmp_buf) == 0 ) {
+#endif
+            jpeg_read_header(&cinfo, TRUE);
+            width = cinfo.image_width;
+            height = cinfo.image_height;
+            jpeg_destroy_decompress(&cinfo);
+            fclose(file);
+            return IMIO_SUCCESS;
+        } else {
+            jpeg_destroy_decompress(&cinfo);
+            fclose(file);
+            return IMIO_HEADERERROR;
+        }
+    } else if (hasTiffExtension(fname)) {
+#ifdef WIN32
+        wchar_t *wfilename = (wchar_t*)g_utf8_to_utf16 (fname.c_str(), -1, NULL, NULL, NULL);
+        TIFF* in = TIFFOpenW (wfilename, "r");
+        g_free (wfilename);
+#else
+        TIFF* in = TIFFOpen(fname.c_str(), "r");
+#endif
+
+        if (in == nullptr) {
+            return IMIO_CANNOTREADFILE;
+        }
+
+        uint32 w = 0, h = 0;
+        const bool hasSize = TIFFGetField(in, TIFFTAG_IMAGEWIDTH, &w) && TIFFGetField(in, TIFFTAG_IMAGELENGTH, &h);
+        TIFFClose(in);
+
+        if (!hasSize) {
+            return IMIO_HEADERERROR;
+        }
+
+        width = w;
+        height = h;
+        return IMIO_SUCCESS;
+    } else {
+        return IMIO_FILETYPENOTSUPPORTED;
+    }
+}
+
 int ImageIO::save (const Glib::ustring &fname) const
 {
     if (hasPngExtension(fname)) {
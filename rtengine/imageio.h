@@ -108,6 +108,8 @@ public:
     int loadTIFF (const Glib::ustring &fname);
     static int getPNGSampleFormat (const Glib::ustring &fname, IIOSampleFormat &sFormat, IIOSampleArrangement &sArrangement);
     static int getTIFFSampleFormat (const Glib::ustring &fname, IIOSampleFormat &sFormat, IIOSampleArrangement &sArrangement);
+    // Reads the dimensions of a PNG, JPEG or TIFF file from its header, without decoding the image
+    static int getImageSize (const Glib::ustring &fname, int &width, int &height);
 
     int loadJPEGFromMemory (const char* buffer, int bufsize);
     int loadPPMFromMemory(const char* buffer, int width, int height, bool swap, int bps);
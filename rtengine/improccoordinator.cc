@@ -32,6 +32,7 @@
 #include "image8.h"
 #include "imagefloat.h"
 #include "improcfun.h"
+#include "instrumentation.h"
 #include "labimage.h"
 #include "lcp.h"
 #include "procparams.h"
@@ -230,21 +231,25 @@ DetailedCrop* ImProcCoordinator::createCrop(::EditDataProvider *editDataProvider
 void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 {
 
+    instrumentation::Stage stage("updatePreviewImage", "ImProcCoordinator");
     MyMutex::MyLock processingLock(mProcessing);
 
-    bool highDetailNeeded = options.prevdemo == PD_Sidecar ? true : (todo & M_HIGHQUAL);
+    bool fullResolutionNeeded = todo & M_HIGHQUAL;
                 //    printf("metwb=%s \n", params->wb.method.c_str());
 
     // Check if any detail crops need high detail. If not, take a fast path short cut
-    if (!highDetailNeeded) {
+    if (!fullResolutionNeeded) {
         for (size_t i = 0; i < crops.size(); i++) {
             if (crops[i]->get_skip() == 1) {   // skip=1 -> full  resolution
-                highDetailNeeded = true;
+                fullResolutionNeeded = true;
                 break;
             }
         }
     }
 
+    // in the "sidecar" mode the demosaic method of the profile is always used, even below 100%
+    const bool highDetailNeeded = options.prevdemo == PD_Sidecar || fullResolutionNeeded;
+
     if (((todo & ALL) == ALL) || (todo & M_MONITOR) || panningRelatedChange || (highDetailNeeded && options.prevdemo != PD_Sidecar)) {
         bwAutoR = bwAutoG = bwAutoB = -9000.f;
 
@@ -278,6 +283,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         // raw auto CA is bypassed if no high detail is needed, so we have to compute it when high detail is needed
+        instrumentation::Stage step("preprocess", "ImProcCoordinator");
         if ((todo & M_PREPROC) || (!highDetailPreprocessComputed && highDetailNeeded)) {
             imgsrc->setCurrentFrame(params->raw.bayersensor.imageNum);
 
@@ -320,6 +326,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             imageTypeListener->imageTypeChanged(imgsrc->isRAW(), imgsrc->getSensorType() == ST_BAYER, imgsrc->getSensorType() == ST_FUJI_XTRANS, imgsrc->isMono());
         }
 
+        step.next("demosaic");
         if ((todo & M_RAW)
                 || (!highDetailRawComputed && highDetailNeeded)
                 || (params->toneCurve.hrenabled && params->toneCurve.method != "Color" && imgsrc->isRGBSourceModified())
@@ -345,7 +352,14 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 
             bool autoContrast = imgsrc->getSensorType() == ST_BAYER ? params->raw.bayersensor.dualDemosaicAutoContrast : params->raw.xtranssensor.dualDemosaicAutoContrast;
             double contrastThreshold = imgsrc->getSensorType() == ST_BAYER ? params->raw.bayersensor.dualDemosaicContrast : params->raw.xtranssensor.dualDemosaicContrast;
-            imgsrc->demosaic(rp, autoContrast, contrastThreshold, params->pdsharpening.enabled);
+            // below 100% the preview is binned from the raw data, unless a later step works on the interpolated planes. The planes
+            // are interpolated with the method of rp when a crop at 100% shows up later, see RawImageSource::finishBinnedDemosaic()
+            const bool binnedPreview = !fullResolutionNeeded && !params->pdsharpening.enabled && !params->retinex.enabled
+                                       && !(params->toneCurve.hrenabled && params->toneCurve.method == "Color") && params->wb.method != "autitcgreen";
+
+            if (!binnedPreview || !imgsrc->demosaicBinned(rp, autoContrast, contrastThreshold)) {
+                imgsrc->demosaic(rp, autoContrast, contrastThreshold, params->pdsharpening.enabled);
+            }
 
             if (imgsrc->getSensorType() == ST_BAYER && bayerAutoContrastListener && autoContrast) {
                 bayerAutoContrastListener->autoContrastChanged(contrastThreshold);
@@ -371,6 +385,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
 
+        step.next("HLRecovery");
         if ((todo & M_RAW)
                 || (!highDetailRawComputed && highDetailNeeded)
                 || (params->toneCurve.hrenabled && params->toneCurve.method != "Color" && imgsrc->isRGBSourceModified())
@@ -389,6 +404,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             }
         }
 
+        step.next("autoWB");
         if (todo & (M_INIT | M_LINDENOISE | M_HDR)) {
             if (params->wb.method == "autitcgreen") {
                 imgsrc->getrgbloc(0, 0, fh, fw, 0, 0, fh, fw);
@@ -415,6 +431,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         if (settings->verbose) {
             printf("automethod=%s \n", params->wb.method.c_str());
         }
+        step.next("getImage");
         if (todo & (M_INIT | M_LINDENOISE | M_HDR)) {
             MyMutex::MyLock initLock(minit);  // Also used in crop window
 
@@ -575,6 +592,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             ipf.firstAnalysis(orig_prev, *params, vhist16);
         }
 
+        step.next("dehaze_fattal");
         if ((todo & M_HDR) && (params->fattal.enabled || params->dehaze.enabled)) {
             if (fattal_11_dcrop_cache) {
                 delete fattal_11_dcrop_cache;
@@ -616,6 +634,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             ipf.lab2rgb(labcbdl, *oprevi, params->icm.workingProfile);
         }
 
+        step.next("autoExposure");
         if (todo & M_AUTOEXP) {
             if (params->toneCurve.autoexp) {
                 LUTu aehist;
@@ -652,6 +671,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             }
         }
 
+        step.next("rgbCurves");
         if (todo & (M_AUTOEXP | M_RGBCURVE)) {
             if (params->icm.workingTRC == "Custom") { //exec TRC IN free
                 if (oprevi == orig_prev) {
@@ -685,6 +705,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
 
+        step.next("rgbProc");
         if ((todo & M_RGBCURVE) || (todo & M_CROP)) {
             //        if (hListener) oprevi->calcCroppedHistogram(params, scale, histCropped);
 
@@ -803,6 +824,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             params->crop.mapToResized(pW, pH, scale, x1, x2,  y1, y2);
         }
 
+        step.next("lumaCurve");
         if (todo & (M_LUMACURVE | M_CROP)) {
             LUTu lhist16(32768);
             lhist16.clear();
@@ -842,6 +864,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
                                           params->labCurve.lccurve, chroma_acurve, chroma_bcurve, satcurve, lhskcurve, scale == 1 ? 1 : 16);
         }
 
+        step.next("labPipeline");
         if (todo & (M_LUMINANCE + M_COLOR)) {
             nprevl->CopyFrom(oprevl);
 
@@ -1181,6 +1204,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         // Update the monitor color transform if necessary
+        step.next("monitorTransform");
         if ((todo & M_MONITOR) || (lastOutputProfile != params->icm.outputProfile) || lastOutputIntent != params->icm.outputIntent || lastOutputBPC != params->icm.outputBPC) {
             lastOutputProfile = params->icm.outputProfile;
             lastOutputIntent = params->icm.outputIntent;
@@ -1190,6 +1214,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
     }
 
     // process crop, if needed
+    instrumentation::Stage cropStage("crops", "ImProcCoordinator");
     for (size_t i = 0; i < crops.size(); i++)
         if (crops[i]->hasListener() && (panningRelatedChange || (highDetailNeeded && options.prevdemo != PD_Sidecar) || (todo & (M_MONITOR | M_RGBCURVE | M_LUMACURVE)) || crops[i]->get_skip() == 1)) {
             crops[i]->update(todo);     // may call ourselves
@@ -27,8 +27,10 @@
 #include "rawimagesource.h"
 #include "improcfun.h"
 #include "improccoordinator.h"
+#include "instrumentation.h"
 #include "dfmanager.h"
 #include "ffmanager.h"
+#include "fftwplancache.h"
 #include "rtthumbnail.h"
 #include "profilestore.h"
 #include "../rtgui/threadutils.h"
@@ -106,14 +108,26 @@ int init (const Settings* s, const Glib::ustring& baseDir, const Glib::ustring&
     delete lcmsMutex;
     lcmsMutex = new MyMutex;
     fftwMutex = new MyMutex;
+    initFftw();
+
+    if (!s->traceFile.empty()) {
+        const Glib::ustring traceFile = Glib::path_is_absolute(s->traceFile) ? s->traceFile : Glib::build_filename(userSettingsDir, s->traceFile);
+
+        if (!instrumentation::start(traceFile)) {
+            printf("Could not create the trace file \"%s\"\n", traceFile.c_str());
+        }
+    }
+
     return 0;
 }
 
 void cleanup ()
 {
+    instrumentation::stop ();
     ProcParams::cleanup ();
     Color::cleanup ();
     RawImageSource::cleanup ();
+    cleanupFftwPlans ();
 
 #ifdef RT_FFTW3F_OMP
     fftwf_cleanup_threads();
@@ -0,0 +1,252 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+#include <glib/gstdio.h>
+
+#include "instrumentation.h"
+
+#include "../rtgui/threadutils.h"
+
+namespace
+{
+
+std::atomic<bool> active(false);
+std::atomic<std::int64_t> bufferBytes(0);
+std::atomic<int> threadCount(0);
+
+// peaks of the stages in progress, in all threads: concurrent stages (e.g. the -J pipeline of rawtherapee-cli) each
+// keep the high-water mark of the buffers during their own lifetime
+MyMutex peaksMutex;
+std::vector<std::int64_t*> openPeaks;
+
+MyMutex fileMutex;
+FILE* file = nullptr;
+bool chromeTrace = false;
+bool firstEvent = true;
+
+const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+std::int64_t wallTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// CPU time of the whole process, the stages use all the OpenMP threads
+std::int64_t cpuTime()
+{
+#ifdef WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+
+    const auto toMicroseconds = [](const FILETIME& time) {
+        return static_cast<std::int64_t>((static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10;
+    };
+
+    return toMicroseconds(kernelTime) + toMicroseconds(userTime);
+#else
+    timespec time;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time)) {
+        return 0;
+    }
+
+    return static_cast<std::int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+int threadId()
+{
+    thread_local const int id = ++threadCount;
+    return id;
+}
+
+void updatePeaks(std::int64_t bytes)
+{
+    MyMutex::MyLock lock(peaksMutex);
+
+    for (auto peak : openPeaks) {
+        *peak = std::max(*peak, bytes);
+    }
+}
+
+void closeFile()
+{
+    if (file) {
+        if (chromeTrace) {
+            fputs("\n]}\n", file);
+        }
+
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+}
+
+namespace rtengine
+{
+
+namespace instrumentation
+{
+
+bool start(const std::string& fileName)
+{
+    MyMutex::MyLock lock(fileMutex);
+
+    active = false;
+    closeFile();
+
+    file = g_fopen(fileName.c_str(), "w");
+
+    if (!file) {
+        return false;
+    }
+
+    chromeTrace = !(fileName.size() >= 6 && fileName.compare(fileName.size() - 6, 6, ".jsonl") == 0);
+    firstEvent = true;
+
+    if (chromeTrace) {
+        fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", file);
+    }
+
+    active = true;
+    return true;
+}
+
+void stop()
+{
+    MyMutex::MyLock lock(fileMutex);
+
+    active = false;
+    closeFile();
+}
+
+bool isActive()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+void bufferBytesChanged(std::ptrdiff_t delta)
+{
+    const std::int64_t bytes = bufferBytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+
+    if (delta > 0 && active.load(std::memory_order_relaxed)) {
+        updatePeaks(bytes);
+    }
+}
+
+Stage::Stage(const char* name, const char* category) :
+    name(name),
+    category(category),
+    active(false),
+    startTime(0),
+    startCpuTime(0),
+    startBytes(0),
+    peakBytes(0)
+{
+    begin(name);
+}
+
+Stage::~Stage()
+{
+    end();
+}
+
+void Stage::next(const char* name)
+{
+    end();
+    begin(name);
+}
+
+void Stage::begin(const char* name)
+{
+    this->name = name;
+    active = isActive();
+
+    if (!active) {
+        return;
+    }
+
+    {
+        MyMutex::MyLock lock(peaksMutex);
+        startBytes = bufferBytes.load(std::memory_order_relaxed);
+        peakBytes = startBytes;
+        openPeaks.push_back(&peakBytes);
+    }
+
+    startCpuTime = cpuTime();
+    startTime = wallTime();
+}
+
+void Stage::end()
+{
+    if (!active) {
+        return;
+    }
+
+    active = false;
+
+    const std::int64_t duration = wallTime() - startTime;
+    const std::int64_t cpuDuration = cpuTime() - startCpuTime;
+    std::int64_t peak;
+
+    {
+        MyMutex::MyLock lock(peaksMutex);
+        openPeaks.erase(std::find(openPeaks.begin(), openPeaks.end(), &peakBytes));
+        peak = peakBytes;
+    }
+
+    const std::int64_t endBytes = bufferBytes.load(std::memory_order_relaxed);
+
+    MyMutex::MyLock lock(fileMutex);
+
+    if (!file) {
+        return;
+    }
+
+    if (chromeTrace) {
+        fprintf(file, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %" PRId64 ", \"dur\": %" PRId64 ", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"cpu_us\": %" PRId64 ", \"bytes_start\": %" PRId64 ", \"bytes_end\": %" PRId64 ", \"bytes_peak\": %" PRId64 "}}",
+                firstEvent ? "" : ",\n", name, category, startTime, duration, threadId(), cpuDuration, startBytes, endBytes, peak);
+    } else {
+        fprintf(file, "{\"name\": \"%s\", \"cat\": \"%s\", \"ts_us\": %" PRId64 ", \"wall_us\": %" PRId64 ", \"cpu_us\": %" PRId64 ", \"thread\": %d, "
+                "\"bytes_start\": %" PRId64 ", \"bytes_end\": %" PRId64 ", \"bytes_peak\": %" PRId64 "}\n",
+                name, category, startTime, duration, cpuDuration, threadId(), startBytes, endBytes, peak);
+    }
+
+    firstEvent = false;
+    fflush(file);
+}
+
+}
+
+}
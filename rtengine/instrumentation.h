@@ -0,0 +1,79 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "noncopyable.h"
+
+/* Runtime-enabled instrumentation of the processing stages.
+ *
+ * Unlike BENCHFUN, it is always compiled in. When it is started, each Stage records its wall time, the CPU time of the
+ * process and the high-water mark of the image buffers (AlignedBuffer, LabImage, array2D and the RawImage buffers) allocated
+ * by the process while it ran.
+ * The events are written as JSON lines (".jsonl" file) or in the Chrome trace format (any other file name, can be
+ * loaded in chrome://tracing or Perfetto). When it is not started, a Stage only costs an atomic load. */
+
+namespace rtengine
+{
+
+namespace instrumentation
+{
+
+/** Starts recording to the given file, replacing any recording in progress.
+  * @return false if the file could not be created */
+bool start (const std::string& fileName);
+
+/** Stops recording and closes the file */
+void stop ();
+
+bool isActive ();
+
+/** Accounts the allocation (positive delta) or release (negative delta) of an image buffer, always called */
+void bufferBytesChanged (std::ptrdiff_t delta);
+
+class Stage final :
+    public NonCopyable
+{
+public:
+    /** Starts a stage, which lasts until next() or the destruction of the object
+      * @param name is the name of the stage, it must be a string literal
+      * @param category groups the stages in the output (e.g. "processImage", "ImProcCoordinator", "save") */
+    Stage (const char* name, const char* category);
+    ~Stage ();
+
+    /** Ends the current stage and starts a new one of the same category */
+    void next (const char* name);
+
+private:
+    void begin (const char* name);
+    void end ();
+
+    const char* name;
+    const char* const category;
+    bool active;
+    std::int64_t startTime;
+    std::int64_t startCpuTime;
+    std::int64_t startBytes;
+    std::int64_t peakBytes; // updated by bufferBytesChanged() while the stage is in progress
+};
+
+}
+
+}
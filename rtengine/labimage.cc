@@ -19,6 +19,7 @@
 
 #include <memory>
 
+#include "instrumentation.h"
 #include "labimage.h"
 
 namespace rtengine
@@ -70,6 +71,7 @@ void LabImage::allocLab(size_t w, size_t h)
     b = new float*[h];
 
     data = new float [w * h * 3];
+    instrumentation::bufferBytesChanged(w * h * 3 * sizeof(float));
     float * index = data;
 
     for (size_t i = 0; i < h; i++) {
@@ -95,6 +97,7 @@ void LabImage::deleteLab()
     delete [] a;
     delete [] b;
     delete [] data;
+    instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(W * H * 3 * sizeof(float)));
 }
 
 void LabImage::reallocLab()
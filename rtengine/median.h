@@ -6298,3 +6298,2628 @@ inline std::array<T, 4> middle4of6(T arg0, T arg1, T arg2, T arg3, T arg4, T arg
 {
     return middle4of6(std::array<T, 6>{std::move(arg0), std::move(arg1), std::move(arg2), std::move(arg3), std::move(arg4), std::move(arg5)});
 }
+
+#ifdef __SSE2__
+/* Medians of two vertically adjacent 7x7 or 9x9 windows, which share all their rows but one.
+ *
+ * sortColumn sorts the values of a column of the shared rows. medianPair takes the shared rows with each column sorted,
+ * array[(size - 1) * column + row] for column in [0, size) and row in [0, size - 1), followed by the row only in the
+ * upper window and by the row only in the lower window. It returns the median of the upper window, then the median of
+ * the lower window.
+ *
+ * The sorted columns are merged once for both windows, then each window merges its own row. Only the comparisons the
+ * middle element depends on are kept, which is about half of the comparisons of the networks of the single windows.
+ * When the filter slides along a pair of rows, each column is sorted once for size windows.
+ *
+ * The functions are generated and checked by tools/generateMedianNetworks, which describes the construction: optimal
+ * networks for the columns, Batcher odd-even merges of the columns in the cheapest merge tree, Batcher sort and merge of
+ * the row of each window, then removal of the comparisons the middle element does not depend on. */
+inline void sortColumn(std::array<vfloat, 6>& array)
+{
+    vfloat tmp;
+    tmp = vminf(array[0], array[5]);
+    array[5] = vmaxf(array[0], array[5]);
+    array[0] = tmp;
+    tmp = vminf(array[1], array[3]);
+    array[3] = vmaxf(array[1], array[3]);
+    array[1] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[0], array[3]);
+    array[3] = vmaxf(array[0], array[3]);
+    array[0] = tmp;
+    tmp = vminf(array[2], array[5]);
+    array[5] = vmaxf(array[2], array[5]);
+    array[2] = tmp;
+    tmp = vminf(array[0], array[1]);
+    array[1] = vmaxf(array[0], array[1]);
+    array[0] = tmp;
+    tmp = vminf(array[2], array[3]);
+    array[3] = vmaxf(array[2], array[3]);
+    array[2] = tmp;
+    tmp = vminf(array[4], array[5]);
+    array[5] = vmaxf(array[4], array[5]);
+    array[4] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+}
+
+inline std::array<vfloat, 2> medianPair(std::array<vfloat, 56> array)
+{
+    vfloat tmp;
+    tmp = vminf(array[6], array[12]);
+    array[12] = vmaxf(array[6], array[12]);
+    array[6] = tmp;
+    tmp = vminf(array[10], array[16]);
+    array[16] = vmaxf(array[10], array[16]);
+    array[10] = tmp;
+    tmp = vminf(array[10], array[12]);
+    array[12] = vmaxf(array[10], array[12]);
+    array[10] = tmp;
+    tmp = vminf(array[8], array[14]);
+    array[14] = vmaxf(array[8], array[14]);
+    array[8] = tmp;
+    tmp = vminf(array[8], array[10]);
+    array[10] = vmaxf(array[8], array[10]);
+    array[8] = tmp;
+    tmp = vminf(array[14], array[12]);
+    array[12] = vmaxf(array[14], array[12]);
+    array[14] = tmp;
+    tmp = vminf(array[7], array[13]);
+    array[13] = vmaxf(array[7], array[13]);
+    array[7] = tmp;
+    tmp = vminf(array[11], array[17]);
+    array[17] = vmaxf(array[11], array[17]);
+    array[11] = tmp;
+    tmp = vminf(array[11], array[13]);
+    array[13] = vmaxf(array[11], array[13]);
+    array[11] = tmp;
+    tmp = vminf(array[9], array[15]);
+    array[15] = vmaxf(array[9], array[15]);
+    array[9] = tmp;
+    tmp = vminf(array[9], array[11]);
+    array[11] = vmaxf(array[9], array[11]);
+    array[9] = tmp;
+    tmp = vminf(array[15], array[13]);
+    array[13] = vmaxf(array[15], array[13]);
+    array[15] = tmp;
+    tmp = vminf(array[7], array[8]);
+    array[8] = vmaxf(array[7], array[8]);
+    array[7] = tmp;
+    tmp = vminf(array[9], array[10]);
+    array[10] = vmaxf(array[9], array[10]);
+    array[9] = tmp;
+    tmp = vminf(array[11], array[14]);
+    array[14] = vmaxf(array[11], array[14]);
+    array[11] = tmp;
+    tmp = vminf(array[15], array[12]);
+    array[12] = vmaxf(array[15], array[12]);
+    array[15] = tmp;
+    tmp = vminf(array[13], array[16]);
+    array[16] = vmaxf(array[13], array[16]);
+    array[13] = tmp;
+    tmp = vminf(array[0], array[6]);
+    array[6] = vmaxf(array[0], array[6]);
+    array[0] = tmp;
+    tmp = vminf(array[12], array[6]);
+    array[6] = vmaxf(array[12], array[6]);
+    array[12] = tmp;
+    tmp = vminf(array[4], array[10]);
+    array[10] = vmaxf(array[4], array[10]);
+    array[4] = tmp;
+    tmp = vminf(array[4], array[12]);
+    array[12] = vmaxf(array[4], array[12]);
+    array[4] = tmp;
+    tmp = vminf(array[10], array[6]);
+    array[6] = vmaxf(array[10], array[6]);
+    array[10] = tmp;
+    tmp = vminf(array[2], array[8]);
+    array[8] = vmaxf(array[2], array[8]);
+    array[2] = tmp;
+    tmp = vminf(array[16], array[8]);
+    array[8] = vmaxf(array[16], array[8]);
+    array[16] = tmp;
+    tmp = vminf(array[14], array[16]);
+    array[16] = vmaxf(array[14], array[16]);
+    array[14] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[14], array[12]);
+    array[12] = vmaxf(array[14], array[12]);
+    array[14] = tmp;
+    tmp = vminf(array[16], array[10]);
+    array[10] = vmaxf(array[16], array[10]);
+    array[16] = tmp;
+    tmp = vminf(array[8], array[6]);
+    array[6] = vmaxf(array[8], array[6]);
+    array[8] = tmp;
+    tmp = vminf(array[1], array[7]);
+    array[7] = vmaxf(array[1], array[7]);
+    array[1] = tmp;
+    tmp = vminf(array[13], array[7]);
+    array[7] = vmaxf(array[13], array[7]);
+    array[13] = tmp;
+    tmp = vminf(array[5], array[11]);
+    array[11] = vmaxf(array[5], array[11]);
+    array[5] = tmp;
+    tmp = vminf(array[5], array[13]);
+    array[13] = vmaxf(array[5], array[13]);
+    array[5] = tmp;
+    tmp = vminf(array[11], array[7]);
+    array[7] = vmaxf(array[11], array[7]);
+    array[11] = tmp;
+    tmp = vminf(array[3], array[9]);
+    array[9] = vmaxf(array[3], array[9]);
+    array[3] = tmp;
+    tmp = vminf(array[17], array[9]);
+    array[9] = vmaxf(array[17], array[9]);
+    array[17] = tmp;
+    tmp = vminf(array[15], array[17]);
+    array[17] = vmaxf(array[15], array[17]);
+    array[15] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    tmp = vminf(array[15], array[13]);
+    array[13] = vmaxf(array[15], array[13]);
+    array[15] = tmp;
+    tmp = vminf(array[17], array[11]);
+    array[11] = vmaxf(array[17], array[11]);
+    array[17] = tmp;
+    tmp = vminf(array[9], array[7]);
+    array[7] = vmaxf(array[9], array[7]);
+    array[9] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[14]);
+    array[14] = vmaxf(array[5], array[14]);
+    array[5] = tmp;
+    tmp = vminf(array[15], array[12]);
+    array[12] = vmaxf(array[15], array[12]);
+    array[15] = tmp;
+    tmp = vminf(array[13], array[16]);
+    array[16] = vmaxf(array[13], array[16]);
+    array[13] = tmp;
+    tmp = vminf(array[17], array[10]);
+    array[10] = vmaxf(array[17], array[10]);
+    array[17] = tmp;
+    tmp = vminf(array[11], array[8]);
+    array[8] = vmaxf(array[11], array[8]);
+    array[11] = tmp;
+    tmp = vminf(array[9], array[6]);
+    array[6] = vmaxf(array[9], array[6]);
+    array[9] = tmp;
+    tmp = vminf(array[18], array[24]);
+    array[24] = vmaxf(array[18], array[24]);
+    array[18] = tmp;
+    tmp = vminf(array[22], array[28]);
+    array[28] = vmaxf(array[22], array[28]);
+    array[22] = tmp;
+    tmp = vminf(array[22], array[24]);
+    array[24] = vmaxf(array[22], array[24]);
+    array[22] = tmp;
+    tmp = vminf(array[20], array[26]);
+    array[26] = vmaxf(array[20], array[26]);
+    array[20] = tmp;
+    tmp = vminf(array[20], array[22]);
+    array[22] = vmaxf(array[20], array[22]);
+    array[20] = tmp;
+    tmp = vminf(array[26], array[24]);
+    array[24] = vmaxf(array[26], array[24]);
+    array[26] = tmp;
+    tmp = vminf(array[19], array[25]);
+    array[25] = vmaxf(array[19], array[25]);
+    array[19] = tmp;
+    tmp = vminf(array[23], array[29]);
+    array[29] = vmaxf(array[23], array[29]);
+    array[23] = tmp;
+    tmp = vminf(array[23], array[25]);
+    array[25] = vmaxf(array[23], array[25]);
+    array[23] = tmp;
+    tmp = vminf(array[21], array[27]);
+    array[27] = vmaxf(array[21], array[27]);
+    array[21] = tmp;
+    tmp = vminf(array[21], array[23]);
+    array[23] = vmaxf(array[21], array[23]);
+    array[21] = tmp;
+    tmp = vminf(array[27], array[25]);
+    array[25] = vmaxf(array[27], array[25]);
+    array[27] = tmp;
+    tmp = vminf(array[19], array[20]);
+    array[20] = vmaxf(array[19], array[20]);
+    array[19] = tmp;
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[26]);
+    array[26] = vmaxf(array[23], array[26]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[24]);
+    array[24] = vmaxf(array[27], array[24]);
+    array[27] = tmp;
+    tmp = vminf(array[25], array[28]);
+    array[28] = vmaxf(array[25], array[28]);
+    array[25] = tmp;
+    tmp = vminf(array[30], array[36]);
+    array[36] = vmaxf(array[30], array[36]);
+    array[30] = tmp;
+    tmp = vminf(array[34], array[40]);
+    array[40] = vmaxf(array[34], array[40]);
+    array[34] = tmp;
+    tmp = vminf(array[34], array[36]);
+    array[36] = vmaxf(array[34], array[36]);
+    array[34] = tmp;
+    tmp = vminf(array[32], array[38]);
+    array[38] = vmaxf(array[32], array[38]);
+    array[32] = tmp;
+    tmp = vminf(array[32], array[34]);
+    array[34] = vmaxf(array[32], array[34]);
+    array[32] = tmp;
+    tmp = vminf(array[38], array[36]);
+    array[36] = vmaxf(array[38], array[36]);
+    array[38] = tmp;
+    tmp = vminf(array[31], array[37]);
+    array[37] = vmaxf(array[31], array[37]);
+    array[31] = tmp;
+    tmp = vminf(array[35], array[41]);
+    array[41] = vmaxf(array[35], array[41]);
+    array[35] = tmp;
+    tmp = vminf(array[35], array[37]);
+    array[37] = vmaxf(array[35], array[37]);
+    array[35] = tmp;
+    tmp = vminf(array[33], array[39]);
+    array[39] = vmaxf(array[33], array[39]);
+    array[33] = tmp;
+    tmp = vminf(array[33], array[35]);
+    array[35] = vmaxf(array[33], array[35]);
+    array[33] = tmp;
+    tmp = vminf(array[39], array[37]);
+    array[37] = vmaxf(array[39], array[37]);
+    array[39] = tmp;
+    tmp = vminf(array[31], array[32]);
+    array[32] = vmaxf(array[31], array[32]);
+    array[31] = tmp;
+    tmp = vminf(array[33], array[34]);
+    array[34] = vmaxf(array[33], array[34]);
+    array[33] = tmp;
+    tmp = vminf(array[35], array[38]);
+    array[38] = vmaxf(array[35], array[38]);
+    array[35] = tmp;
+    tmp = vminf(array[39], array[36]);
+    array[36] = vmaxf(array[39], array[36]);
+    array[39] = tmp;
+    tmp = vminf(array[37], array[40]);
+    array[40] = vmaxf(array[37], array[40]);
+    array[37] = tmp;
+    tmp = vminf(array[18], array[30]);
+    array[30] = vmaxf(array[18], array[30]);
+    array[18] = tmp;
+    tmp = vminf(array[24], array[36]);
+    array[36] = vmaxf(array[24], array[36]);
+    array[24] = tmp;
+    tmp = vminf(array[24], array[30]);
+    array[30] = vmaxf(array[24], array[30]);
+    array[24] = tmp;
+    tmp = vminf(array[22], array[34]);
+    array[34] = vmaxf(array[22], array[34]);
+    array[22] = tmp;
+    tmp = vminf(array[22], array[24]);
+    array[24] = vmaxf(array[22], array[24]);
+    array[22] = tmp;
+    tmp = vminf(array[34], array[30]);
+    array[30] = vmaxf(array[34], array[30]);
+    array[34] = tmp;
+    tmp = vminf(array[20], array[32]);
+    array[32] = vmaxf(array[20], array[32]);
+    array[20] = tmp;
+    tmp = vminf(array[28], array[40]);
+    array[40] = vmaxf(array[28], array[40]);
+    array[28] = tmp;
+    tmp = vminf(array[28], array[32]);
+    array[32] = vmaxf(array[28], array[32]);
+    array[28] = tmp;
+    tmp = vminf(array[26], array[38]);
+    array[38] = vmaxf(array[26], array[38]);
+    array[26] = tmp;
+    tmp = vminf(array[26], array[28]);
+    array[28] = vmaxf(array[26], array[28]);
+    array[26] = tmp;
+    tmp = vminf(array[38], array[32]);
+    array[32] = vmaxf(array[38], array[32]);
+    array[38] = tmp;
+    tmp = vminf(array[20], array[22]);
+    array[22] = vmaxf(array[20], array[22]);
+    array[20] = tmp;
+    tmp = vminf(array[26], array[24]);
+    array[24] = vmaxf(array[26], array[24]);
+    array[26] = tmp;
+    tmp = vminf(array[28], array[34]);
+    array[34] = vmaxf(array[28], array[34]);
+    array[28] = tmp;
+    tmp = vminf(array[38], array[30]);
+    array[30] = vmaxf(array[38], array[30]);
+    array[38] = tmp;
+    tmp = vminf(array[32], array[36]);
+    array[36] = vmaxf(array[32], array[36]);
+    array[32] = tmp;
+    tmp = vminf(array[19], array[31]);
+    array[31] = vmaxf(array[19], array[31]);
+    array[19] = tmp;
+    tmp = vminf(array[25], array[37]);
+    array[37] = vmaxf(array[25], array[37]);
+    array[25] = tmp;
+    tmp = vminf(array[25], array[31]);
+    array[31] = vmaxf(array[25], array[31]);
+    array[25] = tmp;
+    tmp = vminf(array[23], array[35]);
+    array[35] = vmaxf(array[23], array[35]);
+    array[23] = tmp;
+    tmp = vminf(array[23], array[25]);
+    array[25] = vmaxf(array[23], array[25]);
+    array[23] = tmp;
+    tmp = vminf(array[35], array[31]);
+    array[31] = vmaxf(array[35], array[31]);
+    array[35] = tmp;
+    tmp = vminf(array[21], array[33]);
+    array[33] = vmaxf(array[21], array[33]);
+    array[21] = tmp;
+    tmp = vminf(array[29], array[41]);
+    array[41] = vmaxf(array[29], array[41]);
+    array[29] = tmp;
+    tmp = vminf(array[29], array[33]);
+    array[33] = vmaxf(array[29], array[33]);
+    array[29] = tmp;
+    tmp = vminf(array[27], array[39]);
+    array[39] = vmaxf(array[27], array[39]);
+    array[27] = tmp;
+    tmp = vminf(array[27], array[29]);
+    array[29] = vmaxf(array[27], array[29]);
+    array[27] = tmp;
+    tmp = vminf(array[39], array[33]);
+    array[33] = vmaxf(array[39], array[33]);
+    array[39] = tmp;
+    tmp = vminf(array[21], array[23]);
+    array[23] = vmaxf(array[21], array[23]);
+    array[21] = tmp;
+    tmp = vminf(array[27], array[25]);
+    array[25] = vmaxf(array[27], array[25]);
+    array[27] = tmp;
+    tmp = vminf(array[29], array[35]);
+    array[35] = vmaxf(array[29], array[35]);
+    array[29] = tmp;
+    tmp = vminf(array[39], array[31]);
+    array[31] = vmaxf(array[39], array[31]);
+    array[39] = tmp;
+    tmp = vminf(array[33], array[37]);
+    array[37] = vmaxf(array[33], array[37]);
+    array[33] = tmp;
+    tmp = vminf(array[19], array[20]);
+    array[20] = vmaxf(array[19], array[20]);
+    array[19] = tmp;
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[26]);
+    array[26] = vmaxf(array[23], array[26]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[24]);
+    array[24] = vmaxf(array[27], array[24]);
+    array[27] = tmp;
+    tmp = vminf(array[25], array[28]);
+    array[28] = vmaxf(array[25], array[28]);
+    array[25] = tmp;
+    tmp = vminf(array[29], array[34]);
+    array[34] = vmaxf(array[29], array[34]);
+    array[29] = tmp;
+    tmp = vminf(array[35], array[38]);
+    array[38] = vmaxf(array[35], array[38]);
+    array[35] = tmp;
+    tmp = vminf(array[39], array[30]);
+    array[30] = vmaxf(array[39], array[30]);
+    array[39] = tmp;
+    tmp = vminf(array[31], array[32]);
+    array[32] = vmaxf(array[31], array[32]);
+    array[31] = tmp;
+    tmp = vminf(array[33], array[36]);
+    array[36] = vmaxf(array[33], array[36]);
+    array[33] = tmp;
+    tmp = vminf(array[37], array[40]);
+    array[40] = vmaxf(array[37], array[40]);
+    array[37] = tmp;
+    tmp = vminf(array[0], array[18]);
+    array[18] = vmaxf(array[0], array[18]);
+    array[0] = tmp;
+    tmp = vminf(array[6], array[30]);
+    array[30] = vmaxf(array[6], array[30]);
+    array[6] = tmp;
+    tmp = vminf(array[6], array[18]);
+    array[18] = vmaxf(array[6], array[18]);
+    array[6] = tmp;
+    tmp = vminf(array[12], array[24]);
+    array[24] = vmaxf(array[12], array[24]);
+    array[12] = tmp;
+    tmp = vminf(array[12], array[6]);
+    array[6] = vmaxf(array[12], array[6]);
+    array[12] = tmp;
+    tmp = vminf(array[24], array[18]);
+    array[18] = vmaxf(array[24], array[18]);
+    array[24] = tmp;
+    tmp = vminf(array[4], array[22]);
+    array[22] = vmaxf(array[4], array[22]);
+    array[4] = tmp;
+    tmp = vminf(array[36], array[22]);
+    array[22] = vmaxf(array[36], array[22]);
+    array[36] = tmp;
+    tmp = vminf(array[10], array[34]);
+    array[34] = vmaxf(array[10], array[34]);
+    array[10] = tmp;
+    tmp = vminf(array[10], array[36]);
+    array[36] = vmaxf(array[10], array[36]);
+    array[10] = tmp;
+    tmp = vminf(array[34], array[22]);
+    array[22] = vmaxf(array[34], array[22]);
+    array[34] = tmp;
+    tmp = vminf(array[4], array[12]);
+    array[12] = vmaxf(array[4], array[12]);
+    array[4] = tmp;
+    tmp = vminf(array[10], array[6]);
+    array[6] = vmaxf(array[10], array[6]);
+    array[10] = tmp;
+    tmp = vminf(array[36], array[24]);
+    array[24] = vmaxf(array[36], array[24]);
+    array[36] = tmp;
+    tmp = vminf(array[34], array[18]);
+    array[18] = vmaxf(array[34], array[18]);
+    array[34] = tmp;
+    tmp = vminf(array[22], array[30]);
+    array[30] = vmaxf(array[22], array[30]);
+    array[22] = tmp;
+    tmp = vminf(array[2], array[20]);
+    array[20] = vmaxf(array[2], array[20]);
+    array[2] = tmp;
+    tmp = vminf(array[32], array[20]);
+    array[20] = vmaxf(array[32], array[20]);
+    array[32] = tmp;
+    tmp = vminf(array[16], array[28]);
+    array[28] = vmaxf(array[16], array[28]);
+    array[16] = tmp;
+    tmp = vminf(array[16], array[32]);
+    array[32] = vmaxf(array[16], array[32]);
+    array[16] = tmp;
+    tmp = vminf(array[28], array[20]);
+    array[20] = vmaxf(array[28], array[20]);
+    array[28] = tmp;
+    tmp = vminf(array[14], array[26]);
+    array[26] = vmaxf(array[14], array[26]);
+    array[14] = tmp;
+    tmp = vminf(array[40], array[26]);
+    array[26] = vmaxf(array[40], array[26]);
+    array[40] = tmp;
+    tmp = vminf(array[8], array[38]);
+    array[38] = vmaxf(array[8], array[38]);
+    array[8] = tmp;
+    tmp = vminf(array[8], array[40]);
+    array[40] = vmaxf(array[8], array[40]);
+    array[8] = tmp;
+    tmp = vminf(array[38], array[26]);
+    array[26] = vmaxf(array[38], array[26]);
+    array[38] = tmp;
+    tmp = vminf(array[14], array[16]);
+    array[16] = vmaxf(array[14], array[16]);
+    array[14] = tmp;
+    tmp = vminf(array[8], array[32]);
+    array[32] = vmaxf(array[8], array[32]);
+    array[8] = tmp;
+    tmp = vminf(array[40], array[28]);
+    array[28] = vmaxf(array[40], array[28]);
+    array[40] = tmp;
+    tmp = vminf(array[38], array[20]);
+    array[20] = vmaxf(array[38], array[20]);
+    array[38] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    array[14] = vminf(array[14], array[12]);
+    array[10] = vmaxf(array[16], array[10]);
+    tmp = vminf(array[8], array[6]);
+    array[6] = vmaxf(array[8], array[6]);
+    array[8] = tmp;
+    tmp = vminf(array[32], array[36]);
+    array[36] = vmaxf(array[32], array[36]);
+    array[32] = tmp;
+    tmp = vminf(array[40], array[24]);
+    array[24] = vmaxf(array[40], array[24]);
+    array[40] = tmp;
+    tmp = vminf(array[28], array[34]);
+    array[34] = vmaxf(array[28], array[34]);
+    array[28] = tmp;
+    array[18] = vmaxf(array[38], array[18]);
+    tmp = vminf(array[20], array[22]);
+    array[22] = vmaxf(array[20], array[22]);
+    array[20] = tmp;
+    tmp = vminf(array[26], array[30]);
+    array[30] = vmaxf(array[26], array[30]);
+    array[26] = tmp;
+    tmp = vminf(array[1], array[19]);
+    array[19] = vmaxf(array[1], array[19]);
+    array[1] = tmp;
+    tmp = vminf(array[7], array[31]);
+    array[31] = vmaxf(array[7], array[31]);
+    array[7] = tmp;
+    tmp = vminf(array[7], array[19]);
+    array[19] = vmaxf(array[7], array[19]);
+    array[7] = tmp;
+    tmp = vminf(array[13], array[25]);
+    array[25] = vmaxf(array[13], array[25]);
+    array[13] = tmp;
+    tmp = vminf(array[13], array[7]);
+    array[7] = vmaxf(array[13], array[7]);
+    array[13] = tmp;
+    tmp = vminf(array[25], array[19]);
+    array[19] = vmaxf(array[25], array[19]);
+    array[25] = tmp;
+    tmp = vminf(array[5], array[23]);
+    array[23] = vmaxf(array[5], array[23]);
+    array[5] = tmp;
+    tmp = vminf(array[37], array[23]);
+    array[23] = vmaxf(array[37], array[23]);
+    array[37] = tmp;
+    tmp = vminf(array[11], array[35]);
+    array[35] = vmaxf(array[11], array[35]);
+    array[11] = tmp;
+    tmp = vminf(array[11], array[37]);
+    array[37] = vmaxf(array[11], array[37]);
+    array[11] = tmp;
+    tmp = vminf(array[35], array[23]);
+    array[23] = vmaxf(array[35], array[23]);
+    array[35] = tmp;
+    array[5] = vminf(array[5], array[13]);
+    tmp = vminf(array[11], array[7]);
+    array[7] = vmaxf(array[11], array[7]);
+    array[11] = tmp;
+    tmp = vminf(array[37], array[25]);
+    array[25] = vmaxf(array[37], array[25]);
+    array[37] = tmp;
+    tmp = vminf(array[35], array[19]);
+    array[19] = vmaxf(array[35], array[19]);
+    array[35] = tmp;
+    tmp = vminf(array[23], array[31]);
+    array[31] = vmaxf(array[23], array[31]);
+    array[23] = tmp;
+    tmp = vminf(array[3], array[21]);
+    array[21] = vmaxf(array[3], array[21]);
+    array[3] = tmp;
+    tmp = vminf(array[33], array[21]);
+    array[21] = vmaxf(array[33], array[21]);
+    array[33] = tmp;
+    tmp = vminf(array[17], array[29]);
+    array[29] = vmaxf(array[17], array[29]);
+    array[17] = tmp;
+    tmp = vminf(array[17], array[33]);
+    array[33] = vmaxf(array[17], array[33]);
+    array[17] = tmp;
+    tmp = vminf(array[29], array[21]);
+    array[21] = vmaxf(array[29], array[21]);
+    array[29] = tmp;
+    tmp = vminf(array[15], array[27]);
+    array[27] = vmaxf(array[15], array[27]);
+    array[15] = tmp;
+    tmp = vminf(array[41], array[27]);
+    array[27] = vmaxf(array[41], array[27]);
+    array[41] = tmp;
+    tmp = vminf(array[9], array[39]);
+    array[39] = vmaxf(array[9], array[39]);
+    array[9] = tmp;
+    tmp = vminf(array[9], array[41]);
+    array[41] = vmaxf(array[9], array[41]);
+    array[9] = tmp;
+    tmp = vminf(array[39], array[27]);
+    array[27] = vmaxf(array[39], array[27]);
+    array[39] = tmp;
+    array[17] = vmaxf(array[15], array[17]);
+    tmp = vminf(array[9], array[33]);
+    array[33] = vmaxf(array[9], array[33]);
+    array[9] = tmp;
+    tmp = vminf(array[41], array[29]);
+    array[29] = vmaxf(array[41], array[29]);
+    array[41] = tmp;
+    tmp = vminf(array[39], array[21]);
+    array[21] = vmaxf(array[39], array[21]);
+    array[39] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    tmp = vminf(array[17], array[11]);
+    array[11] = vmaxf(array[17], array[11]);
+    array[17] = tmp;
+    tmp = vminf(array[9], array[7]);
+    array[7] = vmaxf(array[9], array[7]);
+    array[9] = tmp;
+    tmp = vminf(array[33], array[37]);
+    array[37] = vmaxf(array[33], array[37]);
+    array[33] = tmp;
+    tmp = vminf(array[41], array[25]);
+    array[25] = vmaxf(array[41], array[25]);
+    array[41] = tmp;
+    array[29] = vminf(array[29], array[35]);
+    tmp = vminf(array[39], array[19]);
+    array[19] = vmaxf(array[39], array[19]);
+    array[39] = tmp;
+    tmp = vminf(array[21], array[23]);
+    array[23] = vmaxf(array[21], array[23]);
+    array[21] = tmp;
+    tmp = vminf(array[27], array[31]);
+    array[31] = vmaxf(array[27], array[31]);
+    array[27] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[14]);
+    array[14] = vmaxf(array[5], array[14]);
+    array[5] = tmp;
+    array[10] = vmaxf(array[17], array[10]);
+    tmp = vminf(array[11], array[8]);
+    array[8] = vmaxf(array[11], array[8]);
+    array[11] = tmp;
+    tmp = vminf(array[9], array[6]);
+    array[6] = vmaxf(array[9], array[6]);
+    array[9] = tmp;
+    tmp = vminf(array[7], array[32]);
+    array[32] = vmaxf(array[7], array[32]);
+    array[7] = tmp;
+    tmp = vminf(array[33], array[36]);
+    array[36] = vmaxf(array[33], array[36]);
+    array[33] = tmp;
+    tmp = vminf(array[37], array[40]);
+    array[40] = vmaxf(array[37], array[40]);
+    array[37] = tmp;
+    tmp = vminf(array[41], array[24]);
+    array[24] = vmaxf(array[41], array[24]);
+    array[41] = tmp;
+    tmp = vminf(array[25], array[28]);
+    array[28] = vmaxf(array[25], array[28]);
+    array[25] = tmp;
+    array[29] = vminf(array[29], array[34]);
+    array[18] = vmaxf(array[39], array[18]);
+    tmp = vminf(array[19], array[20]);
+    array[20] = vmaxf(array[19], array[20]);
+    array[19] = tmp;
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[26]);
+    array[26] = vmaxf(array[23], array[26]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[30]);
+    array[30] = vmaxf(array[27], array[30]);
+    array[27] = tmp;
+
+    std::array<vfloat, 56> lower = array;
+    tmp = vminf(lower[50], lower[51]);
+    lower[51] = vmaxf(lower[50], lower[51]);
+    lower[50] = tmp;
+    tmp = vminf(lower[49], lower[50]);
+    lower[50] = vmaxf(lower[49], lower[50]);
+    lower[49] = tmp;
+    tmp = vminf(lower[51], lower[50]);
+    lower[50] = vmaxf(lower[51], lower[50]);
+    lower[51] = tmp;
+    tmp = vminf(lower[52], lower[53]);
+    lower[53] = vmaxf(lower[52], lower[53]);
+    lower[52] = tmp;
+    tmp = vminf(lower[54], lower[55]);
+    lower[55] = vmaxf(lower[54], lower[55]);
+    lower[54] = tmp;
+    tmp = vminf(lower[52], lower[54]);
+    lower[54] = vmaxf(lower[52], lower[54]);
+    lower[52] = tmp;
+    tmp = vminf(lower[53], lower[55]);
+    lower[55] = vmaxf(lower[53], lower[55]);
+    lower[53] = tmp;
+    tmp = vminf(lower[53], lower[54]);
+    lower[54] = vmaxf(lower[53], lower[54]);
+    lower[53] = tmp;
+    tmp = vminf(lower[49], lower[52]);
+    lower[52] = vmaxf(lower[49], lower[52]);
+    lower[49] = tmp;
+    tmp = vminf(lower[50], lower[54]);
+    lower[54] = vmaxf(lower[50], lower[54]);
+    lower[50] = tmp;
+    tmp = vminf(lower[50], lower[52]);
+    lower[52] = vmaxf(lower[50], lower[52]);
+    lower[50] = tmp;
+    tmp = vminf(lower[51], lower[53]);
+    lower[53] = vmaxf(lower[51], lower[53]);
+    lower[51] = tmp;
+    tmp = vminf(lower[55], lower[53]);
+    lower[53] = vmaxf(lower[55], lower[53]);
+    lower[55] = tmp;
+    tmp = vminf(lower[51], lower[50]);
+    lower[50] = vmaxf(lower[51], lower[50]);
+    lower[51] = tmp;
+    tmp = vminf(lower[55], lower[52]);
+    lower[52] = vmaxf(lower[55], lower[52]);
+    lower[55] = tmp;
+    tmp = vminf(lower[53], lower[54]);
+    lower[54] = vmaxf(lower[53], lower[54]);
+    lower[53] = tmp;
+    lower[49] = vmaxf(lower[0], lower[49]);
+    lower[18] = vminf(lower[18], lower[49]);
+    lower[18] = vmaxf(lower[6], lower[18]);
+    lower[24] = vminf(lower[24], lower[30]);
+    lower[24] = vminf(lower[24], lower[18]);
+    lower[52] = vmaxf(lower[4], lower[52]);
+    lower[22] = vminf(lower[22], lower[52]);
+    lower[36] = vminf(lower[36], lower[22]);
+    lower[36] = vmaxf(lower[10], lower[36]);
+    lower[24] = vmaxf(lower[36], lower[24]);
+    lower[50] = vmaxf(lower[2], lower[50]);
+    lower[20] = vminf(lower[20], lower[50]);
+    lower[20] = vmaxf(lower[32], lower[20]);
+    lower[28] = vminf(lower[28], lower[20]);
+    lower[54] = vmaxf(lower[14], lower[54]);
+    lower[26] = vminf(lower[26], lower[54]);
+    lower[40] = vminf(lower[40], lower[26]);
+    lower[40] = vmaxf(lower[8], lower[40]);
+    lower[40] = vminf(lower[40], lower[28]);
+    lower[24] = vmaxf(lower[40], lower[24]);
+    lower[51] = vmaxf(lower[1], lower[51]);
+    lower[19] = vminf(lower[19], lower[51]);
+    lower[19] = vmaxf(lower[7], lower[19]);
+    lower[25] = vminf(lower[25], lower[31]);
+    lower[25] = vminf(lower[25], lower[19]);
+    lower[53] = vmaxf(lower[5], lower[53]);
+    lower[23] = vminf(lower[23], lower[53]);
+    lower[37] = vminf(lower[37], lower[23]);
+    lower[37] = vmaxf(lower[11], lower[37]);
+    lower[25] = vmaxf(lower[37], lower[25]);
+    lower[55] = vmaxf(lower[3], lower[55]);
+    lower[21] = vminf(lower[21], lower[55]);
+    lower[21] = vmaxf(lower[33], lower[21]);
+    lower[29] = vminf(lower[29], lower[21]);
+    lower[41] = vminf(lower[41], lower[27]);
+    lower[41] = vmaxf(lower[9], lower[41]);
+    lower[41] = vminf(lower[41], lower[29]);
+    lower[41] = vminf(lower[41], lower[25]);
+    lower[24] = vmaxf(lower[41], lower[24]);
+
+    tmp = vminf(array[43], array[44]);
+    array[44] = vmaxf(array[43], array[44]);
+    array[43] = tmp;
+    tmp = vminf(array[42], array[43]);
+    array[43] = vmaxf(array[42], array[43]);
+    array[42] = tmp;
+    tmp = vminf(array[44], array[43]);
+    array[43] = vmaxf(array[44], array[43]);
+    array[44] = tmp;
+    tmp = vminf(array[45], array[46]);
+    array[46] = vmaxf(array[45], array[46]);
+    array[45] = tmp;
+    tmp = vminf(array[47], array[48]);
+    array[48] = vmaxf(array[47], array[48]);
+    array[47] = tmp;
+    tmp = vminf(array[45], array[47]);
+    array[47] = vmaxf(array[45], array[47]);
+    array[45] = tmp;
+    tmp = vminf(array[46], array[48]);
+    array[48] = vmaxf(array[46], array[48]);
+    array[46] = tmp;
+    tmp = vminf(array[46], array[47]);
+    array[47] = vmaxf(array[46], array[47]);
+    array[46] = tmp;
+    tmp = vminf(array[42], array[45]);
+    array[45] = vmaxf(array[42], array[45]);
+    array[42] = tmp;
+    tmp = vminf(array[43], array[47]);
+    array[47] = vmaxf(array[43], array[47]);
+    array[43] = tmp;
+    tmp = vminf(array[43], array[45]);
+    array[45] = vmaxf(array[43], array[45]);
+    array[43] = tmp;
+    tmp = vminf(array[44], array[46]);
+    array[46] = vmaxf(array[44], array[46]);
+    array[44] = tmp;
+    tmp = vminf(array[48], array[46]);
+    array[46] = vmaxf(array[48], array[46]);
+    array[48] = tmp;
+    tmp = vminf(array[44], array[43]);
+    array[43] = vmaxf(array[44], array[43]);
+    array[44] = tmp;
+    tmp = vminf(array[48], array[45]);
+    array[45] = vmaxf(array[48], array[45]);
+    array[48] = tmp;
+    tmp = vminf(array[46], array[47]);
+    array[47] = vmaxf(array[46], array[47]);
+    array[46] = tmp;
+    array[42] = vmaxf(array[0], array[42]);
+    array[18] = vminf(array[18], array[42]);
+    array[18] = vmaxf(array[6], array[18]);
+    array[24] = vminf(array[24], array[30]);
+    array[24] = vminf(array[24], array[18]);
+    array[45] = vmaxf(array[4], array[45]);
+    array[22] = vminf(array[22], array[45]);
+    array[36] = vminf(array[36], array[22]);
+    array[36] = vmaxf(array[10], array[36]);
+    array[24] = vmaxf(array[36], array[24]);
+    array[43] = vmaxf(array[2], array[43]);
+    array[20] = vminf(array[20], array[43]);
+    array[20] = vmaxf(array[32], array[20]);
+    array[28] = vminf(array[28], array[20]);
+    array[47] = vmaxf(array[14], array[47]);
+    array[26] = vminf(array[26], array[47]);
+    array[40] = vminf(array[40], array[26]);
+    array[40] = vmaxf(array[8], array[40]);
+    array[40] = vminf(array[40], array[28]);
+    array[24] = vmaxf(array[40], array[24]);
+    array[44] = vmaxf(array[1], array[44]);
+    array[19] = vminf(array[19], array[44]);
+    array[19] = vmaxf(array[7], array[19]);
+    array[25] = vminf(array[25], array[31]);
+    array[25] = vminf(array[25], array[19]);
+    array[46] = vmaxf(array[5], array[46]);
+    array[23] = vminf(array[23], array[46]);
+    array[37] = vminf(array[37], array[23]);
+    array[37] = vmaxf(array[11], array[37]);
+    array[25] = vmaxf(array[37], array[25]);
+    array[48] = vmaxf(array[3], array[48]);
+    array[21] = vminf(array[21], array[48]);
+    array[21] = vmaxf(array[33], array[21]);
+    array[29] = vminf(array[29], array[21]);
+    array[41] = vminf(array[41], array[27]);
+    array[41] = vmaxf(array[9], array[41]);
+    array[41] = vminf(array[41], array[29]);
+    array[41] = vminf(array[41], array[25]);
+    array[24] = vmaxf(array[41], array[24]);
+
+    return {array[24], lower[24]};
+}
+
+inline void sortColumn(std::array<vfloat, 8>& array)
+{
+    vfloat tmp;
+    tmp = vminf(array[0], array[2]);
+    array[2] = vmaxf(array[0], array[2]);
+    array[0] = tmp;
+    tmp = vminf(array[1], array[3]);
+    array[3] = vmaxf(array[1], array[3]);
+    array[1] = tmp;
+    tmp = vminf(array[4], array[6]);
+    array[6] = vmaxf(array[4], array[6]);
+    array[4] = tmp;
+    tmp = vminf(array[5], array[7]);
+    array[7] = vmaxf(array[5], array[7]);
+    array[5] = tmp;
+    tmp = vminf(array[0], array[4]);
+    array[4] = vmaxf(array[0], array[4]);
+    array[0] = tmp;
+    tmp = vminf(array[1], array[5]);
+    array[5] = vmaxf(array[1], array[5]);
+    array[1] = tmp;
+    tmp = vminf(array[2], array[6]);
+    array[6] = vmaxf(array[2], array[6]);
+    array[2] = tmp;
+    tmp = vminf(array[3], array[7]);
+    array[7] = vmaxf(array[3], array[7]);
+    array[3] = tmp;
+    tmp = vminf(array[0], array[1]);
+    array[1] = vmaxf(array[0], array[1]);
+    array[0] = tmp;
+    tmp = vminf(array[2], array[3]);
+    array[3] = vmaxf(array[2], array[3]);
+    array[2] = tmp;
+    tmp = vminf(array[4], array[5]);
+    array[5] = vmaxf(array[4], array[5]);
+    array[4] = tmp;
+    tmp = vminf(array[6], array[7]);
+    array[7] = vmaxf(array[6], array[7]);
+    array[6] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    tmp = vminf(array[1], array[4]);
+    array[4] = vmaxf(array[1], array[4]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[6]);
+    array[6] = vmaxf(array[3], array[6]);
+    array[3] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[6]);
+    array[6] = vmaxf(array[5], array[6]);
+    array[5] = tmp;
+}
+
+inline std::array<vfloat, 2> medianPair(std::array<vfloat, 90> array)
+{
+    vfloat tmp;
+    tmp = vminf(array[0], array[8]);
+    array[8] = vmaxf(array[0], array[8]);
+    array[0] = tmp;
+    tmp = vminf(array[4], array[12]);
+    array[12] = vmaxf(array[4], array[12]);
+    array[4] = tmp;
+    tmp = vminf(array[4], array[8]);
+    array[8] = vmaxf(array[4], array[8]);
+    array[4] = tmp;
+    tmp = vminf(array[2], array[10]);
+    array[10] = vmaxf(array[2], array[10]);
+    array[2] = tmp;
+    tmp = vminf(array[6], array[14]);
+    array[14] = vmaxf(array[6], array[14]);
+    array[6] = tmp;
+    tmp = vminf(array[6], array[10]);
+    array[10] = vmaxf(array[6], array[10]);
+    array[6] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[6], array[8]);
+    array[8] = vmaxf(array[6], array[8]);
+    array[6] = tmp;
+    tmp = vminf(array[10], array[12]);
+    array[12] = vmaxf(array[10], array[12]);
+    array[10] = tmp;
+    tmp = vminf(array[1], array[9]);
+    array[9] = vmaxf(array[1], array[9]);
+    array[1] = tmp;
+    tmp = vminf(array[5], array[13]);
+    array[13] = vmaxf(array[5], array[13]);
+    array[5] = tmp;
+    tmp = vminf(array[5], array[9]);
+    array[9] = vmaxf(array[5], array[9]);
+    array[5] = tmp;
+    tmp = vminf(array[3], array[11]);
+    array[11] = vmaxf(array[3], array[11]);
+    array[3] = tmp;
+    tmp = vminf(array[7], array[15]);
+    array[15] = vmaxf(array[7], array[15]);
+    array[7] = tmp;
+    tmp = vminf(array[7], array[11]);
+    array[11] = vmaxf(array[7], array[11]);
+    array[7] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    tmp = vminf(array[7], array[9]);
+    array[9] = vmaxf(array[7], array[9]);
+    array[7] = tmp;
+    tmp = vminf(array[11], array[13]);
+    array[13] = vmaxf(array[11], array[13]);
+    array[11] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[6]);
+    array[6] = vmaxf(array[5], array[6]);
+    array[5] = tmp;
+    tmp = vminf(array[7], array[8]);
+    array[8] = vmaxf(array[7], array[8]);
+    array[7] = tmp;
+    tmp = vminf(array[9], array[10]);
+    array[10] = vmaxf(array[9], array[10]);
+    array[9] = tmp;
+    tmp = vminf(array[11], array[12]);
+    array[12] = vmaxf(array[11], array[12]);
+    array[11] = tmp;
+    tmp = vminf(array[13], array[14]);
+    array[14] = vmaxf(array[13], array[14]);
+    array[13] = tmp;
+    tmp = vminf(array[16], array[24]);
+    array[24] = vmaxf(array[16], array[24]);
+    array[16] = tmp;
+    tmp = vminf(array[20], array[28]);
+    array[28] = vmaxf(array[20], array[28]);
+    array[20] = tmp;
+    tmp = vminf(array[20], array[24]);
+    array[24] = vmaxf(array[20], array[24]);
+    array[20] = tmp;
+    tmp = vminf(array[18], array[26]);
+    array[26] = vmaxf(array[18], array[26]);
+    array[18] = tmp;
+    tmp = vminf(array[22], array[30]);
+    array[30] = vmaxf(array[22], array[30]);
+    array[22] = tmp;
+    tmp = vminf(array[22], array[26]);
+    array[26] = vmaxf(array[22], array[26]);
+    array[22] = tmp;
+    tmp = vminf(array[18], array[20]);
+    array[20] = vmaxf(array[18], array[20]);
+    array[18] = tmp;
+    tmp = vminf(array[22], array[24]);
+    array[24] = vmaxf(array[22], array[24]);
+    array[22] = tmp;
+    tmp = vminf(array[26], array[28]);
+    array[28] = vmaxf(array[26], array[28]);
+    array[26] = tmp;
+    tmp = vminf(array[17], array[25]);
+    array[25] = vmaxf(array[17], array[25]);
+    array[17] = tmp;
+    tmp = vminf(array[21], array[29]);
+    array[29] = vmaxf(array[21], array[29]);
+    array[21] = tmp;
+    tmp = vminf(array[21], array[25]);
+    array[25] = vmaxf(array[21], array[25]);
+    array[21] = tmp;
+    tmp = vminf(array[19], array[27]);
+    array[27] = vmaxf(array[19], array[27]);
+    array[19] = tmp;
+    tmp = vminf(array[23], array[31]);
+    array[31] = vmaxf(array[23], array[31]);
+    array[23] = tmp;
+    tmp = vminf(array[23], array[27]);
+    array[27] = vmaxf(array[23], array[27]);
+    array[23] = tmp;
+    tmp = vminf(array[19], array[21]);
+    array[21] = vmaxf(array[19], array[21]);
+    array[19] = tmp;
+    tmp = vminf(array[23], array[25]);
+    array[25] = vmaxf(array[23], array[25]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[29]);
+    array[29] = vmaxf(array[27], array[29]);
+    array[27] = tmp;
+    tmp = vminf(array[17], array[18]);
+    array[18] = vmaxf(array[17], array[18]);
+    array[17] = tmp;
+    tmp = vminf(array[19], array[20]);
+    array[20] = vmaxf(array[19], array[20]);
+    array[19] = tmp;
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[24]);
+    array[24] = vmaxf(array[23], array[24]);
+    array[23] = tmp;
+    tmp = vminf(array[25], array[26]);
+    array[26] = vmaxf(array[25], array[26]);
+    array[25] = tmp;
+    tmp = vminf(array[27], array[28]);
+    array[28] = vmaxf(array[27], array[28]);
+    array[27] = tmp;
+    tmp = vminf(array[29], array[30]);
+    array[30] = vmaxf(array[29], array[30]);
+    array[29] = tmp;
+    tmp = vminf(array[0], array[16]);
+    array[16] = vmaxf(array[0], array[16]);
+    array[0] = tmp;
+    tmp = vminf(array[8], array[24]);
+    array[24] = vmaxf(array[8], array[24]);
+    array[8] = tmp;
+    tmp = vminf(array[8], array[16]);
+    array[16] = vmaxf(array[8], array[16]);
+    array[8] = tmp;
+    tmp = vminf(array[4], array[20]);
+    array[20] = vmaxf(array[4], array[20]);
+    array[4] = tmp;
+    tmp = vminf(array[12], array[28]);
+    array[28] = vmaxf(array[12], array[28]);
+    array[12] = tmp;
+    tmp = vminf(array[12], array[20]);
+    array[20] = vmaxf(array[12], array[20]);
+    array[12] = tmp;
+    tmp = vminf(array[4], array[8]);
+    array[8] = vmaxf(array[4], array[8]);
+    array[4] = tmp;
+    tmp = vminf(array[12], array[16]);
+    array[16] = vmaxf(array[12], array[16]);
+    array[12] = tmp;
+    tmp = vminf(array[20], array[24]);
+    array[24] = vmaxf(array[20], array[24]);
+    array[20] = tmp;
+    tmp = vminf(array[2], array[18]);
+    array[18] = vmaxf(array[2], array[18]);
+    array[2] = tmp;
+    tmp = vminf(array[10], array[26]);
+    array[26] = vmaxf(array[10], array[26]);
+    array[10] = tmp;
+    tmp = vminf(array[10], array[18]);
+    array[18] = vmaxf(array[10], array[18]);
+    array[10] = tmp;
+    tmp = vminf(array[6], array[22]);
+    array[22] = vmaxf(array[6], array[22]);
+    array[6] = tmp;
+    tmp = vminf(array[14], array[30]);
+    array[30] = vmaxf(array[14], array[30]);
+    array[14] = tmp;
+    tmp = vminf(array[14], array[22]);
+    array[22] = vmaxf(array[14], array[22]);
+    array[14] = tmp;
+    tmp = vminf(array[6], array[10]);
+    array[10] = vmaxf(array[6], array[10]);
+    array[6] = tmp;
+    tmp = vminf(array[14], array[18]);
+    array[18] = vmaxf(array[14], array[18]);
+    array[14] = tmp;
+    tmp = vminf(array[22], array[26]);
+    array[26] = vmaxf(array[22], array[26]);
+    array[22] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[6], array[8]);
+    array[8] = vmaxf(array[6], array[8]);
+    array[6] = tmp;
+    tmp = vminf(array[10], array[12]);
+    array[12] = vmaxf(array[10], array[12]);
+    array[10] = tmp;
+    tmp = vminf(array[14], array[16]);
+    array[16] = vmaxf(array[14], array[16]);
+    array[14] = tmp;
+    tmp = vminf(array[18], array[20]);
+    array[20] = vmaxf(array[18], array[20]);
+    array[18] = tmp;
+    tmp = vminf(array[22], array[24]);
+    array[24] = vmaxf(array[22], array[24]);
+    array[22] = tmp;
+    tmp = vminf(array[26], array[28]);
+    array[28] = vmaxf(array[26], array[28]);
+    array[26] = tmp;
+    tmp = vminf(array[1], array[17]);
+    array[17] = vmaxf(array[1], array[17]);
+    array[1] = tmp;
+    tmp = vminf(array[9], array[25]);
+    array[25] = vmaxf(array[9], array[25]);
+    array[9] = tmp;
+    tmp = vminf(array[9], array[17]);
+    array[17] = vmaxf(array[9], array[17]);
+    array[9] = tmp;
+    tmp = vminf(array[5], array[21]);
+    array[21] = vmaxf(array[5], array[21]);
+    array[5] = tmp;
+    tmp = vminf(array[13], array[29]);
+    array[29] = vmaxf(array[13], array[29]);
+    array[13] = tmp;
+    tmp = vminf(array[13], array[21]);
+    array[21] = vmaxf(array[13], array[21]);
+    array[13] = tmp;
+    tmp = vminf(array[5], array[9]);
+    array[9] = vmaxf(array[5], array[9]);
+    array[5] = tmp;
+    tmp = vminf(array[13], array[17]);
+    array[17] = vmaxf(array[13], array[17]);
+    array[13] = tmp;
+    tmp = vminf(array[21], array[25]);
+    array[25] = vmaxf(array[21], array[25]);
+    array[21] = tmp;
+    tmp = vminf(array[3], array[19]);
+    array[19] = vmaxf(array[3], array[19]);
+    array[3] = tmp;
+    tmp = vminf(array[11], array[27]);
+    array[27] = vmaxf(array[11], array[27]);
+    array[11] = tmp;
+    tmp = vminf(array[11], array[19]);
+    array[19] = vmaxf(array[11], array[19]);
+    array[11] = tmp;
+    tmp = vminf(array[7], array[23]);
+    array[23] = vmaxf(array[7], array[23]);
+    array[7] = tmp;
+    tmp = vminf(array[15], array[31]);
+    array[31] = vmaxf(array[15], array[31]);
+    array[15] = tmp;
+    tmp = vminf(array[15], array[23]);
+    array[23] = vmaxf(array[15], array[23]);
+    array[15] = tmp;
+    tmp = vminf(array[7], array[11]);
+    array[11] = vmaxf(array[7], array[11]);
+    array[7] = tmp;
+    tmp = vminf(array[15], array[19]);
+    array[19] = vmaxf(array[15], array[19]);
+    array[15] = tmp;
+    tmp = vminf(array[23], array[27]);
+    array[27] = vmaxf(array[23], array[27]);
+    array[23] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    tmp = vminf(array[7], array[9]);
+    array[9] = vmaxf(array[7], array[9]);
+    array[7] = tmp;
+    tmp = vminf(array[11], array[13]);
+    array[13] = vmaxf(array[11], array[13]);
+    array[11] = tmp;
+    tmp = vminf(array[15], array[17]);
+    array[17] = vmaxf(array[15], array[17]);
+    array[15] = tmp;
+    tmp = vminf(array[19], array[21]);
+    array[21] = vmaxf(array[19], array[21]);
+    array[19] = tmp;
+    tmp = vminf(array[23], array[25]);
+    array[25] = vmaxf(array[23], array[25]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[29]);
+    array[29] = vmaxf(array[27], array[29]);
+    array[27] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[6]);
+    array[6] = vmaxf(array[5], array[6]);
+    array[5] = tmp;
+    tmp = vminf(array[7], array[8]);
+    array[8] = vmaxf(array[7], array[8]);
+    array[7] = tmp;
+    tmp = vminf(array[9], array[10]);
+    array[10] = vmaxf(array[9], array[10]);
+    array[9] = tmp;
+    tmp = vminf(array[11], array[12]);
+    array[12] = vmaxf(array[11], array[12]);
+    array[11] = tmp;
+    tmp = vminf(array[13], array[14]);
+    array[14] = vmaxf(array[13], array[14]);
+    array[13] = tmp;
+    tmp = vminf(array[15], array[16]);
+    array[16] = vmaxf(array[15], array[16]);
+    array[15] = tmp;
+    tmp = vminf(array[17], array[18]);
+    array[18] = vmaxf(array[17], array[18]);
+    array[17] = tmp;
+    tmp = vminf(array[19], array[20]);
+    array[20] = vmaxf(array[19], array[20]);
+    array[19] = tmp;
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[24]);
+    array[24] = vmaxf(array[23], array[24]);
+    array[23] = tmp;
+    tmp = vminf(array[25], array[26]);
+    array[26] = vmaxf(array[25], array[26]);
+    array[25] = tmp;
+    tmp = vminf(array[27], array[28]);
+    array[28] = vmaxf(array[27], array[28]);
+    array[27] = tmp;
+    tmp = vminf(array[29], array[30]);
+    array[30] = vmaxf(array[29], array[30]);
+    array[29] = tmp;
+    tmp = vminf(array[32], array[40]);
+    array[40] = vmaxf(array[32], array[40]);
+    array[32] = tmp;
+    tmp = vminf(array[36], array[44]);
+    array[44] = vmaxf(array[36], array[44]);
+    array[36] = tmp;
+    tmp = vminf(array[36], array[40]);
+    array[40] = vmaxf(array[36], array[40]);
+    array[36] = tmp;
+    tmp = vminf(array[34], array[42]);
+    array[42] = vmaxf(array[34], array[42]);
+    array[34] = tmp;
+    tmp = vminf(array[38], array[46]);
+    array[46] = vmaxf(array[38], array[46]);
+    array[38] = tmp;
+    tmp = vminf(array[38], array[42]);
+    array[42] = vmaxf(array[38], array[42]);
+    array[38] = tmp;
+    tmp = vminf(array[34], array[36]);
+    array[36] = vmaxf(array[34], array[36]);
+    array[34] = tmp;
+    tmp = vminf(array[38], array[40]);
+    array[40] = vmaxf(array[38], array[40]);
+    array[38] = tmp;
+    tmp = vminf(array[42], array[44]);
+    array[44] = vmaxf(array[42], array[44]);
+    array[42] = tmp;
+    tmp = vminf(array[33], array[41]);
+    array[41] = vmaxf(array[33], array[41]);
+    array[33] = tmp;
+    tmp = vminf(array[37], array[45]);
+    array[45] = vmaxf(array[37], array[45]);
+    array[37] = tmp;
+    tmp = vminf(array[37], array[41]);
+    array[41] = vmaxf(array[37], array[41]);
+    array[37] = tmp;
+    tmp = vminf(array[35], array[43]);
+    array[43] = vmaxf(array[35], array[43]);
+    array[35] = tmp;
+    tmp = vminf(array[39], array[47]);
+    array[47] = vmaxf(array[39], array[47]);
+    array[39] = tmp;
+    tmp = vminf(array[39], array[43]);
+    array[43] = vmaxf(array[39], array[43]);
+    array[39] = tmp;
+    tmp = vminf(array[35], array[37]);
+    array[37] = vmaxf(array[35], array[37]);
+    array[35] = tmp;
+    tmp = vminf(array[39], array[41]);
+    array[41] = vmaxf(array[39], array[41]);
+    array[39] = tmp;
+    tmp = vminf(array[43], array[45]);
+    array[45] = vmaxf(array[43], array[45]);
+    array[43] = tmp;
+    tmp = vminf(array[33], array[34]);
+    array[34] = vmaxf(array[33], array[34]);
+    array[33] = tmp;
+    tmp = vminf(array[35], array[36]);
+    array[36] = vmaxf(array[35], array[36]);
+    array[35] = tmp;
+    tmp = vminf(array[37], array[38]);
+    array[38] = vmaxf(array[37], array[38]);
+    array[37] = tmp;
+    tmp = vminf(array[39], array[40]);
+    array[40] = vmaxf(array[39], array[40]);
+    array[39] = tmp;
+    tmp = vminf(array[41], array[42]);
+    array[42] = vmaxf(array[41], array[42]);
+    array[41] = tmp;
+    tmp = vminf(array[43], array[44]);
+    array[44] = vmaxf(array[43], array[44]);
+    array[43] = tmp;
+    tmp = vminf(array[45], array[46]);
+    array[46] = vmaxf(array[45], array[46]);
+    array[45] = tmp;
+    tmp = vminf(array[56], array[64]);
+    array[64] = vmaxf(array[56], array[64]);
+    array[56] = tmp;
+    tmp = vminf(array[60], array[68]);
+    array[68] = vmaxf(array[60], array[68]);
+    array[60] = tmp;
+    tmp = vminf(array[60], array[64]);
+    array[64] = vmaxf(array[60], array[64]);
+    array[60] = tmp;
+    tmp = vminf(array[58], array[66]);
+    array[66] = vmaxf(array[58], array[66]);
+    array[58] = tmp;
+    tmp = vminf(array[62], array[70]);
+    array[70] = vmaxf(array[62], array[70]);
+    array[62] = tmp;
+    tmp = vminf(array[62], array[66]);
+    array[66] = vmaxf(array[62], array[66]);
+    array[62] = tmp;
+    tmp = vminf(array[58], array[60]);
+    array[60] = vmaxf(array[58], array[60]);
+    array[58] = tmp;
+    tmp = vminf(array[62], array[64]);
+    array[64] = vmaxf(array[62], array[64]);
+    array[62] = tmp;
+    tmp = vminf(array[66], array[68]);
+    array[68] = vmaxf(array[66], array[68]);
+    array[66] = tmp;
+    tmp = vminf(array[57], array[65]);
+    array[65] = vmaxf(array[57], array[65]);
+    array[57] = tmp;
+    tmp = vminf(array[61], array[69]);
+    array[69] = vmaxf(array[61], array[69]);
+    array[61] = tmp;
+    tmp = vminf(array[61], array[65]);
+    array[65] = vmaxf(array[61], array[65]);
+    array[61] = tmp;
+    tmp = vminf(array[59], array[67]);
+    array[67] = vmaxf(array[59], array[67]);
+    array[59] = tmp;
+    tmp = vminf(array[63], array[71]);
+    array[71] = vmaxf(array[63], array[71]);
+    array[63] = tmp;
+    tmp = vminf(array[63], array[67]);
+    array[67] = vmaxf(array[63], array[67]);
+    array[63] = tmp;
+    tmp = vminf(array[59], array[61]);
+    array[61] = vmaxf(array[59], array[61]);
+    array[59] = tmp;
+    tmp = vminf(array[63], array[65]);
+    array[65] = vmaxf(array[63], array[65]);
+    array[63] = tmp;
+    tmp = vminf(array[67], array[69]);
+    array[69] = vmaxf(array[67], array[69]);
+    array[67] = tmp;
+    tmp = vminf(array[57], array[58]);
+    array[58] = vmaxf(array[57], array[58]);
+    array[57] = tmp;
+    tmp = vminf(array[59], array[60]);
+    array[60] = vmaxf(array[59], array[60]);
+    array[59] = tmp;
+    tmp = vminf(array[61], array[62]);
+    array[62] = vmaxf(array[61], array[62]);
+    array[61] = tmp;
+    tmp = vminf(array[63], array[64]);
+    array[64] = vmaxf(array[63], array[64]);
+    array[63] = tmp;
+    tmp = vminf(array[65], array[66]);
+    array[66] = vmaxf(array[65], array[66]);
+    array[65] = tmp;
+    tmp = vminf(array[67], array[68]);
+    array[68] = vmaxf(array[67], array[68]);
+    array[67] = tmp;
+    tmp = vminf(array[69], array[70]);
+    array[70] = vmaxf(array[69], array[70]);
+    array[69] = tmp;
+    tmp = vminf(array[48], array[56]);
+    array[56] = vmaxf(array[48], array[56]);
+    array[48] = tmp;
+    tmp = vminf(array[64], array[56]);
+    array[56] = vmaxf(array[64], array[56]);
+    array[64] = tmp;
+    tmp = vminf(array[52], array[60]);
+    array[60] = vmaxf(array[52], array[60]);
+    array[52] = tmp;
+    tmp = vminf(array[68], array[60]);
+    array[60] = vmaxf(array[68], array[60]);
+    array[68] = tmp;
+    tmp = vminf(array[52], array[64]);
+    array[64] = vmaxf(array[52], array[64]);
+    array[52] = tmp;
+    tmp = vminf(array[68], array[56]);
+    array[56] = vmaxf(array[68], array[56]);
+    array[68] = tmp;
+    tmp = vminf(array[50], array[58]);
+    array[58] = vmaxf(array[50], array[58]);
+    array[50] = tmp;
+    tmp = vminf(array[66], array[58]);
+    array[58] = vmaxf(array[66], array[58]);
+    array[66] = tmp;
+    tmp = vminf(array[54], array[62]);
+    array[62] = vmaxf(array[54], array[62]);
+    array[54] = tmp;
+    tmp = vminf(array[70], array[62]);
+    array[62] = vmaxf(array[70], array[62]);
+    array[70] = tmp;
+    tmp = vminf(array[54], array[66]);
+    array[66] = vmaxf(array[54], array[66]);
+    array[54] = tmp;
+    tmp = vminf(array[70], array[58]);
+    array[58] = vmaxf(array[70], array[58]);
+    array[70] = tmp;
+    tmp = vminf(array[50], array[52]);
+    array[52] = vmaxf(array[50], array[52]);
+    array[50] = tmp;
+    tmp = vminf(array[54], array[64]);
+    array[64] = vmaxf(array[54], array[64]);
+    array[54] = tmp;
+    tmp = vminf(array[66], array[68]);
+    array[68] = vmaxf(array[66], array[68]);
+    array[66] = tmp;
+    tmp = vminf(array[70], array[56]);
+    array[56] = vmaxf(array[70], array[56]);
+    array[70] = tmp;
+    tmp = vminf(array[58], array[60]);
+    array[60] = vmaxf(array[58], array[60]);
+    array[58] = tmp;
+    tmp = vminf(array[49], array[57]);
+    array[57] = vmaxf(array[49], array[57]);
+    array[49] = tmp;
+    tmp = vminf(array[65], array[57]);
+    array[57] = vmaxf(array[65], array[57]);
+    array[65] = tmp;
+    tmp = vminf(array[53], array[61]);
+    array[61] = vmaxf(array[53], array[61]);
+    array[53] = tmp;
+    tmp = vminf(array[69], array[61]);
+    array[61] = vmaxf(array[69], array[61]);
+    array[69] = tmp;
+    tmp = vminf(array[53], array[65]);
+    array[65] = vmaxf(array[53], array[65]);
+    array[53] = tmp;
+    tmp = vminf(array[69], array[57]);
+    array[57] = vmaxf(array[69], array[57]);
+    array[69] = tmp;
+    tmp = vminf(array[51], array[59]);
+    array[59] = vmaxf(array[51], array[59]);
+    array[51] = tmp;
+    tmp = vminf(array[67], array[59]);
+    array[59] = vmaxf(array[67], array[59]);
+    array[67] = tmp;
+    tmp = vminf(array[55], array[63]);
+    array[63] = vmaxf(array[55], array[63]);
+    array[55] = tmp;
+    tmp = vminf(array[71], array[63]);
+    array[63] = vmaxf(array[71], array[63]);
+    array[71] = tmp;
+    tmp = vminf(array[55], array[67]);
+    array[67] = vmaxf(array[55], array[67]);
+    array[55] = tmp;
+    tmp = vminf(array[71], array[59]);
+    array[59] = vmaxf(array[71], array[59]);
+    array[71] = tmp;
+    tmp = vminf(array[51], array[53]);
+    array[53] = vmaxf(array[51], array[53]);
+    array[51] = tmp;
+    tmp = vminf(array[55], array[65]);
+    array[65] = vmaxf(array[55], array[65]);
+    array[55] = tmp;
+    tmp = vminf(array[67], array[69]);
+    array[69] = vmaxf(array[67], array[69]);
+    array[67] = tmp;
+    tmp = vminf(array[71], array[57]);
+    array[57] = vmaxf(array[71], array[57]);
+    array[71] = tmp;
+    tmp = vminf(array[59], array[61]);
+    array[61] = vmaxf(array[59], array[61]);
+    array[59] = tmp;
+    tmp = vminf(array[49], array[50]);
+    array[50] = vmaxf(array[49], array[50]);
+    array[49] = tmp;
+    tmp = vminf(array[51], array[52]);
+    array[52] = vmaxf(array[51], array[52]);
+    array[51] = tmp;
+    tmp = vminf(array[53], array[54]);
+    array[54] = vmaxf(array[53], array[54]);
+    array[53] = tmp;
+    tmp = vminf(array[55], array[64]);
+    array[64] = vmaxf(array[55], array[64]);
+    array[55] = tmp;
+    tmp = vminf(array[65], array[66]);
+    array[66] = vmaxf(array[65], array[66]);
+    array[65] = tmp;
+    tmp = vminf(array[67], array[68]);
+    array[68] = vmaxf(array[67], array[68]);
+    array[67] = tmp;
+    tmp = vminf(array[69], array[70]);
+    array[70] = vmaxf(array[69], array[70]);
+    array[69] = tmp;
+    tmp = vminf(array[71], array[56]);
+    array[56] = vmaxf(array[71], array[56]);
+    array[71] = tmp;
+    tmp = vminf(array[57], array[58]);
+    array[58] = vmaxf(array[57], array[58]);
+    array[57] = tmp;
+    tmp = vminf(array[59], array[60]);
+    array[60] = vmaxf(array[59], array[60]);
+    array[59] = tmp;
+    tmp = vminf(array[61], array[62]);
+    array[62] = vmaxf(array[61], array[62]);
+    array[61] = tmp;
+    tmp = vminf(array[32], array[48]);
+    array[48] = vmaxf(array[32], array[48]);
+    array[32] = tmp;
+    tmp = vminf(array[56], array[48]);
+    array[48] = vmaxf(array[56], array[48]);
+    array[56] = tmp;
+    tmp = vminf(array[40], array[64]);
+    array[64] = vmaxf(array[40], array[64]);
+    array[40] = tmp;
+    tmp = vminf(array[40], array[56]);
+    array[56] = vmaxf(array[40], array[56]);
+    array[40] = tmp;
+    tmp = vminf(array[64], array[48]);
+    array[48] = vmaxf(array[64], array[48]);
+    array[64] = tmp;
+    tmp = vminf(array[36], array[52]);
+    array[52] = vmaxf(array[36], array[52]);
+    array[36] = tmp;
+    tmp = vminf(array[60], array[52]);
+    array[52] = vmaxf(array[60], array[52]);
+    array[60] = tmp;
+    tmp = vminf(array[44], array[68]);
+    array[68] = vmaxf(array[44], array[68]);
+    array[44] = tmp;
+    tmp = vminf(array[44], array[60]);
+    array[60] = vmaxf(array[44], array[60]);
+    array[44] = tmp;
+    tmp = vminf(array[68], array[52]);
+    array[52] = vmaxf(array[68], array[52]);
+    array[68] = tmp;
+    tmp = vminf(array[36], array[40]);
+    array[40] = vmaxf(array[36], array[40]);
+    array[36] = tmp;
+    tmp = vminf(array[44], array[56]);
+    array[56] = vmaxf(array[44], array[56]);
+    array[44] = tmp;
+    tmp = vminf(array[60], array[64]);
+    array[64] = vmaxf(array[60], array[64]);
+    array[60] = tmp;
+    tmp = vminf(array[68], array[48]);
+    array[48] = vmaxf(array[68], array[48]);
+    array[68] = tmp;
+    tmp = vminf(array[34], array[50]);
+    array[50] = vmaxf(array[34], array[50]);
+    array[34] = tmp;
+    tmp = vminf(array[58], array[50]);
+    array[50] = vmaxf(array[58], array[50]);
+    array[58] = tmp;
+    tmp = vminf(array[42], array[66]);
+    array[66] = vmaxf(array[42], array[66]);
+    array[42] = tmp;
+    tmp = vminf(array[42], array[58]);
+    array[58] = vmaxf(array[42], array[58]);
+    array[42] = tmp;
+    tmp = vminf(array[66], array[50]);
+    array[50] = vmaxf(array[66], array[50]);
+    array[66] = tmp;
+    tmp = vminf(array[38], array[54]);
+    array[54] = vmaxf(array[38], array[54]);
+    array[38] = tmp;
+    tmp = vminf(array[62], array[54]);
+    array[54] = vmaxf(array[62], array[54]);
+    array[62] = tmp;
+    tmp = vminf(array[46], array[70]);
+    array[70] = vmaxf(array[46], array[70]);
+    array[46] = tmp;
+    tmp = vminf(array[46], array[62]);
+    array[62] = vmaxf(array[46], array[62]);
+    array[46] = tmp;
+    tmp = vminf(array[70], array[54]);
+    array[54] = vmaxf(array[70], array[54]);
+    array[70] = tmp;
+    tmp = vminf(array[38], array[42]);
+    array[42] = vmaxf(array[38], array[42]);
+    array[38] = tmp;
+    tmp = vminf(array[46], array[58]);
+    array[58] = vmaxf(array[46], array[58]);
+    array[46] = tmp;
+    tmp = vminf(array[62], array[66]);
+    array[66] = vmaxf(array[62], array[66]);
+    array[62] = tmp;
+    tmp = vminf(array[70], array[50]);
+    array[50] = vmaxf(array[70], array[50]);
+    array[70] = tmp;
+    tmp = vminf(array[34], array[36]);
+    array[36] = vmaxf(array[34], array[36]);
+    array[34] = tmp;
+    tmp = vminf(array[38], array[40]);
+    array[40] = vmaxf(array[38], array[40]);
+    array[38] = tmp;
+    tmp = vminf(array[42], array[44]);
+    array[44] = vmaxf(array[42], array[44]);
+    array[42] = tmp;
+    tmp = vminf(array[46], array[56]);
+    array[56] = vmaxf(array[46], array[56]);
+    array[46] = tmp;
+    tmp = vminf(array[58], array[60]);
+    array[60] = vmaxf(array[58], array[60]);
+    array[58] = tmp;
+    tmp = vminf(array[62], array[64]);
+    array[64] = vmaxf(array[62], array[64]);
+    array[62] = tmp;
+    tmp = vminf(array[66], array[68]);
+    array[68] = vmaxf(array[66], array[68]);
+    array[66] = tmp;
+    tmp = vminf(array[70], array[48]);
+    array[48] = vmaxf(array[70], array[48]);
+    array[70] = tmp;
+    tmp = vminf(array[50], array[52]);
+    array[52] = vmaxf(array[50], array[52]);
+    array[50] = tmp;
+    tmp = vminf(array[33], array[49]);
+    array[49] = vmaxf(array[33], array[49]);
+    array[33] = tmp;
+    tmp = vminf(array[57], array[49]);
+    array[49] = vmaxf(array[57], array[49]);
+    array[57] = tmp;
+    tmp = vminf(array[41], array[65]);
+    array[65] = vmaxf(array[41], array[65]);
+    array[41] = tmp;
+    tmp = vminf(array[41], array[57]);
+    array[57] = vmaxf(array[41], array[57]);
+    array[41] = tmp;
+    tmp = vminf(array[65], array[49]);
+    array[49] = vmaxf(array[65], array[49]);
+    array[65] = tmp;
+    tmp = vminf(array[37], array[53]);
+    array[53] = vmaxf(array[37], array[53]);
+    array[37] = tmp;
+    tmp = vminf(array[61], array[53]);
+    array[53] = vmaxf(array[61], array[53]);
+    array[61] = tmp;
+    tmp = vminf(array[45], array[69]);
+    array[69] = vmaxf(array[45], array[69]);
+    array[45] = tmp;
+    tmp = vminf(array[45], array[61]);
+    array[61] = vmaxf(array[45], array[61]);
+    array[45] = tmp;
+    tmp = vminf(array[69], array[53]);
+    array[53] = vmaxf(array[69], array[53]);
+    array[69] = tmp;
+    tmp = vminf(array[37], array[41]);
+    array[41] = vmaxf(array[37], array[41]);
+    array[37] = tmp;
+    tmp = vminf(array[45], array[57]);
+    array[57] = vmaxf(array[45], array[57]);
+    array[45] = tmp;
+    tmp = vminf(array[61], array[65]);
+    array[65] = vmaxf(array[61], array[65]);
+    array[61] = tmp;
+    tmp = vminf(array[69], array[49]);
+    array[49] = vmaxf(array[69], array[49]);
+    array[69] = tmp;
+    tmp = vminf(array[35], array[51]);
+    array[51] = vmaxf(array[35], array[51]);
+    array[35] = tmp;
+    tmp = vminf(array[59], array[51]);
+    array[51] = vmaxf(array[59], array[51]);
+    array[59] = tmp;
+    tmp = vminf(array[43], array[67]);
+    array[67] = vmaxf(array[43], array[67]);
+    array[43] = tmp;
+    tmp = vminf(array[43], array[59]);
+    array[59] = vmaxf(array[43], array[59]);
+    array[43] = tmp;
+    tmp = vminf(array[67], array[51]);
+    array[51] = vmaxf(array[67], array[51]);
+    array[67] = tmp;
+    tmp = vminf(array[39], array[55]);
+    array[55] = vmaxf(array[39], array[55]);
+    array[39] = tmp;
+    tmp = vminf(array[63], array[55]);
+    array[55] = vmaxf(array[63], array[55]);
+    array[63] = tmp;
+    tmp = vminf(array[47], array[71]);
+    array[71] = vmaxf(array[47], array[71]);
+    array[47] = tmp;
+    tmp = vminf(array[47], array[63]);
+    array[63] = vmaxf(array[47], array[63]);
+    array[47] = tmp;
+    tmp = vminf(array[71], array[55]);
+    array[55] = vmaxf(array[71], array[55]);
+    array[71] = tmp;
+    tmp = vminf(array[39], array[43]);
+    array[43] = vmaxf(array[39], array[43]);
+    array[39] = tmp;
+    tmp = vminf(array[47], array[59]);
+    array[59] = vmaxf(array[47], array[59]);
+    array[47] = tmp;
+    tmp = vminf(array[63], array[67]);
+    array[67] = vmaxf(array[63], array[67]);
+    array[63] = tmp;
+    tmp = vminf(array[71], array[51]);
+    array[51] = vmaxf(array[71], array[51]);
+    array[71] = tmp;
+    tmp = vminf(array[35], array[37]);
+    array[37] = vmaxf(array[35], array[37]);
+    array[35] = tmp;
+    tmp = vminf(array[39], array[41]);
+    array[41] = vmaxf(array[39], array[41]);
+    array[39] = tmp;
+    tmp = vminf(array[43], array[45]);
+    array[45] = vmaxf(array[43], array[45]);
+    array[43] = tmp;
+    tmp = vminf(array[47], array[57]);
+    array[57] = vmaxf(array[47], array[57]);
+    array[47] = tmp;
+    tmp = vminf(array[59], array[61]);
+    array[61] = vmaxf(array[59], array[61]);
+    array[59] = tmp;
+    tmp = vminf(array[63], array[65]);
+    array[65] = vmaxf(array[63], array[65]);
+    array[63] = tmp;
+    tmp = vminf(array[67], array[69]);
+    array[69] = vmaxf(array[67], array[69]);
+    array[67] = tmp;
+    tmp = vminf(array[71], array[49]);
+    array[49] = vmaxf(array[71], array[49]);
+    array[71] = tmp;
+    tmp = vminf(array[51], array[53]);
+    array[53] = vmaxf(array[51], array[53]);
+    array[51] = tmp;
+    tmp = vminf(array[33], array[34]);
+    array[34] = vmaxf(array[33], array[34]);
+    array[33] = tmp;
+    tmp = vminf(array[35], array[36]);
+    array[36] = vmaxf(array[35], array[36]);
+    array[35] = tmp;
+    tmp = vminf(array[37], array[38]);
+    array[38] = vmaxf(array[37], array[38]);
+    array[37] = tmp;
+    tmp = vminf(array[39], array[40]);
+    array[40] = vmaxf(array[39], array[40]);
+    array[39] = tmp;
+    tmp = vminf(array[41], array[42]);
+    array[42] = vmaxf(array[41], array[42]);
+    array[41] = tmp;
+    tmp = vminf(array[43], array[44]);
+    array[44] = vmaxf(array[43], array[44]);
+    array[43] = tmp;
+    tmp = vminf(array[45], array[46]);
+    array[46] = vmaxf(array[45], array[46]);
+    array[45] = tmp;
+    tmp = vminf(array[47], array[56]);
+    array[56] = vmaxf(array[47], array[56]);
+    array[47] = tmp;
+    tmp = vminf(array[57], array[58]);
+    array[58] = vmaxf(array[57], array[58]);
+    array[57] = tmp;
+    tmp = vminf(array[59], array[60]);
+    array[60] = vmaxf(array[59], array[60]);
+    array[59] = tmp;
+    tmp = vminf(array[61], array[62]);
+    array[62] = vmaxf(array[61], array[62]);
+    array[61] = tmp;
+    tmp = vminf(array[63], array[64]);
+    array[64] = vmaxf(array[63], array[64]);
+    array[63] = tmp;
+    tmp = vminf(array[65], array[66]);
+    array[66] = vmaxf(array[65], array[66]);
+    array[65] = tmp;
+    tmp = vminf(array[67], array[68]);
+    array[68] = vmaxf(array[67], array[68]);
+    array[67] = tmp;
+    tmp = vminf(array[69], array[70]);
+    array[70] = vmaxf(array[69], array[70]);
+    array[69] = tmp;
+    tmp = vminf(array[71], array[48]);
+    array[48] = vmaxf(array[71], array[48]);
+    array[71] = tmp;
+    tmp = vminf(array[49], array[50]);
+    array[50] = vmaxf(array[49], array[50]);
+    array[49] = tmp;
+    tmp = vminf(array[51], array[52]);
+    array[52] = vmaxf(array[51], array[52]);
+    array[51] = tmp;
+    tmp = vminf(array[53], array[54]);
+    array[54] = vmaxf(array[53], array[54]);
+    array[53] = tmp;
+    tmp = vminf(array[0], array[32]);
+    array[32] = vmaxf(array[0], array[32]);
+    array[0] = tmp;
+    tmp = vminf(array[48], array[32]);
+    array[32] = vmaxf(array[48], array[32]);
+    array[48] = tmp;
+    tmp = vminf(array[16], array[56]);
+    array[56] = vmaxf(array[16], array[56]);
+    array[16] = tmp;
+    tmp = vminf(array[16], array[48]);
+    array[48] = vmaxf(array[16], array[48]);
+    array[16] = tmp;
+    tmp = vminf(array[56], array[32]);
+    array[32] = vmaxf(array[56], array[32]);
+    array[56] = tmp;
+    tmp = vminf(array[8], array[40]);
+    array[40] = vmaxf(array[8], array[40]);
+    array[8] = tmp;
+    tmp = vminf(array[24], array[64]);
+    array[64] = vmaxf(array[24], array[64]);
+    array[24] = tmp;
+    tmp = vminf(array[24], array[40]);
+    array[40] = vmaxf(array[24], array[40]);
+    array[24] = tmp;
+    array[8] = vminf(array[8], array[16]);
+    tmp = vminf(array[24], array[48]);
+    array[48] = vmaxf(array[24], array[48]);
+    array[24] = tmp;
+    tmp = vminf(array[40], array[56]);
+    array[56] = vmaxf(array[40], array[56]);
+    array[40] = tmp;
+    tmp = vminf(array[64], array[32]);
+    array[32] = vmaxf(array[64], array[32]);
+    array[64] = tmp;
+    tmp = vminf(array[4], array[36]);
+    array[36] = vmaxf(array[4], array[36]);
+    array[4] = tmp;
+    tmp = vminf(array[52], array[36]);
+    array[36] = vmaxf(array[52], array[36]);
+    array[52] = tmp;
+    tmp = vminf(array[20], array[60]);
+    array[60] = vmaxf(array[20], array[60]);
+    array[20] = tmp;
+    tmp = vminf(array[20], array[52]);
+    array[52] = vmaxf(array[20], array[52]);
+    array[20] = tmp;
+    tmp = vminf(array[60], array[36]);
+    array[36] = vmaxf(array[60], array[36]);
+    array[60] = tmp;
+    tmp = vminf(array[12], array[44]);
+    array[44] = vmaxf(array[12], array[44]);
+    array[12] = tmp;
+    tmp = vminf(array[28], array[68]);
+    array[68] = vmaxf(array[28], array[68]);
+    array[28] = tmp;
+    tmp = vminf(array[28], array[44]);
+    array[44] = vmaxf(array[28], array[44]);
+    array[28] = tmp;
+    array[20] = vmaxf(array[12], array[20]);
+    tmp = vminf(array[28], array[52]);
+    array[52] = vmaxf(array[28], array[52]);
+    array[28] = tmp;
+    tmp = vminf(array[44], array[60]);
+    array[60] = vmaxf(array[44], array[60]);
+    array[44] = tmp;
+    tmp = vminf(array[68], array[36]);
+    array[36] = vmaxf(array[68], array[36]);
+    array[68] = tmp;
+    tmp = vminf(array[4], array[8]);
+    array[8] = vmaxf(array[4], array[8]);
+    array[4] = tmp;
+    tmp = vminf(array[20], array[24]);
+    array[24] = vmaxf(array[20], array[24]);
+    array[20] = tmp;
+    tmp = vminf(array[28], array[48]);
+    array[48] = vmaxf(array[28], array[48]);
+    array[28] = tmp;
+    tmp = vminf(array[52], array[40]);
+    array[40] = vmaxf(array[52], array[40]);
+    array[52] = tmp;
+    tmp = vminf(array[44], array[56]);
+    array[56] = vmaxf(array[44], array[56]);
+    array[44] = tmp;
+    array[60] = vminf(array[60], array[64]);
+    array[32] = vmaxf(array[68], array[32]);
+    tmp = vminf(array[2], array[34]);
+    array[34] = vmaxf(array[2], array[34]);
+    array[2] = tmp;
+    tmp = vminf(array[50], array[34]);
+    array[34] = vmaxf(array[50], array[34]);
+    array[50] = tmp;
+    tmp = vminf(array[18], array[58]);
+    array[58] = vmaxf(array[18], array[58]);
+    array[18] = tmp;
+    tmp = vminf(array[18], array[50]);
+    array[50] = vmaxf(array[18], array[50]);
+    array[18] = tmp;
+    tmp = vminf(array[58], array[34]);
+    array[34] = vmaxf(array[58], array[34]);
+    array[58] = tmp;
+    tmp = vminf(array[10], array[42]);
+    array[42] = vmaxf(array[10], array[42]);
+    array[10] = tmp;
+    tmp = vminf(array[26], array[66]);
+    array[66] = vmaxf(array[26], array[66]);
+    array[26] = tmp;
+    tmp = vminf(array[26], array[42]);
+    array[42] = vmaxf(array[26], array[42]);
+    array[26] = tmp;
+    tmp = vminf(array[10], array[18]);
+    array[18] = vmaxf(array[10], array[18]);
+    array[10] = tmp;
+    tmp = vminf(array[26], array[50]);
+    array[50] = vmaxf(array[26], array[50]);
+    array[26] = tmp;
+    tmp = vminf(array[42], array[58]);
+    array[58] = vmaxf(array[42], array[58]);
+    array[42] = tmp;
+    array[34] = vmaxf(array[66], array[34]);
+    tmp = vminf(array[6], array[38]);
+    array[38] = vmaxf(array[6], array[38]);
+    array[6] = tmp;
+    tmp = vminf(array[54], array[38]);
+    array[38] = vmaxf(array[54], array[38]);
+    array[54] = tmp;
+    tmp = vminf(array[22], array[62]);
+    array[62] = vmaxf(array[22], array[62]);
+    array[22] = tmp;
+    tmp = vminf(array[22], array[54]);
+    array[54] = vmaxf(array[22], array[54]);
+    array[22] = tmp;
+    tmp = vminf(array[62], array[38]);
+    array[38] = vmaxf(array[62], array[38]);
+    array[62] = tmp;
+    tmp = vminf(array[14], array[46]);
+    array[46] = vmaxf(array[14], array[46]);
+    array[14] = tmp;
+    tmp = vminf(array[30], array[70]);
+    array[70] = vmaxf(array[30], array[70]);
+    array[30] = tmp;
+    tmp = vminf(array[30], array[46]);
+    array[46] = vmaxf(array[30], array[46]);
+    array[30] = tmp;
+    tmp = vminf(array[14], array[22]);
+    array[22] = vmaxf(array[14], array[22]);
+    array[14] = tmp;
+    tmp = vminf(array[30], array[54]);
+    array[54] = vmaxf(array[30], array[54]);
+    array[30] = tmp;
+    array[46] = vminf(array[46], array[62]);
+    tmp = vminf(array[70], array[38]);
+    array[38] = vmaxf(array[70], array[38]);
+    array[70] = tmp;
+    array[6] = vminf(array[6], array[10]);
+    array[18] = vmaxf(array[14], array[18]);
+    tmp = vminf(array[22], array[26]);
+    array[26] = vmaxf(array[22], array[26]);
+    array[22] = tmp;
+    tmp = vminf(array[30], array[50]);
+    array[50] = vmaxf(array[30], array[50]);
+    array[30] = tmp;
+    tmp = vminf(array[54], array[42]);
+    array[42] = vmaxf(array[54], array[42]);
+    array[54] = tmp;
+    tmp = vminf(array[46], array[58]);
+    array[58] = vmaxf(array[46], array[58]);
+    array[46] = tmp;
+    tmp = vminf(array[70], array[34]);
+    array[34] = vmaxf(array[70], array[34]);
+    array[70] = tmp;
+    tmp = vminf(array[2], array[4]);
+    array[4] = vmaxf(array[2], array[4]);
+    array[2] = tmp;
+    tmp = vminf(array[6], array[8]);
+    array[8] = vmaxf(array[6], array[8]);
+    array[6] = tmp;
+    array[20] = vmaxf(array[18], array[20]);
+    tmp = vminf(array[22], array[24]);
+    array[24] = vmaxf(array[22], array[24]);
+    array[22] = tmp;
+    tmp = vminf(array[26], array[28]);
+    array[28] = vmaxf(array[26], array[28]);
+    array[26] = tmp;
+    tmp = vminf(array[30], array[48]);
+    array[48] = vmaxf(array[30], array[48]);
+    array[30] = tmp;
+    tmp = vminf(array[50], array[52]);
+    array[52] = vmaxf(array[50], array[52]);
+    array[50] = tmp;
+    tmp = vminf(array[54], array[40]);
+    array[40] = vmaxf(array[54], array[40]);
+    array[54] = tmp;
+    tmp = vminf(array[42], array[44]);
+    array[44] = vmaxf(array[42], array[44]);
+    array[42] = tmp;
+    tmp = vminf(array[46], array[56]);
+    array[56] = vmaxf(array[46], array[56]);
+    array[46] = tmp;
+    tmp = vminf(array[58], array[60]);
+    array[60] = vmaxf(array[58], array[60]);
+    array[58] = tmp;
+    array[32] = vmaxf(array[70], array[32]);
+    tmp = vminf(array[34], array[36]);
+    array[36] = vmaxf(array[34], array[36]);
+    array[34] = tmp;
+    tmp = vminf(array[1], array[33]);
+    array[33] = vmaxf(array[1], array[33]);
+    array[1] = tmp;
+    tmp = vminf(array[49], array[33]);
+    array[33] = vmaxf(array[49], array[33]);
+    array[49] = tmp;
+    tmp = vminf(array[17], array[57]);
+    array[57] = vmaxf(array[17], array[57]);
+    array[17] = tmp;
+    tmp = vminf(array[17], array[49]);
+    array[49] = vmaxf(array[17], array[49]);
+    array[17] = tmp;
+    tmp = vminf(array[57], array[33]);
+    array[33] = vmaxf(array[57], array[33]);
+    array[57] = tmp;
+    tmp = vminf(array[9], array[41]);
+    array[41] = vmaxf(array[9], array[41]);
+    array[9] = tmp;
+    tmp = vminf(array[25], array[65]);
+    array[65] = vmaxf(array[25], array[65]);
+    array[25] = tmp;
+    tmp = vminf(array[25], array[41]);
+    array[41] = vmaxf(array[25], array[41]);
+    array[25] = tmp;
+    array[9] = vminf(array[9], array[17]);
+    tmp = vminf(array[25], array[49]);
+    array[49] = vmaxf(array[25], array[49]);
+    array[25] = tmp;
+    tmp = vminf(array[41], array[57]);
+    array[57] = vmaxf(array[41], array[57]);
+    array[41] = tmp;
+    tmp = vminf(array[65], array[33]);
+    array[33] = vmaxf(array[65], array[33]);
+    array[65] = tmp;
+    tmp = vminf(array[5], array[37]);
+    array[37] = vmaxf(array[5], array[37]);
+    array[5] = tmp;
+    tmp = vminf(array[53], array[37]);
+    array[37] = vmaxf(array[53], array[37]);
+    array[53] = tmp;
+    tmp = vminf(array[21], array[61]);
+    array[61] = vmaxf(array[21], array[61]);
+    array[21] = tmp;
+    tmp = vminf(array[21], array[53]);
+    array[53] = vmaxf(array[21], array[53]);
+    array[21] = tmp;
+    tmp = vminf(array[61], array[37]);
+    array[37] = vmaxf(array[61], array[37]);
+    array[61] = tmp;
+    tmp = vminf(array[13], array[45]);
+    array[45] = vmaxf(array[13], array[45]);
+    array[13] = tmp;
+    tmp = vminf(array[29], array[69]);
+    array[69] = vmaxf(array[29], array[69]);
+    array[29] = tmp;
+    tmp = vminf(array[29], array[45]);
+    array[45] = vmaxf(array[29], array[45]);
+    array[29] = tmp;
+    array[21] = vmaxf(array[13], array[21]);
+    tmp = vminf(array[29], array[53]);
+    array[53] = vmaxf(array[29], array[53]);
+    array[29] = tmp;
+    tmp = vminf(array[45], array[61]);
+    array[61] = vmaxf(array[45], array[61]);
+    array[45] = tmp;
+    tmp = vminf(array[69], array[37]);
+    array[37] = vmaxf(array[69], array[37]);
+    array[69] = tmp;
+    tmp = vminf(array[5], array[9]);
+    array[9] = vmaxf(array[5], array[9]);
+    array[5] = tmp;
+    tmp = vminf(array[21], array[25]);
+    array[25] = vmaxf(array[21], array[25]);
+    array[21] = tmp;
+    tmp = vminf(array[29], array[49]);
+    array[49] = vmaxf(array[29], array[49]);
+    array[29] = tmp;
+    tmp = vminf(array[53], array[41]);
+    array[41] = vmaxf(array[53], array[41]);
+    array[53] = tmp;
+    tmp = vminf(array[45], array[57]);
+    array[57] = vmaxf(array[45], array[57]);
+    array[45] = tmp;
+    array[61] = vminf(array[61], array[65]);
+    array[33] = vmaxf(array[69], array[33]);
+    tmp = vminf(array[3], array[35]);
+    array[35] = vmaxf(array[3], array[35]);
+    array[3] = tmp;
+    tmp = vminf(array[51], array[35]);
+    array[35] = vmaxf(array[51], array[35]);
+    array[51] = tmp;
+    tmp = vminf(array[19], array[59]);
+    array[59] = vmaxf(array[19], array[59]);
+    array[19] = tmp;
+    tmp = vminf(array[19], array[51]);
+    array[51] = vmaxf(array[19], array[51]);
+    array[19] = tmp;
+    tmp = vminf(array[59], array[35]);
+    array[35] = vmaxf(array[59], array[35]);
+    array[59] = tmp;
+    tmp = vminf(array[11], array[43]);
+    array[43] = vmaxf(array[11], array[43]);
+    array[11] = tmp;
+    tmp = vminf(array[27], array[67]);
+    array[67] = vmaxf(array[27], array[67]);
+    array[27] = tmp;
+    tmp = vminf(array[27], array[43]);
+    array[43] = vmaxf(array[27], array[43]);
+    array[27] = tmp;
+    tmp = vminf(array[11], array[19]);
+    array[19] = vmaxf(array[11], array[19]);
+    array[11] = tmp;
+    tmp = vminf(array[27], array[51]);
+    array[51] = vmaxf(array[27], array[51]);
+    array[27] = tmp;
+    tmp = vminf(array[43], array[59]);
+    array[59] = vmaxf(array[43], array[59]);
+    array[43] = tmp;
+    array[35] = vmaxf(array[67], array[35]);
+    tmp = vminf(array[7], array[39]);
+    array[39] = vmaxf(array[7], array[39]);
+    array[7] = tmp;
+    tmp = vminf(array[55], array[39]);
+    array[39] = vmaxf(array[55], array[39]);
+    array[55] = tmp;
+    tmp = vminf(array[23], array[63]);
+    array[63] = vmaxf(array[23], array[63]);
+    array[23] = tmp;
+    tmp = vminf(array[23], array[55]);
+    array[55] = vmaxf(array[23], array[55]);
+    array[23] = tmp;
+    tmp = vminf(array[63], array[39]);
+    array[39] = vmaxf(array[63], array[39]);
+    array[63] = tmp;
+    tmp = vminf(array[15], array[47]);
+    array[47] = vmaxf(array[15], array[47]);
+    array[15] = tmp;
+    tmp = vminf(array[31], array[71]);
+    array[71] = vmaxf(array[31], array[71]);
+    array[31] = tmp;
+    tmp = vminf(array[31], array[47]);
+    array[47] = vmaxf(array[31], array[47]);
+    array[31] = tmp;
+    tmp = vminf(array[15], array[23]);
+    array[23] = vmaxf(array[15], array[23]);
+    array[15] = tmp;
+    tmp = vminf(array[31], array[55]);
+    array[55] = vmaxf(array[31], array[55]);
+    array[31] = tmp;
+    array[47] = vminf(array[47], array[63]);
+    tmp = vminf(array[71], array[39]);
+    array[39] = vmaxf(array[71], array[39]);
+    array[71] = tmp;
+    array[7] = vminf(array[7], array[11]);
+    array[19] = vmaxf(array[15], array[19]);
+    tmp = vminf(array[23], array[27]);
+    array[27] = vmaxf(array[23], array[27]);
+    array[23] = tmp;
+    tmp = vminf(array[31], array[51]);
+    array[51] = vmaxf(array[31], array[51]);
+    array[31] = tmp;
+    tmp = vminf(array[55], array[43]);
+    array[43] = vmaxf(array[55], array[43]);
+    array[55] = tmp;
+    tmp = vminf(array[47], array[59]);
+    array[59] = vmaxf(array[47], array[59]);
+    array[47] = tmp;
+    tmp = vminf(array[71], array[35]);
+    array[35] = vmaxf(array[71], array[35]);
+    array[71] = tmp;
+    tmp = vminf(array[3], array[5]);
+    array[5] = vmaxf(array[3], array[5]);
+    array[3] = tmp;
+    array[7] = vminf(array[7], array[9]);
+    tmp = vminf(array[19], array[21]);
+    array[21] = vmaxf(array[19], array[21]);
+    array[19] = tmp;
+    tmp = vminf(array[23], array[25]);
+    array[25] = vmaxf(array[23], array[25]);
+    array[23] = tmp;
+    tmp = vminf(array[27], array[29]);
+    array[29] = vmaxf(array[27], array[29]);
+    array[27] = tmp;
+    tmp = vminf(array[31], array[49]);
+    array[49] = vmaxf(array[31], array[49]);
+    array[31] = tmp;
+    tmp = vminf(array[51], array[53]);
+    array[53] = vmaxf(array[51], array[53]);
+    array[51] = tmp;
+    tmp = vminf(array[55], array[41]);
+    array[41] = vmaxf(array[55], array[41]);
+    array[55] = tmp;
+    tmp = vminf(array[43], array[45]);
+    array[45] = vmaxf(array[43], array[45]);
+    array[43] = tmp;
+    tmp = vminf(array[47], array[57]);
+    array[57] = vmaxf(array[47], array[57]);
+    array[47] = tmp;
+    array[59] = vminf(array[59], array[61]);
+    tmp = vminf(array[71], array[33]);
+    array[33] = vmaxf(array[71], array[33]);
+    array[71] = tmp;
+    tmp = vminf(array[35], array[37]);
+    array[37] = vmaxf(array[35], array[37]);
+    array[35] = tmp;
+    tmp = vminf(array[1], array[2]);
+    array[2] = vmaxf(array[1], array[2]);
+    array[1] = tmp;
+    tmp = vminf(array[3], array[4]);
+    array[4] = vmaxf(array[3], array[4]);
+    array[3] = tmp;
+    tmp = vminf(array[5], array[6]);
+    array[6] = vmaxf(array[5], array[6]);
+    array[5] = tmp;
+    tmp = vminf(array[7], array[8]);
+    array[8] = vmaxf(array[7], array[8]);
+    array[7] = tmp;
+    array[20] = vmaxf(array[19], array[20]);
+    tmp = vminf(array[21], array[22]);
+    array[22] = vmaxf(array[21], array[22]);
+    array[21] = tmp;
+    tmp = vminf(array[23], array[24]);
+    array[24] = vmaxf(array[23], array[24]);
+    array[23] = tmp;
+    tmp = vminf(array[25], array[26]);
+    array[26] = vmaxf(array[25], array[26]);
+    array[25] = tmp;
+    tmp = vminf(array[27], array[28]);
+    array[28] = vmaxf(array[27], array[28]);
+    array[27] = tmp;
+    tmp = vminf(array[29], array[30]);
+    array[30] = vmaxf(array[29], array[30]);
+    array[29] = tmp;
+    tmp = vminf(array[31], array[48]);
+    array[48] = vmaxf(array[31], array[48]);
+    array[31] = tmp;
+    tmp = vminf(array[49], array[50]);
+    array[50] = vmaxf(array[49], array[50]);
+    array[49] = tmp;
+    tmp = vminf(array[51], array[52]);
+    array[52] = vmaxf(array[51], array[52]);
+    array[51] = tmp;
+    tmp = vminf(array[53], array[54]);
+    array[54] = vmaxf(array[53], array[54]);
+    array[53] = tmp;
+    tmp = vminf(array[55], array[40]);
+    array[40] = vmaxf(array[55], array[40]);
+    array[55] = tmp;
+    tmp = vminf(array[41], array[42]);
+    array[42] = vmaxf(array[41], array[42]);
+    array[41] = tmp;
+    tmp = vminf(array[43], array[44]);
+    array[44] = vmaxf(array[43], array[44]);
+    array[43] = tmp;
+    tmp = vminf(array[45], array[46]);
+    array[46] = vmaxf(array[45], array[46]);
+    array[45] = tmp;
+    tmp = vminf(array[47], array[56]);
+    array[56] = vmaxf(array[47], array[56]);
+    array[47] = tmp;
+    tmp = vminf(array[57], array[58]);
+    array[58] = vmaxf(array[57], array[58]);
+    array[57] = tmp;
+    array[59] = vminf(array[59], array[60]);
+    array[32] = vmaxf(array[71], array[32]);
+    tmp = vminf(array[33], array[34]);
+    array[34] = vmaxf(array[33], array[34]);
+    array[33] = tmp;
+    tmp = vminf(array[35], array[36]);
+    array[36] = vmaxf(array[35], array[36]);
+    array[35] = tmp;
+    tmp = vminf(array[37], array[38]);
+    array[38] = vmaxf(array[37], array[38]);
+    array[37] = tmp;
+
+    std::array<vfloat, 90> lower = array;
+    tmp = vminf(lower[81], lower[82]);
+    lower[82] = vmaxf(lower[81], lower[82]);
+    lower[81] = tmp;
+    tmp = vminf(lower[83], lower[84]);
+    lower[84] = vmaxf(lower[83], lower[84]);
+    lower[83] = tmp;
+    tmp = vminf(lower[81], lower[83]);
+    lower[83] = vmaxf(lower[81], lower[83]);
+    lower[81] = tmp;
+    tmp = vminf(lower[82], lower[84]);
+    lower[84] = vmaxf(lower[82], lower[84]);
+    lower[82] = tmp;
+    tmp = vminf(lower[82], lower[83]);
+    lower[83] = vmaxf(lower[82], lower[83]);
+    lower[82] = tmp;
+    tmp = vminf(lower[85], lower[86]);
+    lower[86] = vmaxf(lower[85], lower[86]);
+    lower[85] = tmp;
+    tmp = vminf(lower[88], lower[89]);
+    lower[89] = vmaxf(lower[88], lower[89]);
+    lower[88] = tmp;
+    tmp = vminf(lower[87], lower[88]);
+    lower[88] = vmaxf(lower[87], lower[88]);
+    lower[87] = tmp;
+    tmp = vminf(lower[89], lower[88]);
+    lower[88] = vmaxf(lower[89], lower[88]);
+    lower[89] = tmp;
+    tmp = vminf(lower[85], lower[87]);
+    lower[87] = vmaxf(lower[85], lower[87]);
+    lower[85] = tmp;
+    tmp = vminf(lower[88], lower[87]);
+    lower[87] = vmaxf(lower[88], lower[87]);
+    lower[88] = tmp;
+    tmp = vminf(lower[86], lower[89]);
+    lower[89] = vmaxf(lower[86], lower[89]);
+    lower[86] = tmp;
+    tmp = vminf(lower[86], lower[88]);
+    lower[88] = vmaxf(lower[86], lower[88]);
+    lower[86] = tmp;
+    tmp = vminf(lower[89], lower[87]);
+    lower[87] = vmaxf(lower[89], lower[87]);
+    lower[89] = tmp;
+    tmp = vminf(lower[81], lower[85]);
+    lower[85] = vmaxf(lower[81], lower[85]);
+    lower[81] = tmp;
+    tmp = vminf(lower[87], lower[85]);
+    lower[85] = vmaxf(lower[87], lower[85]);
+    lower[87] = tmp;
+    tmp = vminf(lower[83], lower[88]);
+    lower[88] = vmaxf(lower[83], lower[88]);
+    lower[83] = tmp;
+    tmp = vminf(lower[83], lower[87]);
+    lower[87] = vmaxf(lower[83], lower[87]);
+    lower[83] = tmp;
+    tmp = vminf(lower[88], lower[85]);
+    lower[85] = vmaxf(lower[88], lower[85]);
+    lower[88] = tmp;
+    tmp = vminf(lower[82], lower[86]);
+    lower[86] = vmaxf(lower[82], lower[86]);
+    lower[82] = tmp;
+    tmp = vminf(lower[84], lower[89]);
+    lower[89] = vmaxf(lower[84], lower[89]);
+    lower[84] = tmp;
+    tmp = vminf(lower[84], lower[86]);
+    lower[86] = vmaxf(lower[84], lower[86]);
+    lower[84] = tmp;
+    tmp = vminf(lower[82], lower[83]);
+    lower[83] = vmaxf(lower[82], lower[83]);
+    lower[82] = tmp;
+    tmp = vminf(lower[84], lower[87]);
+    lower[87] = vmaxf(lower[84], lower[87]);
+    lower[84] = tmp;
+    tmp = vminf(lower[86], lower[88]);
+    lower[88] = vmaxf(lower[86], lower[88]);
+    lower[86] = tmp;
+    tmp = vminf(lower[89], lower[85]);
+    lower[85] = vmaxf(lower[89], lower[85]);
+    lower[89] = tmp;
+    lower[81] = vmaxf(lower[0], lower[81]);
+    lower[32] = vminf(lower[32], lower[81]);
+    lower[32] = vmaxf(lower[48], lower[32]);
+    lower[56] = vminf(lower[56], lower[32]);
+    lower[85] = vmaxf(lower[8], lower[85]);
+    lower[40] = vminf(lower[40], lower[85]);
+    lower[40] = vmaxf(lower[24], lower[40]);
+    lower[40] = vminf(lower[40], lower[56]);
+    lower[87] = vmaxf(lower[4], lower[87]);
+    lower[36] = vminf(lower[36], lower[87]);
+    lower[52] = vminf(lower[52], lower[36]);
+    lower[52] = vmaxf(lower[20], lower[52]);
+    lower[28] = vminf(lower[28], lower[44]);
+    lower[52] = vmaxf(lower[28], lower[52]);
+    lower[40] = vmaxf(lower[52], lower[40]);
+    lower[83] = vmaxf(lower[2], lower[83]);
+    lower[34] = vminf(lower[34], lower[83]);
+    lower[34] = vmaxf(lower[50], lower[34]);
+    lower[58] = vminf(lower[58], lower[34]);
+    lower[42] = vmaxf(lower[26], lower[42]);
+    lower[42] = vminf(lower[42], lower[58]);
+    lower[88] = vmaxf(lower[6], lower[88]);
+    lower[38] = vminf(lower[38], lower[88]);
+    lower[54] = vminf(lower[54], lower[38]);
+    lower[54] = vmaxf(lower[22], lower[54]);
+    lower[30] = vminf(lower[30], lower[46]);
+    lower[54] = vmaxf(lower[30], lower[54]);
+    lower[54] = vminf(lower[54], lower[42]);
+    lower[40] = vmaxf(lower[54], lower[40]);
+    lower[82] = vmaxf(lower[1], lower[82]);
+    lower[33] = vminf(lower[33], lower[82]);
+    lower[33] = vmaxf(lower[49], lower[33]);
+    lower[57] = vminf(lower[57], lower[33]);
+    lower[41] = vmaxf(lower[25], lower[41]);
+    lower[41] = vminf(lower[41], lower[57]);
+    lower[86] = vmaxf(lower[5], lower[86]);
+    lower[37] = vminf(lower[37], lower[86]);
+    lower[53] = vminf(lower[53], lower[37]);
+    lower[53] = vmaxf(lower[21], lower[53]);
+    lower[29] = vminf(lower[29], lower[45]);
+    lower[53] = vmaxf(lower[29], lower[53]);
+    lower[41] = vmaxf(lower[53], lower[41]);
+    lower[84] = vmaxf(lower[3], lower[84]);
+    lower[35] = vminf(lower[35], lower[84]);
+    lower[35] = vmaxf(lower[51], lower[35]);
+    lower[59] = vminf(lower[59], lower[35]);
+    lower[43] = vmaxf(lower[27], lower[43]);
+    lower[43] = vminf(lower[43], lower[59]);
+    lower[89] = vmaxf(lower[7], lower[89]);
+    lower[39] = vminf(lower[39], lower[89]);
+    lower[55] = vminf(lower[55], lower[39]);
+    lower[55] = vmaxf(lower[23], lower[55]);
+    lower[31] = vminf(lower[31], lower[47]);
+    lower[55] = vmaxf(lower[31], lower[55]);
+    lower[55] = vminf(lower[55], lower[43]);
+    lower[55] = vminf(lower[55], lower[41]);
+    lower[40] = vmaxf(lower[55], lower[40]);
+
+    tmp = vminf(array[72], array[73]);
+    array[73] = vmaxf(array[72], array[73]);
+    array[72] = tmp;
+    tmp = vminf(array[74], array[75]);
+    array[75] = vmaxf(array[74], array[75]);
+    array[74] = tmp;
+    tmp = vminf(array[72], array[74]);
+    array[74] = vmaxf(array[72], array[74]);
+    array[72] = tmp;
+    tmp = vminf(array[73], array[75]);
+    array[75] = vmaxf(array[73], array[75]);
+    array[73] = tmp;
+    tmp = vminf(array[73], array[74]);
+    array[74] = vmaxf(array[73], array[74]);
+    array[73] = tmp;
+    tmp = vminf(array[76], array[77]);
+    array[77] = vmaxf(array[76], array[77]);
+    array[76] = tmp;
+    tmp = vminf(array[79], array[80]);
+    array[80] = vmaxf(array[79], array[80]);
+    array[79] = tmp;
+    tmp = vminf(array[78], array[79]);
+    array[79] = vmaxf(array[78], array[79]);
+    array[78] = tmp;
+    tmp = vminf(array[80], array[79]);
+    array[79] = vmaxf(array[80], array[79]);
+    array[80] = tmp;
+    tmp = vminf(array[76], array[78]);
+    array[78] = vmaxf(array[76], array[78]);
+    array[76] = tmp;
+    tmp = vminf(array[79], array[78]);
+    array[78] = vmaxf(array[79], array[78]);
+    array[79] = tmp;
+    tmp = vminf(array[77], array[80]);
+    array[80] = vmaxf(array[77], array[80]);
+    array[77] = tmp;
+    tmp = vminf(array[77], array[79]);
+    array[79] = vmaxf(array[77], array[79]);
+    array[77] = tmp;
+    tmp = vminf(array[80], array[78]);
+    array[78] = vmaxf(array[80], array[78]);
+    array[80] = tmp;
+    tmp = vminf(array[72], array[76]);
+    array[76] = vmaxf(array[72], array[76]);
+    array[72] = tmp;
+    tmp = vminf(array[78], array[76]);
+    array[76] = vmaxf(array[78], array[76]);
+    array[78] = tmp;
+    tmp = vminf(array[74], array[79]);
+    array[79] = vmaxf(array[74], array[79]);
+    array[74] = tmp;
+    tmp = vminf(array[74], array[78]);
+    array[78] = vmaxf(array[74], array[78]);
+    array[74] = tmp;
+    tmp = vminf(array[79], array[76]);
+    array[76] = vmaxf(array[79], array[76]);
+    array[79] = tmp;
+    tmp = vminf(array[73], array[77]);
+    array[77] = vmaxf(array[73], array[77]);
+    array[73] = tmp;
+    tmp = vminf(array[75], array[80]);
+    array[80] = vmaxf(array[75], array[80]);
+    array[75] = tmp;
+    tmp = vminf(array[75], array[77]);
+    array[77] = vmaxf(array[75], array[77]);
+    array[75] = tmp;
+    tmp = vminf(array[73], array[74]);
+    array[74] = vmaxf(array[73], array[74]);
+    array[73] = tmp;
+    tmp = vminf(array[75], array[78]);
+    array[78] = vmaxf(array[75], array[78]);
+    array[75] = tmp;
+    tmp = vminf(array[77], array[79]);
+    array[79] = vmaxf(array[77], array[79]);
+    array[77] = tmp;
+    tmp = vminf(array[80], array[76]);
+    array[76] = vmaxf(array[80], array[76]);
+    array[80] = tmp;
+    array[72] = vmaxf(array[0], array[72]);
+    array[32] = vminf(array[32], array[72]);
+    array[32] = vmaxf(array[48], array[32]);
+    array[56] = vminf(array[56], array[32]);
+    array[76] = vmaxf(array[8], array[76]);
+    array[40] = vminf(array[40], array[76]);
+    array[40] = vmaxf(array[24], array[40]);
+    array[40] = vminf(array[40], array[56]);
+    array[78] = vmaxf(array[4], array[78]);
+    array[36] = vminf(array[36], array[78]);
+    array[52] = vminf(array[52], array[36]);
+    array[52] = vmaxf(array[20], array[52]);
+    array[28] = vminf(array[28], array[44]);
+    array[52] = vmaxf(array[28], array[52]);
+    array[40] = vmaxf(array[52], array[40]);
+    array[74] = vmaxf(array[2], array[74]);
+    array[34] = vminf(array[34], array[74]);
+    array[34] = vmaxf(array[50], array[34]);
+    array[58] = vminf(array[58], array[34]);
+    array[42] = vmaxf(array[26], array[42]);
+    array[42] = vminf(array[42], array[58]);
+    array[79] = vmaxf(array[6], array[79]);
+    array[38] = vminf(array[38], array[79]);
+    array[54] = vminf(array[54], array[38]);
+    array[54] = vmaxf(array[22], array[54]);
+    array[30] = vminf(array[30], array[46]);
+    array[54] = vmaxf(array[30], array[54]);
+    array[54] = vminf(array[54], array[42]);
+    array[40] = vmaxf(array[54], array[40]);
+    array[73] = vmaxf(array[1], array[73]);
+    array[33] = vminf(array[33], array[73]);
+    array[33] = vmaxf(array[49], array[33]);
+    array[57] = vminf(array[57], array[33]);
+    array[41] = vmaxf(array[25], array[41]);
+    array[41] = vminf(array[41], array[57]);
+    array[77] = vmaxf(array[5], array[77]);
+    array[37] = vminf(array[37], array[77]);
+    array[53] = vminf(array[53], array[37]);
+    array[53] = vmaxf(array[21], array[53]);
+    array[29] = vminf(array[29], array[45]);
+    array[53] = vmaxf(array[29], array[53]);
+    array[41] = vmaxf(array[53], array[41]);
+    array[75] = vmaxf(array[3], array[75]);
+    array[35] = vminf(array[35], array[75]);
+    array[35] = vmaxf(array[51], array[35]);
+    array[59] = vminf(array[59], array[35]);
+    array[43] = vmaxf(array[27], array[43]);
+    array[43] = vminf(array[43], array[59]);
+    array[80] = vmaxf(array[7], array[80]);
+    array[39] = vminf(array[39], array[80]);
+    array[55] = vminf(array[55], array[39]);
+    array[55] = vmaxf(array[23], array[55]);
+    array[31] = vminf(array[31], array[47]);
+    array[55] = vmaxf(array[31], array[55]);
+    array[55] = vminf(array[55], array[43]);
+    array[55] = vminf(array[55], array[41]);
+    array[40] = vmaxf(array[55], array[40]);
+
+    return {array[40], lower[40]};
+}
+#endif
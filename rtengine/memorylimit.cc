@@ -0,0 +1,71 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <initializer_list>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "memorylimit.h"
+
+namespace rtengine
+{
+
+std::size_t getMemoryLimit()
+{
+    std::size_t limit = 0;
+
+#ifdef WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    if (GlobalMemoryStatusEx(&status)) {
+        limit = status.ullTotalPhys;
+    }
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+
+    if (pages > 0 && pageSize > 0) {
+        limit = static_cast<std::size_t>(pages) * pageSize;
+    }
+
+#ifdef __linux__
+    // cgroup v2 writes "max" when there is no limit, cgroup v1 a huge value
+    for (const char* name : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+        FILE* const file = fopen(name, "r");
+
+        if (file) {
+            unsigned long long value;
+
+            if (fscanf(file, "%llu", &value) == 1 && value > 0 && (limit == 0 || value < limit)) {
+                limit = value;
+            }
+
+            fclose(file);
+        }
+    }
+#endif
+#endif
+
+    return limit;
+}
+
+}
@@ -0,0 +1,171 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <initializer_list>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "colortemp.h"
+#include "imagefloat.h"
+#include "imagesource.h"
+#include "improcfun.h"
+#include "noiseanalysis.h"
+#include "procparams.h"
+#include "rawanalysiscache.h"
+#include "settings.h"
+
+namespace
+{
+
+constexpr std::size_t valuesPerSample = 15;
+
+}
+
+namespace rtengine
+{
+
+void measureNoiseSamples(ImProcFunctions& ipf, ImageSource* imgsrc, const ColorTemp& wb, int tr, const procparams::ProcParams& params, const std::vector<int>& left, const std::vector<int>& top, int crW, int crH, std::vector<NoiseSample>& samples)
+{
+    const int columns = left.size();
+    const int count = columns * top.size();
+    samples.assign(count, NoiseSample());
+
+    // crop of the image as measured by RGB_denoise_info, with the image reduced to 1/4 for the denoise curves
+    const auto getCrop = [&](int k, Imagefloat* crop, Imagefloat* provicalc) {
+        const PreviewProps pp(left[k % columns], top[k / columns], crW, crH, 1);
+        imgsrc->getImage(wb, tr, crop, pp, params.toneCurve, params.raw);
+
+        for (int ii = 0; ii < crH; ii += 2) {
+            for (int jj = 0; jj < crW; jj += 2) {
+                provicalc->r(ii >> 1, jj >> 1) = crop->r(ii, jj);
+                provicalc->g(ii >> 1, jj >> 1) = crop->g(ii, jj);
+                provicalc->b(ii >> 1, jj >> 1) = crop->b(ii, jj);
+            }
+        }
+
+        imgsrc->convertColorSpace(provicalc, params.icm, wb);
+    };
+
+    const procparams::RAWParams& raw = params.raw;
+    const procparams::DirPyrDenoiseParams& dnparams = params.dirpyrDenoise;
+    // the retinex works on the whole demosaiced image with too many parameters to describe, its crops are always measured
+    const bool useCache = !params.retinex.enabled;
+
+    // the crops depend on the raw processing, the white balance, the highlight reconstruction and the input profile. The
+    // chroma sliders, which the automatic modes set from the statistics, do not change them
+    std::ostringstream key;
+
+    if (useCache) {
+        key << imgsrc->getRawAnalysisKey()
+            << " bayer " << raw.bayersensor.method << ' ' << raw.bayersensor.border << ' ' << raw.bayersensor.imageNum << ' ' << raw.bayersensor.ccSteps
+            << ' ' << raw.bayersensor.dcb_iterations << ' ' << raw.bayersensor.dcb_enhance << ' ' << raw.bayersensor.lmmse_iterations
+            << ' ' << raw.bayersensor.dualDemosaicAutoContrast << ' ' << raw.bayersensor.dualDemosaicContrast;
+
+        if (raw.bayersensor.method == procparams::RAWParams::BayerSensor::getMethodString(procparams::RAWParams::BayerSensor::Method::PIXELSHIFT)) {
+            const procparams::RAWParams::BayerSensor& ps = raw.bayersensor;
+            key << " pixelshift " << int(ps.pixelShiftMotionCorrectionMethod) << ' ' << ps.pixelShiftEperIso << ' ' << ps.pixelShiftSigma << ' ' << ps.pixelShiftShowMotion
+                << ' ' << ps.pixelShiftShowMotionMaskOnly << ' ' << ps.pixelShiftHoleFill << ' ' << ps.pixelShiftMedian << ' ' << ps.pixelShiftGreen << ' ' << ps.pixelShiftBlur
+                << ' ' << ps.pixelShiftSmoothFactor << ' ' << ps.pixelShiftEqualBright << ' ' << ps.pixelShiftEqualBrightChannel << ' ' << ps.pixelShiftNonGreenCross
+                << ' ' << ps.pixelShiftDemosaicMethod;
+        }
+
+        key << " xtrans " << raw.xtranssensor.method << ' ' << raw.xtranssensor.border << ' ' << raw.xtranssensor.ccSteps
+            << ' ' << raw.xtranssensor.dualDemosaicAutoContrast << ' ' << raw.xtranssensor.dualDemosaicContrast;
+
+        if (params.filmNegative.enabled) {
+            key << " filmnegative " << params.filmNegative.redRatio << ' ' << params.filmNegative.greenExp << ' ' << params.filmNegative.blueRatio;
+        }
+
+        if (params.pdsharpening.enabled) {
+            const procparams::CaptureSharpeningParams& cs = params.pdsharpening;
+            key << " capturesharpening " << cs.autoContrast << ' ' << cs.autoRadius << ' ' << cs.contrast << ' ' << cs.deconvradius << ' ' << cs.deconvradiusOffset
+                << ' ' << cs.deconviter << ' ' << cs.deconvitercheck;
+        }
+
+        key << " wb " << wb.getTemp() << ' ' << wb.getGreen() << ' ' << wb.getEqual() << ' ' << wb.getMethod()
+            << " hr " << params.toneCurve.hrenabled << ' ' << params.toneCurve.method
+            << " icm " << params.icm.inputProfile << ' ' << params.icm.toneCurve << ' ' << params.icm.applyLookTable << ' ' << params.icm.applyBaselineExposureOffset
+            << ' ' << params.icm.applyHueSatMap << ' ' << params.icm.dcpIlluminant << ' ' << params.icm.workingProfile
+            << " crops " << tr << ' ' << crW << ' ' << crH;
+
+        for (const auto x : left) {
+            key << ' ' << x;
+        }
+
+        for (const auto y : top) {
+            key << ' ' << y;
+        }
+
+        key << " denoise " << imgsrc->isRAW() << ' ' << imgsrc->getDirPyrDenoiseExpComp() << ' ' << settings->leveldnti << ' ' << settings->leveldnautsimpl
+            << ' ' << dnparams.Cmethod << ' ' << dnparams.C2method << ' ' << dnparams.dmethod << ' ' << dnparams.smethod << ' ' << dnparams.gamma;
+    }
+
+    std::vector<double> values;
+
+    if (useCache && loadRawAnalysis(imgsrc->getFileName(), "DenoiseInfo", key.str(), values) && values.size() == count * valuesPerSample) {
+        for (int k = 0; k < count; ++k) {
+            const double* const v = &values[k * valuesPerSample];
+            samples[k] = {
+                static_cast<float>(v[0]), static_cast<int>(v[1]), static_cast<float>(v[2]), static_cast<float>(v[3]), static_cast<float>(v[4]),
+                static_cast<float>(v[5]), static_cast<float>(v[6]), static_cast<float>(v[7]), static_cast<float>(v[8]), static_cast<float>(v[9]),
+                static_cast<float>(v[10]), static_cast<float>(v[11]), static_cast<float>(v[12]), static_cast<float>(v[13]), static_cast<float>(v[14])
+            };
+        }
+
+        return;
+    }
+
+    LUTf gamcurve(65536, 0);
+    float gam, gamthresh, gamslope;
+    ipf.RGB_denoise_infoGamCurve(dnparams, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope);
+    // a binned preview is completed here with all the threads, not by the first getImage() of the parallel loop
+    imgsrc->completeBinnedDemosaic();
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        Imagefloat crop(crW, crH);
+        Imagefloat provicalc((crW + 1) / 2, (crH + 1) / 2);
+
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+
+        for (int k = 0; k < count; ++k) {
+            NoiseSample& s = samples[k];
+            getCrop(k, &crop, &provicalc);
+            ipf.RGB_denoise_info(&crop, &provicalc, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope, dnparams, imgsrc->getDirPyrDenoiseExpComp(), s.chaut, s.nb, s.redaut, s.blueaut, s.maxredaut, s.maxblueaut, s.minredaut, s.minblueaut, s.chromina, s.sigma, s.lumema, s.sigma_L, s.redyel, s.skinc, s.nsknc);
+        }
+    }
+
+    if (!useCache) {
+        return;
+    }
+
+    values.clear();
+
+    for (const auto& s : samples) {
+        values.insert(values.end(), {s.chaut, double(s.nb), s.redaut, s.blueaut, s.maxredaut, s.maxblueaut, s.minredaut, s.minblueaut, s.chromina, s.sigma, s.lumema, s.sigma_L, s.redyel, s.skinc, s.nsknc});
+    }
+
+    saveRawAnalysis(imgsrc->getFileName(), "DenoiseInfo", key.str(), values);
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <vector>
+
+/* Noise statistics of the crops measured by the automatic chroma modes of the noise reduction.
+ *
+ * The editor, its detail windows and the exports measure the same crops of the full size image. The statistics are kept in
+ * the raw analysis cache, identified by the parameters of the raw processing, of the white balance and of the input profile
+ * the crops depend on, and by the parameters of the measurement. An image processed with the same ones reuses the statistics
+ * without building the crops. */
+
+namespace rtengine
+{
+
+class ColorTemp;
+class ImageSource;
+class ImProcFunctions;
+
+namespace procparams
+{
+
+class ProcParams;
+
+}
+
+// output of ImProcFunctions::RGB_denoise_info for a crop
+struct NoiseSample {
+    float chaut;
+    int nb;
+    float redaut;
+    float blueaut;
+    float maxredaut;
+    float maxblueaut;
+    float minredaut;
+    float minblueaut;
+    float chromina;
+    float sigma;
+    float lumema;
+    float sigma_L;
+    float redyel;
+    float skinc;
+    float nsknc;
+};
+
+/** Measures the noise of a grid of crops of the full size image, the crops are processed concurrently
+  * @param left,top are the coordinates of the columns and rows of crops of crW x crH pixels
+  * @param samples receives the statistics of the crop of row r and column c at r * left.size() + c */
+void measureNoiseSamples (ImProcFunctions& ipf, ImageSource* imgsrc, const ColorTemp& wb, int tr, const procparams::ProcParams& params, const std::vector<int>& left, const std::vector<int>& top, int crW, int crH, std::vector<NoiseSample>& samples);
+
+}
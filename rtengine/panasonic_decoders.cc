@@ -15,6 +15,7 @@
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <iostream>
 #include "dcraw.h"
 
@@ -33,6 +34,22 @@
 
 */
 
+void DCraw::pana_bits_t::load()
+{
+    fread (buf+load_flags, 1, 0x4000-load_flags, ifp);
+    fread (buf, 1, load_flags, ifp);
+}
+
+void DCraw::pana_bits_t::seek(int offset)
+{
+    // the block is read from the current position of the file
+    vbits = 0;
+    if (offset) {
+        load();
+        vbits = offset;
+    }
+}
+
 unsigned DCraw::pana_bits_t::operator() (int nbits, unsigned *bytes)
 {
     int byte;
@@ -41,8 +58,7 @@ unsigned DCraw::pana_bits_t::operator() (int nbits, unsigned *bytes)
         return vbits=0;
     }
     if (!vbits) {
-        fread (buf+load_flags, 1, 0x4000-load_flags, ifp);
-        fread (buf, 1, load_flags, ifp);
+        load();
     }
     if (encoding == 5) {
         for (byte = 0; byte < 16; byte++)
@@ -61,9 +77,10 @@ unsigned DCraw::pana_bits_t::operator() (int nbits, unsigned *bytes)
 class pana_cs6_page_decoder
 {
     unsigned int pixelbuffer[14], lastoffset, maxoffset;
-    unsigned char current, *buffer;
+    unsigned char current;
+    const unsigned char *buffer;
 public:
-    pana_cs6_page_decoder(unsigned char *_buffer, unsigned int bsize)
+    pana_cs6_page_decoder(const unsigned char *_buffer, unsigned int bsize)
       : pixelbuffer{}, lastoffset(0), maxoffset(bsize), current(0), buffer(_buffer)
     {
     }
@@ -103,37 +120,62 @@ void DCraw::panasonic_load_raw()
 {
     int enc_blck_size = RT_pana_info.bpp == 12 ? 10 : 9;
     if (RT_pana_info.encoding == 5) {
-        pana_bits_t pana_bits(ifp, load_flags, RT_pana_info.encoding);
-        pana_bits(0, 0);
-        unsigned bytes[16] = {};
-        for (int row = 0; row < raw_height; ++row) {
-            ushort* raw_block_data = raw_image + row * raw_width;
+        // the pixels are stored in groups of 16 bytes, 1024 groups per 0x4000 bytes block
+        // any range of rows can be decoded on its own by seeking to the block containing its first group
+        constexpr int rowsPerChunk = 32;
+        const int groupsPerRow = (raw_width + enc_blck_size - 1) / enc_blck_size;
+        const INT64 start = ftell(ifp);
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            // per-thread copy of the file and bit reader, only the master thread updates the progress bar
+            IMFILE ifpthr = *ifp;
+            ifpthr.plistener = nullptr;
+#ifdef _OPENMP
+            #pragma omp master
+#endif
+            ifpthr.plistener = ifp->plistener;
+            pana_bits_t pana_bits(&ifpthr, load_flags, RT_pana_info.encoding);
+            unsigned bytes[16] = {};
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic)
+#endif
+            for (int chunk = 0; chunk < raw_height; chunk += rowsPerChunk) {
+                const INT64 group = static_cast<INT64>(chunk) * groupsPerRow;
+                fseek(&ifpthr, start + (group >> 10) * 0x4000, SEEK_SET);
+                pana_bits.seek((group & 1023) * 16);
 
-            for (int col = 0; col < raw_width; col += enc_blck_size) {
-                pana_bits(0, bytes);
+                for (int row = chunk; row < std::min<int>(chunk + rowsPerChunk, raw_height); ++row) {
+                    ushort* raw_block_data = raw_image + row * raw_width;
 
-                if (RT_pana_info.bpp == 12) {
-                    raw_block_data[col] = ((bytes[1] & 0xF) << 8) + bytes[0];
-                    raw_block_data[col + 1] = 16 * bytes[2] + (bytes[1] >> 4);
-                    raw_block_data[col + 2] = ((bytes[4] & 0xF) << 8) + bytes[3];
-                    raw_block_data[col + 3] = 16 * bytes[5] + (bytes[4] >> 4);
-                    raw_block_data[col + 4] = ((bytes[7] & 0xF) << 8) + bytes[6];
-                    raw_block_data[col + 5] = 16 * bytes[8] + (bytes[7] >> 4);
-                    raw_block_data[col + 6] = ((bytes[10] & 0xF) << 8) + bytes[9];
-                    raw_block_data[col + 7] = 16 * bytes[11] + (bytes[10] >> 4);
-                    raw_block_data[col + 8] = ((bytes[13] & 0xF) << 8) + bytes[12];
-                    raw_block_data[col + 9] = 16 * bytes[14] + (bytes[13] >> 4);
-                }
-                else if (RT_pana_info.bpp == 14) {
-                    raw_block_data[col] = bytes[0] + ((bytes[1] & 0x3F) << 8);
-                    raw_block_data[col + 1] = (bytes[1] >> 6) + 4 * (bytes[2]) + ((bytes[3] & 0xF) << 10);
-                    raw_block_data[col + 2] = (bytes[3] >> 4) + 16 * (bytes[4]) + ((bytes[5] & 3) << 12);
-                    raw_block_data[col + 3] = ((bytes[5] & 0xFC) >> 2) + (bytes[6] << 6);
-                    raw_block_data[col + 4] = bytes[7] + ((bytes[8] & 0x3F) << 8);
-                    raw_block_data[col + 5] = (bytes[8] >> 6) + 4 * bytes[9] + ((bytes[10] & 0xF) << 10);
-                    raw_block_data[col + 6] = (bytes[10] >> 4) + 16 * bytes[11] + ((bytes[12] & 3) << 12);
-                    raw_block_data[col + 7] = ((bytes[12] & 0xFC) >> 2) + (bytes[13] << 6);
-                    raw_block_data[col + 8] = bytes[14] + ((bytes[15] & 0x3F) << 8);
+                    for (int col = 0; col < raw_width; col += enc_blck_size) {
+                        pana_bits(0, bytes);
+
+                        if (RT_pana_info.bpp == 12) {
+                            raw_block_data[col] = ((bytes[1] & 0xF) << 8) + bytes[0];
+                            raw_block_data[col + 1] = 16 * bytes[2] + (bytes[1] >> 4);
+                            raw_block_data[col + 2] = ((bytes[4] & 0xF) << 8) + bytes[3];
+                            raw_block_data[col + 3] = 16 * bytes[5] + (bytes[4] >> 4);
+                            raw_block_data[col + 4] = ((bytes[7] & 0xF) << 8) + bytes[6];
+                            raw_block_data[col + 5] = 16 * bytes[8] + (bytes[7] >> 4);
+                            raw_block_data[col + 6] = ((bytes[10] & 0xF) << 8) + bytes[9];
+                            raw_block_data[col + 7] = 16 * bytes[11] + (bytes[10] >> 4);
+                            raw_block_data[col + 8] = ((bytes[13] & 0xF) << 8) + bytes[12];
+                            raw_block_data[col + 9] = 16 * bytes[14] + (bytes[13] >> 4);
+                        }
+                        else if (RT_pana_info.bpp == 14) {
+                            raw_block_data[col] = bytes[0] + ((bytes[1] & 0x3F) << 8);
+                            raw_block_data[col + 1] = (bytes[1] >> 6) + 4 * (bytes[2]) + ((bytes[3] & 0xF) << 10);
+                            raw_block_data[col + 2] = (bytes[3] >> 4) + 16 * (bytes[4]) + ((bytes[5] & 3) << 12);
+                            raw_block_data[col + 3] = ((bytes[5] & 0xFC) >> 2) + (bytes[6] << 6);
+                            raw_block_data[col + 4] = bytes[7] + ((bytes[8] & 0x3F) << 8);
+                            raw_block_data[col + 5] = (bytes[8] >> 6) + 4 * bytes[9] + ((bytes[10] & 0xF) << 10);
+                            raw_block_data[col + 6] = (bytes[10] >> 4) + 16 * bytes[11] + ((bytes[12] & 3) << 12);
+                            raw_block_data[col + 7] = ((bytes[12] & 0xFC) >> 2) + (bytes[13] << 6);
+                            raw_block_data[col + 8] = bytes[14] + ((bytes[15] & 0x3F) << 8);
+                        }
+                    }
                 }
             }
         }
@@ -142,6 +184,7 @@ void DCraw::panasonic_load_raw()
     } else if (RT_pana_info.encoding == 7) {
         panasonicC7_load_raw();
     } else {
+        // variable length codes, the rows can only be decoded in sequence
         pana_bits_t pana_bits(ifp, load_flags, RT_pana_info.encoding);
         pana_bits(0, 0);
         int sh = 0, pred[2], nonz[2];
@@ -175,104 +218,120 @@ void DCraw::panasonic_load_raw()
 
 void DCraw::panasonicC6_load_raw()
 {
+    // each row is a sequence of self-contained 16 bytes blocks of 11 pixels, the rows are decoded in place from the file data
     constexpr int rowstep = 16;
     const int blocksperrow = raw_width / 11;
     const int rowbytes = blocksperrow * 16;
-    unsigned char *iobuf = (unsigned char *)malloc(rowbytes * rowstep);
-    merror(iobuf, "panasonicC6_load_raw()");
+    const INT64 start = ftell(ifp);
+    const int rows = raw_height / rowstep * rowstep;
+    const int availablerows = rowbytes ? std::min<INT64>(rows, (ifp->size - start) / rowbytes) : 0;
+    const unsigned char *data = reinterpret_cast<const unsigned char*>(ifp->data) + start;
+    unsigned errors = 0;
 
-    for (int row = 0; row < raw_height - rowstep + 1; row += rowstep) {
-        const int rowstoread = MIN(rowstep, raw_height - row);
-        fread(iobuf, rowbytes, rowstoread, ifp);
-        pana_cs6_page_decoder page(iobuf, rowbytes * rowstoread);
-        for (int crow = 0, col = 0; crow < rowstoread; ++crow, col = 0) {
-            unsigned short *rowptr = &raw_image[(row + crow) * raw_width];
-            for (int rblock = 0; rblock < blocksperrow; rblock++) {
-                page.read_page();
-                unsigned oddeven[2] = {0, 0}, nonzero[2] = {0, 0};
-                unsigned pmul = 0, pixel_base = 0;
-                for (int pix = 0; pix < 11; ++pix) {
-                    if (pix % 3 == 2) {
-                        unsigned base = page.nextpixel();
-                        if (base > 3) {
-                            derror();
-                        }
-                        if (base == 3) {
-                            base = 4;
-                        }
-                        pixel_base = 0x200 << base;
-                        pmul = 1 << base;
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(+:errors) schedule(dynamic,rowstep)
+#endif
+    for (int row = 0; row < availablerows; ++row) {
+        pana_cs6_page_decoder page(data + static_cast<INT64>(row) * rowbytes, rowbytes);
+        unsigned short *rowptr = &raw_image[row * raw_width];
+        int col = 0;
+        for (int rblock = 0; rblock < blocksperrow; rblock++) {
+            page.read_page();
+            unsigned oddeven[2] = {0, 0}, nonzero[2] = {0, 0};
+            unsigned pmul = 0, pixel_base = 0;
+            for (int pix = 0; pix < 11; ++pix) {
+                if (pix % 3 == 2) {
+                    unsigned base = page.nextpixel();
+                    if (base > 3) {
+                        ++errors;
                     }
-                    unsigned epixel = page.nextpixel();
-                    if (oddeven[pix % 2]) {
-                        epixel *= pmul;
-                        if (pixel_base < 0x2000 && nonzero[pix % 2] > pixel_base) {
-                            epixel += nonzero[pix % 2] - pixel_base;
-                        }
-                        nonzero[pix % 2] = epixel;
-                    } else {
-                        oddeven[pix % 2] = epixel;
-                        if (epixel) {
-                            nonzero[pix % 2] = epixel;
-                        } else {
-                            epixel = nonzero[pix % 2];
-                        }
+                    if (base == 3) {
+                        base = 4;
+                    }
+                    pixel_base = 0x200 << base;
+                    pmul = 1 << base;
+                }
+                unsigned epixel = page.nextpixel();
+                if (oddeven[pix % 2]) {
+                    epixel *= pmul;
+                    if (pixel_base < 0x2000 && nonzero[pix % 2] > pixel_base) {
+                        epixel += nonzero[pix % 2] - pixel_base;
                     }
-                    const unsigned spix = epixel - 0xf;
-                    if (spix <= 0xffff) {
-                        rowptr[col++] = spix & 0xffff;
+                    nonzero[pix % 2] = epixel;
+                } else {
+                    oddeven[pix % 2] = epixel;
+                    if (epixel) {
+                        nonzero[pix % 2] = epixel;
                     } else {
-                        epixel = (((signed int)(epixel + 0x7ffffff1)) >> 0x1f);
-                        rowptr[col++] = epixel & 0x3fff;
+                        epixel = nonzero[pix % 2];
                     }
                 }
+                const unsigned spix = epixel - 0xf;
+                if (spix <= 0xffff) {
+                    rowptr[col++] = spix & 0xffff;
+                } else {
+                    epixel = (((signed int)(epixel + 0x7ffffff1)) >> 0x1f);
+                    rowptr[col++] = epixel & 0x3fff;
+                }
             }
         }
     }
-    free(iobuf);
+
+    if (availablerows < rows) {
+        ++errors;
+    }
+    if (errors) {
+        derror();
+        data_error += errors - 1;
+    }
     tiff_bps = RT_pana_info.bpp;
 }
 
 void DCraw::panasonicC7_load_raw()
 {
+    // each row is a sequence of self-contained 16 bytes blocks, the rows are decoded in place from the file data
     constexpr int rowstep = 16;
     const int pixperblock = RT_pana_info.bpp == 14 ? 9 : 10;
     const int rowbytes = raw_width / pixperblock * 16;
+    const INT64 start = ftell(ifp);
+    const int rows = raw_height / rowstep * rowstep;
+    const int availablerows = rowbytes ? std::min<INT64>(rows, (ifp->size - start) / rowbytes) : 0;
+    const unsigned char *data = reinterpret_cast<const unsigned char*>(ifp->data) + start;
 
-    unsigned char *iobuf = (unsigned char *)malloc(rowbytes * rowstep);
-    merror(iobuf, "panasonicC7_load_raw()");
-    for (int row = 0; row < raw_height - rowstep + 1; row += rowstep) {
-        const int rowstoread = MIN(rowstep, raw_height - row);
-        fread (iobuf, rowbytes, rowstoread, ifp);
-        unsigned char *bytes = iobuf;
-        for (int crow = 0; crow < rowstoread; crow++) {
-            ushort *rowptr = &raw_image[(row + crow) * raw_width];
-            for (int col = 0; col < raw_width - pixperblock + 1; col += pixperblock, bytes += 16) {
-                if (RT_pana_info.bpp == 14) {
-                    rowptr[col] = bytes[0] + ((bytes[1] & 0x3F) << 8);
-                    rowptr[col + 1] = (bytes[1] >> 6) + 4 * (bytes[2]) + ((bytes[3] & 0xF) << 10);
-                    rowptr[col + 2] = (bytes[3] >> 4) + 16 * (bytes[4]) + ((bytes[5] & 3) << 12);
-                    rowptr[col + 3] = ((bytes[5] & 0xFC) >> 2) + (bytes[6] << 6);
-                    rowptr[col + 4] = bytes[7] + ((bytes[8] & 0x3F) << 8);
-                    rowptr[col + 5] = (bytes[8] >> 6) + 4 * bytes[9] + ((bytes[10] & 0xF) << 10);
-                    rowptr[col + 6] = (bytes[10] >> 4) + 16 * bytes[11] + ((bytes[12] & 3) << 12);
-                    rowptr[col + 7] = ((bytes[12] & 0xFC) >> 2) + (bytes[13] << 6);
-                    rowptr[col + 8] = bytes[14] + ((bytes[15] & 0x3F) << 8);
-                } else if (RT_pana_info.bpp == 12) { // have not seen in the wild yet
-                    rowptr[col] = ((bytes[1] & 0xF) << 8) + bytes[0];
-                    rowptr[col + 1] = 16 * bytes[2] + (bytes[1] >> 4);
-                    rowptr[col + 2] = ((bytes[4] & 0xF) << 8) + bytes[3];
-                    rowptr[col + 3] = 16 * bytes[5] + (bytes[4] >> 4);
-                    rowptr[col + 4] = ((bytes[7] & 0xF) << 8) + bytes[6];
-                    rowptr[col + 5] = 16 * bytes[8] + (bytes[7] >> 4);
-                    rowptr[col + 6] = ((bytes[10] & 0xF) << 8) + bytes[9];
-                    rowptr[col + 7] = 16 * bytes[11] + (bytes[10] >> 4);
-                    rowptr[col + 8] = ((bytes[13] & 0xF) << 8) + bytes[12];
-                    rowptr[col + 9] = 16 * bytes[14] + (bytes[13] >> 4);
-                }
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,rowstep)
+#endif
+    for (int row = 0; row < availablerows; ++row) {
+        const unsigned char *bytes = data + static_cast<INT64>(row) * rowbytes;
+        ushort *rowptr = &raw_image[row * raw_width];
+        for (int col = 0; col < raw_width - pixperblock + 1; col += pixperblock, bytes += 16) {
+            if (RT_pana_info.bpp == 14) {
+                rowptr[col] = bytes[0] + ((bytes[1] & 0x3F) << 8);
+                rowptr[col + 1] = (bytes[1] >> 6) + 4 * (bytes[2]) + ((bytes[3] & 0xF) << 10);
+                rowptr[col + 2] = (bytes[3] >> 4) + 16 * (bytes[4]) + ((bytes[5] & 3) << 12);
+                rowptr[col + 3] = ((bytes[5] & 0xFC) >> 2) + (bytes[6] << 6);
+                rowptr[col + 4] = bytes[7] + ((bytes[8] & 0x3F) << 8);
+                rowptr[col + 5] = (bytes[8] >> 6) + 4 * bytes[9] + ((bytes[10] & 0xF) << 10);
+                rowptr[col + 6] = (bytes[10] >> 4) + 16 * bytes[11] + ((bytes[12] & 3) << 12);
+                rowptr[col + 7] = ((bytes[12] & 0xFC) >> 2) + (bytes[13] << 6);
+                rowptr[col + 8] = bytes[14] + ((bytes[15] & 0x3F) << 8);
+            } else if (RT_pana_info.bpp == 12) { // have not seen in the wild yet
+                rowptr[col] = ((bytes[1] & 0xF) << 8) + bytes[0];
+                rowptr[col + 1] = 16 * bytes[2] + (bytes[1] >> 4);
+                rowptr[col + 2] = ((bytes[4] & 0xF) << 8) + bytes[3];
+                rowptr[col + 3] = 16 * bytes[5] + (bytes[4] >> 4);
+                rowptr[col + 4] = ((bytes[7] & 0xF) << 8) + bytes[6];
+                rowptr[col + 5] = 16 * bytes[8] + (bytes[7] >> 4);
+                rowptr[col + 6] = ((bytes[10] & 0xF) << 8) + bytes[9];
+                rowptr[col + 7] = 16 * bytes[11] + (bytes[10] >> 4);
+                rowptr[col + 8] = ((bytes[13] & 0xF) << 8) + bytes[12];
+                rowptr[col + 9] = 16 * bytes[14] + (bytes[13] >> 4);
             }
         }
     }
-    free(iobuf);
+
+    if (availablerows < rows) {
+        derror();
+    }
     tiff_bps = RT_pana_info.bpp;
 }
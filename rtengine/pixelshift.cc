@@ -22,8 +22,11 @@
 
 #include <cmath>
 #include <stack>
+#include <utility>
+#include <vector>
 
 #include "array2D.h"
+#include "compactrawframe.h"
 #include "gauss.h"
 #include "median.h"
 #include "procparams.h"
@@ -302,6 +305,63 @@ void calcFrameBrightnessFactor(unsigned int frame, uint32_t datalen, LUTu *histo
 
 }
 
+// Rows row and row + 1 of the 4 frames. The compact frames are converted to float when the rows are loaded, the
+// others are read in place. Loading the next row converts only one new row per compact frame.
+class FrameRows
+{
+public:
+    FrameRows(array2D<float>* const frames[4], const rtengine::CompactRawFrame compact[4]) :
+        first(-2)
+    {
+        for (int k = 0; k < 4; ++k) {
+            this->frames[k] = frames[k];
+            this->compact[k] = &compact[k];
+
+            if (!compact[k].empty()) {
+                buffer[k][0].resize(compact[k].getWidth());
+                buffer[k][1].resize(compact[k].getWidth());
+            }
+        }
+    }
+
+    void load(int row)
+    {
+        const bool next = row == first + 1;
+        first = row;
+
+        for (int k = 0; k < 4; ++k) {
+            if (compact[k]->empty()) {
+                rows[k][0] = (*frames[k])[row];
+                rows[k][1] = (*frames[k])[row + 1];
+                continue;
+            }
+
+            if (next) {
+                std::swap(buffer[k][0], buffer[k][1]);
+            } else {
+                compact[k]->unpackRow(row, buffer[k][0].data());
+            }
+
+            compact[k]->unpackRow(row + 1, buffer[k][1].data());
+            rows[k][0] = buffer[k][0].data();
+            rows[k][1] = buffer[k][1].data();
+        }
+    }
+
+    // row must be the loaded row or the one below
+    const float* operator()(unsigned int frame, int row) const
+    {
+        return rows[frame][row - first];
+    }
+
+private:
+    array2D<float>* frames[4];
+    const rtengine::CompactRawFrame* compact[4];
+    std::vector<float> buffer[4][2];
+    const float* rows[4][2];
+    int first;
+};
+
 }
 
 using namespace std;
@@ -335,28 +395,43 @@ BENCHFUN
     if(motionDetection) {
         if(!showOnlyMask) {
             if(bayerParams.pixelShiftMedian) { // We need the demosaiced frames for motion correction
+                // the compact frames are restored one at a time
+                array2D<float> frameBuffer;
+                const auto floatFrame = [&](int k) -> array2D<float>& {
+                    if (rawDataCompact[k].empty()) {
+                        return *rawDataFrames[k];
+                    }
+
+                    rawDataCompact[k].unpack(frameBuffer);
+                    return frameBuffer;
+                };
+
+                array2D<float>& frame0 = floatFrame(0);
+
                 if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::LMMSE)) {
-                    lmmse_interpolate_omp(winw, winh, *(rawDataFrames[0]), red, green, blue, bayerParams.lmmse_iterations);
+                    lmmse_interpolate_omp(winw, winh, frame0, red, green, blue, bayerParams.lmmse_iterations);
                 } else if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::AMAZEVNG4)) {
-                    dual_demosaic_RT (true, rawParamsIn, winw, winh, *(rawDataFrames[0]), red, green, blue, bayerParams.dualDemosaicContrast, true);
+                    dual_demosaic_RT (true, rawParamsIn, winw, winh, frame0, red, green, blue, bayerParams.dualDemosaicContrast, true);
                 } else if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::RCDVNG4)) {
-                    dual_demosaic_RT (true, rawParamsIn, winw, winh, *(rawDataFrames[0]), red, green, blue, bayerParams.dualDemosaicContrast, true);
+                    dual_demosaic_RT (true, rawParamsIn, winw, winh, frame0, red, green, blue, bayerParams.dualDemosaicContrast, true);
                 } else {
-                    amaze_demosaic_RT(winx, winy, winw, winh, *(rawDataFrames[0]), red, green, blue, options.chunkSizeAMAZE, options.measure);
+                    amaze_demosaic_RT(winx, winy, winw, winh, frame0, red, green, blue, options.chunkSizeAMAZE, options.measure);
                 }
                 multi_array2D<float, 3> redTmp(winw, winh);
                 multi_array2D<float, 3> greenTmp(winw, winh);
                 multi_array2D<float, 3> blueTmp(winw, winh);
 
                 for(int i = 0; i < 3; i++) {
+                    array2D<float>& frameData = floatFrame(i + 1);
+
                     if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::LMMSE)) {
-                        lmmse_interpolate_omp(winw, winh, *(rawDataFrames[i + 1]), redTmp[i], greenTmp[i], blueTmp[i], bayerParams.lmmse_iterations);
+                        lmmse_interpolate_omp(winw, winh, frameData, redTmp[i], greenTmp[i], blueTmp[i], bayerParams.lmmse_iterations);
                     } else if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::AMAZEVNG4)) {
-                        dual_demosaic_RT (true, rawParamsIn, winw, winh, *(rawDataFrames[i + 1]), redTmp[i], greenTmp[i], blueTmp[i], bayerParams.dualDemosaicContrast, true);
+                        dual_demosaic_RT (true, rawParamsIn, winw, winh, frameData, redTmp[i], greenTmp[i], blueTmp[i], bayerParams.dualDemosaicContrast, true);
                     } else if (bayerParams.pixelShiftDemosaicMethod == bayerParams.getPSDemosaicMethodString(procparams::RAWParams::BayerSensor::PSDemosaicMethod::RCDVNG4)) {
-                        dual_demosaic_RT (true, rawParamsIn, winw, winh, *(rawDataFrames[i + 1]), redTmp[i], greenTmp[i], blueTmp[i], bayerParams.dualDemosaicContrast, true);
+                        dual_demosaic_RT (true, rawParamsIn, winw, winh, frameData, redTmp[i], greenTmp[i], blueTmp[i], bayerParams.dualDemosaicContrast, true);
                     } else {
-                        amaze_demosaic_RT(winx, winy, winw, winh, *(rawDataFrames[i + 1]), redTmp[i], greenTmp[i], blueTmp[i], options.chunkSizeAMAZE, options.measure);
+                        amaze_demosaic_RT(winx, winy, winw, winh, frameData, redTmp[i], greenTmp[i], blueTmp[i], options.chunkSizeAMAZE, options.measure);
                     }
                 }
 
@@ -648,26 +723,28 @@ BENCHFUN
                     histoblueThr[i] = new LUTu(65536, LUT_CLIP_BELOW | LUT_CLIP_ABOVE, true);
                 }
 
+                FrameRows frameRows(rawDataFrames, rawDataCompact);
 #ifdef _OPENMP
                 #pragma omp for schedule(dynamic,16) nowait
 #endif
 
                 for(int i = winy + 1; i < winh - 1; ++i) {
+                    frameRows.load(i);
                     int j = winx + 1;
                     int c = fc(cfarray, i, j);
 
                     bool bluerow = (c + fc(cfarray, i, j + 1)) == 3;
 
                     for(int j = winx + 1, offset = fc(cfarray, i, j) & 1; j < winw - 1; ++j, offset ^= 1) {
-                        (*histogreenThr[1 - offset])[(*rawDataFrames[1 - offset])[i - offset + 1][j]]++;
-                        (*histogreenThr[3 - offset])[(*rawDataFrames[3 - offset])[i + offset][j + 1]]++;
+                        (*histogreenThr[1 - offset])[frameRows(1 - offset, i - offset + 1)[j]]++;
+                        (*histogreenThr[3 - offset])[frameRows(3 - offset, i + offset)[j + 1]]++;
 
                         if(bluerow) {
-                            (*historedThr[2 - offset])[(*rawDataFrames[2 - offset])[i + 1][j - offset + 1]]++;
-                            (*histoblueThr[(offset << 1) + offset])[(*rawDataFrames[(offset << 1) + offset])[i][j + offset]]++;
+                            (*historedThr[2 - offset])[frameRows(2 - offset, i + 1)[j - offset + 1]]++;
+                            (*histoblueThr[(offset << 1) + offset])[frameRows((offset << 1) + offset, i)[j + offset]]++;
                         } else {
-                            (*historedThr[(offset << 1) + offset])[(*rawDataFrames[(offset << 1) + offset])[i][j + offset]]++;
-                            (*histoblueThr[2 - offset])[(*rawDataFrames[2 - offset])[i + 1][j - offset + 1]]++;
+                            (*historedThr[(offset << 1) + offset])[frameRows((offset << 1) + offset, i)[j + offset]]++;
+                            (*histoblueThr[2 - offset])[frameRows(2 - offset, i + 1)[j - offset + 1]]++;
                         }
                     }
                 }
@@ -722,16 +799,20 @@ BENCHFUN
     }
 
 
+    // each thread gets its own copy of the row buffers
+    FrameRows frameRows(rawDataFrames, rawDataCompact);
+
     if(motionDetection) {
         // fill channels psRed and psBlue
         array2D<float> psRed(winw + 32, winh); // increase width to avoid cache conflicts
         array2D<float> psBlue(winw + 32, winh);
 
 #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic,16)
+        #pragma omp parallel for schedule(dynamic,16) firstprivate(frameRows)
 #endif
 
         for(int i = winy + 1; i < winh - 1; ++i) {
+            frameRows.load(i);
             float *nonGreenDest0 = psRed[i];
             float *nonGreenDest1 = psBlue[i];
             float ngbright[2][4] = {{redBrightness[0], redBrightness[1], redBrightness[2], redBrightness[3]},
@@ -752,8 +833,8 @@ BENCHFUN
 
             for(; j < winw - 1; ++j) {
                 // store the non green values from the 4 frames into 2 temporary planes
-                nonGreenDest0[j] = (*rawDataFrames[(offset << 1) + offset])[i][j + offset] * ngbright[ng][(offset << 1) + offset];
-                nonGreenDest1[j] = (*rawDataFrames[2 - offset])[i + 1][j - offset + 1] * ngbright[ng ^ 1][2 - offset];
+                nonGreenDest0[j] = frameRows((offset << 1) + offset, i)[j + offset] * ngbright[ng][(offset << 1) + offset];
+                nonGreenDest1[j] = frameRows(2 - offset, i + 1)[j - offset + 1] * ngbright[ng ^ 1][2 - offset];
                 offset ^= 1; // 0 => 1 or 1 => 0
             }
         }
@@ -791,10 +872,11 @@ BENCHFUN
 
 
 #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic,16)
+        #pragma omp parallel for schedule(dynamic,16) firstprivate(frameRows)
 #endif
 
         for(int i = winy + border - offsY; i < winh - (border + offsY); ++i) {
+            frameRows.load(i);
             // offset to keep the code short. It changes its value between 0 and 1 for each iteration of the loop
             unsigned int offset = fc(cfarray, i, winx + border - offsX) & 1;
 
@@ -802,7 +884,7 @@ BENCHFUN
                 psMask[i][j] = noMotion;
 
                 if(checkGreen) {
-                    if(greenDiff((*rawDataFrames[1 - offset])[i - offset + 1][j] * greenBrightness[1 - offset], (*rawDataFrames[3 - offset])[i + offset][j + 1] * greenBrightness[3 - offset], stddevFactorGreen, eperIsoGreen, nRead, prnu) > 0.f) {
+                    if(greenDiff(frameRows(1 - offset, i - offset + 1)[j] * greenBrightness[1 - offset], frameRows(3 - offset, i + offset)[j + 1] * greenBrightness[3 - offset], stddevFactorGreen, eperIsoGreen, nRead, prnu) > 0.f) {
                         psMask[i][j] = greenWeight;
                         // do not set the motion pixel values. They have already been set by demosaicer
                         continue;
@@ -902,10 +984,11 @@ BENCHFUN
         }
 
 #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic,16)
+        #pragma omp parallel for schedule(dynamic,16) firstprivate(frameRows)
 #endif
 
         for(int i = winy + border - offsY; i < winh - (border + offsY); ++i) {
+            frameRows.load(i);
 #ifdef __SSE2__
 
             // pow() is expensive => pre calculate blend factor using SSE
@@ -958,11 +1041,11 @@ BENCHFUN
                         const float blend = smoothFactor == 0.f ? 1.f : pow_F(std::max(psMask[i][j] - 1.f, 0.f), smoothFactor);
 #endif
                         redDest[j + offsX] = intp(blend, showMotion ? 0.f : redDest[j + offsX], psRed[i][j] );
-                        greenDest[j + offsX] = intp(blend, showMotion ? 13500.f : greenDest[j + offsX], ((*rawDataFrames[1 - offset])[i - offset + 1][j] * greenBrightness[1 - offset] + (*rawDataFrames[3 - offset])[i + offset][j + 1] * greenBrightness[3 - offset]) * 0.5f);
+                        greenDest[j + offsX] = intp(blend, showMotion ? 13500.f : greenDest[j + offsX], (frameRows(1 - offset, i - offset + 1)[j] * greenBrightness[1 - offset] + frameRows(3 - offset, i + offset)[j + 1] * greenBrightness[3 - offset]) * 0.5f);
                         blueDest[j + offsX] = intp(blend, showMotion ? 0.f : blueDest[j + offsX], psBlue[i][j]);
                     } else {
                         redDest[j + offsX] = psRed[i][j];
-                        greenDest[j + offsX] = ((*rawDataFrames[1 - offset])[i - offset + 1][j] * greenBrightness[1 - offset] + (*rawDataFrames[3 - offset])[i + offset][j + 1] * greenBrightness[3 - offset]) * 0.5f;
+                        greenDest[j + offsX] = (frameRows(1 - offset, i - offset + 1)[j] * greenBrightness[1 - offset] + frameRows(3 - offset, i + offset)[j + 1] * greenBrightness[3 - offset]) * 0.5f;
                         blueDest[j + offsX] = psBlue[i][j];
                     }
                 }
@@ -974,10 +1057,11 @@ BENCHFUN
                                 {blueBrightness[0], blueBrightness[1], blueBrightness[2], blueBrightness[3]}
         };
 #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic,16)
+        #pragma omp parallel for schedule(dynamic,16) firstprivate(frameRows)
 #endif
 
         for(int i = winy + 1; i < winh - 1; ++i) {
+            frameRows.load(i);
             float *nonGreenDest0 = red[i];
             float *nonGreenDest1 = blue[i];
             int ng = 0;
@@ -995,9 +1079,9 @@ BENCHFUN
 
             for(; j < winw - 1; ++j) {
                 // set red, green and blue values
-                green[i][j] = ((*rawDataFrames[1 - offset])[i - offset + 1][j] * greenBrightness[1 - offset] + (*rawDataFrames[3 - offset])[i + offset][j + 1] * greenBrightness[3 - offset]) * 0.5f;
-                nonGreenDest0[j] = (*rawDataFrames[(offset << 1) + offset])[i][j + offset] * ngbright[ng][(offset << 1) + offset];
-                nonGreenDest1[j] = (*rawDataFrames[2 - offset])[i + 1][j - offset + 1] * ngbright[ng ^ 1][2 - offset];
+                green[i][j] = (frameRows(1 - offset, i - offset + 1)[j] * greenBrightness[1 - offset] + frameRows(3 - offset, i + offset)[j + 1] * greenBrightness[3 - offset]) * 0.5f;
+                nonGreenDest0[j] = frameRows((offset << 1) + offset, i)[j + offset] * ngbright[ng][(offset << 1) + offset];
+                nonGreenDest1[j] = frameRows(2 - offset, i + 1)[j - offset + 1] * ngbright[ng ^ 1][2 - offset];
                 offset ^= 1; // 0 => 1 or 1 => 0
             }
         }
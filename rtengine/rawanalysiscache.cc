@@ -0,0 +1,112 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+#include <glib/gstdio.h>
+#include <glibmm/checksum.h>
+
+#include "cachefile.h"
+#include "rawanalysiscache.h"
+#include "settings.h"
+
+namespace
+{
+
+constexpr char analysisMagic[4] = {'R', 'T', 'R', 'A'};
+constexpr std::uint32_t analysisVersion = 1;
+
+struct AnalysisHeader {
+    rtengine::CacheFileHeader file;
+    char analysis[32];
+    char key[33];               // md5 of the key
+    std::int64_t fileSize;
+    std::int64_t fileTime;
+    std::uint32_t valueCount;
+};
+
+// Fills the header identifying the current version of the raw file and returns the name of the result, or an empty string
+Glib::ustring getAnalysisName(const std::string& fname, const char* analysis, const std::string& key, AnalysisHeader& header)
+{
+    memset(&header, 0, sizeof(header));
+    header.file.init(analysisMagic, analysisVersion);
+    strncpy(header.analysis, analysis, sizeof(header.analysis) - 1);
+    strncpy(header.key, Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_MD5, key).c_str(), sizeof(header.key) - 1);
+    return rtengine::getSourceCacheFileName("rawanalysis", fname, analysis, "rra", header.fileSize, header.fileTime);
+}
+
+}
+
+namespace rtengine
+{
+
+bool loadRawAnalysis(const std::string& fname, const char* analysis, const std::string& key, std::vector<double>& values)
+{
+    values.clear();
+
+    AnalysisHeader expected;
+    const Glib::ustring analysisName = getAnalysisName(fname, analysis, key, expected);
+
+    if (analysisName.empty()) {
+        return false;
+    }
+
+    FILE* const file = g_fopen(analysisName.c_str(), "rb");
+
+    if (!file) {
+        return false;
+    }
+
+    AnalysisHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && !memcmp(&header, &expected, offsetof(AnalysisHeader, valueCount))
+                 && header.valueCount > 0 && header.valueCount <= 1 << 16;
+
+    if (valid) {
+        values.resize(header.valueCount);
+        valid = fread(values.data(), sizeof(double), values.size(), file) == values.size();
+    }
+
+    fclose(file);
+
+    if (!valid) {
+        values.clear();
+    } else if (settings->verbose) {
+        printf("Using the stored %s of %s\n", analysis, fname.c_str());
+    }
+
+    return valid;
+}
+
+void saveRawAnalysis(const std::string& fname, const char* analysis, const std::string& key, const std::vector<double>& values)
+{
+    AnalysisHeader header;
+    const Glib::ustring analysisName = getAnalysisName(fname, analysis, key, header);
+
+    if (analysisName.empty() || values.empty()) {
+        return;
+    }
+
+    // the preview and the queue may store the same result at the same time, the last one wins
+    header.valueCount = values.size();
+    writeCacheFile(analysisName, [&](FILE* file) {
+        return fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(values.data(), sizeof(double), values.size(), file) == values.size();
+    });
+}
+
+}
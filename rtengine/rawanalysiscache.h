@@ -0,0 +1,43 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* Results of the analyses of the raw data which only depend on the raw file and on the preprocessing (fit of the auto CA
+ * correction, auto radius of the capture sharpening).
+ *
+ * Each result is stored in the "rawanalysis" folder of the cache, identified by the name, size and modification time of the
+ * raw file and by the name of the analysis. It also records a key built from the parameters of the steps which run before
+ * the analysis, a result recorded with another key is measured again and replaced. */
+
+namespace rtengine
+{
+
+/** Loads the result of an analysis
+  * @param fname is the name of the raw file
+  * @param analysis identifies the analysis
+  * @param key describes the parameters the result depends on
+  * @param values receives the result
+  * @return false if there is no result for the current version of the file and this key */
+bool loadRawAnalysis (const std::string& fname, const char* analysis, const std::string& key, std::vector<double>& values);
+
+/** Stores the result of an analysis, does nothing if the cache is disabled */
+void saveRawAnalysis (const std::string& fname, const char* analysis, const std::string& key, const std::vector<double>& values);
+
+}
@@ -14,6 +14,7 @@
 #include "rawimage.h"
 #include "settings.h"
 #include "camconst.h"
+#include "instrumentation.h"
 #include "utils.h"
 #include "rtengine.h"
 
@@ -27,6 +28,9 @@ RawImage::RawImage(  const Glib::ustring &name )
     , rotate_deg(0)
     , profile_data(nullptr)
     , allocation(nullptr)
+    , imageBytes(0)
+    , rawImageBytes(0)
+    , allocationBytes(0)
 {
     memset(maximum_c4, 0, sizeof(maximum_c4));
     RT_matrix_from_constant = ThreeValBool::X;
@@ -41,13 +45,13 @@ RawImage::~RawImage()
         ifp = nullptr;
     }
 
-    if( image ) {
-        free(image);
-    }
+    releaseImage();
+    releaseRawImage();
 
     if(allocation) {
         delete [] allocation;
         allocation = nullptr;
+        instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(allocationBytes));
     }
 
     if(float_raw_image) {
@@ -66,6 +70,26 @@ RawImage::~RawImage()
     }
 }
 
+void RawImage::releaseImage()
+{
+    if (image) {
+        free(image);
+        image = nullptr;
+        instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(imageBytes));
+        imageBytes = 0;
+    }
+}
+
+void RawImage::releaseRawImage()
+{
+    if (raw_image) {
+        free(raw_image);
+        raw_image = nullptr;
+        instrumentation::bufferBytesChanged(-static_cast<std::ptrdiff_t>(rawImageBytes));
+        rawImageBytes = 0;
+    }
+}
+
 eSensorType RawImage::getSensorType() const
 {
     if (isBayer()) {
@@ -412,7 +436,7 @@ skip_block:
     }
 }
 
-int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, ProgressListener *plistener, double progressRange)
+int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, ProgressListener *plistener, double progressRange, bool dataOnly)
 {
     ifname = filename.c_str();
     image = nullptr;
@@ -493,14 +517,27 @@ int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, Pro
         if (filters || colors == 1) {
             raw_image = (ushort *) calloc ((static_cast<unsigned int>(raw_height) + 7u) * static_cast<unsigned int>(raw_width), 2);
             merror (raw_image, "main()");
+            rawImageBytes = (static_cast<std::size_t>(raw_height) + 7) * raw_width * 2;
+            instrumentation::bufferBytesChanged(rawImageBytes);
         }
 
-        // dcraw needs this global variable to hold pixel data
-        image = (dcrawImage_t)calloc (static_cast<unsigned int>(height) * static_cast<unsigned int>(width) * sizeof * image + meta_length, 1);
-        meta_data = (char *) (image + static_cast<unsigned int>(height) * static_cast<unsigned int>(width));
+        // the decoders of the raw sensors only write raw_image, compress_image() can crop it into data without the 16 bit
+        // image. The fuji layout and the canon 600 correction still work on the image.
+        const bool skipImage = dataOnly && raw_image && !fuji_width && load_raw != &RawImage::canon_600_load_raw;
+
+        if (skipImage) {
+            meta_data = nullptr;
+        } else {
+            // dcraw needs this global variable to hold pixel data
+            image = (dcrawImage_t)calloc (static_cast<unsigned int>(height) * static_cast<unsigned int>(width) * sizeof * image + meta_length, 1);
+            meta_data = (char *) (image + static_cast<unsigned int>(height) * static_cast<unsigned int>(width));
+
+            if(!image) {
+                return 200;
+            }
 
-        if(!image) {
-            return 200;
+            imageBytes = static_cast<std::size_t>(height) * width * sizeof * image + meta_length;
+            instrumentation::bufferBytesChanged(imageBytes);
         }
 
         /* Issue 2467
@@ -527,37 +564,7 @@ int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, Pro
         CameraConst *cc = ccs->get(make, model);
 
         if (raw_image) {
-            if (cc && cc->has_rawCrop()) {
-                int lm, tm, w, h;
-                cc->get_rawCrop(lm, tm, w, h);
-                if(isXtrans()) {
-                    shiftXtransMatrix(6 - ((top_margin - tm)%6), 6 - ((left_margin - lm)%6));
-                } else {
-                    if(((int)top_margin - tm) & 1) { // we have an odd border difference
-                        filters = (filters << 4) | (filters >> 28);    // left rotate filters by 4 bits
-                    }
-                }
-                left_margin = lm;
-                top_margin = tm;
-
-                if (w < 0) {
-                    iwidth += w;
-                    iwidth -= left_margin;
-                    width += w;
-                    width -= left_margin;
-                } else if (w > 0) {
-                    iwidth = width = min((int)width, w);
-                }
-
-                if (h < 0) {
-                    iheight += h;
-                    iheight -= top_margin;
-                    height += h;
-                    height -= top_margin;
-                } else if (h > 0) {
-                    iheight = height = min((int)height, h);
-                }
-            }
+            applyRawCrop(cc, true);
 
             if (cc && cc->has_rawMask(0)) {
                 for (int i = 0; i < 8 && cc->has_rawMask(i); i++) {
@@ -566,29 +573,17 @@ int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, Pro
             }
 
             crop_masked_pixels();
-            free (raw_image);
-            raw_image = nullptr;
-        } else {
-            if (get_maker() == "Sigma" && cc && cc->has_rawCrop()) { // foveon images
-                int lm, tm, w, h;
-                cc->get_rawCrop(lm, tm, w, h);
-                left_margin = lm;
-                top_margin = tm;
-
-                if (w < 0) {
-                    width += w;
-                    width -= left_margin;
-                } else if (w > 0) {
-                    width = min((int)width, w);
-                }
 
-                if (h < 0) {
-                    height += h;
-                    height -= top_margin;
-                } else if (h > 0) {
-                    height = min((int)height, h);
-                }
+            if (!image && data_error) {
+                // crop_masked_pixels() leaves the image black on errors
+                memset(raw_image, 0, static_cast<size_t>(raw_height) * raw_width * sizeof(*raw_image));
             }
+
+            if (image) {
+                releaseRawImage();
+            }
+        } else {
+            applyRawCrop(cc, false);
         }
 
         // Load embedded profile
@@ -689,16 +684,79 @@ int RawImage::loadRaw (bool loadData, unsigned int imageNum, bool closeFile, Pro
     return 0;
 }
 
-float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
+// Applies the raw crop of camconst.json to the geometry, rawSensor is true when the decoder output is raw_image
+void RawImage::applyRawCrop(CameraConst* cc, bool rawSensor)
 {
-    if( !image ) {
-        return nullptr;
+    if (rawSensor) {
+        if (cc && cc->has_rawCrop()) {
+            int lm, tm, w, h;
+            cc->get_rawCrop(lm, tm, w, h);
+            if(isXtrans()) {
+                shiftXtransMatrix(6 - ((top_margin - tm)%6), 6 - ((left_margin - lm)%6));
+            } else {
+                if(((int)top_margin - tm) & 1) { // we have an odd border difference
+                    filters = (filters << 4) | (filters >> 28);    // left rotate filters by 4 bits
+                }
+            }
+            left_margin = lm;
+            top_margin = tm;
+
+            if (w < 0) {
+                iwidth += w;
+                iwidth -= left_margin;
+                width += w;
+                width -= left_margin;
+            } else if (w > 0) {
+                iwidth = width = min((int)width, w);
+            }
+
+            if (h < 0) {
+                iheight += h;
+                iheight -= top_margin;
+                height += h;
+                height -= top_margin;
+            } else if (h > 0) {
+                iheight = height = min((int)height, h);
+            }
+        }
+    } else if (get_maker() == "Sigma" && cc && cc->has_rawCrop()) { // foveon images
+        int lm, tm, w, h;
+        cc->get_rawCrop(lm, tm, w, h);
+        left_margin = lm;
+        top_margin = tm;
+
+        if (w < 0) {
+            width += w;
+            width -= left_margin;
+        } else if (w > 0) {
+            width = min((int)width, w);
+        }
+
+        if (h < 0) {
+            height += h;
+            height -= top_margin;
+        } else if (h > 0) {
+            height = min((int)height, h);
+        }
     }
+}
 
+float** RawImage::allocate_data(unsigned int frameNum)
+{
+    iheight = height;
+    iwidth = width;
+    applyRawCrop(CameraConstantsStore::getInstance()->get(make, model), filters || colors == 1);
+    return allocateData(frameNum);
+}
+
+float** RawImage::allocateData(unsigned int frameNum)
+{
     if (isBayer() || isXtrans()) {
         if (!allocation) {
             // shift the beginning of all frames but the first by 32 floats to avoid cache miss conflicts on CPUs which have <= 4-way associative L1-Cache
             allocation = new float[static_cast<unsigned int>(height) * static_cast<unsigned int>(width) + frameNum * 32u];
+            allocationBytes = (static_cast<std::size_t>(height) * width + frameNum * 32u) * sizeof(float);
+            instrumentation::bufferBytesChanged(allocationBytes);
             data = new float*[height];
 
             for (int i = 0; i < height; i++) {
@@ -709,6 +767,8 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
         // Monochrome
         if (!allocation) {
             allocation = new float[static_cast<unsigned long>(height) * static_cast<unsigned long>(width)];
+            allocationBytes = static_cast<std::size_t>(height) * width * sizeof(float);
+            instrumentation::bufferBytesChanged(allocationBytes);
             data = new float*[height];
 
             for (int i = 0; i < height; i++) {
@@ -718,6 +778,8 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
     } else {
         if (!allocation) {
             allocation = new float[3UL * static_cast<unsigned long>(height) * static_cast<unsigned long>(width)];
+            allocationBytes = 3 * static_cast<std::size_t>(height) * width * sizeof(float);
+            instrumentation::bufferBytesChanged(allocationBytes);
             data = new float*[height];
 
             for (int i = 0; i < height; i++) {
@@ -726,6 +788,17 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
         }
     }
 
+    return data;
+}
+
+float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
+{
+    if( !image && !raw_image ) {
+        return nullptr;
+    }
+
+    allocateData(frameNum);
+
     // copy pixel raw data: the compressed format earns space
     if( float_raw_image ) {
 #ifdef _OPENMP
@@ -739,6 +812,19 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
 
         delete [] float_raw_image;
         float_raw_image = nullptr;
+    } else if (!image) {
+        // loaded with dataOnly, the decoder output goes straight into data
+#ifdef _OPENMP
+        #pragma omp parallel for
+#endif
+
+        for (int row = 0; row < height; row++) {
+            const ushort* const src = raw_image + static_cast<size_t>(row + top_margin) * raw_width + left_margin;
+
+            for (int col = 0; col < width; col++) {
+                this->data[row][col] = src[col];
+            }
+        }
     } else if (filters != 0 && !isXtrans()) {
 #ifdef _OPENMP
         #pragma omp parallel for
@@ -784,9 +870,11 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
     }
 
     if(freeImage) {
-        free(image); // we don't need this anymore
-        image = nullptr;
+        releaseImage(); // we don't need this anymore
     }
+
+    releaseRawImage(); // kept by loadRaw() with dataOnly
+
     return data;
 }
 
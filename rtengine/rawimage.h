@@ -29,6 +29,8 @@
 namespace rtengine
 {
 
+class CameraConst;
+
 class RawImage: public DCraw
 {
 public:
@@ -36,7 +38,9 @@ public:
     explicit RawImage( const Glib::ustring &name );
     ~RawImage();
 
-    int loadRaw (bool loadData, unsigned int imageNum = 0, bool closeFile = true, ProgressListener *plistener = nullptr, double progressRange = 1.0);
+    // dataOnly: the pixels will only be read through compress_image(). The 16 bit image of the bayer, x-trans and monochrome
+    // sensors is then not allocated, compress_image() crops the decoder output into data and releases it.
+    int loadRaw (bool loadData, unsigned int imageNum = 0, bool closeFile = true, ProgressListener *plistener = nullptr, double progressRange = 1.0, bool dataOnly = false);
     void get_colorsCoeff( float* pre_mul_, float* scale_mul_, float* cblack_, bool forceAutoWB );
     void set_prefilters()
     {
@@ -50,8 +54,11 @@ public:
         return image;
     }
     float** compress_image(unsigned int frameNum, bool freeImage = true); // revert to compressed pixels format and release image data
+    // after loadRaw(false): allocates data with the geometry loadRaw(true) gives, without decoding, for the callers which fill it themselves
+    float** allocate_data(unsigned int frameNum);
     float** data;             // holds pixel values, data[i][j] corresponds to the ith row and jth column
     unsigned prefilters;               // original filters saved ( used for 4 color processing )
+    std::string calibrationIdentity;   // version of the files of a dark frame or flat field, see getCalibrationIdentity()
     unsigned int getFrameCount() const { return is_raw; }
 
     double getBaselineExposure() const { return RT_baseline_exposure; }
@@ -60,6 +67,14 @@ protected:
     int rotate_deg; // 0,90,180,270 degree of rotation: info taken by dcraw from exif
     char* profile_data; // Embedded ICC color profile
     float* allocation; // pointer to allocated memory
+    // sizes of image, raw_image and allocation, accounted in the instrumentation
+    std::size_t imageBytes;
+    std::size_t rawImageBytes;
+    std::size_t allocationBytes;
+    void releaseImage();
+    void releaseRawImage();
+    void applyRawCrop(CameraConst* cc, bool rawSensor);
+    float** allocateData(unsigned int frameNum);
     int maximum_c4[4];
     bool isFoveon() const
     {
@@ -19,6 +19,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <sstream>
 
 #include "camconst.h"
 #include "color.h"
@@ -35,6 +36,7 @@
 #include "mytime.h"
 #include "pdaflinesfilter.h"
 #include "procparams.h"
+#include "rawanalysiscache.h"
 #include "rawimage.h"
 #include "rawimagesource_i.h"
 #include "rawimagesource.h"
@@ -737,6 +739,10 @@ void RawImageSource::getImage (const ColorTemp &ctemp, int tran, Imagefloat* ima
 
     int maxx = this->W, maxy = this->H, skip = pp.getSkip();
 
+    if (skip < 2) {
+        finishBinnedDemosaic(false);
+    }
+
     // raw clip levels after white balance
     hlmax[0] = clmax[0] * rm;
     hlmax[1] = clmax[1] * gm;
@@ -748,6 +754,24 @@ void RawImageSource::getImage (const ColorTemp &ctemp, int tran, Imagefloat* ima
     rm /= area;
     gm /= area;
     bm /= area;
+
+    // sums of the raw samples of each colour in a box, scaled to the area of the box, see demosaicBinned()
+    const auto binBox = [this, area](int row, int col, int size, float &rtot, float &gtot, float &btot) {
+        float tot[4] = {};
+        int count[4] = {};
+
+        for (int m = 0; m < size; m++) {
+            for (int n = 0; n < size; n++) {
+                const unsigned int c = FC(row + m, col + n);
+                tot[c] += rawData[row + m][col + n];
+                count[c]++;
+            }
+        }
+
+        rtot = tot[0] * area / count[0];
+        gtot = (tot[1] + tot[3]) * area / (count[1] + count[3]);
+        btot = tot[2] * area / count[2];
+    };
     bool doHr = (hrp.hrenabled && hrp.method != "Color");
     const float expcomp = std::pow(2, ri->getBaselineExposure());
     rm *= expcomp;
@@ -777,12 +801,16 @@ void RawImageSource::getImage (const ColorTemp &ctemp, int tran, Imagefloat* ima
 
                     float rtot = 0.f, gtot = 0.f, btot = 0.f;
 
-                    for (int m = 0; m < skip; m++)
-                        for (int n = 0; n < skip; n++) {
-                            rtot += red[i + m][jx + n];
-                            gtot += green[i + m][jx + n];
-                            btot += blue[i + m][jx + n];
-                        }
+                    if (binnedPlanes) {
+                        binBox(i, jx, skip, rtot, gtot, btot);
+                    } else {
+                        for (int m = 0; m < skip; m++)
+                            for (int n = 0; n < skip; n++) {
+                                rtot += red[i + m][jx + n];
+                                gtot += green[i + m][jx + n];
+                                btot += blue[i + m][jx + n];
+                            }
+                    }
 
                     rtot *= rm;
                     gtot *= gm;
@@ -1048,10 +1076,15 @@ int RawImageSource::load (const Glib::ustring &fname, bool firstFrameOnly)
             for (unsigned int i = 0; i < numFrames; ++i) {
                 if (i == 0) {
                     riFrames[i] = ri;
-                    errCodeThr = riFrames[i]->loadRaw (true, i + 1, true, plistener, 0.8);
+                    errCodeThr = riFrames[i]->loadRaw (true, i + 1, true, plistener, 0.8, true);
                 } else {
                     riFrames[i] = new RawImage(fname);
-                    errCodeThr = riFrames[i]->loadRaw (true, i + 1);
+                    errCodeThr = riFrames[i]->loadRaw (true, i + 1, true, nullptr, 1.0, true);
+                }
+
+                if (!errCodeThr) {
+                    // release the decoder output of this frame before the next one is decoded
+                    riFrames[i]->compress_image(i);
                 }
             }
 #ifdef _OPENMP
@@ -1073,10 +1106,15 @@ int RawImageSource::load (const Glib::ustring &fname, bool firstFrameOnly)
             for (unsigned int i = 0; i < numFrames; ++i) {
                 if (i == 0) {
                     riFrames[i] = ri;
-                    errCodeThr = riFrames[i]->loadRaw (true, i, true, plistener, 0.8);
+                    errCodeThr = riFrames[i]->loadRaw (true, i, true, plistener, 0.8, true);
                 } else {
                     riFrames[i] = new RawImage(fname);
-                    errCodeThr = riFrames[i]->loadRaw (true, i);
+                    errCodeThr = riFrames[i]->loadRaw (true, i, true, nullptr, 1.0, true);
+                }
+
+                if (!errCodeThr) {
+                    // release the decoder output of this frame before the next one is decoded
+                    riFrames[i]->compress_image(i);
                 }
             }
 #ifdef _OPENMP
@@ -1088,14 +1126,14 @@ int RawImageSource::load (const Glib::ustring &fname, bool firstFrameOnly)
         }
     } else {
         riFrames[0] = ri;
-        errCode = riFrames[0]->loadRaw (true, 0, true, plistener, 0.8);
-    }
+        errCode = riFrames[0]->loadRaw (true, 0, true, plistener, 0.8, true);
 
-    if (!errCode) {
-        for (unsigned int i = 0; i < numFrames; ++i) {
-            riFrames[i]->compress_image(i);
+        if (!errCode) {
+            riFrames[0]->compress_image(0);
         }
-    } else {
+    }
+
+    if (errCode) {
         return errCode;
     }
 
@@ -1243,7 +1281,7 @@ int RawImageSource::load (const Glib::ustring &fname, bool firstFrameOnly)
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
-void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &lensProf, const CoarseTransformParams& coarse, bool prepareDenoise)
+void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &lensProf, const CoarseTransformParams& coarse, bool prepareDenoise, bool useAnalysisCache)
 {
 //    BENCHFUN
     MyTime t1, t2;
@@ -1295,6 +1333,35 @@ void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &le
         printf("Flat Field Correction:%s\n", rif->get_filename().c_str());
     }
 
+    // parameters of the preprocessing which the analyses stored in the cache depend on, the dark frame and the flat field are
+    // identified by the names, sizes and modification times of their files
+    const auto calibrationKey = [](const RawImage* calibration) {
+        return !calibration ? std::string() : calibration->calibrationIdentity.empty() ? calibration->get_filename() : calibration->calibrationIdentity;
+    };
+    std::ostringstream key;
+    key << currFrame << ' ' << numFrames
+        << " df " << calibrationKey(rid)
+        << " ff " << calibrationKey(rif) << ' ' << raw.ff_BlurRadius << ' ' << raw.ff_BlurType << ' ' << raw.ff_AutoClipControl << ' ' << raw.ff_clipControl
+        << " bp " << raw.hotPixelFilter << ' ' << raw.deadPixelFilter << ' ' << raw.hotdeadpix_thresh
+        << " bayer " << raw.bayersensor.black0 << ' ' << raw.bayersensor.black1 << ' ' << raw.bayersensor.black2 << ' ' << raw.bayersensor.black3 << ' ' << raw.bayersensor.twogreen
+        << ' ' << raw.bayersensor.greenthresh << ' ' << (raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::VNG4))
+        << ' ' << raw.bayersensor.linenoise << ' ' << int(raw.bayersensor.linenoiseDirection) << ' ' << raw.bayersensor.pdafLinesFilter
+        << " xtrans " << raw.xtranssensor.blackred << ' ' << raw.xtranssensor.blackgreen << ' ' << raw.xtranssensor.blackblue;
+
+    if (!hasFlatField && lensProf.useVign && lensProf.lcMode != LensProfParams::LcMode::NONE) {
+        key << " vignetting " << int(lensProf.lcMode) << ' ' << lensProf.lcpFile << ' ' << lensProf.lfCameraMake << ' ' << lensProf.lfCameraModel << ' ' << lensProf.lfLens
+            << ' ' << coarse.rotate << ' ' << coarse.hflip << ' ' << coarse.vflip;
+    }
+
+    preprocessKey = key.str();
+
+    // the capture sharpening radius is measured on the raw data corrected for CA and exposure
+    key << " ca " << raw.ca_autocorrect << ' ' << raw.cared << ' ' << raw.cablue << ' ' << raw.caautoiterations << ' ' << raw.ca_avoidcolourshift
+        << " exposure " << raw.expos;
+    radiusKey = key.str();
+
+    bool colorsScaled = false;
+
     if (numFrames == 4) {
         int bufferNumber = 0;
         for (unsigned int i=0; i<4; ++i) {
@@ -1323,6 +1390,11 @@ void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &le
                 rawData[i][j] = (rawData[i][j] + (*rawDataFrames[1])[i][j]) * 0.5f;
             }
         }
+
+        (*rawDataFrames[1])(0, 0); // only needed for the average
+    } else if (!hasFlatField && (ri->getSensorType() == ST_BAYER || ri->getSensorType() == ST_FUJI_XTRANS || ri->get_colors() == 1)) {
+        copyScaledPixels(raw, ri, rid, rawData);
+        colorsScaled = true;
     } else {
         copyOriginalPixels(raw, ri, rid, rif, rawData);
     }
@@ -1369,7 +1441,7 @@ void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &le
         for (int i=0; i<4; ++i) {
             scaleColors(0, 0, W, H, raw, *rawDataFrames[i]);
         }
-    } else {
+    } else if (!colorsScaled) {
         scaleColors(0, 0, W, H, raw, rawData); //+ + raw parameters for black level(raw.blackxx)
     }
 
@@ -1527,15 +1599,25 @@ void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &le
             plistener->setProgressStr ("PROGRESSBAR_RAWCACORR");
             plistener->setProgress (0.0);
         }
+        // the fit of the auto CA correction is measured once per raw file and preprocessing
+        const std::string caKey = Glib::ustring::compose("%1 %2 %3", preprocessKey, raw.caautoiterations, raw.ca_avoidcolourshift);
+        std::vector<double> fitParams;
+        const bool fitParamsStored = raw.ca_autocorrect && useAnalysisCache && loadRawAnalysis(ri->get_filename(), "AutoCAFit", caKey, fitParams);
+
         if (numFrames == 4) {
-            double fitParams[64];
-            float *buffer = CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[0], fitParams, false, true, nullptr, false, options.chunkSizeCA, options.measure);
+            float *buffer = CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[0], &fitParams, fitParamsStored, !fitParamsStored, nullptr, false, options.chunkSizeCA, options.measure);
+            // the other frames reuse the fit of the first one, or measure their own if there is none (auto CA disabled or no fit found)
+            const bool transferFit = !fitParams.empty();
             for (int i = 1; i < 3; ++i) {
-                CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[i], fitParams, true, false, buffer, false, options.chunkSizeCA, options.measure);
+                CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[i], &fitParams, transferFit, false, buffer, false, options.chunkSizeCA, options.measure);
             }
-            CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[3], fitParams, true, false, buffer, true, options.chunkSizeCA, options.measure);
+            CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, *rawDataFrames[3], &fitParams, transferFit, false, buffer, true, options.chunkSizeCA, options.measure);
         } else {
-            CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, rawData, nullptr, false, false, nullptr, true, options.chunkSizeCA, options.measure);
+            CA_correct_RT(raw.ca_autocorrect, raw.caautoiterations, raw.cared, raw.cablue, raw.ca_avoidcolourshift, rawData, &fitParams, fitParamsStored, !fitParamsStored, nullptr, true, options.chunkSizeCA, options.measure);
+        }
+
+        if (raw.ca_autocorrect && useAnalysisCache && !fitParamsStored) {
+            saveRawAnalysis(ri->get_filename(), "AutoCAFit", caKey, fitParams);
         }
     }
 
@@ -1548,6 +1630,17 @@ void RawImageSource::preprocess  (const RAWParams &raw, const LensProfParams &le
         ImProcFunctions::getAutoExp (aehist, aehistcompr, clip, dirpyrdenoiseExpComp, brightness, contrast, black, hlcompr, hlcomprthresh);
     }
 
+    if (numFrames == 4) {
+        for (unsigned int i = 0; i < 4; ++i) {
+            if (i != currFrame && options.compactRawFrames) {
+                // from now on only pixelshift() reads these frames
+                rawDataCompact[i].pack(*rawDataFrames[i]);
+            } else {
+                rawDataCompact[i].clear();
+            }
+        }
+    }
+
     t2.set();
 
     if (settings->verbose) {
@@ -1629,7 +1722,71 @@ void RawImageSource::demosaic(const RAWParams &raw, bool autoContrast, double &c
 
 
     rgbSourceModified = false;
+    binnedPlanes = false;
+    updatePlaneCache(cache);
+
+    if (settings->verbose) {
+        if (getSensorType() == ST_BAYER) {
+            printf("Demosaicing Bayer data: %s - %d usec\n", raw.bayersensor.method.c_str(), t2.etime(t1));
+        } else if (getSensorType() == ST_FUJI_XTRANS) {
+            printf("Demosaicing X-Trans data: %s - %d usec\n", raw.xtranssensor.method.c_str(), t2.etime(t1));
+        }
+    }
+}
+
+
+bool RawImageSource::demosaicBinned(const RAWParams &raw, bool autoContrast, double contrastThreshold)
+{
+    // the binning needs a regular 2x2 pattern, the cheap methods which do not interpolate are kept
+    if (ri->getSensorType() != ST_BAYER || fuji || d1x
+            || raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::NONE)
+            || raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::MONO)) {
+        return false;
+    }
+
+    // the automatic contrast threshold of the dual demosaic is shown in the editor, it is measured by the full demosaic
+    if (autoContrast && (raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::AMAZEVNG4)
+                         || raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::DCBVNG4)
+                         || raw.bayersensor.method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::RCDVNG4))) {
+        return false;
+    }
+
+    binnedRaw = raw;
+    binnedAutoContrast = autoContrast;
+    binnedContrastThreshold = contrastThreshold;
+    rgbSourceModified = false;
+    binnedPlanes = true;
+    updatePlaneCache(false);
+
+    if (settings->verbose) {
+        printf("Demosaicing Bayer data: binned preview\n");
+    }
+
+    return true;
+}
+
+// Interpolates the planes left out by demosaicBinned() for the consumers of the full resolution planes,
+// with the method the binned preview was requested with (fast in the "fast" preview mode, the one of the profile in the "sidecar" mode)
+void RawImageSource::finishBinnedDemosaic(bool cache)
+{
+    if (!binnedPlanes) {
+        return;
+    }
+
+    MyMutex::MyLock lock(binnedMutex);
+
+    if (binnedPlanes) {
+        if (settings->verbose) {
+            printf("Demosaicing Bayer data: completing the binned preview\n");
+        }
 
+        double contrastThreshold = binnedContrastThreshold;
+        demosaic(binnedRaw, binnedAutoContrast, contrastThreshold, cache);
+    }
+}
+
+void RawImageSource::updatePlaneCache(bool cache)
+{
     if (cache) {
         if (!redCache) {
             redCache = new array2D<float>(W, H);
@@ -1673,19 +1830,12 @@ void RawImageSource::demosaic(const RAWParams &raw, bool autoContrast, double &c
         delete blueCache;
         blueCache = nullptr;
     }
-    if (settings->verbose) {
-        if (getSensorType() == ST_BAYER) {
-            printf("Demosaicing Bayer data: %s - %d usec\n", raw.bayersensor.method.c_str(), t2.etime(t1));
-        } else if (getSensorType() == ST_FUJI_XTRANS) {
-            printf("Demosaicing X-Trans data: %s - %d usec\n", raw.xtranssensor.method.c_str(), t2.etime(t1));
-        }
-    }
 }
 
-
 //void RawImageSource::retinexPrepareBuffers(ColorManagementParams cmp, RetinexParams retinexParams, multi_array2D<float, 3> &conversionBuffer, LUTu &lhist16RETI)
 void RawImageSource::retinexPrepareBuffers(const ColorManagementParams& cmp, const RetinexParams &retinexParams, multi_array2D<float, 4> &conversionBuffer, LUTu &lhist16RETI)
 {
+    finishBinnedDemosaic(false);
     bool useHsl = (retinexParams.retinexcolorspace == "HSLLOG" || retinexParams.retinexcolorspace == "HSLLIN");
     conversionBuffer[0] (W - 2 * border, H - 2 * border);
     conversionBuffer[1] (W - 2 * border, H - 2 * border);
@@ -2354,6 +2504,10 @@ void RawImageSource::flush()
         rawDataBuffer[i] = nullptr;
     }
 
+    for (auto &frame : rawDataCompact) {
+        frame.clear();
+    }
+
     if (rawData) {
         rawData(0, 0);
     }
@@ -2386,6 +2540,9 @@ void RawImageSource::HLRecovery_Global(const ToneCurveParams &hrp)
 {
     if (hrp.hrenabled && hrp.method == "Color") {
         if (!rgbSourceModified) {
+            // the inpainting needs the full resolution planes, a binned preview is only completed here
+            finishBinnedDemosaic(false);
+
             if (settings->verbose) {
                 printf ("Applying Highlight Recovery: Color propagation...\n");
             }
@@ -2499,8 +2656,74 @@ void RawImageSource::copyOriginalPixels(const RAWParams &raw, RawImage *src, Raw
     }
 }
 
-// Scale original pixels into the range 0 65535 using black offsets and multipliers
-void RawImageSource::scaleColors(int winx, int winy, int winw, int winh, const RAWParams &raw, array2D<float> &rawData)
+// Fused copyOriginalPixels() and scaleColors() of bayer, x-trans and monochrome frames without flat field: the dark frame,
+// the black level and the multipliers are applied in the same pass
+void RawImageSource::copyScaledPixels(const RAWParams &raw, RawImage *src, RawImage *riDark, array2D<float> &rawData)
+{
+    initScaleColors(raw);
+
+    if (!rawData) {
+        rawData(W, H);
+    }
+
+    const float black[4] = {
+                     static_cast<float>(ri->get_cblack(0)), static_cast<float>(ri->get_cblack(1)),
+                     static_cast<float>(ri->get_cblack(2)), static_cast<float>(ri->get_cblack(3))
+                     };
+    const bool subtractDark = riDark && W == riDark->get_width() && H == riDark->get_height();
+    const bool isXtrans = ri->getSensorType() == ST_FUJI_XTRANS;
+    const bool isMono = !isXtrans && ri->getSensorType() != ST_BAYER;
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        float tmpchmax[3] = {};
+#ifdef _OPENMP
+        #pragma omp for nowait
+#endif
+
+        for (int row = 0; row < H; row++) {
+            // colors of the 6 columns period of the x-trans and bayer patterns, c4 indexes the levels and multipliers
+            int c[6], c4[6];
+
+            for (int col = 0; col < 6; col++) {
+                if (isXtrans) {
+                    c[col] = c4[col] = ri->XTRANSFC(row, col);
+                } else if (isMono) {
+                    c[col] = c4[col] = 0;
+                } else {
+                    c[col] = FC(row, col);
+                    c4[col] = (c[col] == 1 && !(row & 1)) ? 3 : c[col];
+                }
+            }
+
+            // max(0, max(0, v + black - dark) - cblacksom) == max(0, v + black - dark - cblacksom) as cblacksom >= 0
+            for (int col = 0, i = 0; col < W; col++, i = i == 5 ? 0 : i + 1) {
+                const float val = subtractDark ? src->data[row][col] + black[c4[i]] - riDark->data[row][col] : src->data[row][col];
+                const float scaled = max(0.f, val - cblacksom[c4[i]]) * scale_mul[c4[i]];
+                rawData[row][col] = scaled;
+                tmpchmax[c[i]] = max(tmpchmax[c[i]], scaled);
+            }
+        }
+
+#ifdef _OPENMP
+        #pragma omp critical
+#endif
+        {
+            chmax[0] = max(tmpchmax[0], chmax[0]);
+            chmax[1] = max(tmpchmax[1], chmax[1]);
+            chmax[2] = max(tmpchmax[2], chmax[2]);
+        }
+    }
+
+    if (isMono) {
+        chmax[1] = chmax[2] = chmax[3] = chmax[0];
+    }
+}
+
+// Levels and multipliers used by scaleColors()
+void RawImageSource::initScaleColors(const RAWParams &raw)
 {
     chmax[0] = chmax[1] = chmax[2] = chmax[3] = 0; //channel maxima
     float black_lev[4] = {0.f};//black level
@@ -2540,6 +2763,12 @@ void RawImageSource::scaleColors(int winx, int winy, int winw, int winh, const R
     for (int i = 0; i < 4 ; i++) {
         clmax[i] = (c_white[i] - cblacksom[i]) * scale_mul[i];    // raw clip level
     }
+}
+
+// Scale original pixels into the range 0 65535 using black offsets and multipliers
+void RawImageSource::scaleColors(int winx, int winy, int winw, int winh, const RAWParams &raw, array2D<float> &rawData)
+{
+    initScaleColors(raw);
 
     // this seems strange, but it works
 
@@ -5319,6 +5548,7 @@ void RawImageSource::WBauto(double & tempref, double & greenref, array2D<float>
 
 void RawImageSource::getrgbloc(int begx, int begy, int yEn, int xEn, int cx, int cy, int bf_h, int bf_w)
 {
+    finishBinnedDemosaic(false);
 //    BENCHFUN
     //used by auto WB local to calculate red, green, blue in local region
     const int bfw = W / 9 + ((W % 9) > 0 ? 1 : 0);//10 arbitrary value  ; perhaps 4 or 5 or 20
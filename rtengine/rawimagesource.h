@@ -19,11 +19,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <iostream>
 #include <memory>
 
 #include "array2D.h"
 #include "colortemp.h"
+#include "compactrawframe.h"
 #include "iimage.h"
 #include "imagesource.h"
 #include "procparams.h"
@@ -40,6 +42,8 @@ class RetinexgaintransmissionCurve;
 
 class RawImageSource final : public ImageSource
 {
+    friend class RawKernelBench; // rtbench times the demosaicers on synthetic data
+
 private:
     static DiagonalCurve *phaseOneIccCurve;
     static DiagonalCurve *phaseOneIccCurveInv;
@@ -81,9 +85,12 @@ protected:
     unsigned int currFrame = 0;
     unsigned int numFrames = 0;
     int flatFieldAutoClipValue = 0;
+    std::string preprocessKey;  // parameters of the last preprocess(), identifies the results of the raw analyses in the cache
+    std::string radiusKey;  // preprocessKey plus the CA correction and the raw exposure, identifies the capture sharpening radius in the cache
     array2D<float> rawData;  // holds preprocessed pixel values, rowData[i][j] corresponds to the ith row and jth column
     array2D<float> *rawDataFrames[6] = {nullptr};
     array2D<float> *rawDataBuffer[5] = {nullptr};
+    CompactRawFrame rawDataCompact[4];  // pixel shift frames which are not the selected one, rawDataFrames[i] is empty then
 
     // the interpolated green plane:
     array2D<float> green;
@@ -100,6 +107,12 @@ protected:
     // the interpolated blue plane:
     array2D<float>* blueCache;
     bool rawDirty;
+    std::atomic<bool> binnedPlanes{false};  // red, green and blue were not interpolated by the last demosaic, see demosaicBinned()
+    MyMutex binnedMutex;  // serializes finishBinnedDemosaic(), the crops of the detail windows call getImage() from their own threads
+    // demosaic left out by demosaicBinned(), run by finishBinnedDemosaic()
+    procparams::RAWParams binnedRaw;
+    bool binnedAutoContrast = false;
+    double binnedContrastThreshold = 0.0;
     float psRedBrightness[4];
     float psGreenBrightness[4];
     float psBlueBrightness[4];
@@ -123,10 +136,12 @@ public:
 
     int load(const Glib::ustring &fname) override { return load(fname, false); }
     int load(const Glib::ustring &fname, bool firstFrameOnly);
-    void        preprocess  (const procparams::RAWParams &raw, const procparams::LensProfParams &lensProf, const procparams::CoarseTransformParams& coarse, bool prepareDenoise = true) override;
+    void        preprocess  (const procparams::RAWParams &raw, const procparams::LensProfParams &lensProf, const procparams::CoarseTransformParams& coarse, bool prepareDenoise = true, bool useAnalysisCache = true) override;
     void        filmNegativeProcess (const procparams::FilmNegativeParams &params) override;
     bool        getFilmNegativeExponents (Coord2D spotA, Coord2D spotB, int tran, const procparams::FilmNegativeParams &currentParams, std::array<float, 3>& newExps) override;
     void        demosaic    (const procparams::RAWParams &raw, bool autoContrast, double &contrastThreshold, bool cache = false) override;
+    bool        demosaicBinned (const procparams::RAWParams &raw, bool autoContrast, double contrastThreshold) override;
+    void        completeBinnedDemosaic () override {finishBinnedDemosaic(false);}
     void        retinex       (const procparams::ColorManagementParams& cmp, const procparams::RetinexParams &deh, const procparams::ToneCurveParams& Tc, LUTf & cdcurve, LUTf & mapcurve, const RetinextransmissionCurve & dehatransmissionCurve, const RetinexgaintransmissionCurve & dehagaintransmissionCurve, multi_array2D<float, 4> &conversionBuffer, bool dehacontlutili, bool mapcontlutili, bool useHsl, float &minCD, float &maxCD, float &mini, float &maxi, float &Tmean, float &Tsigma, float &Tmin, float &Tmax, LUTu &histLRETI) override;
     void        retinexPrepareCurves       (const procparams::RetinexParams &retinexParams, LUTf &cdcurve, LUTf &mapcurve, RetinextransmissionCurve &retinextransmissionCurve, RetinexgaintransmissionCurve &retinexgaintransmissionCurve, bool &retinexcontlutili, bool &mapcontlutili, bool &useHsl, LUTu & lhist16RETI, LUTu & histLRETI) override;
     void        retinexPrepareBuffers      (const procparams::ColorManagementParams& cmp, const procparams::RetinexParams &retinexParams, multi_array2D<float, 4> &conversionBuffer, LUTu &lhist16RETI) override;
@@ -134,6 +149,7 @@ public:
     void        HLRecovery_Global (const procparams::ToneCurveParams &hrp) override;
     void        refinement(int PassCount);
     void        setBorder(unsigned int rawBorder) override {border = rawBorder;}
+    std::string getRawAnalysisKey() const override {return radiusKey;}
     bool        isRGBSourceModified() const override
     {
         return rgbSourceModified;   // tracks whether cached rgb output of demosaic has been modified
@@ -141,6 +157,8 @@ public:
 
     void        processFlatField(const procparams::RAWParams &raw, const RawImage *riFlatFile, const float black[4]);
     void        copyOriginalPixels(const procparams::RAWParams &raw, RawImage *ri, RawImage *riDark, RawImage *riFlatFile, array2D<float> &rawData  );
+    void        copyScaledPixels(const procparams::RAWParams &raw, RawImage *ri, RawImage *riDark, array2D<float> &rawData);
+    void        initScaleColors (const procparams::RAWParams &raw);
     void        scaleColors (int winx, int winy, int winw, int winh, const procparams::RAWParams &raw, array2D<float> &rawData); // raw for cblack
     void        WBauto(double &tempref, double &greenref, array2D<float> &redloc, array2D<float> &greenloc, array2D<float> &blueloc, int bfw, int bfh, double &avg_rm, double &avg_gm, double &avg_bm, double &tempitc, double &greenitc, float &studgood, bool &twotimes, const procparams::WBParams & wbpar, int begx, int begy, int yEn, int xEn, int cx, int cy, const procparams::ColorManagementParams &cmp, const procparams::RAWParams &raw) override;
     void        getAutoWBMultipliersitc(double &tempref, double &greenref, double &tempitc, double &greenitc, float &studgood, int begx, int begy, int yEn, int xEn, int cx, int cy, int bf_h, int bf_w, double &rm, double &gm, double &bm, const procparams::WBParams & wbpar, const procparams::ColorManagementParams &cmp, const procparams::RAWParams &raw) override;
@@ -247,7 +265,7 @@ protected:
         double cablue,
         bool avoidColourshift,
         const array2D<float> &rawData,
-        double* fitParamsTransfer,
+        std::vector<double>* fitParamsTransfer,
         bool fitParamsIn,
         bool fitParamsOut,
         float* buffer,
@@ -276,6 +294,8 @@ protected:
     void amaze_demosaic_RT(int winx, int winy, int winw, int winh, const array2D<float> &rawData, array2D<float> &red, array2D<float> &green, array2D<float> &blue, size_t chunkSize = 1, bool measure = false);//Emil's code for AMaZE
     void dual_demosaic_RT(bool isBayer, const procparams::RAWParams &raw, int winw, int winh, const array2D<float> &rawData, array2D<float> &red, array2D<float> &green, array2D<float> &blue, double &contrast, bool autoContrast = false);
     void fast_demosaic();//Emil's code for fast demosaicing
+    void finishBinnedDemosaic(bool cache);
+    void updatePlaneCache(bool cache);
     void dcb_demosaic(int iterations, bool dcb_enhance);
     void ahd_demosaic();
     void rcd_demosaic(size_t chunkSize = 1, bool measure = false);
@@ -0,0 +1,126 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstring>
+
+#include <glib/gstdio.h>
+
+#include "cachefile.h"
+#include "rawrestartindex.h"
+#include "settings.h"
+
+namespace
+{
+
+constexpr char indexMagic[4] = {'R', 'T', 'R', 'I'};
+constexpr std::uint32_t indexVersion = 1;
+
+struct IndexHeader {
+    rtengine::CacheFileHeader file;
+    std::uint32_t pointSize;
+    char decoder[64];
+    std::int64_t fileSize;
+    std::int64_t fileTime;
+    std::uint32_t pointCount;
+};
+
+// Fills the header identifying the current version of the raw file and returns the name of its index, or an empty string
+Glib::ustring getIndexName(const char* fname, const char* decoder, IndexHeader& header)
+{
+    memset(&header, 0, sizeof(header));
+    header.file.init(indexMagic, indexVersion);
+    header.pointSize = sizeof(rtengine::RawRestartPoint);
+    strncpy(header.decoder, decoder, sizeof(header.decoder) - 1);
+    return rtengine::getSourceCacheFileName("rawindex", fname, {}, "rri", header.fileSize, header.fileTime);
+}
+
+}
+
+namespace rtengine
+{
+
+bool loadRawRestartIndex(const char* fname, const char* decoder, int rows, std::int64_t dataSize, std::vector<RawRestartPoint>& points)
+{
+    points.clear();
+
+    IndexHeader expected;
+    const Glib::ustring indexName = getIndexName(fname, decoder, expected);
+
+    if (indexName.empty()) {
+        return false;
+    }
+
+    FILE* const file = g_fopen(indexName.c_str(), "rb");
+
+    if (!file) {
+        return false;
+    }
+
+    IndexHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && header.file.matches(indexMagic, indexVersion)
+                 && header.pointSize == expected.pointSize
+                 && !strncmp(header.decoder, expected.decoder, sizeof(header.decoder))
+                 && header.fileSize == expected.fileSize
+                 && header.fileTime == expected.fileTime
+                 && header.pointCount >= 2 && header.pointCount <= 1 << 20;
+
+    if (valid) {
+        points.resize(header.pointCount);
+        valid = fread(points.data(), sizeof(RawRestartPoint), points.size(), file) == points.size()
+                && points.front().row == 0 && points.back().row == rows;
+
+        // the points are restored as they are, a damaged index must not send the decoders out of the data
+        for (std::size_t i = 0; valid && i < points.size(); ++i) {
+            const RawRestartPoint& point = points[i];
+            const bool last = i + 1 == points.size();
+            valid = (last || point.row < points[i + 1].row)
+                    && point.pos >= 0 && (last ? point.pos <= dataSize : point.pos < dataSize)
+                    && point.vbits >= 0 && point.vbits <= 32;
+        }
+    }
+
+    fclose(file);
+
+    if (!valid) {
+        points.clear();
+
+        if (settings->verbose) {
+            printf("Ignoring the outdated restart index %s\n", indexName.c_str());
+        }
+    }
+
+    return valid;
+}
+
+void saveRawRestartIndex(const char* fname, const char* decoder, const std::vector<RawRestartPoint>& points)
+{
+    IndexHeader header;
+    const Glib::ustring indexName = getIndexName(fname, decoder, header);
+
+    if (indexName.empty() || points.size() < 2) {
+        return;
+    }
+
+    // several decoders of the same file may store their index at the same time, the last one wins
+    header.pointCount = points.size();
+    writeCacheFile(indexName, [&](FILE* file) {
+        return fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(points.data(), sizeof(RawRestartPoint), points.size(), file) == points.size();
+    });
+}
+
+}
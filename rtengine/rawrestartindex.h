@@ -0,0 +1,55 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/* Restart index of the raw decoders reading a single Huffman-coded stream without restart markers (Nikon NEF, Pentax PEF, lossless JPEG).
+ *
+ * The first decode of a file records the state of the bit reader and of the vertical predictors every rowsPerRestartPoint rows, and
+ * a last point after the last row. The index is stored in the "rawindex" folder of the cache, identified by the name, size
+ * and modification time of the raw file. Later decodes of the same file decode the row ranges between the points concurrently,
+ * and check that each range ends in the state recorded at the start of the next one. */
+
+namespace rtengine
+{
+
+struct RawRestartPoint {
+    std::int32_t row;
+    std::int64_t pos;       // position of the bit reader in the file
+    std::uint32_t bitbuf;
+    std::int32_t vbits;
+    std::int32_t reset;
+    std::uint16_t vpred[2][2];
+};
+
+constexpr int rowsPerRestartPoint = 32;
+
+/** Loads the restart index of a raw file
+  * @param fname is the name of the raw file
+  * @param decoder identifies the decoder and its parameters, an index recorded with another one is ignored
+  * @param rows is the number of rows of the stream, the points have to start at row 0, end at this row and strictly increase
+  * @param dataSize is the size of the decoded data, the points have to be within it
+  * @param points receives the points, ordered by row
+  * @return false if there is no valid index for the current version of the file */
+bool loadRawRestartIndex (const char* fname, const char* decoder, int rows, std::int64_t dataSize, std::vector<RawRestartPoint>& points);
+
+/** Stores the restart index of a raw file, does nothing if the cache is disabled */
+void saveRawRestartIndex (const char* fname, const char* decoder, const std::vector<RawRestartPoint>& points);
+
+}
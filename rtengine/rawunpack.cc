@@ -0,0 +1,278 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "opthelper.h"
+#include "rawunpack.h"
+
+namespace
+{
+
+using rtengine::rawunpack::BitOrder;
+
+// byte i of the stream, the bytes of the complete words are swapped
+inline unsigned streamByte (const std::uint8_t* src, std::size_t srcBytes, std::size_t i, int wordBytes, std::size_t wordEnd)
+{
+    if (i < wordEnd) {
+        const std::size_t rem = i % wordBytes;
+        return src[i - rem + wordBytes - 1 - rem];
+    }
+
+    return i < srcBytes ? src[i] : 0;
+}
+
+// unpacks the values [first, count), value first must start on a byte boundary
+void unpackScalar (const std::uint8_t* src, std::size_t srcBytes, std::uint16_t* dst, std::size_t first, std::size_t count, int bits, BitOrder order, int wordBytes, const std::uint16_t* curve)
+{
+    const std::size_t wordEnd = srcBytes / wordBytes * wordBytes;
+    const std::uint32_t mask = (1u << bits) - 1;
+    std::size_t pos = first * bits / 8;
+    std::uint32_t buffer = 0;
+    int vbits = 0;
+
+    for (std::size_t n = first; n < count; ++n) {
+        while (vbits < bits) {
+            const std::uint32_t c = streamByte(src, srcBytes, pos++, wordBytes, wordEnd);
+
+            if (order == BitOrder::MSB) {
+                buffer = buffer << 8 | c;
+            } else {
+                buffer |= c << vbits;
+            }
+
+            vbits += 8;
+        }
+
+        std::uint32_t value;
+
+        if (order == BitOrder::MSB) {
+            value = buffer >> (vbits - bits) & mask;
+        } else {
+            value = buffer & mask;
+            buffer >>= bits;
+        }
+
+        vbits -= bits;
+        dst[n] = curve ? curve[value] : value;
+    }
+}
+
+#if defined(__SSSE3__) && defined(__SSE4_1__)
+// Blocks of 16 values made of two groups of 8 values (bits bytes each). Each group is read with one 16 bytes load, a
+// shuffle moves the 3 bytes holding each value into its 32 bit lane, then a per lane shift and a mask extract it.
+class BlockUnpacker
+{
+public:
+    BlockUnpacker (int bits, BitOrder order, int wordBytes) :
+        bits(bits),
+        valid((bits == 10 || bits == 12 || bits == 14) && (wordBytes == 1 || wordBytes == 2 || wordBytes == 4))
+    {
+        if (!valid) {
+            return;
+        }
+
+        for (int g = 0; g < 2; ++g) {
+            const int start = g * bits;
+            base[g] = start / wordBytes * wordBytes;
+
+            for (int i = 0; i < 8; ++i) {
+                const int bitOffset = i * bits;
+                const int k = start + bitOffset / 8;
+                const int r = bitOffset % 8;
+                const int neededBytes = (r + bits + 7) / 8;
+                std::uint8_t* const lane = &shuffle[g][i / 4][(i % 4) * 4];
+
+                for (int j = 0; j < 3; ++j) {
+                    const int logical = k + j;
+                    const int physical = logical - logical % wordBytes + wordBytes - 1 - logical % wordBytes - base[g];
+                    std::uint8_t index = 0x80;
+
+                    if (j < neededBytes) {
+                        if (physical < 0 || physical > 15) {
+                            valid = false;
+                            return;
+                        }
+
+                        index = physical;
+                    }
+
+                    lane[order == BitOrder::MSB ? 2 - j : j] = index;
+                }
+
+                lane[3] = 0x80;
+                shift[i / 4][i % 4] = order == BitOrder::MSB ? 24 - bits - r : r;
+            }
+        }
+
+        maxShift = std::max(*std::max_element(shift[0], shift[0] + 4), *std::max_element(shift[1], shift[1] + 4));
+        loadEnd = std::max(base[0], base[1]) + 16;
+    }
+
+    // number of complete blocks which can be unpacked
+    std::size_t blocks (std::size_t srcBytes, std::size_t count, int wordBytes) const
+    {
+        if (!valid || srcBytes < loadEnd) {
+            return 0;
+        }
+
+        const std::size_t blockBytes = 2 * bits;
+        return std::min({count / 16, (srcBytes - loadEnd) / blockBytes + 1, srcBytes / wordBytes * wordBytes / blockBytes});
+    }
+
+    void unpack (const std::uint8_t* src, std::uint16_t* dst, std::size_t blocks, const std::uint16_t* curve) const
+    {
+        const std::size_t blockBytes = 2 * bits;
+#ifdef __AVX2__
+        const __m256i vmask = _mm256_set1_epi32((1 << bits) - 1);
+        const __m256i vshuffle[2] = {
+            _mm256_setr_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle[0][0])), _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle[1][0]))),
+            _mm256_setr_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle[0][1])), _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle[1][1])))
+        };
+        const __m256i vshift[2] = {
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(shift[0]))),
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(shift[1])))
+        };
+
+        for (std::size_t b = 0; b < blocks; ++b, src += blockBytes, dst += 16) {
+            const __m256i in = _mm256_setr_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + base[0])), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + base[1])));
+            // the lanes hold the values 0-3 and 4-7 of both groups, packing them restores the order
+            const __m256i lo = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(in, vshuffle[0]), vshift[0]), vmask);
+            const __m256i hi = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(in, vshuffle[1]), vshift[1]), vmask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_packus_epi32(lo, hi));
+            applyCurve(dst, curve);
+        }
+#else
+        // no per lane shift, the values are aligned to the largest shift with a multiplication
+        const vint vmask = _mm_set1_epi32((1 << bits) - 1);
+        const vint vmaxShift = _mm_cvtsi32_si128(maxShift);
+        const vint vmul[2] = {
+            _mm_setr_epi32(1 << (maxShift - shift[0][0]), 1 << (maxShift - shift[0][1]), 1 << (maxShift - shift[0][2]), 1 << (maxShift - shift[0][3])),
+            _mm_setr_epi32(1 << (maxShift - shift[1][0]), 1 << (maxShift - shift[1][1]), 1 << (maxShift - shift[1][2]), 1 << (maxShift - shift[1][3]))
+        };
+        vint vshuffle[2][2];
+
+        for (int g = 0; g < 2; ++g) {
+            for (int h = 0; h < 2; ++h) {
+                vshuffle[g][h] = _mm_loadu_si128(reinterpret_cast<const vint*>(shuffle[g][h]));
+            }
+        }
+
+        for (std::size_t b = 0; b < blocks; ++b, src += blockBytes, dst += 16) {
+            for (int g = 0; g < 2; ++g) {
+                const vint in = _mm_loadu_si128(reinterpret_cast<const vint*>(src + base[g]));
+                const vint lo = _mm_and_si128(_mm_srl_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(in, vshuffle[g][0]), vmul[0]), vmaxShift), vmask);
+                const vint hi = _mm_and_si128(_mm_srl_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(in, vshuffle[g][1]), vmul[1]), vmaxShift), vmask);
+                _mm_storeu_si128(reinterpret_cast<vint*>(dst + 8 * g), _mm_packus_epi32(lo, hi));
+            }
+
+            applyCurve(dst, curve);
+        }
+#endif
+    }
+
+private:
+    static void applyCurve (std::uint16_t* dst, const std::uint16_t* curve)
+    {
+        if (curve) {
+            for (int i = 0; i < 16; ++i) {
+                dst[i] = curve[dst[i]];
+            }
+        }
+    }
+
+    const int bits;
+    bool valid;
+    int base[2];
+    std::uint8_t shuffle[2][2][16];
+    std::uint32_t shift[2][4];
+    int maxShift;
+    std::size_t loadEnd;
+};
+#endif
+
+}
+
+namespace rtengine
+{
+
+namespace rawunpack
+{
+
+void unpackBits (const std::uint8_t* src, std::size_t srcBytes, std::uint16_t* dst, std::size_t count, int bits, BitOrder order, int wordBytes, const std::uint16_t* curve)
+{
+    if (order == BitOrder::LSB) {
+        wordBytes = 1;
+    }
+
+    std::size_t first = 0;
+
+#if defined(__SSSE3__) && defined(__SSE4_1__)
+    const BlockUnpacker unpacker(bits, order, wordBytes);
+    const std::size_t blocks = unpacker.blocks(srcBytes, count, wordBytes);
+    unpacker.unpack(src, dst, blocks, curve);
+    first = blocks * 16;
+#endif
+
+    unpackScalar(src, srcBytes, dst, first, count, bits, order, wordBytes, curve);
+}
+
+void unpack16 (const std::uint8_t* src, std::uint16_t* dst, std::size_t count, bool swap, int shift, const std::uint16_t* curve)
+{
+    if (!swap && !shift && !curve) {
+        memcpy(dst, src, count * sizeof(std::uint16_t));
+        return;
+    }
+
+    std::size_t n = 0;
+
+#ifdef __SSE2__
+    const vint vshift = _mm_cvtsi32_si128(shift);
+
+    for (; n + 8 <= count; n += 8) {
+        vint v = _mm_loadu_si128(reinterpret_cast<const vint*>(src + 2 * n));
+
+        if (swap) {
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<vint*>(dst + n), _mm_srl_epi16(v, vshift));
+
+        if (curve) {
+            for (int i = 0; i < 8; ++i) {
+                dst[n + i] = curve[dst[n + i]];
+            }
+        }
+    }
+#endif
+
+    for (; n < count; ++n) {
+        std::uint16_t value;
+        memcpy(&value, src + 2 * n, sizeof(value));
+
+        if (swap) {
+            value = value << 8 | value >> 8;
+        }
+
+        value >>= shift;
+        dst[n] = curve ? curve[value] : value;
+    }
+}
+
+}
+
+}
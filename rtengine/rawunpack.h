@@ -0,0 +1,51 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Unpacking of the uncompressed raw layouts (packed 10, 12 and 14 bit values, 16 bit values of either byte order).
+ *
+ * The loaders call these functions on the rows of the memory mapped file. The 10, 12 and 14 bit packings are unpacked
+ * 16 values at a time with SSE4.1 or AVX2 when the build enables them, any other width is unpacked by the scalar code. */
+
+namespace rtengine
+{
+
+namespace rawunpack
+{
+
+enum class BitOrder {
+    MSB,    // each value starts at the most significant free bit of a word (big-endian packing)
+    LSB     // each value starts at the least significant free bit of a byte (little-endian packing)
+};
+
+/** Unpacks count values of bits bits (1 to 16) from a packed bit stream
+  * @param src is the first byte of the stream, srcBytes the number of bytes which can be read, the values past them are 0
+  * @param wordBytes (MSB order only) the stream is made of little-endian words of 1 to 8 bytes, a partial word at the end
+  *        of the stream is read in stored order. 1 reads a plain big-endian stream.
+  * @param curve if not null, each value is replaced by curve[value] */
+void unpackBits (const std::uint8_t* src, std::size_t srcBytes, std::uint16_t* dst, std::size_t count, int bits, BitOrder order, int wordBytes = 1, const std::uint16_t* curve = nullptr);
+
+/** Copies count 16 bit values, swapping their bytes if swap is true, then shifting them right by shift bits
+  * @param curve if not null, each value is replaced by curve[value] */
+void unpack16 (const std::uint8_t* src, std::uint16_t* dst, std::size_t count, bool swap, int shift = 0, const std::uint16_t* curve = nullptr);
+
+}
+
+}
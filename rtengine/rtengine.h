@@ -22,6 +22,7 @@
 #include <ctime>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <glibmm/ustring.h>
 
@@ -616,6 +617,52 @@ public:
    * @return the resulting image, with the output profile applied, exif and iptc data set. You have to save it or you can access the pixel data directly.  */
 IImagefloat* processImage (ProcessingJob* job, int& errorCode, ProgressListener* pl = nullptr, bool flush = false);
 
+/** Renders several versions of an image from a single ProcessingJob. The image is loaded and processed only once, the pipeline branches
+   * at its output stage: for each rendition, the resize, post-resize sharpening and output profile (profile, rendering intent and black
+   * point compensation) are taken from the corresponding entry of renditions, everything else comes from the job. The fast pipeline
+   * flag of the job is ignored. The ProcessingJob passed becomes invalid, you can not use it any more.
+   * @param job the ProcessingJob to process
+   * @param renditions are the processing parameters holding the output settings of each rendition
+   * @param errorCode is the error code if an error occurred (e.g. the input image could not be loaded etc.)
+   * @param pl is an optional ProgressListener if you want to keep track of the progress
+   * @return the resulting images, in the order of renditions, or an empty vector on error */
+std::vector<IImagefloat*> processImageRenditions (ProcessingJob* job, const std::vector<procparams::ProcParams>& renditions, int& errorCode, ProgressListener* pl = nullptr, bool flush = false);
+
+/** Chunk sizes (tiles per thread) of the dynamically scheduled loops of the tiled kernels */
+struct ChunkSizes {
+    size_t amaze;
+    size_t ca;
+    size_t rcd;
+    size_t rgb;
+    size_t xt;
+};
+
+/** Measures the chunk sizes of the AMaZE, RCD, X-Trans, CA correction and RGB processing loops on this machine. The raw file is loaded
+   * and developed once with neutral parameters, then each loop is timed with the candidate chunk sizes (1 to 16) at the current number
+   * of threads. The options are restored afterwards.
+   * @param fname is a raw file representative of the images to process
+   * @param chunkSizes holds the current chunk sizes on input and the fastest ones on output; the kernels that do not apply to the sensor
+   * of the file (e.g. AMaZE for an X-Trans file) are left unchanged
+   * @param pl is an optional ProgressListener
+   * @return false if the file could not be loaded or is not a Bayer or X-Trans raw file */
+bool tuneChunkSizes (const Glib::ustring& fname, ChunkSizes& chunkSizes, ProgressListener* pl = nullptr);
+
+/** Returns a rough estimation of the peak memory needed by processImage, in bytes. It is meant for scheduling purposes only.
+   * @param width is the full width of the image
+   * @param height is the full height of the image
+   * @param params are the processing parameters; the memory hungry tools (noise reduction, wavelets, pixel shift, etc.) are taken into account
+   * @return the estimated memory footprint */
+std::size_t estimateProcessingMemory (int width, int height, const procparams::ProcParams& params);
+
+/** Reads the full size of an image from the header of its file, without decoding the image. Meant to be used with estimateProcessingMemory
+   * before loading the image.
+   * @param fname is the name of the image file
+   * @param isRaw is true for raw files, false for JPEG, PNG and TIFF files
+   * @param width receives the full width of the image
+   * @param height receives the full height of the image
+   * @return false if the header could not be read */
+bool getImageSize (const Glib::ustring& fname, bool isRaw, int& width, int& height);
+
 /** This class is used to control the batch processing. The class implementing this interface will be called when the full processing of an
    * image is ready and the next job to process is needed. */
 class BatchProcessingListener : public ProgressListener
@@ -633,8 +680,9 @@ public:
    * The ProcessingJob passed becomes invalid, you can not use it any more.
    * @param job the ProcessingJob to cancel.
    * @param bpl is the BatchProcessingListener that is called when the image is ready or the next job is needed. It also acts as a ProgressListener.
+   * @param numThreads is the maximum number of threads used by the processing, 0 meaning no limit. It allows to run several batches concurrently without oversubscription.
    **/
-void startBatchProcessing (ProcessingJob* job, BatchProcessingListener* bpl);
+void startBatchProcessing (ProcessingJob* job, BatchProcessingListener* bpl, int numThreads = 0);
 
 
 extern MyMutex* lcmsMutex;
@@ -46,6 +46,8 @@ public:
     bool            autocielab;
     bool            rgbcurveslumamode_gamut;// controls gamut enforcement for RGB curves in lumamode
     bool            verbose;
+    Glib::ustring   traceFile;              ///< Records the timing and memory use of the processing stages to this file if not empty (see instrumentation.h)
+    Glib::ustring   cacheDirectory;         ///< The base directory of the cache, the engine keeps the restart indexes of the raw decoders there ; disabled if empty
     Glib::ustring   darkFramesPath;         ///< The default directory for dark frames
     Glib::ustring   flatFieldsPath;         ///< The default directory for flat fields
 
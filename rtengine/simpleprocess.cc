@@ -29,14 +29,24 @@
 #include "clutstore.h"
 #include "processingjob.h"
 #include "procparams.h"
+#include <cmath>
+#include <functional>
 #include <glibmm/ustring.h>
 #include <glibmm/thread.h>
 #include "../rtgui/options.h"
 #include "rawimagesource.h"
+#include "rawimage.h"
+#include "imageio.h"
 #include "../rtgui/multilangmgr.h"
 #include "mytime.h"
+#include "noiseanalysis.h"
 #include "guidedfilter.h"
+#include "instrumentation.h"
 #include "color.h"
+#include "gauss.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #undef THREAD_PRIORITY_NORMAL
 
@@ -99,7 +109,15 @@ public:
         labView(nullptr),
         ctColorCurve(),
         autili(false),
-        butili(false)
+        butili(false),
+        utili(false),
+        clcutili(false),
+        ccutili(false),
+        cclutili(false),
+        opautili(false),
+        satLimit(0.f),
+        satLimitOpacity(0.f),
+        dcpProf(nullptr)
     {
     }
 
@@ -112,6 +130,139 @@ public:
         }
     }
 
+    std::vector<Imagefloat*> renditions(const std::vector<procparams::ProcParams>& outputParams)
+    {
+        // The fast pipeline is not used: its early resize would be shared by all the renditions
+        std::vector<Imagefloat*> result;
+
+        if (!stage_init()) {
+            return result;
+        }
+
+        stage_denoise();
+        stage_transform();
+        stage_lab();
+
+        for (size_t i = 0; i < outputParams.size(); ++i) {
+            procparams::ProcParams params = job->pparams;
+            params.resize = outputParams[i].resize;
+            params.prsharpening = outputParams[i].prsharpening;
+            params.icm.outputProfile = outputParams[i].icm.outputProfile;
+            params.icm.outputIntent = outputParams[i].icm.outputIntent;
+            params.icm.outputBPC = outputParams[i].icm.outputBPC;
+            result.push_back(stage_output(params, i + 1 == outputParams.size()));
+        }
+
+        stage_cleanup();
+        return result;
+    }
+
+    bool tune_chunk_sizes(ChunkSizes &chunkSizes)
+    {
+        if (!stage_init()) {
+            return false;
+        }
+
+        stage_denoise();
+        stage_transform();
+
+        const eSensorType sensorType = imgsrc->getSensorType();
+        procparams::RAWParams raw = job->pparams.raw;
+        raw.ca_autocorrect = false;
+        double contrast = 0.0;
+
+        const ChunkSizes initial = {options.chunkSizeAMAZE, options.chunkSizeCA, options.chunkSizeRCD, options.chunkSizeRGB, options.chunkSizeXT};
+
+        // sets 'option' to each candidate and returns the fastest one, as the best of two runs. 'restore', if set, resets
+        // the input of 'run' before each run, out of the timing
+        const auto tune = [](size_t &option, const char *name, const std::function<void ()> &run, const std::function<void ()> &restore) -> size_t {
+            size_t best = option;
+            double bestTime = 0.0;
+
+            for (size_t chunkSize = 1; chunkSize <= 16; chunkSize *= 2) {
+                option = chunkSize;
+                double time = 0.0;
+
+                for (int i = 0; i < 2; ++i) {
+                    if (restore) {
+                        restore();
+                    }
+
+                    MyTime t1, t2;
+                    t1.set();
+                    run();
+                    t2.set();
+                    time = i == 0 ? t2.etime(t1) : std::min<double>(time, t2.etime(t1));
+                }
+
+                if (settings->verbose) {
+                    printf("%s: chunk size %zu, %.0f usec\n", name, chunkSize, time);
+                }
+
+                if (chunkSize == 1 || time < bestTime) {
+                    best = chunkSize;
+                    bestTime = time;
+                }
+            }
+
+            return best;
+        };
+
+        // RGB processing, on the developed image
+        stage_rgb_curves();
+        {
+            // rgb_proc() works in place on baseImg
+            const std::unique_ptr<Imagefloat> source(baseImg->copy());
+            LabImage lab(fw, fh);
+            chunkSizes.rgb = tune(options.chunkSizeRGB, "rgbProc", [&]() { rgb_proc(baseImg, &lab); }, [&]() { source->copyData(baseImg); });
+        }
+        release_rgb_curves();
+        delete baseImg;
+        baseImg = nullptr;
+
+        if (pl) {
+            pl->setProgress(0.4);
+        }
+
+        if (sensorType == ST_BAYER) {
+            raw.bayersensor.method = procparams::RAWParams::BayerSensor::getMethodString(procparams::RAWParams::BayerSensor::Method::AMAZE);
+            chunkSizes.amaze = tune(options.chunkSizeAMAZE, "AMaZE", [&]() { imgsrc->demosaic(raw, false, contrast, false); }, nullptr);
+
+            if (pl) {
+                pl->setProgress(0.6);
+            }
+
+            raw.bayersensor.method = procparams::RAWParams::BayerSensor::getMethodString(procparams::RAWParams::BayerSensor::Method::RCD);
+            chunkSizes.rcd = tune(options.chunkSizeRCD, "RCD", [&]() { imgsrc->demosaic(raw, false, contrast, false); }, nullptr);
+
+            if (pl) {
+                pl->setProgress(0.8);
+            }
+
+            // the correction runs at the end of the preprocessing, the rest of it does not depend on the chunk size. The fit is
+            // measured each time, a fit from the cache would leave it out of the timing
+            raw.ca_autocorrect = true;
+            chunkSizes.ca = tune(options.chunkSizeCA, "CA correction", [&]() { imgsrc->preprocess(raw, job->pparams.lensProf, job->pparams.coarse, false, false); }, nullptr);
+        } else if (sensorType == ST_FUJI_XTRANS) {
+            raw.xtranssensor.method = procparams::RAWParams::XTransSensor::getMethodString(procparams::RAWParams::XTransSensor::Method::THREE_PASS);
+            chunkSizes.xt = tune(options.chunkSizeXT, "X-Trans", [&]() { imgsrc->demosaic(raw, false, contrast, false); }, nullptr);
+        }
+
+        options.chunkSizeAMAZE = initial.amaze;
+        options.chunkSizeCA = initial.ca;
+        options.chunkSizeRCD = initial.rcd;
+        options.chunkSizeRGB = initial.rgb;
+        options.chunkSizeXT = initial.xt;
+
+        stage_cleanup();
+
+        if (pl) {
+            pl->setProgress(1.0);
+        }
+
+        return sensorType == ST_BAYER || sensorType == ST_FUJI_XTRANS;
+    }
+
 private:
     Imagefloat *normal_pipeline()
     {
@@ -145,12 +296,14 @@ private:
     bool stage_init()
     {
         errorCode = 0;
+        instrumentation::Stage stage("stage_init", "processImage");
 
         if (pl) {
             pl->setProgressStr("PROGRESSBAR_PROCESSING");
             pl->setProgress(0.0);
         }
 
+        instrumentation::Stage step("load", "processImage");
         initialImage = job->initialImage;
 
         if (!initialImage) {
@@ -216,6 +369,7 @@ private:
         ipf_p.reset(new ImProcFunctions(&params, true));
         ImProcFunctions &ipf = * (ipf_p.get());
 
+        step.next("preprocess");
         imgsrc->setCurrentFrame(params.raw.bayersensor.imageNum);
         imgsrc->preprocess(params.raw, params.lensProf, params.coarse, params.dirpyrDenoise.enabled);
 
@@ -231,7 +385,9 @@ private:
         bool autoContrast = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicAutoContrast : params.raw.xtranssensor.dualDemosaicAutoContrast;
         double contrastThreshold = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicContrast : params.raw.xtranssensor.dualDemosaicContrast;
 
+        step.next("demosaic");
         imgsrc->demosaic (params.raw, autoContrast, contrastThreshold, params.pdsharpening.enabled && pl);
+        step.next("captureSharpening");
         if (params.pdsharpening.enabled) {
             imgsrc->captureSharpening(params.pdsharpening, false, params.pdsharpening.contrast, params.pdsharpening.deconvradius);
         }
@@ -243,6 +399,7 @@ private:
 
         pp = PreviewProps(0, 0, fw, fh, 1);
 
+        step.next("retinex");
         if (params.retinex.enabled) { //enabled Retinex
             LUTf cdcurve(65536, 0);
             LUTf mapcurve(65536, 0);
@@ -262,6 +419,7 @@ private:
             pl->setProgress(0.40);
         }
 
+        step.next("HLRecovery_Global");
         imgsrc->HLRecovery_Global(params.toneCurve);
 
 
@@ -269,6 +427,7 @@ private:
             pl->setProgress(0.45);
         }
 
+        step.next("autoNoise");
         // set the color temperature
         currWB = ColorTemp(params.wb.temperature, params.wb.green, params.wb.equal, params.wb.method);
 
@@ -353,112 +512,79 @@ private:
 //      Imagefloat *origCropPart;//init auto noise
 //          origCropPart = new Imagefloat (crW, crH);//allocate memory
             if (params.dirpyrDenoise.enabled) {//evaluate Noise
-                LUTf gamcurve(65536, 0);
-                float gam, gamthresh, gamslope;
-                ipf.RGB_denoise_infoGamCurve(params.dirpyrDenoise, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope);
-#ifdef _OPENMP
-                #pragma omp parallel
-#endif
-                {
-                    Imagefloat *origCropPart;//init auto noise
-                    origCropPart = new Imagefloat(crW, crH); //allocate memory
-                    Imagefloat *provicalc = new Imagefloat((crW + 1) / 2, (crH + 1) / 2);  //for denoise curves
-                    int skipP = 1;
-#ifdef _OPENMP
-                    #pragma omp for schedule(dynamic) collapse(2) nowait
-#endif
+                std::vector<int> left(numtiles_W);
+                std::vector<int> top(numtiles_H);
 
-                    for (int wcr = 0; wcr < numtiles_W; wcr++) {
-                        for (int hcr = 0; hcr < numtiles_H; hcr++) {
-                            int beg_tileW = wcr * tileWskip + tileWskip / 2.f - crW / 2.f;
-                            int beg_tileH = hcr * tileHskip + tileHskip / 2.f - crH / 2.f;
-                            PreviewProps ppP(beg_tileW, beg_tileH, crW, crH, skipP);
-                            imgsrc->getImage(currWB, tr, origCropPart, ppP, params.toneCurve, params.raw);
-                            //baseImg->getStdImage(currWB, tr, origCropPart, ppP, true, params.toneCurve);
-
-                            // we only need image reduced to 1/4 here
-                            for (int ii = 0; ii < crH; ii += 2) {
-                                for (int jj = 0; jj < crW; jj += 2) {
-                                    provicalc->r(ii >> 1, jj >> 1) = origCropPart->r(ii, jj);
-                                    provicalc->g(ii >> 1, jj >> 1) = origCropPart->g(ii, jj);
-                                    provicalc->b(ii >> 1, jj >> 1) = origCropPart->b(ii, jj);
-                                }
-                            }
-
-                            imgsrc->convertColorSpace(provicalc, params.icm, currWB);  //for denoise luminance curve
-                            float maxr = 0.f;
-                            float maxb = 0.f;
-                            float pondcorrec = 1.0f;
-                            float chaut, redaut, blueaut, maxredaut, maxblueaut, minredaut, minblueaut, chromina, sigma, lumema, sigma_L, redyel, skinc, nsknc;
-                            int Nb;
-                            chaut = 0.f;
-                            redaut = 0.f;
-                            blueaut = 0.f;
-                            maxredaut = 0.f;
-                            maxblueaut = 0.f;
-                            chromina = 0.f;
-                            sigma = 0.f;
-                            ipf.RGB_denoise_info(origCropPart, provicalc, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope, params.dirpyrDenoise, imgsrc->getDirPyrDenoiseExpComp(), chaut, Nb, redaut, blueaut, maxredaut, maxblueaut, minredaut, minblueaut, chromina, sigma, lumema, sigma_L, redyel, skinc, nsknc);
-                            float multip = 1.f;
-                            float adjustr = 1.f;
-
-                            if (params.icm.workingProfile == "ProPhoto")   {
-                                adjustr = 1.f;   //
-                            } else if (params.icm.workingProfile == "Adobe RGB")  {
-                                adjustr = 1.f / 1.3f;
-                            } else if (params.icm.workingProfile == "sRGB")       {
-                                adjustr = 1.f / 1.3f;
-                            } else if (params.icm.workingProfile == "WideGamut")  {
-                                adjustr = 1.f / 1.1f;
-                            } else if (params.icm.workingProfile == "Rec2020")  {
-                                adjustr = 1.f / 1.1f;
-                            } else if (params.icm.workingProfile == "Beta RGB")   {
-                                adjustr = 1.f / 1.2f;
-                            } else if (params.icm.workingProfile == "BestRGB")    {
-                                adjustr = 1.f / 1.2f;
-                            } else if (params.icm.workingProfile == "BruceRGB")   {
-                                adjustr = 1.f / 1.2f;
-                            }
-
-                            if (!imgsrc->isRAW()) {
-                                multip = 2.f;    //take into account gamma for TIF / JPG approximate value...not good for gamma=1
-                            }
-
-                            float maxmax = max(maxredaut, maxblueaut);
-                            float delta;
-                            int mode = 2;
-                            int lissage = settings->leveldnliss;
-                            ipf.calcautodn_info(chaut, delta, Nb, levaut, maxmax, lumema, chromina, mode, lissage, redyel, skinc, nsknc);
-
-                            //    printf("PROCESS cha=%f red=%f bl=%f redM=%f bluM=%f chrom=%f sigm=%f lum=%f sigL=%f\n",chaut,redaut,blueaut, maxredaut, maxblueaut, chromina, sigma, lumema, sigma_L);
-                            if (maxredaut > maxblueaut) {
-                                maxr = (delta) / ((autoNRmax * multip * adjustr * lowdenoise) / 2.f);
-
-                                if (minblueaut <= minredaut  && minblueaut < chaut) {
-                                    maxb = (-chaut + minblueaut) / (autoNRmax * multip * adjustr * lowdenoise);
-                                }
-                            } else {
-                                maxb = (delta) / ((autoNRmax * multip * adjustr * lowdenoise) / 2.f);
-
-                                if (minredaut <= minblueaut  && minredaut < chaut) {
-                                    maxr = (-chaut + minredaut) / (autoNRmax * multip * adjustr * lowdenoise);
-                                }
-                            }//maxb mxr - empirical evaluation red / blue
-
-                            ch_M[hcr * numtiles_W + wcr] = pondcorrec * chaut / (autoNR * multip * adjustr * lowdenoise);
-                            max_r[hcr * numtiles_W + wcr] = pondcorrec * maxr;
-                            max_b[hcr * numtiles_W + wcr] = pondcorrec * maxb;
-                            lumL[hcr * numtiles_W + wcr] = lumema;
-                            chromC[hcr * numtiles_W + wcr] = chromina;
-                            ry[hcr * numtiles_W + wcr] = redyel;
-                            sk[hcr * numtiles_W + wcr] = skinc;
-                            pcsk[hcr * numtiles_W + wcr] = nsknc;
+                for (int wcr = 0; wcr < numtiles_W; wcr++) {
+                    left[wcr] = wcr * tileWskip + tileWskip / 2.f - crW / 2.f;
+                }
+
+                for (int hcr = 0; hcr < numtiles_H; hcr++) {
+                    top[hcr] = hcr * tileHskip + tileHskip / 2.f - crH / 2.f;
+                }
+
+                std::vector<NoiseSample> samples;
+                measureNoiseSamples(ipf, imgsrc, currWB, tr, params, left, top, crW, crH, samples);
+
+                float multip = 1.f;
+                float adjustr = 1.f;
+
+                if (params.icm.workingProfile == "ProPhoto")   {
+                    adjustr = 1.f;   //
+                } else if (params.icm.workingProfile == "Adobe RGB")  {
+                    adjustr = 1.f / 1.3f;
+                } else if (params.icm.workingProfile == "sRGB")       {
+                    adjustr = 1.f / 1.3f;
+                } else if (params.icm.workingProfile == "WideGamut")  {
+                    adjustr = 1.f / 1.1f;
+                } else if (params.icm.workingProfile == "Rec2020")  {
+                    adjustr = 1.f / 1.1f;
+                } else if (params.icm.workingProfile == "Beta RGB")   {
+                    adjustr = 1.f / 1.2f;
+                } else if (params.icm.workingProfile == "BestRGB")    {
+                    adjustr = 1.f / 1.2f;
+                } else if (params.icm.workingProfile == "BruceRGB")   {
+                    adjustr = 1.f / 1.2f;
+                }
 
+                if (!imgsrc->isRAW()) {
+                    multip = 2.f;    //take into account gamma for TIF / JPG approximate value...not good for gamma=1
+                }
+
+                for (int k = 0; k < numtiles_W * numtiles_H; k++) {
+                    const NoiseSample &sample = samples[k];
+                    float maxr = 0.f;
+                    float maxb = 0.f;
+                    float pondcorrec = 1.0f;
+                    float chaut = sample.chaut;
+                    float maxmax = max(sample.maxredaut, sample.maxblueaut);
+                    float delta;
+                    int mode = 2;
+                    int lissage = settings->leveldnliss;
+                    ipf.calcautodn_info(chaut, delta, sample.nb, levaut, maxmax, sample.lumema, sample.chromina, mode, lissage, sample.redyel, sample.skinc, sample.nsknc);
+
+                    if (sample.maxredaut > sample.maxblueaut) {
+                        maxr = (delta) / ((autoNRmax * multip * adjustr * lowdenoise) / 2.f);
+
+                        if (sample.minblueaut <= sample.minredaut  && sample.minblueaut < chaut) {
+                            maxb = (-chaut + sample.minblueaut) / (autoNRmax * multip * adjustr * lowdenoise);
                         }
-                    }
+                    } else {
+                        maxb = (delta) / ((autoNRmax * multip * adjustr * lowdenoise) / 2.f);
 
-                    delete provicalc;
-                    delete origCropPart;
+                        if (sample.minredaut <= sample.minblueaut  && sample.minredaut < chaut) {
+                            maxr = (-chaut + sample.minredaut) / (autoNRmax * multip * adjustr * lowdenoise);
+                        }
+                    }//maxb mxr - empirical evaluation red / blue
+
+                    ch_M[k] = pondcorrec * chaut / (autoNR * multip * adjustr * lowdenoise);
+                    max_r[k] = pondcorrec * maxr;
+                    max_b[k] = pondcorrec * maxb;
+                    lumL[k] = sample.lumema;
+                    chromC[k] = sample.chromina;
+                    ry[k] = sample.redyel;
+                    sk[k] = sample.skinc;
+                    pcsk[k] = sample.nsknc;
                 }
 
                 int liss = settings->leveldnliss; //smooth result around mean
@@ -568,69 +694,26 @@ private:
             }
 
             if (params.dirpyrDenoise.enabled) {//evaluate Noise
-                LUTf gamcurve(65536, 0);
-                float gam, gamthresh, gamslope;
-                ipf.RGB_denoise_infoGamCurve(params.dirpyrDenoise, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope);
+                const int begW = 50;
+                const int begH = 50;
+                std::vector<NoiseSample> samples;
+                measureNoiseSamples(ipf, imgsrc, currWB, tr, params, {begW, fw / 2 - crW / 2, fw - crW - begW}, {begH, fh / 2 - crH / 2, fh - crH - begH}, crW, crH, samples);
                 int Nb[9];
-                int  coordW[3];//coordinate of part of image to measure noise
-                int  coordH[3];
-                int begW = 50;
-                int begH = 50;
-                coordW[0] = begW;
-                coordW[1] = fw / 2 - crW / 2;
-                coordW[2] = fw - crW - begW;
-                coordH[0] = begH;
-                coordH[1] = fh / 2 - crH / 2;
-                coordH[2] = fh - crH - begH;
-#ifdef _OPENMP
-                #pragma omp parallel
-#endif
-                {
-                    Imagefloat *origCropPart;//init auto noise
-                    origCropPart = new Imagefloat(crW, crH); //allocate memory
-                    Imagefloat *provicalc = new Imagefloat((crW + 1) / 2, (crH + 1) / 2);  //for denoise curves
-
-#ifdef _OPENMP
-                    #pragma omp for schedule(dynamic) collapse(2) nowait
-#endif
-
-                    for (int wcr = 0; wcr <= 2; wcr++) {
-                        for (int hcr = 0; hcr <= 2; hcr++) {
-                            PreviewProps ppP(coordW[wcr], coordH[hcr], crW, crH, 1);
-                            imgsrc->getImage(currWB, tr, origCropPart, ppP, params.toneCurve, params.raw);
-                            //baseImg->getStdImage(currWB, tr, origCropPart, ppP, true, params.toneCurve);
-
-
-                            // we only need image reduced to 1/4 here
-                            for (int ii = 0; ii < crH; ii += 2) {
-                                for (int jj = 0; jj < crW; jj += 2) {
-                                    provicalc->r(ii >> 1, jj >> 1) = origCropPart->r(ii, jj);
-                                    provicalc->g(ii >> 1, jj >> 1) = origCropPart->g(ii, jj);
-                                    provicalc->b(ii >> 1, jj >> 1) = origCropPart->b(ii, jj);
-                                }
-                            }
-
-                            imgsrc->convertColorSpace(provicalc, params.icm, currWB);  //for denoise luminance curve
-                            int nb = 0;
-                            float chaut = 0.f, redaut = 0.f, blueaut = 0.f, maxredaut = 0.f, maxblueaut = 0.f, minredaut = 0.f, minblueaut = 0.f, chromina = 0.f, sigma = 0.f, lumema = 0.f, sigma_L = 0.f, redyel = 0.f, skinc = 0.f, nsknc = 0.f;
-                            ipf.RGB_denoise_info(origCropPart, provicalc, imgsrc->isRAW(), gamcurve, gam, gamthresh, gamslope,  params.dirpyrDenoise, imgsrc->getDirPyrDenoiseExpComp(), chaut, nb, redaut, blueaut, maxredaut, maxblueaut, minredaut, minblueaut, chromina, sigma, lumema, sigma_L, redyel, skinc, nsknc);
-                            Nb[hcr * 3 + wcr] = nb;
-                            ch_M[hcr * 3 + wcr] = chaut;
-                            max_r[hcr * 3 + wcr] = maxredaut;
-                            max_b[hcr * 3 + wcr] = maxblueaut;
-                            min_r[hcr * 3 + wcr] = minredaut;
-                            min_b[hcr * 3 + wcr] = minblueaut;
-                            lumL[hcr * 3 + wcr] = lumema;
-                            chromC[hcr * 3 + wcr] = chromina;
-                            ry[hcr * 3 + wcr] = redyel;
-                            sk[hcr * 3 + wcr] = skinc;
-                            pcsk[hcr * 3 + wcr] = nsknc;
-                        }
-                    }
 
-                    delete provicalc;
-                    delete origCropPart;
+                for (int k = 0; k < 9; ++k) {
+                    Nb[k] = samples[k].nb;
+                    ch_M[k] = samples[k].chaut;
+                    max_r[k] = samples[k].maxredaut;
+                    max_b[k] = samples[k].maxblueaut;
+                    min_r[k] = samples[k].minredaut;
+                    min_b[k] = samples[k].minblueaut;
+                    lumL[k] = samples[k].lumema;
+                    chromC[k] = samples[k].chromina;
+                    ry[k] = samples[k].redyel;
+                    sk[k] = samples[k].skinc;
+                    pcsk[k] = samples[k].nsknc;
                 }
+
                 float chM = 0.f;
                 float MaxR = 0.f;
                 float MaxB = 0.f;
@@ -756,6 +839,7 @@ private:
             //end evaluate noise
         }
 
+        step.next("getImage");
         baseImg = new Imagefloat(fw, fh);
         imgsrc->getImage(currWB, tr, baseImg, pp, params.toneCurve, params.raw);
 
@@ -773,6 +857,8 @@ private:
         hlcomprthresh = params.toneCurve.hlcomprthresh;
 
 
+        step.next("autoExposure");
+
         if (params.toneCurve.autoexp) {
             LUTu aehist;
             int aehistcompr;
@@ -809,6 +895,7 @@ private:
 
     void stage_denoise()
     {
+        instrumentation::Stage stage("stage_denoise", "processImage");
         const procparams::ProcParams& params = job->pparams;
 
         DirPyrDenoiseParams denoiseParams = params.dirpyrDenoise;   // make a copy because we cheat here
@@ -867,18 +954,24 @@ private:
         const procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
         ImProcFunctions &ipf = * (ipf_p.get());
+        instrumentation::Stage stage("stage_transform", "processImage");
 
+        instrumentation::Stage step("convertColorSpace", "processImage");
         imgsrc->convertColorSpace(baseImg, params.icm, currWB);
 
         // perform first analysis
         hist16(65536);
 
+        step.next("firstAnalysis");
         ipf.firstAnalysis(baseImg, params, hist16);
 
+        step.next("dehaze");
         ipf.dehaze(baseImg);
+        step.next("ToneMapFattal02");
         ipf.ToneMapFattal02(baseImg);
 
         // perform transform (excepted resizing)
+        step.next("transform");
         if (ipf.needsTransform(fw, fh, imgsrc->getRotateDegree(), imgsrc->getMetaData())) {
             Imagefloat* trImg = nullptr;
 
@@ -899,6 +992,24 @@ private:
     }
 
     Imagefloat *stage_finish()
+    {
+        instrumentation::Stage stage("stage_finish", "processImage");
+        int halo;
+        const int stripHeight = strip_height(halo);
+        Imagefloat *readyImg;
+
+        if (stripHeight > 0) {
+            readyImg = stage_strips(stripHeight, halo);
+        } else {
+            stage_lab();
+            readyImg = stage_output(job->pparams, true);
+        }
+
+        stage_cleanup();
+        return readyImg;
+    }
+
+    void stage_rgb_curves()
     {
         procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
@@ -949,7 +1060,7 @@ private:
         CurveFactory::RGBCurve(params.rgbCurves.gcurve, gCurve, 1);
         CurveFactory::RGBCurve(params.rgbCurves.bcurve, bCurve, 1);
 
-        bool opautili = false;
+        opautili = false;
 
         if (params.colorToning.enabled) {
             TMatrix wprof = ICCStore::getInstance()->workingSpaceMatrix(params.icm.workingProfile);
@@ -965,16 +1076,12 @@ private:
             CurveFactory::curveToning(params.colorToning.cl2curve, cl2Toningcurve, 1);
         }
 
-        labView = new LabImage(fw, fh);
-
         if (params.blackwhite.enabled) {
             CurveFactory::curveBW(params.blackwhite.beforeCurve, params.blackwhite.afterCurve, hist16, dummy, customToneCurvebw1, customToneCurvebw2, 1);
         }
 
-        double rrm, ggm, bbm;
-        float autor, autog, autob;
-        float satLimit = float (params.colorToning.satProtectionThreshold) / 100.f * 0.7f + 0.3f;
-        float satLimitOpacity = 1.f - (float (params.colorToning.saturatedOpacity) / 100.f);
+        satLimit = float (params.colorToning.satProtectionThreshold) / 100.f * 0.7f + 0.3f;
+        satLimitOpacity = 1.f - (float (params.colorToning.saturatedOpacity) / 100.f);
 
         if (params.colorToning.enabled  && params.colorToning.autosat && params.colorToning.method != "LabGrid") { //for colortoning evaluation of saturation settings
             float moyS = 0.f;
@@ -995,17 +1102,30 @@ private:
             satLimitOpacity = 100.f * (moyS - 0.85f * eqty); //-0.85 sigma==>20% pixels with low saturation
         }
 
+        dcpProf = imgsrc->getDCP(params.icm, dcpApplyState);
+    }
+
+    void rgb_proc(Imagefloat *working, LabImage *lab)
+    {
+        const procparams::ProcParams& params = job->pparams;
+        ImProcFunctions &ipf = * (ipf_p.get());
+
+        double rrm, ggm, bbm;
+        float autor, autog, autob;
         autor = -9000.f; // This will ask to compute the "auto" values for the B&W tool (have to be inferior to -5000)
-        DCPProfileApplyState as;
-        DCPProfile *dcpProf = imgsrc->getDCP(params.icm, as);
 
         LUTu histToneCurve;
 
-        ipf.rgbProc(baseImg, labView, nullptr, curve1, curve2, curve, params.toneCurve.saturation, rCurve, gCurve, bCurve, satLimit, satLimitOpacity, ctColorCurve, ctOpacityCurve, opautili, clToningcurve, cl2Toningcurve, customToneCurve1, customToneCurve2, customToneCurvebw1, customToneCurvebw2, rrm, ggm, bbm, autor, autog, autob, expcomp, hlcompr, hlcomprthresh, dcpProf, as, histToneCurve, options.chunkSizeRGB, options.measure);
+        ipf.rgbProc(working, lab, nullptr, curve1, curve2, curve, params.toneCurve.saturation, rCurve, gCurve, bCurve, satLimit, satLimitOpacity, ctColorCurve, ctOpacityCurve, opautili, clToningcurve, cl2Toningcurve, customToneCurve1, customToneCurve2, customToneCurvebw1, customToneCurvebw2, rrm, ggm, bbm, autor, autog, autob, expcomp, hlcompr, hlcomprthresh, dcpProf, dcpApplyState, histToneCurve, options.chunkSizeRGB, options.measure);
 
-        if (settings->verbose) {
+        if (settings->verbose && working == baseImg) { // not reported for each strip
             printf ("Output image / Auto B&W coefs:   R=%.2f   G=%.2f   B=%.2f\n", static_cast<double>(autor), static_cast<double>(autog), static_cast<double>(autob));
         }
+    }
+
+    void release_rgb_curves()
+    {
+        const procparams::ProcParams& params = job->pparams;
 
         // if clut was used and size of clut cache == 1 we free the memory used by the clutstore (default clut cache size = 1 for 32 bit OS)
         if (params.filmSimulation.enabled && !params.filmSimulation.clutFilename.empty() && options.clutCacheSize == 1) {
@@ -1021,6 +1141,37 @@ private:
         noiseCCurve.Reset();
         customToneCurvebw1.Reset();
         customToneCurvebw2.Reset();
+    }
+
+    void stage_lab_curves()
+    {
+        const procparams::ProcParams& params = job->pparams;
+
+        CurveFactory::complexLCurve(params.labCurve.brightness, params.labCurve.contrast, params.labCurve.lcurve, hist16, lumacurve, dummy, 1, utili);
+
+        CurveFactory::curveCL(clcutili, params.labCurve.clcurve, clcurve, 1);
+
+        // own curves for a and b, curve1 and curve2 are still needed by rgbProc when processing strips
+        aoutCurve(65536);
+        boutCurve(65536);
+        CurveFactory::complexsgnCurve(autili, butili, ccutili, cclutili, params.labCurve.acurve, params.labCurve.bcurve, params.labCurve.cccurve,
+                                      params.labCurve.lccurve, aoutCurve, boutCurve, satcurve, lhskcurve, 1);
+    }
+
+    void stage_lab()
+    {
+        procparams::ProcParams& params = job->pparams;
+        //ImProcFunctions ipf (&params, true);
+        ImProcFunctions &ipf = * (ipf_p.get());
+
+        instrumentation::Stage step("rgbCurves", "processImage");
+        stage_rgb_curves();
+
+        labView = new LabImage(fw, fh);
+
+        step.next("rgbProc");
+        rgb_proc(baseImg, labView);
+        release_rgb_curves();
 
         // Freeing baseImg because not used anymore
         delete baseImg;
@@ -1035,70 +1186,51 @@ private:
         // start tile processing...???
 
 
+        step.next("labCurves");
+
         if (params.labCurve.contrast != 0) { //only use hist16 for contrast
             hist16.clear();
-
-#ifdef _OPENMP
-            #pragma omp parallel
-#endif
-            {
-                LUTu hist16thr(hist16.getSize());   // one temporary lookup table per thread
-                hist16thr.clear();
-#ifdef _OPENMP
-                #pragma omp for schedule(static) nowait
-#endif
-
-                for (int i = 0; i < fh; i++)
-                    for (int j = 0; j < fw; j++) {
-                        hist16thr[(int)((labView->L[i][j]))]++;
-                    }
-
-#ifdef _OPENMP
-                #pragma omp critical
-#endif
-                {
-                    hist16 += hist16thr;
-                }
-            }
+            add_to_lum_histogram(labView);
         }
 
-        bool utili;
-        CurveFactory::complexLCurve(params.labCurve.brightness, params.labCurve.contrast, params.labCurve.lcurve, hist16, lumacurve, dummy, 1, utili);
-
-        bool clcutili;
-        CurveFactory::curveCL(clcutili, params.labCurve.clcurve, clcurve, 1);
-
-        bool ccutili, cclutili;
-        CurveFactory::complexsgnCurve(autili, butili, ccutili, cclutili, params.labCurve.acurve, params.labCurve.bcurve, params.labCurve.cccurve,
-                                      params.labCurve.lccurve, curve1, curve2, satcurve, lhskcurve, 1);
+        stage_lab_curves();
 
-        ipf.chromiLuminanceCurve(nullptr, 1, labView, labView, curve1, curve2, satcurve, lhskcurve, clcurve, lumacurve, utili, autili, butili, ccutili, cclutili, clcutili, dummy, dummy);
+        step.next("chromiLuminanceCurve");
+        ipf.chromiLuminanceCurve(nullptr, 1, labView, labView, aoutCurve, boutCurve, satcurve, lhskcurve, clcurve, lumacurve, utili, autili, butili, ccutili, cclutili, clcutili, dummy, dummy);
 
+        step.next("EPDToneMap");
         if ((params.colorappearance.enabled && !params.colorappearance.tonecie) || (!params.colorappearance.enabled)) {
             ipf.EPDToneMap (labView, 0, 1);
         }
 
 
+        step.next("vibrance");
         ipf.vibrance(labView);
+        step.next("labColorCorrectionRegions");
         ipf.labColorCorrectionRegions(labView);
 
         // for all treatments Defringe, Sharpening, Contrast detail ,Microcontrast they are activated if "CIECAM" function are disabled
 
         if ((params.colorappearance.enabled && !settings->autocielab) || (!params.colorappearance.enabled)) {
+            step.next("impulsedenoise");
             ipf.impulsedenoise (labView);
+            step.next("defringe");
             ipf.defringe(labView);
         }
 
+        step.next("MLsharpen");
         if (params.sharpenEdge.enabled) {
             ipf.MLsharpen(labView);
         }
 
+        step.next("MLmicrocontrast");
         if (params.sharpenMicro.enabled) {
             if ((params.colorappearance.enabled && !settings->autocielab) || (!params.colorappearance.enabled)) {
                 ipf.MLmicrocontrast(labView);     //!params.colorappearance.sharpcie
             }
         }
 
+        step.next("sharpening");
         if (((params.colorappearance.enabled && !settings->autocielab) || (!params.colorappearance.enabled)) && params.sharpening.enabled) {
             ipf.sharpening(labView, params.sharpening);
 
@@ -1107,12 +1239,14 @@ private:
 
 
         // directional pyramid wavelet
+        step.next("dirpyrequalizer");
         if (params.dirpyrequalizer.cbdlMethod == "aft") {
             if ((params.colorappearance.enabled && !settings->autocielab)  || !params.colorappearance.enabled) {
                 ipf.dirpyrequalizer(labView, 1);     //TODO: this is the luminance tonecurve, not the RGB one
             }
         }
 
+        step.next("ip_wavelet");
         if ((params.wavelet.enabled)) {
             LabImage *unshar = nullptr;
             Glib::ustring provis;
@@ -1272,9 +1406,11 @@ private:
             wavCLVCurve.Reset();
         }
 
+        step.next("softLight");
         ipf.softLight(labView);
 
         //Colorappearance and tone-mapping associated
+        step.next("ciecam_02float");
 
         int f_w = 1, f_h = 1;
 
@@ -1342,6 +1478,264 @@ private:
         if (pl) {
             pl->setProgress(0.60);
         }
+    }
+
+    void add_to_lum_histogram(const LabImage *lab)
+    {
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            LUTu hist16thr(hist16.getSize());   // one temporary lookup table per thread
+            hist16thr.clear();
+#ifdef _OPENMP
+            #pragma omp for schedule(static) nowait
+#endif
+
+            for (int i = 0; i < lab->H; i++)
+                for (int j = 0; j < lab->W; j++) {
+                    hist16thr[(int)((lab->L[i][j]))]++;
+                }
+
+#ifdef _OPENMP
+            #pragma omp critical
+#endif
+            {
+                hist16 += hist16thr;
+            }
+        }
+    }
+
+    // Rows of context needed above and below a strip by the Lab tools, or -1 when an enabled tool needs the whole image
+    // (global analysis or unbounded support). The pixel-wise tools need no context.
+    int strip_halo() const
+    {
+        const procparams::ProcParams& params = job->pparams;
+
+        if (params.resize.enabled || params.dirpyrequalizer.enabled || params.sh.enabled || params.localContrast.enabled
+                || (params.blackwhite.enabled && params.blackwhite.autoc) || (params.colorToning.enabled && params.colorToning.method == "LabRegions")
+                || params.epd.enabled || params.impulseDenoise.enabled || params.defringe.enabled || params.sharpenEdge.enabled
+                || params.sharpenMicro.enabled || params.wavelet.enabled || params.colorappearance.enabled) {
+            return -1;
+        }
+
+        // support of the Gaussian blurs, an upper bound of the 3x3, 5x5 and 7x7 kernels
+        const auto gaussHalo = [](double sigma) -> int {
+            return sigma < 0.25 ? 0 : static_cast<int>(std::ceil(6.0 * sigma)) + 3;
+        };
+
+        int halo = 0;
+        const procparams::SharpeningParams& sharpening = params.sharpening;
+
+        if (sharpening.enabled && sharpening.amount >= 1) {
+            // the strips only match the full frame exactly with the kernels of bounded support, the recursive filter used for
+            // the larger radii depends on the whole column
+            const bool rld = sharpening.method == "rld";
+            const bool damping = sharpening.deconvdamping > 0;
+
+            if (!gaussianBlurIsFinite(sharpening.blurradius)
+                    || (rld && (!gaussianBlurIsFinite(sharpening.deconvradius, GAUSS_MULT) || (damping && !gaussianBlurIsFinite(sharpening.deconvradius))))
+                    || (!rld && !gaussianBlurIsFinite(sharpening.radius))) {
+                return -1;
+            }
+
+            halo += 2; // contrast blend mask
+            halo += sharpening.blurradius >= 0.25 ? gaussHalo(sharpening.blurradius) : 0;
+
+            if (rld) {
+                halo += 2 * sharpening.deconviter * gaussHalo(sharpening.deconvradius);
+            } else {
+                halo += gaussHalo(sharpening.radius);
+
+                if (sharpening.edgesonly) {
+                    halo += static_cast<int>(std::ceil(4.0 * sharpening.edges_radius)) + 2;
+                }
+            }
+        }
+
+        return halo;
+    }
+
+    // Height of the strips when the Lab stage has to be processed in strips to fit in options.exportMemoryBudget, 0 otherwise
+    int strip_height(int &halo) const
+    {
+        halo = strip_halo();
+
+        if (options.exportMemoryBudget <= 0 || halo < 0) {
+            return 0;
+        }
+
+        const procparams::ProcParams& params = job->pparams;
+        const std::size_t budget = static_cast<std::size_t>(options.exportMemoryBudget) << 20;
+        const std::size_t pixels = static_cast<std::size_t>(fw) * fh;
+
+        // full frame: working image, Lab image and the temporary buffers of the tools
+        if (pixels * 4 * 12 <= budget) {
+            return 0;
+        }
+
+        // strips: the working image is kept and receives the output rows, a cropped output gets its own image.
+        // Each row of a strip holds the RGB and Lab strips, the temporary buffers of the tools and two output strips
+        const std::size_t fixedBytes = pixels * 12 + (params.crop.enabled ? static_cast<std::size_t>(params.crop.w) * params.crop.h * 12 : 0);
+        const std::size_t rowBytes = static_cast<std::size_t>(fw) * 80;
+        int height = budget > fixedBytes ? static_cast<int>(std::min<std::size_t>((budget - fixedBytes) / rowBytes, fh)) - 2 * halo : 0;
+
+        if (budget <= fixedBytes && settings->verbose) {
+            printf("Export memory budget of %d MiB too low, using the smallest strips\n", options.exportMemoryBudget);
+        }
+
+        // a strip must be at least as high as the context, so that its output rows never overwrite the input of the next one
+        height = std::max(height, std::max(halo, 16));
+
+        return height < fh ? height : 0;
+    }
+
+    // Alternative to stage_lab and stage_output for full resolution exports: the Lab tools and the output conversion
+    // run on horizontal strips with the context rows declared by strip_halo. The global statistics needed by the curves
+    // (L histogram for the contrast of the Lab adjustments) are gathered by an analysis pre-pass over the strips.
+    Imagefloat *stage_strips(int stripHeight, int halo)
+    {
+        procparams::ProcParams& params = job->pparams;
+        //ImProcFunctions ipf (&params, true);
+        ImProcFunctions &ipf = * (ipf_p.get());
+
+        if (settings->verbose) {
+            printf("Processing %d x %d image in strips of %d rows (context: %d rows)\n", fw, fh, stripHeight, halo);
+        }
+
+        instrumentation::Stage step("rgbCurves", "processImage");
+        stage_rgb_curves();
+
+        const auto copyRows = [this](int top, int bottom) {
+            Imagefloat *strip = new Imagefloat(fw, bottom - top);
+
+#ifdef _OPENMP
+            #pragma omp parallel for
+#endif
+
+            for (int i = top; i < bottom; i++) {
+                for (int j = 0; j < fw; j++) {
+                    strip->r(i - top, j) = baseImg->r(i, j);
+                    strip->g(i - top, j) = baseImg->g(i, j);
+                    strip->b(i - top, j) = baseImg->b(i, j);
+                }
+            }
+
+            return strip;
+        };
+
+        step.next("stripAnalysis");
+
+        if (params.labCurve.contrast != 0) { //only use hist16 for contrast
+            hist16.clear();
+
+            for (int y0 = 0; y0 < fh; y0 += stripHeight) {
+                const int y1 = std::min(y0 + stripHeight, fh);
+                std::unique_ptr<Imagefloat> working(copyRows(y0, y1));
+                LabImage lab(fw, y1 - y0);
+                rgb_proc(working.get(), &lab);
+                add_to_lum_histogram(&lab);
+            }
+        }
+
+        step.next("labCurves");
+        stage_lab_curves();
+
+        step.next("strips");
+        int cx = 0, cy = 0, cw = fw, ch = fh;
+
+        if (params.crop.enabled) {
+            cx = params.crop.x;
+            cy = params.crop.y;
+            cw = params.crop.w;
+            ch = params.crop.h;
+        }
+
+        // without crop, the output rows replace the working image ones
+        Imagefloat *readyImg = params.crop.enabled ? new Imagefloat(cw, ch) : baseImg;
+        std::unique_ptr<Imagefloat> pending;
+        int pendingRow = 0;
+
+        const auto flushPending = [&]() {
+            if (!pending) {
+                return;
+            }
+
+#ifdef _OPENMP
+            #pragma omp parallel for
+#endif
+
+            for (int i = 0; i < pending->getHeight(); i++) {
+                for (int j = 0; j < pending->getWidth(); j++) {
+                    readyImg->r(pendingRow + i, j) = pending->r(i, j);
+                    readyImg->g(pendingRow + i, j) = pending->g(i, j);
+                    readyImg->b(pendingRow + i, j) = pending->b(i, j);
+                }
+            }
+
+            pending.reset();
+        };
+
+        for (int y0 = cy; y0 < cy + ch; y0 += stripHeight) {
+            const int y1 = std::min(y0 + stripHeight, cy + ch);
+            const int top = std::max(y0 - halo, 0);
+            const int bottom = std::min(y1 + halo, fh);
+
+            std::unique_ptr<Imagefloat> working(copyRows(top, bottom));
+            // the output of the previous strip can only be stored once its context rows have been read again
+            flushPending();
+
+            LabImage lab(fw, bottom - top);
+            rgb_proc(working.get(), &lab);
+            working.reset();
+
+            // same order as in stage_lab
+            ipf.chromiLuminanceCurve(nullptr, 1, &lab, &lab, aoutCurve, boutCurve, satcurve, lhskcurve, clcurve, lumacurve, utili, autili, butili, ccutili, cclutili, clcutili, dummy, dummy);
+            ipf.vibrance(&lab);
+
+            if (params.sharpening.enabled) {
+                ipf.sharpening(&lab, params.sharpening);
+            }
+
+            ipf.softLight(&lab);
+
+            pending.reset(ipf.lab2rgbOut(&lab, cx, y0 - top, cw, y1 - y0, params.icm));
+            pendingRow = y0 - cy;
+
+            if (pl) {
+                pl->setProgress(0.5 + 0.2 * (y1 - cy) / ch);
+            }
+        }
+
+        flushPending();
+        release_rgb_curves();
+
+        if (readyImg != baseImg) {
+            delete baseImg;
+        }
+
+        baseImg = nullptr;
+
+        if (settings->verbose) {
+            printf("Output profile_: \"%s\"\n", params.icm.outputProfile.c_str());
+        }
+
+        step.next("stage_output_rgb");
+        return stage_output_rgb(params, readyImg);
+    }
+
+    // Crop, resize, output sharpening and output profile: the only steps which differ between the renditions of an image.
+    // The Lab image is shared, it is only handed over to this stage (and may be modified) when 'consume' is set.
+    Imagefloat *stage_output(const procparams::ProcParams& params, bool consume)
+    {
+        instrumentation::Stage stage("stage_output", "processImage");
+        ImProcFunctions ipf(&params, true);
+        LabImage *lab = labView;
+        bool ownLab = consume;
+
+        if (consume) {
+            labView = nullptr;
+        }
 
         int imw, imh;
         double tmpScale = ipf.resizeScale(&params, fw, fh, imw, imh);
@@ -1349,7 +1743,7 @@ private:
         LabImage *tmplab;
 
         // crop and convert to rgb16
-        int cx = 0, cy = 0, cw = labView->W, ch = labView->H;
+        int cx = 0, cy = 0, cw = lab->W, ch = lab->H;
 
         if (params.crop.enabled) {
             cx = params.crop.x;
@@ -1362,69 +1756,99 @@ private:
 
                 for (int row = 0; row < ch; row++) {
                     for (int col = 0; col < cw; col++) {
-                        tmplab->L[row][col] = labView->L[row + cy][col + cx];
-                        tmplab->a[row][col] = labView->a[row + cy][col + cx];
-                        tmplab->b[row][col] = labView->b[row + cy][col + cx];
+                        tmplab->L[row][col] = lab->L[row + cy][col + cx];
+                        tmplab->a[row][col] = lab->a[row + cy][col + cx];
+                        tmplab->b[row][col] = lab->b[row + cy][col + cx];
                     }
                 }
 
-                delete labView;
-                labView = tmplab;
+                if (ownLab) {
+                    delete lab;
+                }
+
+                lab = tmplab;
+                ownLab = true;
                 cx = 0;
                 cy = 0;
             }
         }
 
         if (labResize) { // resize lab data
-            if ((labView->W != imw || labView->H != imh) &&
-                    (params.resize.allowUpscaling || (labView->W >= imw && labView->H >= imh))) {
+            if ((lab->W != imw || lab->H != imh) &&
+                    (params.resize.allowUpscaling || (lab->W >= imw && lab->H >= imh))) {
                 // resize image
+                instrumentation::Stage step("Lanczos", "processImage");
                 tmplab = new LabImage(imw, imh);
-                ipf.Lanczos(labView, tmplab, tmpScale);
-                delete labView;
-                labView = tmplab;
+                ipf.Lanczos(lab, tmplab, tmpScale);
+
+                if (ownLab) {
+                    delete lab;
+                }
+
+                lab = tmplab;
+                ownLab = true;
             }
 
-            cw = labView->W;
-            ch = labView->H;
+            cw = lab->W;
+            ch = lab->H;
 
             if (params.prsharpening.enabled) {
+                instrumentation::Stage step("prsharpening", "processImage");
+
+                if (!ownLab) { // the shared image must stay untouched for the other renditions
+                    tmplab = new LabImage(cw, ch);
+                    tmplab->CopyFrom(lab);
+                    lab = tmplab;
+                    ownLab = true;
+                }
+
                 for (int i = 0; i < ch; i++) {
                     for (int j = 0; j < cw; j++) {
-                        labView->L[i][j] = labView->L[i][j] < 0.f ? 0.f : labView->L[i][j];
+                        lab->L[i][j] = lab->L[i][j] < 0.f ? 0.f : lab->L[i][j];
                     }
                 }
 
-                ipf.sharpening(labView, params.prsharpening);
+                ipf.sharpening(lab, params.prsharpening);
             }
         }
 
-        bool bwonly = params.blackwhite.enabled && !params.colorToning.enabled && !autili && !butili && !params.colorappearance.enabled;
-
         ///////////// Custom output gamma has been removed, the user now has to create
         ///////////// a new output profile with the ICCProfileCreator
 
         // if Default gamma mode: we use the profile selected in the "Output profile" combobox;
         // gamma come from the selected profile, otherwise it comes from "Free gamma" tool
 
-        Imagefloat* readyImg = ipf.lab2rgbOut(labView, cx, cy, cw, ch, params.icm);
+        instrumentation::Stage step("lab2rgbOut", "processImage");
+        Imagefloat* readyImg = ipf.lab2rgbOut(lab, cx, cy, cw, ch, params.icm);
 
         if (settings->verbose) {
             printf("Output profile_: \"%s\"\n", params.icm.outputProfile.c_str());
         }
 
-        delete labView;
-        labView = nullptr;
+        if (ownLab) {
+            delete lab;
+        }
 
+        step.next("stage_output_rgb");
+        return stage_output_rgb(params, readyImg);
+    }
 
+    // Last steps of the output stage, on the image converted to the output profile
+    Imagefloat *stage_output_rgb(const procparams::ProcParams& params, Imagefloat *readyImg)
+    {
+        ImProcFunctions ipf(&params, true);
+
+        int imw, imh;
+        double tmpScale = ipf.resizeScale(&params, fw, fh, imw, imh);
+        bool bwonly = params.blackwhite.enabled && !params.colorToning.enabled && !autili && !butili && !params.colorappearance.enabled;
 
         if (bwonly) { //force BW r=g=b
             if (settings->verbose) {
                 printf("Force BW\n");
             }
 
-            for (int ccw = 0; ccw < cw; ccw++) {
-                for (int cch = 0; cch < ch; cch++) {
+            for (int ccw = 0; ccw < readyImg->getWidth(); ccw++) {
+                for (int cch = 0; cch < readyImg->getHeight(); cch++) {
                     readyImg->r(cch, ccw) = readyImg->g(cch, ccw);
                     readyImg->b(cch, ccw) = readyImg->g(cch, ccw);
                 }
@@ -1490,6 +1914,14 @@ private:
 //    if( settings->verbose )
 //           printf("Total:- %d usec\n", t2.etime(t1));
 
+        return readyImg;
+    }
+
+    void stage_cleanup()
+    {
+        delete labView;
+        labView = nullptr;
+
         if (!job->initialImage) {
             initialImage->decreaseRef();
         }
@@ -1511,11 +1943,11 @@ private:
             hist16.reset();
             hist16C.reset();
         */
-        return readyImg;
     }
 
     void stage_early_resize()
     {
+        instrumentation::Stage stage("stage_early_resize", "processImage");
         procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
         ImProcFunctions &ipf = * (ipf_p.get());
@@ -1697,6 +2129,8 @@ private:
 
     LUTf curve1;
     LUTf curve2;
+    LUTf aoutCurve;
+    LUTf boutCurve;
     LUTf curve;
     LUTf satcurve;
     LUTf lhskcurve;
@@ -1719,6 +2153,12 @@ private:
     ToneCurve customToneCurvebw2;
 
     bool autili, butili;
+    bool utili, clcutili, ccutili, cclutili;
+    bool opautili;
+    float satLimit;
+    float satLimitOpacity;
+    DCPProfile *dcpProf;
+    DCPProfileApplyState dcpApplyState;
 };
 
 } // namespace
@@ -1730,8 +2170,84 @@ IImagefloat* processImage(ProcessingJob* pjob, int& errorCode, ProgressListener*
     return proc();
 }
 
-void batchProcessingThread(ProcessingJob* job, BatchProcessingListener* bpl)
+std::vector<IImagefloat*> processImageRenditions(ProcessingJob* pjob, const std::vector<procparams::ProcParams>& renditions, int& errorCode, ProgressListener* pl, bool flush)
+{
+    ImageProcessor proc(pjob, errorCode, pl, flush);
+    const std::vector<Imagefloat*> images = proc.renditions(renditions);
+    return std::vector<IImagefloat*>(images.begin(), images.end());
+}
+
+bool tuneChunkSizes(const Glib::ustring& fname, ChunkSizes& chunkSizes, ProgressListener* pl)
+{
+    // neutral parameters: the timings must not depend on the default profile of the user
+    procparams::ProcParams params;
+    int errorCode = 0;
+    ImageProcessor proc(ProcessingJob::create(fname, true, params), errorCode, pl, false);
+    return proc.tune_chunk_sizes(chunkSizes) && !errorCode;
+}
+
+std::size_t estimateProcessingMemory(int width, int height, const procparams::ProcParams& params)
 {
+    // Bytes per pixel of the full frame: raw data (16 bit and float), demosaiced planes,
+    // working image, Lab image and output image
+    std::size_t bytesPerPixel = 2 + 4 + 3 * 4 + 3 * 4 + 3 * 4 + 3 * 4;
+
+    if (params.raw.bayersensor.method == procparams::RAWParams::BayerSensor::getMethodString(procparams::RAWParams::BayerSensor::Method::PIXELSHIFT)) {
+        // three more raw frames
+        bytesPerPixel += 3 * (2 + 4);
+    }
+
+    if (params.dirpyrDenoise.enabled) {
+        // copy of the image plus the wavelet decompositions of the tiles
+        bytesPerPixel += 3 * 4 + 6 * 4;
+    }
+
+    if (params.wavelet.enabled) {
+        // decomposition of the whole Lab image
+        bytesPerPixel += 12 * 4;
+    }
+
+    if (params.colorappearance.enabled) {
+        bytesPerPixel += 6 * 4;
+    }
+
+    if (params.retinex.enabled) {
+        bytesPerPixel += 6 * 4;
+    }
+
+    if (params.fattal.enabled || params.dehaze.enabled) {
+        bytesPerPixel += 3 * 4;
+    }
+
+    return static_cast<std::size_t>(std::max(width, 0)) * static_cast<std::size_t>(std::max(height, 0)) * bytesPerPixel;
+}
+
+bool getImageSize(const Glib::ustring& fname, bool isRaw, int& width, int& height)
+{
+    if (isRaw) {
+        // header only, the raw data are not decoded
+        RawImage ri(fname);
+
+        if (ri.loadRaw(false) != 0) {
+            return false;
+        }
+
+        width = ri.get_width();
+        height = ri.get_height();
+        return true;
+    }
+
+    return ImageIO::getImageSize(fname, width, height) == IMIO_SUCCESS;
+}
+
+void batchProcessingThread(ProcessingJob* job, BatchProcessingListener* bpl, int numThreads)
+{
+#ifdef _OPENMP
+    if (numThreads > 0) {
+        // only affects the parallel regions started from this thread
+        omp_set_num_threads(numThreads);
+    }
+#endif
 
     ProcessingJob* currentJob = job;
 
@@ -1753,11 +2269,11 @@ void batchProcessingThread(ProcessingJob* job, BatchProcessingListener* bpl)
     }
 }
 
-void startBatchProcessing(ProcessingJob* job, BatchProcessingListener* bpl)
+void startBatchProcessing(ProcessingJob* job, BatchProcessingListener* bpl, int numThreads)
 {
 
     if (bpl) {
-        Glib::Thread::create(sigc::bind(sigc::ptr_fun(batchProcessingThread), job, bpl), 0, true, true, Glib::THREAD_PRIORITY_LOW);
+        Glib::Thread::create(sigc::bind(sigc::ptr_fun(batchProcessingThread), job, bpl, numThreads), 0, true, true, Glib::THREAD_PRIORITY_LOW);
     }
 
 }
@@ -67,6 +67,7 @@
 
 #include "array2D.h"
 #include "color.h"
+#include "fftwplancache.h"
 #include "iccstore.h"
 #include "imagefloat.h"
 #include "improcfun.h"
@@ -722,6 +723,21 @@ void tmo_fattal02 (size_t width,
 // for both solvers.
 
 
+// executes the 2d discrete cosine transform of A into T with a cached plan,
+// the two transforms of solve_pde_fft share the same plan
+void dct2d (Array2Df *A, Array2Df *T, bool multithread)
+{
+    const int n[2] = {A->getRows(), A->getCols()};
+    const fftwf_r2r_kind kinds[2] = {FFTW_REDFT00, FFTW_REDFT00};
+#ifdef _OPENMP
+    const int nthreads = multithread ? omp_get_max_threads() : 1;
+#else
+    const int nthreads = 1;
+#endif
+    fftwf_execute_r2r (getR2RPlan (2, n, 1, A->data(), T->data(), kinds, FFTW_ESTIMATE, nthreads), A->data(), T->data());
+}
+
+
 // returns T = EVy A EVx^tr
 // note, modifies input data
 void transform_ev2normal (Array2Df *A, Array2Df *T, bool multithread)
@@ -761,11 +777,7 @@ void transform_ev2normal (Array2Df *A, Array2Df *T, bool multithread)
     // fftwf_free(in);
 
     // executes 2d discrete cosine transform
-    fftwf_plan p;
-    p = fftwf_plan_r2r_2d (height, width, A->data(), T->data(),
-                           FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-    fftwf_execute (p);
-    fftwf_destroy_plan (p);
+    dct2d (A, T, multithread);
 }
 
 
@@ -777,11 +789,7 @@ void transform_normal2ev (Array2Df *A, Array2Df *T, bool multithread)
     assert ((int)T->getCols() == width && (int)T->getRows() == height);
 
     // executes 2d discrete cosine transform
-    fftwf_plan p;
-    p = fftwf_plan_r2r_2d (height, width, A->data(), T->data(),
-                           FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-    fftwf_execute (p);
-    fftwf_destroy_plan (p);
+    dct2d (A, T, multithread);
 
     // need to scale the output matrix to get the right transform
     float factor = (1.0f / ((height - 1) * (width - 1)));
@@ -872,18 +880,6 @@ void solve_pde_fft (Array2Df *F, Array2Df *U, Array2Df *buf, bool multithread)/*
     assert ((int)U->getCols() == width && (int)U->getRows() == height);
     assert (buf->getCols() == width && buf->getRows() == height);
 
-    // activate parallel execution of fft routines
-#ifdef RT_FFTW3F_OMP
-
-    if (multithread) {
-        fftwf_init_threads();
-        fftwf_plan_with_nthreads ( omp_get_max_threads() );
-    }
-
-// #else
-//   fftwf_plan_with_nthreads( 2 );
-#endif
-
     // in general there might not be a solution to the Poisson pde
     // with Neumann boundary conditions unless the boundary satisfies
     // an integral condition, this function modifies the boundary so that
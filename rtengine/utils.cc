@@ -19,6 +19,13 @@
 #include <cmath>
 #include <cstring>
 #include <cstdio>
+#include <fstream>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
 #include "rt_math.h"
 
 #include "utils.h"
@@ -263,6 +270,47 @@ void swab(const void* from, void* to, ssize_t n)
     }
 }
 
+Glib::ustring getCPUModel()
+{
+    std::string model;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    unsigned int brand[12] = {};
+
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004) {
+        for (unsigned int i = 0; i < 3; ++i) {
+            __get_cpuid(0x80000002 + i, &brand[4 * i], &brand[4 * i + 1], &brand[4 * i + 2], &brand[4 * i + 3]);
+        }
+
+        model.assign(reinterpret_cast<const char*>(brand), strnlen(reinterpret_cast<const char*>(brand), sizeof(brand)));
+    }
+#endif
+
+    if (model.empty()) {
+        // other architectures, Linux only
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+
+        while (model.empty() && std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0 || line.compare(0, 9, "cpu model") == 0) {
+                const std::string::size_type colon = line.find(':');
+
+                if (colon != std::string::npos) {
+                    model = line.substr(colon + 1);
+                }
+            }
+        }
+    }
+
+    const std::string::size_type first = model.find_first_not_of(" \t");
+
+    if (first == std::string::npos) {
+        return "unknown";
+    }
+
+    return model.substr(first, model.find_last_not_of(" \t") - first + 1);
+}
+
 }
 
 #if __SIZEOF_WCHAR_T__ == 4
@@ -54,6 +54,9 @@ bool hasPngExtension(const Glib::ustring& filename);
 
 void swab(const void* from, void* to, ssize_t n);
 
+// Return the model name of the CPU, or "unknown"
+Glib::ustring getCPUModel();
+
 }
 
 #if __SIZEOF_WCHAR_T__ == 4
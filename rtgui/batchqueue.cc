@@ -18,6 +18,7 @@
  */
 #include <glibmm/ustring.h>
 #include <glib/gstdio.h>
+#include <algorithm>
 #include <cstring>
 #include <functional>
 #include "../rtengine/rt_math.h"
@@ -40,10 +41,55 @@
 #include "rtimage.h"
 #include <sys/time.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 using namespace rtengine;
 
-BatchQueue::BatchQueue (FileCatalog* aFileCatalog) : processing(nullptr), fileCatalog(aFileCatalog), sequence(0), listener(nullptr)
+/* Processes the jobs of one slot of the queue, several workers running concurrently.
+ * It forwards the BatchProcessingListener calls of its processing thread to the BatchQueue. */
+class BatchQueue::Worker final :
+    public rtengine::BatchProcessingListener
+{
+public:
+    explicit Worker (BatchQueue& queue) :
+        queue(queue),
+        entry(nullptr),
+        footprint(0)
+    {
+    }
+
+    void setProgress(double p) override
+    {
+        queue.setProgress(*this, p);
+    }
+
+    void setProgressStr(const Glib::ustring& str) override
+    {
+    }
+
+    void setProgressState(bool inProcessing) override
+    {
+    }
+
+    void error(const Glib::ustring& descr) override
+    {
+        queue.error(*this, descr);
+    }
+
+    rtengine::ProcessingJob* imageReady(rtengine::IImagefloat* img) override
+    {
+        return queue.imageReady(*this, img);
+    }
+
+    BatchQueue& queue;
+    BatchQueueEntry* entry;  // the entry being processed, nullptr if the worker is idle
+    std::size_t footprint;   // estimated memory needed to process the entry
+};
+
+BatchQueue::BatchQueue (FileCatalog* aFileCatalog) : memoryInUse(0), fileCatalog(aFileCatalog), sequence(0), listener(nullptr)
 {
 
     location = THLOC_BATCHQUEUE;
@@ -575,48 +621,163 @@ void BatchQueue::openItemInEditor(ThumbBrowserEntryBase* item)
 
 void BatchQueue::startProcessing ()
 {
+    if (!isProcessing()) {
+        {
+            MYWRITERLOCK(l, entryRW);
+            sequence = 0;
+        }
 
-    if (!processing) {
-        MYWRITERLOCK(l, entryRW);
+        startAdmissibleJobs (false);
+    }
+}
+
+bool BatchQueue::isProcessing ()
+{
+    MYREADERLOCK(l, entryRW);
+
+    return std::any_of (workers.begin (), workers.end (), [] (const std::unique_ptr<Worker>& worker) { return worker->entry != nullptr; });
+}
+
+std::size_t BatchQueue::estimateMemory (BatchQueueEntry* entry) const
+{
+    int w = 0;
+    int h = 0;
+
+    if (entry->thumbnail) {
+        entry->thumbnail->getFinalSize (*entry->params, w, h);
+    }
+
+    if (w <= 0 || h <= 0) {
+        // size not known yet, assume a 24 MP image
+        w = 6000;
+        h = 4000;
+    }
+
+    return rtengine::estimateProcessingMemory (w, h, *entry->params);
+}
+
+bool BatchQueue::assignNextJob (Worker& worker)
+{
+    if (listener && !listener->canStartNext ()) {
+        return false;
+    }
+
+    // the entries under processing are at the head of the queue
+    const auto pos = std::find_if (fd.begin (), fd.end (), [] (const ThumbBrowserEntryBase* fdEntry) { return !fdEntry->processing; });
+
+    if (pos == fd.end ()) {
+        return false;
+    }
+
+    BatchQueueEntry* const next = static_cast<BatchQueueEntry*> (*pos);
+    const std::size_t footprint = estimateMemory (next);
+    const std::size_t budget = static_cast<std::size_t> (std::max (options.batchQueueMemoryBudget, 0)) << 20;
+    const bool othersRunning = std::any_of (workers.begin (), workers.end (), [] (const std::unique_ptr<Worker>& w) { return w->entry != nullptr; });
+
+    // jobs are started in queue order, one job is always admitted whatever its size
+    if (othersRunning && budget > 0 && memoryInUse + footprint > budget) {
+        return false;
+    }
+
+    // tag it as processing and set sequence
+    next->processing = true;
+    next->sequence = ++sequence;
+
+    // remove from selection
+    if (next->selected) {
+        const auto selPos = std::find (selected.begin(), selected.end(), next);
+
+        if (selPos != selected.end()) {
+            selected.erase (selPos);
+        }
+
+        next->selected = false;
+    }
+
+    worker.entry = next;
+    worker.footprint = footprint;
+    memoryInUse += footprint;
 
-        if (!fd.empty()) {
-            BatchQueueEntry* next;
+    return true;
+}
+
+void BatchQueue::startAdmissibleJobs (bool lockGui)
+{
+    const int maxJobs = std::max (options.batchQueueMaxJobs, 1);
+    int numThreads = 0;
 
-            next = static_cast<BatchQueueEntry*>(fd[0]);
-            // tag it as processing and set sequence
-            next->processing = true;
-            next->sequence = sequence = 1;
-            processing = next;
+#ifdef _OPENMP
+    if (maxJobs > 1) {
+        // split the threads between the concurrent jobs, the noise reduction and wavelet limit of the preferences still applies within each job
+        numThreads = std::max (omp_get_max_threads () / maxJobs, 1);
+    }
+#endif
 
-            // remove from selection
-            if (processing->selected) {
-                std::vector<ThumbBrowserEntryBase*>::iterator pos = std::find (selected.begin(), selected.end(), processing);
+    std::vector<Worker*> started;
 
-                if (pos != selected.end()) {
-                    selected.erase (pos);
+    {
+        MYWRITERLOCK(l, entryRW);
+
+        while (true) {
+            int running = 0;
+            Worker* idle = nullptr;
+
+            for (const auto& worker : workers) {
+                if (worker->entry) {
+                    ++running;
+                } else if (!idle) {
+                    idle = worker.get ();
                 }
+            }
 
-                processing->selected = false;
+            if (running >= maxJobs) {
+                break;
             }
 
-            MYWRITERLOCK_RELEASE(l);
+            if (!idle) {
+                workers.emplace_back (new Worker (*this));
+                idle = workers.back ().get ();
+            }
 
-            // remove button set
-            next->removeButtonSet ();
+            if (!assignNextJob (*idle)) {
+                break;
+            }
 
-            // start batch processing
-            rtengine::startBatchProcessing (next->job, this);
-            queue_draw ();
+            started.push_back (idle);
+        }
+    }
 
-            notifyListener();
+    if (started.empty ()) {
+        return;
+    }
+
+    for (const auto worker : started) {
+        // remove button set
+        if (lockGui) {
+            // ButtonSet have Cairo::Surface which might be rendered while we're trying to delete them
+            GThreadLock lock;
+            worker->entry->removeButtonSet ();
+        } else {
+            worker->entry->removeButtonSet ();
         }
     }
+
+    for (const auto worker : started) {
+        // start batch processing
+        rtengine::startBatchProcessing (worker->entry->job, worker, numThreads);
+    }
+
+    if (!lockGui) {
+        // otherwise called from a processing thread which redraws and notifies by itself
+        queue_draw ();
+        notifyListener ();
+    }
 }
 
-void BatchQueue::setProgress(double p)
+void BatchQueue::setProgress(Worker& worker, double p)
 {
-    if (processing) {
-        processing->progress = p;
+    if (worker.entry) {
+        worker.entry->progress = p;
     }
 
     // No need to acquire the GUI, setProgressUI will do it
@@ -629,42 +790,53 @@ void BatchQueue::setProgress(double p)
     );
 }
 
-void BatchQueue::setProgressStr(const Glib::ustring& str)
+void BatchQueue::error(Worker& worker, const Glib::ustring& descr)
 {
-}
-
-void BatchQueue::setProgressState(bool inProcessing)
-{
-}
+    BatchQueueEntry* const failed = worker.entry;
 
-void BatchQueue::error(const Glib::ustring& descr)
-{
-    if (processing && processing->processing) {
+    if (failed && failed->processing) {
         // restore failed thumb
-        BatchQueueButtonSet* bqbs = new BatchQueueButtonSet (processing);
+        BatchQueueButtonSet* bqbs = new BatchQueueButtonSet (failed);
         bqbs->setButtonListener (this);
-        processing->addButtonSet (bqbs);
-        processing->processing = false;
-        processing->job = rtengine::ProcessingJob::create(processing->filename, processing->thumbnail->getType() == FT_Raw, *processing->params);
-        processing = nullptr;
+        failed->addButtonSet (bqbs);
+
+        {
+            MYWRITERLOCK(l, entryRW);
+            failed->processing = false;
+            failed->job = rtengine::ProcessingJob::create(failed->filename, failed->thumbnail->getType() == FT_Raw, *failed->params);
+            memoryInUse -= worker.footprint;
+            worker.footprint = 0;
+            worker.entry = nullptr;
+        }
+
         redraw ();
     }
 
     if (listener) {
         BatchQueueListener* const bql = listener;
 
+        // the other jobs may still be running
+        const bool queueRunning = isProcessing ();
+        int qsize = 0;
+        {
+            MYREADERLOCK(l, entryRW);
+            qsize = fd.size();
+        }
+
         idle_register.add(
-            [bql, descr]() -> bool
+            [bql, qsize, queueRunning, descr]() -> bool
             {
-                bql->queueSizeChanged(0, false, true, descr);
+                bql->queueSizeChanged(qsize, queueRunning, true, descr);
                 return false;
             }
         );
     }
 }
 
-rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
+rtengine::ProcessingJob* BatchQueue::imageReady(Worker& worker, rtengine::IImagefloat* img)
 {
+    BatchQueueEntry* const processing = worker.entry;
+
     // save image img
     Glib::ustring fname;
     SaveFormat saveFormat;
@@ -672,7 +844,7 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
     if (processing->outFileName.empty()) { // auto file name
         Glib::ustring s = calcAutoFileNameBase (processing->filename, processing->sequence);
         saveFormat = options.saveFormatBatch;
-        fname = autoCompleteFileName (s, saveFormat.format);
+        fname = autoCompleteFileName (s, saveFormat.format, processing->overwriteFile);
     } else { // use the save-as filename with automatic completion for uniqueness
         if (processing->forceFormatOpts) {
             saveFormat = processing->saveFormat;
@@ -682,15 +854,15 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
 
         // The output filename's extension is forced to the current or selected output format,
         // despite what the user have set in the filename's field of the "Save as" dialog box
-        fname = autoCompleteFileName (removeExtension(processing->outFileName), saveFormat.format);
+        fname = autoCompleteFileName (removeExtension(processing->outFileName), saveFormat.format, processing->overwriteFile);
         //fname = autoCompleteFileName (removeExtension(processing->outFileName), getExtension(processing->outFileName));
     }
 
     //printf ("fname=%s, %s\n", fname.c_str(), removeExtension(fname).c_str());
 
-    if (img && !fname.empty()) {
-        int err = 0;
+    int err = 0;
 
+    if (img && !fname.empty()) {
         if (saveFormat.format == "tif") {
             err = img->saveAsTIFF (fname, saveFormat.tiffBits, saveFormat.tiffFloat, saveFormat.tiffUncompressed);
         } else if (saveFormat.format == "png") {
@@ -700,7 +872,15 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
         }
 
         img->free ();
+    }
 
+    if (!fname.empty()) {
+        // the name has been reserved by autoCompleteFileName, whether the image could be saved or not
+        MyMutex::MyLock lock(reservedFileNamesMutex);
+        reservedFileNames.erase (fname);
+    }
+
+    if (img && !fname.empty()) {
         if (err) {
             throw Glib::FileError(Glib::FileError::FAILED, M("MAIN_MSG_CANNOTSAVE") + "\n" + fname);
         }
@@ -727,41 +907,30 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
     {
         MYWRITERLOCK(l, entryRW);
 
-        delete processing;
-        processing = nullptr;
-
-        fd.erase (fd.begin());
+        const auto pos = std::find (fd.begin (), fd.end (), processing);
 
-        // return next job
-        if (!fd.empty() && listener && listener->canStartNext ()) {
-            BatchQueueEntry* next = static_cast<BatchQueueEntry*>(fd[0]);
-            // tag it as selected and set sequence
-            next->processing = true;
-            next->sequence = ++sequence;
-            processing = next;
-
-            // remove from selection
-            if (processing->selected) {
-                std::vector<ThumbBrowserEntryBase*>::iterator pos = std::find (selected.begin(), selected.end(), processing);
-
-                if (pos != selected.end()) {
-                    selected.erase (pos);
-                }
+        if (pos != fd.end ()) {
+            fd.erase (pos);
+        }
 
-                processing->selected = false;
-            }
+        delete processing;
+        memoryInUse -= worker.footprint;
+        worker.footprint = 0;
+        worker.entry = nullptr;
 
-            // remove button set
-            remove_button_set = true;
-        }
+        // return next job
+        remove_button_set = assignNextJob (worker);
     }
 
     if (remove_button_set) {
         // ButtonSet have Cairo::Surface which might be rendered while we're trying to delete them
         GThreadLock lock;
-        processing->removeButtonSet ();
+        worker.entry->removeButtonSet ();
     }
 
+    // the memory released by this job might allow other jobs to start
+    startAdmissibleJobs (true);
+
     if (saveBatchQueue ()) {
         ::g_remove (processedParams.c_str ());
 
@@ -793,7 +962,7 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
     redraw ();
     notifyListener ();
 
-    return processing ? processing->job : nullptr;
+    return worker.entry ? worker.entry->job : nullptr;
 }
 
 // Calculates automatic filename of processed batch entry, but just the base name
@@ -929,7 +1098,8 @@ Glib::ustring BatchQueue::calcAutoFileNameBase (const Glib::ustring& origFileNam
     return path;
 }
 
-Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, const Glib::ustring& format)
+// The returned file name is reserved until the image is saved, so that concurrent jobs don't pick the same name
+Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, const Glib::ustring& format, bool overwrite)
 {
 
     // separate filename and the path to the destination directory
@@ -944,7 +1114,9 @@ Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, c
 
     // In overwrite mode we TRY to delete the old file first.
     // if that's not possible (e.g. locked by viewer, R/O), we revert to the standard naming scheme
-    bool inOverwriteMode = processing->overwriteFile;
+    bool inOverwriteMode = overwrite;
+
+    MyMutex::MyLock lock(reservedFileNamesMutex);
 
     for (int tries = 0; tries < 100; tries++) {
         if (tries == 0) {
@@ -953,6 +1125,10 @@ Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, c
             fname = Glib::ustring::compose ("%1-%2.%3", Glib::build_filename (dstdir,  dstfname), tries, format);
         }
 
+        if (reservedFileNames.count (fname)) {
+            continue;
+        }
+
         int fileExists = Glib::file_test (fname, Glib::FILE_TEST_EXISTS);
 
         if (inOverwriteMode && fileExists) {
@@ -964,6 +1140,7 @@ Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, c
         }
 
         if (!fileExists) {
+            reservedFileNames.insert (fname);
             return fname;
         }
     }
@@ -986,7 +1163,7 @@ void BatchQueue::buttonPressed (LWButton* button, int actionCode, void* actionDa
 
 void BatchQueue::notifyListener ()
 {
-    const bool queueRunning = processing;
+    const bool queueRunning = isProcessing ();
     if (listener) {
         BatchQueueListener* const bql = listener;
 
@@ -17,7 +17,9 @@
  */
 #pragma once
 
+#include <memory>
 #include <set>
+#include <vector>
 
 #include <gtkmm.h>
 
@@ -44,7 +46,6 @@ class FileCatalog;
 
 class BatchQueue final :
     public ThumbBrowserBase,
-    public rtengine::BatchProcessingListener,
     public LWButtonListener,
     public rtengine::NonCopyable
 {
@@ -68,12 +69,6 @@ public:
         return (!fd.empty());
     }
 
-    void setProgress(double p) override;
-    void setProgressStr(const Glib::ustring& str) override;
-    void setProgressState(bool inProcessing) override;
-    void error(const Glib::ustring& descr) override;
-    rtengine::ProcessingJob* imageReady(rtengine::IImagefloat* img) override;
-
     void rightClicked () override;
     void doubleClicked (ThumbBrowserEntryBase* entry) override;
     bool keyPressed (GdkEventKey* event) override;
@@ -92,18 +87,35 @@ public:
     static int calcMaxThumbnailHeight();
 
 private:
+    class Worker;
+
     int getMaxThumbnailHeight() const override;
     void saveThumbnailHeight (int height) override;
     int  getThumbnailHeight () override;
 
-    Glib::ustring autoCompleteFileName (const Glib::ustring& fileName, const Glib::ustring& format);
+    // Called from the processing threads through the Worker's BatchProcessingListener interface
+    void setProgress (Worker& worker, double p);
+    void error (Worker& worker, const Glib::ustring& descr);
+    rtengine::ProcessingJob* imageReady (Worker& worker, rtengine::IImagefloat* img);
+
+    // Assigns the next admissible entry to 'worker' and tags it as processing; entryRW has to be write locked
+    bool assignNextJob (Worker& worker);
+    // Starts new workers while entries can be admitted; lockGui has to be true when called from a processing thread
+    void startAdmissibleJobs (bool lockGui);
+    bool isProcessing ();
+    std::size_t estimateMemory (BatchQueueEntry* entry) const;
+
+    Glib::ustring autoCompleteFileName (const Glib::ustring& fileName, const Glib::ustring& format, bool overwrite);
     Glib::ustring getTempFilenameForParams( const Glib::ustring &filename );
     bool saveBatchQueue ();
     void notifyListener ();
 
     using ThumbBrowserBase::redrawNeeded;
 
-    BatchQueueEntry* processing;  // holds the currently processed image
+    std::vector<std::unique_ptr<Worker>> workers; // one per concurrent job, protected by entryRW
+    std::size_t memoryInUse; // estimated memory of the entries being processed, protected by entryRW
+    std::set<Glib::ustring> reservedFileNames; // output files being written by the workers
+    MyMutex reservedFileNamesMutex;
     FileCatalog* fileCatalog;
     int sequence; // holds the current sequence index
 
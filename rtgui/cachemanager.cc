@@ -39,7 +39,7 @@ namespace
 {
 
 constexpr int cacheDirMode = 0777;
-constexpr const char* cacheDirs[] = { "profiles", "images", "embprofiles", "data" };
+constexpr const char* cacheDirs[] = { "profiles", "images", "embprofiles", "data", "rawindex" };
 
 }
 
@@ -239,6 +239,7 @@ void CacheManager::clearImages () const
     deleteDir ("data");
     deleteDir ("images");
     deleteDir ("embprofiles");
+    deleteDir ("rawindex");
 }
 
 void CacheManager::clearProfiles () const
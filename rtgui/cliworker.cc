@@ -0,0 +1,618 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <glib/gstdio.h>
+
+#ifndef WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "cliworker.h"
+#include "options.h"
+#include "pathutils.h"
+
+#include "../rtengine/cJSON.h"
+#include "../rtengine/noncopyable.h"
+#include "../rtengine/procparams.h"
+#include "../rtengine/profilestore.h"
+#include "../rtengine/rtengine.h"
+
+namespace
+{
+
+// Line based JSON transport on top of stdio streams
+class JobChannel :
+    public rtengine::NonCopyable
+{
+public:
+    JobChannel (FILE* in, FILE* out, bool owned) :
+        in (in),
+        out (out),
+        owned (owned)
+    {
+    }
+
+    ~JobChannel ()
+    {
+        if (owned) {
+            fclose (in);
+            fclose (out);
+        }
+    }
+
+    // Returns false at the end of the stream
+    bool readLine (std::string& line)
+    {
+        line.clear();
+        char buffer[4096];
+
+        while (fgets (buffer, sizeof (buffer), in)) {
+            line += buffer;
+
+            if (!line.empty() && line.back() == '\n') {
+                line.pop_back();
+                return true;
+            }
+        }
+
+        return !line.empty();
+    }
+
+    // Sends and deletes the message
+    void send (cJSON* message)
+    {
+        char* const text = cJSON_PrintUnformatted (message);
+
+        if (text) {
+            fputs (text, out);
+            fputc ('\n', out);
+            fflush (out);
+            cJSON_free (text);
+        }
+
+        cJSON_Delete (message);
+    }
+
+private:
+    FILE* const in;
+    FILE* const out;
+    const bool owned;
+};
+
+Glib::ustring getString (const cJSON* job, const char* name, const Glib::ustring& defaultValue = Glib::ustring())
+{
+    const cJSON* const item = cJSON_GetObjectItem (job, name);
+    return cJSON_IsString (item) ? Glib::ustring (item->valuestring) : defaultValue;
+}
+
+int getInt (const cJSON* job, const char* name, int defaultValue)
+{
+    const cJSON* const item = cJSON_GetObjectItem (job, name);
+    return cJSON_IsNumber (item) ? item->valueint : defaultValue;
+}
+
+bool getBool (const cJSON* job, const char* name, bool defaultValue)
+{
+    const cJSON* const item = cJSON_GetObjectItem (job, name);
+    return cJSON_IsBool (item) ? cJSON_IsTrue (item) : defaultValue;
+}
+
+void sendStatus (JobChannel& channel, const cJSON* job, const char* status, const Glib::ustring& output = Glib::ustring(), const Glib::ustring& message = Glib::ustring())
+{
+    cJSON* const response = cJSON_CreateObject();
+    const cJSON* const id = job ? cJSON_GetObjectItem (job, "id") : nullptr;
+
+    if (id) {
+        cJSON_AddItemToObject (response, "id", cJSON_Duplicate (id, 1));
+    }
+
+    cJSON_AddStringToObject (response, "status", status);
+
+    if (!output.empty()) {
+        cJSON_AddStringToObject (response, "output", output.c_str());
+    }
+
+    if (!message.empty()) {
+        cJSON_AddStringToObject (response, "message", message.c_str());
+    }
+
+    channel.send (response);
+}
+
+using ProfilePtr = std::unique_ptr<rtengine::procparams::PartialProfile, void (*) (rtengine::procparams::PartialProfile*)>;
+
+void deleteProfile (rtengine::procparams::PartialProfile* profile)
+{
+    if (profile) {
+        profile->deleteInstance();
+        delete profile;
+    }
+}
+
+// The default profiles are loaded on first use and kept between the jobs
+class DefaultProfiles :
+    public rtengine::NonCopyable
+{
+public:
+    DefaultProfiles () :
+        loaded (false),
+        raw (nullptr, deleteProfile),
+        img (nullptr, deleteProfile)
+    {
+    }
+
+    // Returns an empty string on success, the error message otherwise
+    Glib::ustring applyTo (rtengine::procparams::ProcParams& params, rtengine::InitialImage* ii, bool isRaw)
+    {
+        if (!loaded) {
+            raw.reset (load (options.defProfRaw, options.is_defProfRawMissing(), true));
+            img.reset (load (options.defProfImg, options.is_defProfImgMissing(), false));
+            loaded = true;
+        }
+
+        const Glib::ustring& name = isRaw ? options.defProfRaw : options.defProfImg;
+
+        if (name == DEFPROFILE_DYNAMIC) {
+            const ProfilePtr dynamic (ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData()), deleteProfile);
+            dynamic->applyTo (&params);
+            return Glib::ustring();
+        }
+
+        const ProfilePtr& profile = isRaw ? raw : img;
+
+        if (!profile) {
+            return isRaw ? "default raw processing profile not found" : "default non-raw processing profile not found";
+        }
+
+        profile->applyTo (&params);
+        return Glib::ustring();
+    }
+
+private:
+    static rtengine::procparams::PartialProfile* load (const Glib::ustring& name, bool missing, bool isRaw)
+    {
+        if (name == DEFPROFILE_DYNAMIC) {
+            return nullptr;
+        }
+
+        const Glib::ustring profPath = options.findProfilePath (name);
+
+        if (missing || profPath.empty()) {
+            return nullptr;
+        }
+
+        rtengine::procparams::PartialProfile* const profile = isRaw ? new rtengine::procparams::PartialProfile (true, true) : new rtengine::procparams::PartialProfile (true);
+
+        if (profile->load (profPath == DEFPROFILE_INTERNAL ? DEFPROFILE_INTERNAL : Glib::build_filename (profPath, Glib::path_get_basename (name) + paramFileExtension))) {
+            deleteProfile (profile);
+            return nullptr;
+        }
+
+        return profile;
+    }
+
+    bool loaded;
+    ProfilePtr raw;
+    ProfilePtr img;
+};
+
+// Output file and format of one rendition of a job
+struct OutputSpec {
+    Glib::ustring file;
+    Glib::ustring format;
+    int quality;
+    int subsampling;
+    int bits;
+    bool isFloat;
+    bool compression;
+};
+
+// Reads the output options of 'item', the members missing from 'item' are taken from 'job'.
+// Returns an empty string on success, the error message otherwise
+Glib::ustring parseOutput (const cJSON* item, const cJSON* job, const Glib::ustring& inputFile, OutputSpec& spec)
+{
+    spec.format = getString (item, "format", getString (job, "format", "jpg"));
+
+    if (spec.format != "jpg" && spec.format != "tif" && spec.format != "png") {
+        return "unsupported output format: " + spec.format;
+    }
+
+    spec.quality = getInt (item, "quality", getInt (job, "quality", 92));
+    spec.subsampling = getInt (item, "subsampling", getInt (job, "subsampling", 3));
+    spec.bits = getInt (item, "bits", getInt (job, "bits", spec.format == "tif" ? 16 : 8));
+    spec.isFloat = getBool (item, "float", getBool (job, "float", spec.bits == 32));
+    spec.compression = getBool (item, "compression", getBool (job, "compression", false));
+
+    if (spec.quality < 0 || spec.quality > 100 || spec.subsampling < 1 || spec.subsampling > 3 || (spec.bits != 8 && spec.bits != 16 && spec.bits != 32)) {
+        return "invalid output options";
+    }
+
+    spec.file = getString (item, "output");
+
+    if (spec.file.empty()) {
+        if (item != job) {
+            return "missing output file";
+        }
+
+        spec.file = removeExtension (inputFile) + "." + spec.format;
+    } else if (Glib::file_test (spec.file, Glib::FILE_TEST_IS_DIR)) {
+        spec.file = Glib::build_filename (spec.file, removeExtension (Glib::path_get_basename (inputFile)) + "." + spec.format);
+    }
+
+    if (inputFile == spec.file) {
+        return "Cannot overwrite: " + inputFile;
+    }
+
+    if (!getBool (job, "overwrite", false) && Glib::file_test (spec.file, Glib::FILE_TEST_EXISTS)) {
+        return spec.file + " already exists";
+    }
+
+    return Glib::ustring();
+}
+
+// Sets the resize, post-resize sharpening and output profile of a rendition, the other parameters are shared
+void applyRenditionParams (const cJSON* item, rtengine::procparams::ProcParams& params)
+{
+    const int width = getInt (item, "width", 0);
+    const int height = getInt (item, "height", 0);
+    const cJSON* const scale = cJSON_GetObjectItem (item, "scale");
+
+    if (width > 0 || height > 0) {
+        params.resize.enabled = true;
+        params.resize.dataspec = width > 0 && height > 0 ? 3 : (width > 0 ? 1 : 2);
+        params.resize.width = width;
+        params.resize.height = height;
+    } else if (cJSON_IsNumber (scale) && scale->valuedouble > 0.0) {
+        params.resize.enabled = true;
+        params.resize.dataspec = 0;
+        params.resize.scale = scale->valuedouble;
+    }
+
+    params.resize.enabled = getBool (item, "resize", params.resize.enabled);
+    params.prsharpening.enabled = getBool (item, "sharpen", params.prsharpening.enabled);
+    params.icm.outputProfile = getString (item, "outputProfile", params.icm.outputProfile);
+}
+
+int saveImage (rtengine::IImagefloat* image, const OutputSpec& spec)
+{
+    if (spec.format == "jpg") {
+        return image->saveAsJPEG (spec.file, spec.quality, spec.subsampling);
+    } else if (spec.format == "tif") {
+        return image->saveAsTIFF (spec.file, spec.bits, spec.isFloat, !spec.compression);
+    } else {
+        return image->saveAsPNG (spec.file, spec.bits);
+    }
+}
+
+void processJob (JobChannel& channel, const cJSON* job, DefaultProfiles& defaults)
+{
+    const Glib::ustring inputFile = getString (job, "input");
+
+    if (inputFile.empty()) {
+        sendStatus (channel, job, "error", Glib::ustring(), "missing input file");
+        return;
+    }
+
+    // Either a single output described by the job itself, or several renditions sharing the processing of the image
+    const cJSON* const renditions = cJSON_GetObjectItem (job, "renditions");
+    std::vector<const cJSON*> outputItems;
+
+    if (cJSON_IsArray (renditions)) {
+        const cJSON* rendition = nullptr;
+
+        cJSON_ArrayForEach (rendition, renditions) {
+            if (!cJSON_IsObject (rendition)) {
+                sendStatus (channel, job, "error", Glib::ustring(), "invalid rendition");
+                return;
+            }
+
+            outputItems.push_back (rendition);
+        }
+
+        if (outputItems.empty()) {
+            sendStatus (channel, job, "error", Glib::ustring(), "no rendition");
+            return;
+        }
+    } else {
+        outputItems.push_back (job);
+    }
+
+    std::vector<OutputSpec> outputs (outputItems.size());
+
+    for (size_t i = 0; i < outputItems.size(); ++i) {
+        const Glib::ustring error = parseOutput (outputItems[i], job, inputFile, outputs[i]);
+
+        if (!error.empty()) {
+            sendStatus (channel, job, "error", outputs[i].file, error);
+            return;
+        }
+    }
+
+    const Glib::ustring& outputFile = outputs.front().file;
+    const Glib::ustring ext = getExtension (inputFile).lowercase();
+    const bool isRaw = !(ext == "jpg" || ext == "jpeg" || ext == "tif" || ext == "tiff" || ext == "png");
+
+    sendStatus (channel, job, "loading", outputFile);
+
+    int errorCode = 0;
+    rtengine::InitialImage* const ii = rtengine::InitialImage::load (inputFile, isRaw, &errorCode, nullptr);
+
+    if (!ii) {
+        sendStatus (channel, job, "error", outputFile, "Error loading file: " + inputFile);
+        return;
+    }
+
+    // The profiles are always merged in this order: default, explicit profiles, sidecar. Unlike batch mode, where the sidecar
+    // is merged at the position of -s/-S among the -p options, a job can not place the sidecar between its profiles
+    rtengine::procparams::ProcParams params;
+
+    if (getBool (job, "default", false)) {
+        const Glib::ustring error = defaults.applyTo (params, ii, isRaw);
+
+        if (!error.empty()) {
+            ii->decreaseRef();
+            sendStatus (channel, job, "error", outputFile, error);
+            return;
+        }
+    }
+
+    const cJSON* const profiles = cJSON_GetObjectItem (job, "profiles");
+    const cJSON* profile = nullptr;
+
+    cJSON_ArrayForEach (profile, profiles) {
+        if (!cJSON_IsString (profile) || params.load (profile->valuestring)) {
+            ii->decreaseRef();
+            sendStatus (channel, job, "error", outputFile, Glib::ustring ("processing profile not found: ") + (cJSON_IsString (profile) ? profile->valuestring : ""));
+            return;
+        }
+    }
+
+    if (getBool (job, "sidecar", false)) {
+        const Glib::ustring sidecar = inputFile + paramFileExtension;
+
+        if (!Glib::file_test (sidecar, Glib::FILE_TEST_EXISTS) || params.load (sidecar)) {
+            ii->decreaseRef();
+            sendStatus (channel, job, "error", outputFile, "no sidecar procparams found for: " + inputFile);
+            return;
+        }
+    }
+
+    sendStatus (channel, job, "processing", outputFile);
+
+    std::vector<rtengine::IImagefloat*> resultImages;
+
+    if (outputItems.front() == job) {
+        rtengine::ProcessingJob* const processingJob = rtengine::ProcessingJob::create (ii, params, getBool (job, "fast", false));
+        rtengine::IImagefloat* const resultImage = rtengine::processImage (processingJob, errorCode, nullptr);
+
+        if (resultImage) {
+            resultImages.push_back (resultImage);
+        }
+    } else {
+        std::vector<rtengine::procparams::ProcParams> renditionParams (outputItems.size(), params);
+
+        for (size_t i = 0; i < outputItems.size(); ++i) {
+            applyRenditionParams (outputItems[i], renditionParams[i]);
+        }
+
+        rtengine::ProcessingJob* const processingJob = rtengine::ProcessingJob::create (ii, params);
+        resultImages = rtengine::processImageRenditions (processingJob, renditionParams, errorCode, nullptr);
+    }
+
+    if (resultImages.size() != outputs.size()) {
+        for (auto resultImage : resultImages) {
+            resultImage->free();
+        }
+
+        ii->decreaseRef();
+        sendStatus (channel, job, "error", outputFile, "Error processing: " + inputFile);
+        return;
+    }
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        sendStatus (channel, job, "saving", outputs[i].file);
+
+        errorCode = saveImage (resultImages[i], outputs[i]);
+        resultImages[i]->free();
+
+        if (errorCode) {
+            sendStatus (channel, job, "error", outputs[i].file, "Error saving to: " + outputs[i].file);
+        } else {
+            sendStatus (channel, job, "done", outputs[i].file);
+        }
+    }
+
+    ii->decreaseRef();
+}
+
+// Returns false when the worker has been asked to quit
+bool serve (JobChannel& channel, DefaultProfiles& defaults)
+{
+    sendStatus (channel, nullptr, "ready");
+
+    std::string line;
+
+    while (channel.readLine (line)) {
+        if (line.find_first_not_of (" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        cJSON* const job = cJSON_Parse (line.c_str());
+
+        if (!cJSON_IsObject (job)) {
+            cJSON_Delete (job);
+            sendStatus (channel, nullptr, "error", Glib::ustring(), "invalid job: " + line);
+            continue;
+        }
+
+        if (getString (job, "command") == "quit") {
+            sendStatus (channel, job, "done");
+            cJSON_Delete (job);
+            return false;
+        }
+
+        processJob (channel, job, defaults);
+        cJSON_Delete (job);
+    }
+
+    return true;
+}
+
+#ifndef WIN32
+// Removes the socket left by a previous worker. Returns false if the path is taken by something else than a socket.
+bool removeSocket (const Glib::ustring& socketPath)
+{
+    GStatBuf stat;
+
+    if (g_lstat (socketPath.c_str(), &stat)) {
+        return errno == ENOENT;
+    }
+
+    return S_ISSOCK (stat.st_mode) && !g_remove (socketPath.c_str());
+}
+#endif
+
+}
+
+int runCliWorker (const Glib::ustring& socketPath)
+{
+    DefaultProfiles defaults;
+
+    if (socketPath.empty()) {
+        FILE* out = stdout;
+
+#ifndef WIN32
+        // The responses get the real stdout, the messages printed by the engine are redirected to stderr
+        const int responseFd = dup (fileno (stdout));
+
+        if (responseFd >= 0) {
+            fflush (stdout);
+            dup2 (fileno (stderr), fileno (stdout));
+            out = fdopen (responseFd, "w");
+        }
+#endif
+
+        JobChannel channel (stdin, out, false);
+        serve (channel, defaults);
+        return 0;
+    }
+
+#ifdef WIN32
+    std::cerr << "Error: the worker socket is not supported on this platform, use -w instead." << std::endl;
+    return -2;
+#else
+    sockaddr_un address;
+    std::memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.bytes() >= sizeof (address.sun_path)) {
+        std::cerr << "Error: socket path too long: " << socketPath << std::endl;
+        return -2;
+    }
+
+    std::strncpy (address.sun_path, socketPath.c_str(), sizeof (address.sun_path) - 1);
+
+    const int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0) {
+        std::cerr << "Error: cannot create the worker socket." << std::endl;
+        return -2;
+    }
+
+    if (!removeSocket (socketPath)) {
+        std::cerr << "Error: " << socketPath << " exists and is not a socket." << std::endl;
+        close (listener);
+        return -2;
+    }
+
+    if (bind (listener, reinterpret_cast<sockaddr*> (&address), sizeof (address)) || listen (listener, 8)) {
+        std::cerr << "Error: cannot listen to " << socketPath << std::endl;
+        close (listener);
+        return -2;
+    }
+
+    // A client disconnecting while we answer must not kill the worker
+    std::signal (SIGPIPE, SIG_IGN);
+
+    std::cout << "Waiting for jobs on " << socketPath << std::endl;
+
+    bool running = true;
+    int result = 0;
+
+    while (running) {
+        const int client = accept (listener, nullptr, nullptr);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // out of descriptors or memory, wait for the resources to be released instead of spinning
+                sleep (1);
+                continue;
+            }
+
+            std::cerr << "Error: cannot accept the connections to " << socketPath << std::endl;
+            result = -2;
+            break;
+        }
+
+        // Clients are served one after another, each one can send as many jobs as it wants
+        const int clientOut = dup (client);
+        FILE* const in = fdopen (client, "r");
+        FILE* const out = clientOut >= 0 ? fdopen (clientOut, "w") : nullptr;
+
+        if (!in || !out) {
+            if (in) {
+                fclose (in);
+            } else {
+                close (client);
+            }
+
+            if (out) {
+                fclose (out);
+            } else if (clientOut >= 0) {
+                close (clientOut);
+            }
+
+            continue;
+        }
+
+        JobChannel channel (in, out, true);
+        running = serve (channel, defaults);
+    }
+
+    close (listener);
+    removeSocket (socketPath);
+
+    return result;
+#endif
+}
@@ -0,0 +1,42 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glibmm/ustring.h>
+
+/* Persistent worker mode of rawtherapee-cli (-w and -W options).
+ *
+ * The engine is initialized once, then jobs are read as JSON objects, one per line, e.g.:
+ *   {"id": "1", "input": "/in/a.nef", "output": "/out/a.jpg", "profiles": ["/p/base.pp3"], "format": "jpg", "quality": 90}
+ * Optional members: "sidecar", "default", "fast", "overwrite" (booleans), "format" ("jpg", "tif" or "png"),
+ * "quality" and "subsampling" (JPEG), "bits" and "float" (TIFF/PNG bit depth), "compression" (TIFF deflate).
+ * The processing parameters are merged in a fixed order: the default profile ("default"), the "profiles" in array order,
+ * then the sidecar file ("sidecar").
+ * A job may also carry a "renditions" array instead of a single output: the image is then decoded and processed once,
+ * and each rendition object gets its own "output" file and output options (same members as above), plus "width" and/or
+ * "height" (fit in a box when both are given) or "scale", "resize" and "sharpen" (booleans, post-resize sharpening)
+ * and "outputProfile".
+ * {"command": "quit"} stops the worker.
+ *
+ * For each job, status lines are sent back as JSON objects:
+ *   {"id": "1", "status": "loading"|"processing"|"saving"|"done"|"error", "output": "...", "message": "..."}
+ * A {"status": "ready"} line is sent when the worker accepts jobs. The caches of the engine (CLUTs, LCP and ICC
+ * profiles, camera constants, lensfun database) stay warm between jobs.
+ *
+ * @param socketPath path of the Unix domain socket to listen to, or empty to read the jobs from stdin
+ * @return 0 when the worker has been stopped normally, -2 on error */
+int runCliWorker (const Glib::ustring& socketPath);
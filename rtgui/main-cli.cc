@@ -26,11 +26,20 @@
 #include "config.h"
 #include <gtkmm.h>
 #include <giomm.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <vector>
 #include <tiffio.h>
 #include <cstring>
 #include <cstdlib>
 #include <locale.h>
+#include "../rtengine/instrumentation.h"
+#include "../rtengine/noncopyable.h"
 #include "../rtengine/procparams.h"
 #include "../rtengine/profilestore.h"
 #include "../rtengine/rtengine.h"
@@ -40,6 +49,7 @@
 #include "version.h"
 #include "extprog.h"
 #include "pathutils.h"
+#include "cliworker.h"
 
 #ifndef WIN32
 #include <glibmm/fileutils.h>
@@ -88,6 +98,268 @@ Glib::ustring fname_to_utf8 (const char* fname)
 
 bool fast_export = false;
 
+/* State of one input file on its way through the prepare, load, process and save stages.
+ * In pipelined mode the messages are collected per file and printed in input order
+ * once the file is done, so the console output looks the same as in sequential mode. */
+struct ConversionTask :
+    public rtengine::NonCopyable
+{
+    ConversionTask (const Glib::ustring& fname, bool buffered) :
+        inputFile (fname),
+        ii (nullptr),
+        job (nullptr),
+        resultImage (nullptr),
+        footprint (0),
+        isRaw (true),
+        failed (false),
+        retired (false),
+        out (buffered ? &outBuffer : &std::cout),
+        err (buffered ? &errBuffer : &std::cerr)
+    {
+    }
+
+    ~ConversionTask ()
+    {
+        release();
+    }
+
+    void release ()
+    {
+        if (job) {
+            rtengine::ProcessingJob::destroy (job);
+            job = nullptr;
+        }
+
+        if (ii) {
+            ii->decreaseRef();
+            ii = nullptr;
+        }
+
+        if (resultImage) {
+            resultImage->free();
+            resultImage = nullptr;
+        }
+    }
+
+    void flushLog ()
+    {
+        std::cout << outBuffer.str() << std::flush;
+        std::cerr << errBuffer.str() << std::flush;
+    }
+
+    Glib::ustring inputFile;
+    Glib::ustring outputFile;
+    // Has to be instanciated for each file to have a ProcParams object with default values
+    rtengine::procparams::ProcParams params;
+    rtengine::InitialImage* ii;
+    rtengine::ProcessingJob* job;
+    rtengine::IImagefloat* resultImage;
+    std::size_t footprint;
+    bool isRaw;
+    bool failed;
+    bool retired;
+    std::ostringstream outBuffer;
+    std::ostringstream errBuffer;
+    std::ostream* out;
+    std::ostream* err;
+};
+
+// A stage returns false when the file has to leave the pipeline, either skipped or failed
+using ConversionStage = std::function<bool (ConversionTask&)>;
+
+/* Runs the load, process and save stages of consecutive files concurrently (-J option).
+ * Loading and saving are mostly single threaded, so they are run in their own threads
+ * while the (OpenMP parallelized) processing of the previous file goes on in the calling thread.
+ * At most 'maxInFlight' files are loaded at once and, if 'memoryBudget' is not 0, a new file
+ * is only loaded when its footprint, estimated by the prepare stage from the header of the file,
+ * fits in the budget left by the files in flight. */
+class ConversionPipeline :
+    public rtengine::NonCopyable
+{
+public:
+    ConversionPipeline (const std::vector<Glib::ustring>& inputFiles, const ConversionStage& prepare, const ConversionStage& load, const ConversionStage& process, const ConversionStage& save, unsigned int maxInFlight, std::size_t memoryBudget) :
+        prepare (prepare),
+        load (load),
+        process (process),
+        save (save),
+        maxInFlight (std::max (maxInFlight, 1u)),
+        memoryBudget (memoryBudget),
+        inFlight (0),
+        memoryInUse (0),
+        nextToFlush (0),
+        failures (0)
+    {
+        for (const auto& fname : inputFiles) {
+            tasks.emplace_back (new ConversionTask (fname, true));
+        }
+    }
+
+    // Returns the number of files which failed
+    unsigned int run ()
+    {
+        Glib::Threads::Thread* loader = Glib::Threads::Thread::create (sigc::mem_fun (*this, &ConversionPipeline::loadThread));
+        Glib::Threads::Thread* saver = Glib::Threads::Thread::create (sigc::mem_fun (*this, &ConversionPipeline::saveThread));
+
+        processLoop();
+
+        loader->join();
+        saver->join();
+
+        return failures;
+    }
+
+private:
+    bool canAdmit (std::size_t footprint) const
+    {
+        if (inFlight == 0) {
+            // always accept at least one file, whatever its size
+            return true;
+        }
+
+        return inFlight < maxInFlight && (memoryBudget == 0 || memoryInUse + footprint <= memoryBudget);
+    }
+
+    // The prepare stage only sees the files already saved, so the output names are reserved until the end of the run:
+    // a file whose output name is the one of a previous file (e.g. same -o file, or a.cr2 and a.jpg) is skipped
+    // instead of overwriting it, even with -Y
+    bool reserveOutputFile (ConversionTask& task)
+    {
+        if (!reservedOutputFiles.insert (task.outputFile).second) {
+            *task.err << task.outputFile << " is already the output of a previous image. This image has been skipped." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void loadThread ()
+    {
+        for (const auto& task : tasks) {
+            if (!prepare (*task) || !reserveOutputFile (*task)) {
+                // nothing has been reserved for the skipped file
+                task->footprint = 0;
+
+                {
+                    Glib::Threads::Mutex::Lock lock (mutex);
+                    ++inFlight;
+                }
+
+                retire (*task);
+                continue;
+            }
+
+            // the estimation is reserved until the file is loaded, then replaced by the footprint computed by the load stage
+            const std::size_t estimation = task->footprint;
+
+            {
+                Glib::Threads::Mutex::Lock lock (mutex);
+
+                while (!canAdmit (estimation)) {
+                    cond.wait (mutex);
+                }
+
+                ++inFlight;
+                memoryInUse += estimation;
+            }
+
+            if (load (*task)) {
+                Glib::Threads::Mutex::Lock lock (mutex);
+                memoryInUse = memoryInUse - estimation + task->footprint;
+                toProcess.push_back (task.get());
+                cond.broadcast();
+            } else {
+                retire (*task);
+            }
+        }
+
+        Glib::Threads::Mutex::Lock lock (mutex);
+        toProcess.push_back (nullptr);
+        cond.broadcast();
+    }
+
+    void processLoop ()
+    {
+        while (ConversionTask* task = pop (toProcess)) {
+            if (process (*task)) {
+                Glib::Threads::Mutex::Lock lock (mutex);
+                toSave.push_back (task);
+                cond.broadcast();
+            } else {
+                retire (*task);
+            }
+        }
+
+        Glib::Threads::Mutex::Lock lock (mutex);
+        toSave.push_back (nullptr);
+        cond.broadcast();
+    }
+
+    void saveThread ()
+    {
+        while (ConversionTask* task = pop (toSave)) {
+            save (*task);
+            retire (*task);
+        }
+    }
+
+    // Waits for the next file of the queue, nullptr meaning that the previous stage is done
+    ConversionTask* pop (std::deque<ConversionTask*>& queue)
+    {
+        Glib::Threads::Mutex::Lock lock (mutex);
+
+        while (queue.empty()) {
+            cond.wait (mutex);
+        }
+
+        ConversionTask* task = queue.front();
+        queue.pop_front();
+        return task;
+    }
+
+    // Frees the file's memory, then prints the messages of all files which are done, in input order
+    void retire (ConversionTask& task)
+    {
+        task.release();
+
+        Glib::Threads::Mutex::Lock lock (mutex);
+        memoryInUse -= task.footprint;
+        --inFlight;
+        task.retired = true;
+
+        while (nextToFlush < tasks.size() && tasks[nextToFlush]->retired) {
+            tasks[nextToFlush]->flushLog();
+
+            if (tasks[nextToFlush]->failed) {
+                ++failures;
+            }
+
+            tasks[nextToFlush].reset();
+            ++nextToFlush;
+        }
+
+        cond.broadcast();
+    }
+
+    const ConversionStage& prepare;
+    const ConversionStage& load;
+    const ConversionStage& process;
+    const ConversionStage& save;
+    const unsigned int maxInFlight;
+    const std::size_t memoryBudget;
+
+    std::vector<std::unique_ptr<ConversionTask>> tasks;
+    std::deque<ConversionTask*> toProcess;
+    std::deque<ConversionTask*> toSave;
+    std::set<Glib::ustring> reservedOutputFiles; // only used by the load thread
+
+    Glib::Threads::Mutex mutex;
+    Glib::Threads::Cond cond;
+    unsigned int inFlight;
+    std::size_t memoryInUse;
+    std::size_t nextToFlush;
+    unsigned int failures;
+};
+
 }
 
 /* Process line command options
@@ -217,6 +489,7 @@ int main (int argc, char **argv)
 
     if (argc > 1) {
         ret = processLineParams (argc, argv);
+        rtengine::instrumentation::stop ();
     } else {
         std::cout << "Terminating without anything to do." << std::endl;
     }
@@ -272,6 +545,10 @@ int processLineParams ( int argc, char **argv )
     bool isFloat = false;
     std::string outputType;
     unsigned errors = 0;
+    unsigned int jobsInFlight = 0;
+    std::size_t memoryBudget = 0;
+    bool workerMode = false;
+    Glib::ustring workerSocket;
 
     for ( int iArg = 1; iArg < argc; iArg++) {
         Glib::ustring currParam (argv[iArg]);
@@ -432,6 +709,111 @@ int processLineParams ( int argc, char **argv )
                     fast_export = true;
                     break;
 
+                case 'J': {
+                    // pipelined conversion, optionally followed by the maximum number of images in flight
+                    const int value = currParam.size() < 3 ? 3 : atoi (currParam.substr (2).c_str());
+
+                    if (value < 1 || value > 64) {
+                        std::cerr << "Error: the value accompanying the -J switch has to be in the [1-64] range!" << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    jobsInFlight = value;
+                    break;
+                }
+
+                case 'W': // worker listening to a Unix domain socket
+                    if (iArg + 1 < argc) {
+                        iArg++;
+                        workerSocket = fname_to_utf8 (argv[iArg]);
+                    } else {
+                        std::cerr << "Error: socket path missing next to the -W switch." << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                // fall through, -W is -w with a socket instead of stdin
+
+                case 'w': // worker reading the jobs from stdin
+                    workerMode = true;
+                    break;
+
+                case 'T': // trace of the processing stages
+                    if (iArg + 1 < argc) {
+                        iArg++;
+
+                        if (!rtengine::instrumentation::start (fname_to_utf8 (argv[iArg]))) {
+                            std::cerr << "Error: the trace file \"" << fname_to_utf8 (argv[iArg]) << "\" can't be created." << std::endl;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+                    } else {
+                        std::cerr << "Error: file name missing next to the -T switch." << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    break;
+
+                case 'C': // measure the chunk sizes of the tiled kernels on this machine
+                    if (iArg + 1 < argc) {
+                        iArg++;
+                        const Glib::ustring fname = fname_to_utf8 (argv[iArg]);
+                        rtengine::ChunkSizes chunkSizes = {options.chunkSizeAMAZE, options.chunkSizeCA, options.chunkSizeRCD, options.chunkSizeRGB, options.chunkSizeXT};
+
+                        std::cout << "Measuring the chunk sizes on \"" << fname << "\", this may take a few minutes..." << std::endl;
+
+                        if (!rtengine::tuneChunkSizes (fname, chunkSizes)) {
+                            std::cerr << "Error: the chunk sizes can't be measured on \"" << fname << "\", a Bayer or X-Trans raw file is required." << std::endl;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+
+                        options.chunkSizeAMAZE = chunkSizes.amaze;
+                        options.chunkSizeCA = chunkSizes.ca;
+                        options.chunkSizeRCD = chunkSizes.rcd;
+                        options.chunkSizeRGB = chunkSizes.rgb;
+                        options.chunkSizeXT = chunkSizes.xt;
+                        options.saveTunedChunkSizes ();
+
+                        std::cout << "Chunk sizes: AMaZE " << chunkSizes.amaze << ", CA correction " << chunkSizes.ca << ", RCD " << chunkSizes.rcd
+                                  << ", RGB processing " << chunkSizes.rgb << ", X-Trans " << chunkSizes.xt << std::endl;
+                        std::cout << "Saved in " << Glib::build_filename (options.rtdir, "chunksizes") << std::endl;
+                        deleteProcParams (processingParams);
+                        return 0;
+                    } else {
+                        std::cerr << "Error: raw file name missing next to the -C switch." << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                case 'M': {
+                    const int value = currParam.size() < 3 ? -1 : atoi (currParam.substr (2).c_str());
+
+                    if (value < 1) {
+                        std::cerr << "Error: the -M switch requires a memory budget in MiB greater than 0!" << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    memoryBudget = static_cast<std::size_t> (value) << 20;
+                    break;
+                }
+
+                case 'm': {
+                    const int value = currParam.size() < 3 ? -1 : atoi (currParam.substr (2).c_str());
+
+                    if (value < 1) {
+                        std::cerr << "Error: the -m switch requires a memory budget in MiB greater than 0!" << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    options.exportMemoryBudget = value;
+                    break;
+                }
+
                 case 'c': // MUST be last option
                     while (iArg + 1 < argc) {
                         iArg++;
@@ -536,9 +918,11 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "Usage:" << std::endl;
                     std::cout << "  " << Glib::path_get_basename (argv[0]) << " -c <dir>|<files>   Convert files in batch with default parameters." << std::endl;
                     std::cout << "  " << Glib::path_get_basename (argv[0]) << " <other options> -c <dir>|<files>   Convert files in batch with your own settings." << std::endl;
+                    std::cout << "  " << Glib::path_get_basename (argv[0]) << " [-q] -w|-W <socket>   Run as a persistent worker processing JSON jobs." << std::endl;
+                    std::cout << "  " << Glib::path_get_basename (argv[0]) << " [-q] -C <raw file>   Measure and store the chunk sizes of the tiled kernels." << std::endl;
                     std::cout << std::endl;
                     std::cout << "Options:" << std::endl;
-                    std::cout << "  " << Glib::path_get_basename (argv[0]) << "[-o <output>|-O <output>] [-q] [-a] [-s|-S] [-p <one.pp3> [-p <two.pp3> ...] ] [-d] [ -j[1-100] -js<1-3> | -t[z] -b<8|16|16f|32> | -n -b<8|16> ] [-Y] [-f] -c <input>" << std::endl;
+                    std::cout << "  " << Glib::path_get_basename (argv[0]) << "[-o <output>|-O <output>] [-q] [-a] [-s|-S] [-p <one.pp3> [-p <two.pp3> ...] ] [-d] [ -j[1-100] -js<1-3> | -t[z] -b<8|16|16f|32> | -n -b<8|16> ] [-Y] [-f] [-J[1-64] [-M<MiB>] ] -c <input>" << std::endl;
                     std::cout << std::endl;
                     std::cout << "  -c <files>       Specify one or more input files or folders." << std::endl;
                     std::cout << "                   When specifying folders, Rawtherapee will look for image file types which comply" << std::endl;
@@ -580,6 +964,24 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "                   Compression is hard-coded to PNG_FILTER_PAETH, Z_RLE." << std::endl;
                     std::cout << "  -Y               Overwrite output if present." << std::endl;
                     std::cout << "  -f               Use the custom fast-export processing pipeline." << std::endl;
+                    std::cout << "  -J[1-64]         Pipelined conversion: load, process and save consecutive images concurrently." << std::endl;
+                    std::cout << "                   Optionally, specify the maximum number of images in flight (default value: 3)." << std::endl;
+                    std::cout << "  -M<MiB>          Memory budget for -J, in MiB. A new image is only loaded when its estimated" << std::endl;
+                    std::cout << "                   memory footprint fits in the budget left by the images in flight." << std::endl;
+                    std::cout << "  -m<MiB>          Memory budget per image, in MiB. When an image does not fit, the last processing" << std::endl;
+                    std::cout << "                   steps run on horizontal strips (if all the enabled tools allow it)." << std::endl;
+                    std::cout << "  -w               Worker mode: initialize once, then read jobs from stdin as JSON objects, one per line," << std::endl;
+                    std::cout << "                   e.g. {\"id\": \"1\", \"input\": \"a.raw\", \"output\": \"a.jpg\", \"profiles\": [\"a.pp3\"]}" << std::endl;
+                    std::cout << "                   Optional members: format (jpg|tif|png), quality, subsampling, bits, float, compression," << std::endl;
+                    std::cout << "                   sidecar, default, fast, overwrite. {\"command\": \"quit\"} stops the worker." << std::endl;
+                    std::cout << "                   The default profile, the profiles and the sidecar file are merged in this order." << std::endl;
+                    std::cout << "                   The job status is written to stdout as JSON lines." << std::endl;
+                    std::cout << "  -W <socket>      Like -w, but read the jobs from the given Unix domain socket." << std::endl;
+                    std::cout << "  -T <file>        Record the wall time, CPU time and peak image memory of each processing stage." << std::endl;
+                    std::cout << "                   JSON lines if the file name ends with .jsonl, Chrome trace format otherwise." << std::endl;
+                    std::cout << "  -C <raw file>    Measure the fastest chunk sizes of the tiled kernels on this machine with the given" << std::endl;
+                    std::cout << "                   raw file, then exit. They are used by RawTherapee and " << Glib::path_get_basename (argv[0]) << " afterwards," << std::endl;
+                    std::cout << "                   until they are changed in Preferences > Performance." << std::endl;
                     std::cout << std::endl;
                     std::cout << "Your " << pparamsExt << " files can be incomplete, RawTherapee will build the final values as follows:" << std::endl;
                     std::cout << "  1- A new processing profile is created using neutral values," << std::endl;
@@ -642,6 +1044,17 @@ int processLineParams ( int argc, char **argv )
         return 1;
     }
 
+    if (memoryBudget > 0 && jobsInFlight == 0) {
+        std::cerr << "Error: the -M switch only applies to pipelined conversions, it has to be used with -J." << std::endl;
+        deleteProcParams (processingParams);
+        return -3;
+    }
+
+    if (workerMode) {
+        deleteProcParams (processingParams);
+        return runCliWorker (workerSocket);
+    }
+
     if ( inputFiles.empty() ) {
         return 2;
     }
@@ -672,89 +1085,46 @@ int processLineParams ( int argc, char **argv )
         }
     }
 
-    for ( size_t iFile = 0; iFile < inputFiles.size(); iFile++) {
-
-        // Has to be reinstanciated at each profile to have a ProcParams object with default values
-        rtengine::procparams::ProcParams currentParams;
-
-        Glib::ustring inputFile = inputFiles[iFile];
-        std::cout << "Output is " << bits << "-bit " << (isFloat ? "floating-point" : "integer") << "." << std::endl;
-        std::cout << "Processing: " << inputFile << std::endl;
-
-        rtengine::InitialImage* ii = nullptr;
-        rtengine::ProcessingJob* job = nullptr;
-        int errorCode;
-        bool isRaw = false;
-
-        Glib::ustring outputFile;
-
-        if ( outputType.empty() ) {
-            outputType = "jpg";
-        }
-
-        if ( outputPath.empty() ) {
-            Glib::ustring s = inputFile;
-            Glib::ustring::size_type ext = s.find_last_of ('.');
-            outputFile = s.substr (0, ext) + "." + outputType;
-        } else if ( outputDirectory ) {
-            Glib::ustring s = Glib::path_get_basename ( inputFile );
-            Glib::ustring::size_type ext = s.find_last_of ('.');
-            outputFile = Glib::build_filename (outputPath, s.substr (0, ext) + "." + outputType);
-        } else {
-            if (leaveUntouched) {
-                outputFile = outputPath;
-            } else {
-                Glib::ustring s = outputPath;
-                Glib::ustring::size_type ext = s.find_last_of ('.');
-                outputFile = s.substr (0, ext) + "." + outputType;
-            }
-        }
-
-        if ( inputFile == outputFile) {
-            std::cerr << "Cannot overwrite: " << inputFile << std::endl;
-            continue;
-        }
-
-        if ( !overwriteFiles && Glib::file_test ( outputFile, Glib::FILE_TEST_EXISTS ) ) {
-            std::cerr << outputFile  << " already exists: use -Y option to overwrite. This image has been skipped." << std::endl;
-            continue;
-        }
-
-        // Load the image
-        isRaw = true;
-        Glib::ustring ext = getExtension (inputFile);
-
-        if (ext.lowercase() == "jpg" || ext.lowercase() == "jpeg" || ext.lowercase() == "tif" || ext.lowercase() == "tiff" || ext.lowercase() == "png") {
-            isRaw = false;
-        }
+    if ( outputType.empty() ) {
+        outputType = "jpg";
+    }
 
-        ii = rtengine::InitialImage::load ( inputFile, isRaw, &errorCode, nullptr );
-
-        if (!ii) {
-            errors++;
-            std::cerr << "Error loading file: " << inputFile << std::endl;
-            continue;
-        }
+    // Merges the default profile, the sidecar file and the -p profiles into 'currentParams'. Without metadata, a dynamic default profile
+    // can not be resolved and is skipped. Returns false if the sidecar file is required but missing.
+    const auto mergeProfiles = [&] (const ConversionTask & task, const rtengine::FramesMetaData* metaData, rtengine::procparams::ProcParams & currentParams, bool verbose) -> bool {
+        const Glib::ustring& inputFile = task.inputFile;
+        std::ostream& out = *task.out;
+        std::ostream& err = *task.err;
 
         if (useDefault) {
-            if (isRaw) {
-                if (options.defProfRaw == DEFPROFILE_DYNAMIC) {
+            if (task.isRaw) {
+                if (options.defProfRaw == DEFPROFILE_DYNAMIC && metaData) {
                     rawParams->deleteInstance();
                     delete rawParams;
-                    rawParams = ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData());
+                    rawParams = ProfileStore::getInstance()->loadDynamicProfile (metaData);
                 }
 
-                std::cout << "  Merging default raw processing profile." << std::endl;
-                rawParams->applyTo (&currentParams);
+                if (options.defProfRaw != DEFPROFILE_DYNAMIC || metaData) {
+                    if (verbose) {
+                        out << "  Merging default raw processing profile." << std::endl;
+                    }
+
+                    rawParams->applyTo (&currentParams);
+                }
             } else {
-                if (options.defProfImg == DEFPROFILE_DYNAMIC) {
+                if (options.defProfImg == DEFPROFILE_DYNAMIC && metaData) {
                     imgParams->deleteInstance();
                     delete imgParams;
-                    imgParams = ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData());
+                    imgParams = ProfileStore::getInstance()->loadDynamicProfile (metaData);
                 }
 
-                std::cout << "  Merging default non-raw processing profile." << std::endl;
-                imgParams->applyTo (&currentParams);
+                if (options.defProfImg != DEFPROFILE_DYNAMIC || metaData) {
+                    if (verbose) {
+                        out << "  Merging default non-raw processing profile." << std::endl;
+                    }
+
+                    imgParams->applyTo (&currentParams);
+                }
             }
         }
 
@@ -769,70 +1139,195 @@ int processLineParams ( int argc, char **argv )
 
                 // the "load" method don't reset the procparams values anymore, so values found in the procparam file override the one of currentParams
                 if ( !Glib::file_test ( sideProcessingParams, Glib::FILE_TEST_EXISTS ) || currentParams.load ( sideProcessingParams )) {
-                    std::cerr << "Warning: sidecar file requested but not found for: " << sideProcessingParams << std::endl;
+                    if (verbose) {
+                        err << "Warning: sidecar file requested but not found for: " << sideProcessingParams << std::endl;
+                    }
                 } else {
                     sideCarFound = true;
-                    std::cout << "  Merging sidecar procparams." << std::endl;
+
+                    if (verbose) {
+                        out << "  Merging sidecar procparams." << std::endl;
+                    }
                 }
             }
 
             if ( processingParams.size() > i  ) {
-                std::cout << "  Merging procparams #" << i << std::endl;
+                if (verbose) {
+                    out << "  Merging procparams #" << i << std::endl;
+                }
+
                 processingParams[i]->applyTo (&currentParams);
             }
 
             i++;
         } while (i < processingParams.size() + (sideProcParams ? 1 : 0));
 
-        if ( sideProcParams && !sideCarFound && skipIfNoSidecar ) {
+        return !sideProcParams || sideCarFound || !skipIfNoSidecar;
+    };
+
+    // Checks the output file and estimates the memory footprint of the image from the header of the file, before the image is decoded.
+    // Returns false if the image has to be skipped.
+    const ConversionStage prepareStage = [&] (ConversionTask & task) -> bool {
+        const Glib::ustring& inputFile = task.inputFile;
+        std::ostream& out = *task.out;
+        std::ostream& err = *task.err;
+
+        out << "Output is " << bits << "-bit " << (isFloat ? "floating-point" : "integer") << "." << std::endl;
+        out << "Processing: " << inputFile << std::endl;
+
+        if ( outputPath.empty() ) {
+            Glib::ustring s = inputFile;
+            Glib::ustring::size_type ext = s.find_last_of ('.');
+            task.outputFile = s.substr (0, ext) + "." + outputType;
+        } else if ( outputDirectory ) {
+            Glib::ustring s = Glib::path_get_basename ( inputFile );
+            Glib::ustring::size_type ext = s.find_last_of ('.');
+            task.outputFile = Glib::build_filename (outputPath, s.substr (0, ext) + "." + outputType);
+        } else {
+            if (leaveUntouched) {
+                task.outputFile = outputPath;
+            } else {
+                Glib::ustring s = outputPath;
+                Glib::ustring::size_type ext = s.find_last_of ('.');
+                task.outputFile = s.substr (0, ext) + "." + outputType;
+            }
+        }
+
+        if ( inputFile == task.outputFile) {
+            err << "Cannot overwrite: " << inputFile << std::endl;
+            return false;
+        }
+
+        if ( !overwriteFiles && Glib::file_test ( task.outputFile, Glib::FILE_TEST_EXISTS ) ) {
+            err << task.outputFile  << " already exists: use -Y option to overwrite. This image has been skipped." << std::endl;
+            return false;
+        }
+
+        Glib::ustring ext = getExtension (inputFile);
+        task.isRaw = !(ext.lowercase() == "jpg" || ext.lowercase() == "jpeg" || ext.lowercase() == "tif" || ext.lowercase() == "tiff" || ext.lowercase() == "png");
+
+        // The estimation only matters for the memory budget of the pipelined mode. The dynamic default profile needs the metadata
+        // of the decoded image and is left out, the footprint computed by the load stage replaces the estimation anyway.
+        int fullWidth = 0, fullHeight = 0;
+
+        if (memoryBudget > 0 && rtengine::getImageSize (inputFile, task.isRaw, fullWidth, fullHeight)) {
+            rtengine::procparams::ProcParams estimationParams;
+            mergeProfiles (task, nullptr, estimationParams, false);
+            task.footprint = rtengine::estimateProcessingMemory (fullWidth, fullHeight, estimationParams);
+        }
+
+        return true;
+    };
+
+    // Loads the image and builds its processing parameters. Returns false if the image has to be skipped.
+    const ConversionStage loadStage = [&] (ConversionTask & task) -> bool {
+        const Glib::ustring& inputFile = task.inputFile;
+        std::ostream& err = *task.err;
+
+        int errorCode;
+        rtengine::InitialImage* ii = rtengine::InitialImage::load ( inputFile, task.isRaw, &errorCode, nullptr );
+
+        if (!ii) {
+            task.failed = true;
+            err << "Error loading file: " << inputFile << std::endl;
+            return false;
+        }
+
+        rtengine::procparams::ProcParams& currentParams = task.params;
+
+        if (!mergeProfiles (task, ii->getMetaData(), currentParams, true)) {
             delete ii;
-            errors++;
-            std::cerr << "Error: no sidecar procparams found for: " << inputFile << std::endl;
-            continue;
+            task.failed = true;
+            err << "Error: no sidecar procparams found for: " << inputFile << std::endl;
+            return false;
         }
 
-        job = rtengine::ProcessingJob::create (ii, currentParams, fast_export);
+        task.job = rtengine::ProcessingJob::create (ii, currentParams, fast_export);
 
-        if ( !job ) {
-            errors++;
-            std::cerr << "Error creating processing for: " << inputFile << std::endl;
+        if ( !task.job ) {
+            task.failed = true;
+            err << "Error creating processing for: " << inputFile << std::endl;
             ii->decreaseRef();
-            continue;
+            return false;
         }
 
-        // Process image
-        rtengine::IImagefloat* resultImage = rtengine::processImage (job, errorCode, nullptr);
+        int fullWidth = 0, fullHeight = 0;
+        ii->getImageSource()->getFullSize (fullWidth, fullHeight);
+        task.footprint = rtengine::estimateProcessingMemory (fullWidth, fullHeight, currentParams);
+        task.ii = ii;
 
-        if ( !resultImage ) {
-            errors++;
-            std::cerr << "Error processing: " << inputFile << std::endl;
-            rtengine::ProcessingJob::destroy ( job );
-            continue;
+        return true;
+    };
+
+    // Runs the processing pipeline. The job is consumed by rtengine::processImage.
+    const ConversionStage processStage = [&] (ConversionTask & task) -> bool {
+        int errorCode;
+        task.resultImage = rtengine::processImage (task.job, errorCode, nullptr);
+
+        if ( !task.resultImage ) {
+            task.failed = true;
+            *task.err << "Error processing: " << task.inputFile << std::endl;
+            rtengine::ProcessingJob::destroy ( task.job );
+            task.job = nullptr;
+            return false;
         }
 
-        // save image to disk
+        task.job = nullptr;
+        return true;
+    };
+
+    // Saves the result image to disk
+    const ConversionStage saveStage = [&] (ConversionTask & task) -> bool {
+        int errorCode;
+
         if ( outputType == "jpg" ) {
-            errorCode = resultImage->saveAsJPEG ( outputFile, compression, subsampling );
+            errorCode = task.resultImage->saveAsJPEG ( task.outputFile, compression, subsampling );
         } else if ( outputType == "tif" ) {
-            errorCode = resultImage->saveAsTIFF ( outputFile, bits, isFloat, compression == 0  );
+            errorCode = task.resultImage->saveAsTIFF ( task.outputFile, bits, isFloat, compression == 0  );
         } else if ( outputType == "png" ) {
-            errorCode = resultImage->saveAsPNG ( outputFile, bits );
+            errorCode = task.resultImage->saveAsPNG ( task.outputFile, bits );
         } else {
-            errorCode = resultImage->saveToFile (outputFile);
+            errorCode = task.resultImage->saveToFile (task.outputFile);
         }
 
         if (errorCode) {
-            errors++;
-            std::cerr << "Error saving to: " << outputFile << std::endl;
+            task.failed = true;
+            *task.err << "Error saving to: " << task.outputFile << std::endl;
         } else {
             if ( copyParamsFile ) {
-                Glib::ustring outputProcessingParams = outputFile + paramFileExtension;
-                currentParams.save ( outputProcessingParams );
+                Glib::ustring outputProcessingParams = task.outputFile + paramFileExtension;
+                task.params.save ( outputProcessingParams );
+            }
+        }
+
+        return !errorCode;
+    };
+
+    if (jobsInFlight == 0) {
+        for ( size_t iFile = 0; iFile < inputFiles.size(); iFile++) {
+            ConversionTask task (inputFiles[iFile], false);
+
+            if (prepareStage (task) && loadStage (task) && processStage (task)) {
+                saveStage (task);
+            }
+
+            task.release();
+
+            if (task.failed) {
+                errors++;
             }
         }
+    } else {
+        std::cout << "Converting with up to " << jobsInFlight << " images in flight";
+
+        if (memoryBudget > 0) {
+            std::cout << " and a memory budget of " << (memoryBudget >> 20) << " MiB";
+        }
+
+        std::cout << "." << std::endl;
 
-        ii->decreaseRef();
-        resultImage->free();
+        ConversionPipeline pipeline (inputFiles, prepareStage, loadStage, processStage, saveStage, jobsInFlight, memoryBudget);
+        errors += pipeline.run();
     }
 
     if (imgParams) {
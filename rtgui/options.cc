@@ -449,6 +449,8 @@ void Options::setDefaults()
     curvebboxpos = 1;
     prevdemo = PD_Sidecar;
     rgbDenoiseThreadLimit = 0;
+    rgbDenoiseMemoryBudget = 0;
+    rgbDenoiseHalfFloatWavelets = false;
 #if defined( _OPENMP ) && defined( __x86_64__ )
     clutCacheSize = omp_get_num_procs();
 #else
@@ -464,6 +466,11 @@ void Options::setDefaults()
     chunkSizeRCD = 2;
     chunkSizeRGB = 2;
     chunkSizeXT = 2;
+    untunedChunkSizes.clear();
+    compactRawFrames = true;
+    batchQueueMaxJobs = 1;
+    batchQueueMemoryBudget = 0;
+    exportMemoryBudget = 0;
     FileBrowserToolbarSingleRow = false;
     hideTPVScrollbar = false;
     whiteBalanceSpotSize = 8;
@@ -585,6 +592,7 @@ void Options::setDefaults()
     rtSettings.ACESp0 = "RTv2_ACES-AP0";
     rtSettings.ACESp1 = "RTv2_ACES-AP1";
     rtSettings.verbose = false;
+    rtSettings.traceFile = "";
     rtSettings.gamutICC = true;
     rtSettings.gamutLch = true;
     rtSettings.amchroma = 40;//between 20 and 140   low values increase effect..and also artifacts, high values reduces
@@ -1083,6 +1091,14 @@ void Options::readFromFile(Glib::ustring fname)
                     rgbDenoiseThreadLimit = keyFile.get_integer("Performance", "RgbDenoiseThreadLimit");
                 }
 
+                if (keyFile.has_key("Performance", "RgbDenoiseMemoryBudget")) {
+                    rgbDenoiseMemoryBudget = std::max(0, keyFile.get_integer("Performance", "RgbDenoiseMemoryBudget"));
+                }
+
+                if (keyFile.has_key("Performance", "RgbDenoiseHalfFloatWavelets")) {
+                    rgbDenoiseHalfFloatWavelets = keyFile.get_boolean("Performance", "RgbDenoiseHalfFloatWavelets");
+                }
+
                 if (keyFile.has_key("Performance", "ClutCacheSize")) {
                     clutCacheSize = keyFile.get_integer("Performance", "ClutCacheSize");
                 }
@@ -1107,6 +1123,9 @@ void Options::readFromFile(Glib::ustring fname)
                     measure = keyFile.get_boolean("Performance", "Measure");
                 }
 
+                // these are the chunk sizes of the option file, loadTunedChunkSizes() supersedes them again
+                untunedChunkSizes.clear();
+
                 if (keyFile.has_key("Performance", "ChunkSizeAMAZE")) {
                     chunkSizeAMAZE = std::min(16, std::max(1, keyFile.get_integer("Performance", "ChunkSizeAMAZE")));
                 }
@@ -1127,6 +1146,26 @@ void Options::readFromFile(Glib::ustring fname)
                     chunkSizeXT = std::min(16, std::max(1, keyFile.get_integer("Performance", "ChunkSizeXT")));
                 }
 
+                if (keyFile.has_key("Performance", "CompactRawFrames")) {
+                    compactRawFrames = keyFile.get_boolean("Performance", "CompactRawFrames");
+                }
+
+                if (keyFile.has_key("Performance", "BatchQueueMaxJobs")) {
+                    batchQueueMaxJobs = std::min(64, std::max(1, keyFile.get_integer("Performance", "BatchQueueMaxJobs")));
+                }
+
+                if (keyFile.has_key("Performance", "BatchQueueMemoryBudget")) {
+                    batchQueueMemoryBudget = std::max(0, keyFile.get_integer("Performance", "BatchQueueMemoryBudget"));
+                }
+
+                if (keyFile.has_key("Performance", "ExportMemoryBudget")) {
+                    exportMemoryBudget = std::max(0, keyFile.get_integer("Performance", "ExportMemoryBudget"));
+                }
+
+                if (keyFile.has_key("Performance", "TraceFile")) {
+                    rtSettings.traceFile = keyFile.get_string("Performance", "TraceFile");
+                }
+
                 if (keyFile.has_key("Performance", "ThumbnailInspectorMode")) {
                     rtSettings.thumbnail_inspector_mode = static_cast<rtengine::Settings::ThumbnailInspectorMode>(keyFile.get_integer("Performance", "ThumbnailInspectorMode"));
                 }
@@ -2026,17 +2065,26 @@ void Options::saveToFile(Glib::ustring fname)
         keyFile.set_boolean("Clipping Indication", "BlinkClipped", blinkClipped);
 
         keyFile.set_integer("Performance", "RgbDenoiseThreadLimit", rgbDenoiseThreadLimit);
+        keyFile.set_integer("Performance", "RgbDenoiseMemoryBudget", rgbDenoiseMemoryBudget);
+        keyFile.set_boolean("Performance", "RgbDenoiseHalfFloatWavelets", rgbDenoiseHalfFloatWavelets);
         keyFile.set_integer("Performance", "ClutCacheSize", clutCacheSize);
         keyFile.set_integer("Performance", "MaxInspectorBuffers", maxInspectorBuffers);
         keyFile.set_integer("Performance", "InspectorDelay", inspectorDelay);
         keyFile.set_integer("Performance", "PreviewDemosaicFromSidecar", prevdemo);
         keyFile.set_boolean("Performance", "SerializeTiffRead", serializeTiffRead);
         keyFile.set_integer("Performance", "Measure", measure);
-        keyFile.set_integer("Performance", "ChunkSizeAMAZE", chunkSizeAMAZE);
-        keyFile.set_integer("Performance", "ChunkSizeRCD", chunkSizeRCD);
-        keyFile.set_integer("Performance", "ChunkSizeRGB", chunkSizeRGB);
-        keyFile.set_integer("Performance", "ChunkSizeXT", chunkSizeXT);
-        keyFile.set_integer("Performance", "ChunkSizeCA", chunkSizeCA);
+        // the tuned chunk sizes are specific to this machine, they stay in the "chunksizes" file
+        const bool tuned = untunedChunkSizes.size() == 5;
+        keyFile.set_integer("Performance", "ChunkSizeAMAZE", tuned ? untunedChunkSizes[0] : chunkSizeAMAZE);
+        keyFile.set_integer("Performance", "ChunkSizeRCD", tuned ? untunedChunkSizes[2] : chunkSizeRCD);
+        keyFile.set_integer("Performance", "ChunkSizeRGB", tuned ? untunedChunkSizes[3] : chunkSizeRGB);
+        keyFile.set_integer("Performance", "ChunkSizeXT", tuned ? untunedChunkSizes[4] : chunkSizeXT);
+        keyFile.set_integer("Performance", "ChunkSizeCA", tuned ? untunedChunkSizes[1] : chunkSizeCA);
+        keyFile.set_boolean("Performance", "CompactRawFrames", compactRawFrames);
+        keyFile.set_integer("Performance", "BatchQueueMaxJobs", batchQueueMaxJobs);
+        keyFile.set_integer("Performance", "BatchQueueMemoryBudget", batchQueueMemoryBudget);
+        keyFile.set_integer("Performance", "ExportMemoryBudget", exportMemoryBudget);
+        keyFile.set_string("Performance", "TraceFile", rtSettings.traceFile);
         keyFile.set_integer("Performance", "ThumbnailInspectorMode", int(rtSettings.thumbnail_inspector_mode));
 
         keyFile.set_string("Output", "Format", saveFormat.format);
@@ -2405,6 +2453,9 @@ void Options::load(bool lightweight)
         }
     }
 
+    // The measured chunk sizes supersede the ones of the option files
+    options.loadTunedChunkSizes();
+
 #ifdef __APPLE__
 
     if (options.multiUser) {
@@ -2418,6 +2469,8 @@ void Options::load(bool lightweight)
         printf("Cache directory (cacheBaseDir) = %s\n", cacheBaseDir.c_str());
     }
 
+    options.rtSettings.cacheDirectory = cacheBaseDir;
+
     // Update profile's path and recreate it if necessary
     options.updatePaths();
 
@@ -2512,6 +2565,143 @@ void Options::save()
     options.saveToFile(Glib::build_filename(rtdir, "options"));
 }
 
+namespace
+{
+
+// The chunk sizes depend on the cache sizes and on the number of threads, they are stored per CPU model and thread count
+Glib::ustring getChunkSizesKey()
+{
+    Glib::ustring key;
+
+    for (const auto c : rtengine::getCPUModel()) {
+        key += g_unichar_isalnum(c) ? c : '_';
+    }
+
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+#else
+    const int threads = 1;
+#endif
+
+    return key + '_' + std::to_string(threads);
+}
+
+bool writeChunkSizes(const Glib::ustring& fname, Glib::KeyFile& keyFile)
+{
+    FILE *f = g_fopen(fname.c_str(), "wt");
+
+    if (f == nullptr) {
+        std::cout << "Warning! Unable to save the chunk sizes to: " << fname << std::endl;
+        return false;
+    }
+
+    fprintf(f, "%s", keyFile.to_data().c_str());
+    fclose(f);
+    return true;
+}
+
+}
+
+bool Options::loadTunedChunkSizes()
+{
+    const Glib::ustring fname = Glib::build_filename(rtdir, "chunksizes");
+
+    if (!Glib::file_test(fname, Glib::FILE_TEST_EXISTS)) {
+        return false;
+    }
+
+    try {
+        Glib::KeyFile keyFile;
+        keyFile.load_from_file(fname);
+        const Glib::ustring key = getChunkSizesKey();
+
+        if (!keyFile.has_key("ChunkSizes", key)) {
+            return false;
+        }
+
+        const std::vector<int> sizes = keyFile.get_integer_list("ChunkSizes", key);
+
+        if (sizes.size() != 5) {
+            return false;
+        }
+
+        if (untunedChunkSizes.empty()) {
+            untunedChunkSizes = {chunkSizeAMAZE, chunkSizeCA, chunkSizeRCD, chunkSizeRGB, chunkSizeXT};
+        }
+
+        chunkSizeAMAZE = std::min(16, std::max(1, sizes[0]));
+        chunkSizeCA = std::min(16, std::max(1, sizes[1]));
+        chunkSizeRCD = std::min(16, std::max(1, sizes[2]));
+        chunkSizeRGB = std::min(16, std::max(1, sizes[3]));
+        chunkSizeXT = std::min(16, std::max(1, sizes[4]));
+
+        if (rtSettings.verbose) {
+            printf("Using the chunk sizes tuned for %s\n", key.c_str());
+        }
+
+        return true;
+    } catch (Glib::Error &err) {
+        if (rtSettings.verbose) {
+            printf("Options::loadTunedChunkSizes / Error code %d while reading values from \"%s\":\n%s\n", err.code(), fname.c_str(), err.what().c_str());
+        }
+    }
+
+    return false;
+}
+
+void Options::saveTunedChunkSizes() const
+{
+    const Glib::ustring fname = Glib::build_filename(rtdir, "chunksizes");
+    Glib::KeyFile keyFile;
+
+    try {
+        if (Glib::file_test(fname, Glib::FILE_TEST_EXISTS)) {
+            keyFile.load_from_file(fname);
+        }
+
+        const std::vector<int> sizes = {
+            static_cast<int>(chunkSizeAMAZE),
+            static_cast<int>(chunkSizeCA),
+            static_cast<int>(chunkSizeRCD),
+            static_cast<int>(chunkSizeRGB),
+            static_cast<int>(chunkSizeXT)
+        };
+        keyFile.set_integer_list("ChunkSizes", getChunkSizesKey(), sizes);
+        writeChunkSizes(fname, keyFile);
+    } catch (Glib::Error &err) {
+        if (rtSettings.verbose) {
+            printf("Options::saveTunedChunkSizes / Error code %d while writing \"%s\":\n%s\n", err.code(), fname.c_str(), err.what().c_str());
+        }
+    }
+}
+
+void Options::forgetTunedChunkSizes()
+{
+    // the current chunk sizes are saved in the option file from now on
+    untunedChunkSizes.clear();
+
+    const Glib::ustring fname = Glib::build_filename(rtdir, "chunksizes");
+
+    if (!Glib::file_test(fname, Glib::FILE_TEST_EXISTS)) {
+        return;
+    }
+
+    try {
+        Glib::KeyFile keyFile;
+        keyFile.load_from_file(fname);
+        const Glib::ustring key = getChunkSizesKey();
+
+        if (keyFile.has_key("ChunkSizes", key)) {
+            keyFile.remove_key("ChunkSizes", key);
+            writeChunkSizes(fname, keyFile);
+        }
+    } catch (Glib::Error &err) {
+        if (rtSettings.verbose) {
+            printf("Options::forgetTunedChunkSizes / Error code %d while writing \"%s\":\n%s\n", err.code(), fname.c_str(), err.what().c_str());
+        }
+    }
+}
+
 /*
  * return true if ext is a parsed extension (retained or not)
  */
@@ -327,6 +327,8 @@ public:
     // Performance options
     Glib::ustring clutsDir;
     int rgbDenoiseThreadLimit; // maximum number of threads for the denoising tool ; 0 = use the maximum available
+    int rgbDenoiseMemoryBudget; // memory budget of the tiles of the denoising tool, in MiB ; 0 = half of the memory available to the process
+    bool rgbDenoiseHalfFloatWavelets; // store the luminance wavelet details as half floats while the chroma is denoised
     int maxInspectorBuffers;   // maximum number of buffers (i.e. images) for the Inspector feature
     int inspectorDelay;
     int clutCacheSize;
@@ -339,6 +341,13 @@ public:
     size_t chunkSizeRCD;
     size_t chunkSizeRGB;
     size_t chunkSizeXT;
+    // chunk sizes of the option file (AMaZE, CA, RCD, RGB, X-Trans) when loadTunedChunkSizes() superseded them, saved instead of
+    // the tuned ones; empty otherwise
+    std::vector<size_t> untunedChunkSizes;
+    bool compactRawFrames;      // store the pixel shift frames which are not selected as 16 bit integers
+    int batchQueueMaxJobs;      // maximum number of images processed concurrently by the batch queue
+    int batchQueueMemoryBudget; // memory budget of the concurrent batch queue jobs, in MiB ; 0 = unlimited
+    int exportMemoryBudget;     // memory budget of the last stages of an export, processed in strips above it, in MiB ; 0 = unlimited
     bool menuGroupRank;
     bool menuGroupLabel;
     bool menuGroupFileOperations;
@@ -434,6 +443,11 @@ public:
     static void load (bool lightweight = false);
     static void save();
 
+    // Chunk sizes measured by "rawtherapee-cli -C", stored in the "chunksizes" file of rtdir for each CPU model and number of threads
+    bool loadTunedChunkSizes ();
+    void saveTunedChunkSizes () const;
+    void forgetTunedChunkSizes ();
+
     // if multiUser=false, send back the global profile path
     Glib::ustring getPreferredProfilePath();
     Glib::ustring getUserProfilePath();
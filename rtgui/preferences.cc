@@ -720,10 +720,24 @@ Gtk::Widget* Preferences::getPerformancePanel ()
 #endif
 
     placeSpinBox(threadsVBox, threadsSpinBtn, "PREFERENCES_PERFORMANCE_THREADS_LABEL", 0, 1, 5, 2, 0, maxThreadNumber);
+    placeSpinBox(threadsVBox, denoiseMemoryBudgetSB, "PREFERENCES_PERFORMANCE_DENOISEBUDGET", 0, 256, 1024, 7, 0, 1048576, "PREFERENCES_PERFORMANCE_DENOISEBUDGET_TOOLTIP");
+
+    denoiseHalfFloatCB = Gtk::manage ( new Gtk::CheckButton (M ("PREFERENCES_PERFORMANCE_DENOISEHALFFLOAT")) );
+    denoiseHalfFloatCB->set_tooltip_text (M ("PREFERENCES_PERFORMANCE_DENOISEHALFFLOAT_TOOLTIP"));
+    threadsVBox->pack_start (*denoiseHalfFloatCB, Gtk::PACK_SHRINK, 0);
 
     threadsFrame->add (*threadsVBox);
 
     vbPerformance->pack_start (*threadsFrame, Gtk::PACK_SHRINK, 4);
+
+    Gtk::Frame* batchQueueFrame = Gtk::manage ( new Gtk::Frame (M ("PREFERENCES_BATCHQUEUE")) );
+    Gtk::VBox* batchQueueVBox = Gtk::manage ( new Gtk::VBox () );
+    placeSpinBox(batchQueueVBox, batchQueueMaxJobsSB, "PREFERENCES_BATCHQUEUE_MAXJOBS", 0, 1, 5, 2, 1, maxThreadNumber, "PREFERENCES_BATCHQUEUE_MAXJOBS_TOOLTIP");
+    placeSpinBox(batchQueueVBox, batchQueueMemoryBudgetSB, "PREFERENCES_BATCHQUEUE_MEMORYBUDGET", 0, 256, 1024, 7, 0, 1048576, "PREFERENCES_BATCHQUEUE_MEMORYBUDGET_TOOLTIP");
+    placeSpinBox(batchQueueVBox, exportMemoryBudgetSB, "PREFERENCES_BATCHQUEUE_EXPORTBUDGET", 0, 256, 1024, 7, 0, 1048576, "PREFERENCES_BATCHQUEUE_EXPORTBUDGET_TOOLTIP");
+    batchQueueFrame->add (*batchQueueVBox);
+
+    vbPerformance->pack_start (*batchQueueFrame, Gtk::PACK_SHRINK, 4);
     swPerformance->add(*vbPerformance);
 
     return swPerformance;
@@ -1799,14 +1813,27 @@ void Preferences::storePreferences ()
     moptions.autoSaveTpOpen = ckbAutoSaveTpOpen->get_active();
 
     moptions.rgbDenoiseThreadLimit = threadsSpinBtn->get_value_as_int();
+    moptions.rgbDenoiseMemoryBudget = denoiseMemoryBudgetSB->get_value_as_int();
+    moptions.rgbDenoiseHalfFloatWavelets = denoiseHalfFloatCB->get_active();
     moptions.clutCacheSize = clutCacheSizeSB->get_value_as_int();
     moptions.measure = measureCB->get_active();
+
+    if (chunkSizeAMSB->get_value_as_int() != static_cast<int>(moptions.chunkSizeAMAZE) || chunkSizeCASB->get_value_as_int() != static_cast<int>(moptions.chunkSizeCA)
+            || chunkSizeRCDSB->get_value_as_int() != static_cast<int>(moptions.chunkSizeRCD) || chunkSizeRGBSB->get_value_as_int() != static_cast<int>(moptions.chunkSizeRGB)
+            || chunkSizeXTSB->get_value_as_int() != static_cast<int>(moptions.chunkSizeXT)) {
+        // the values set by the user replace the measured ones
+        moptions.forgetTunedChunkSizes();
+    }
+
     moptions.chunkSizeAMAZE = chunkSizeAMSB->get_value_as_int();
     moptions.chunkSizeCA = chunkSizeCASB->get_value_as_int();
     moptions.chunkSizeRCD = chunkSizeRCDSB->get_value_as_int();
     moptions.chunkSizeRGB = chunkSizeRGBSB->get_value_as_int();
     moptions.chunkSizeXT = chunkSizeXTSB->get_value_as_int();
     moptions.maxInspectorBuffers = maxInspectorBuffersSB->get_value_as_int();
+    moptions.batchQueueMaxJobs = batchQueueMaxJobsSB->get_value_as_int();
+    moptions.batchQueueMemoryBudget = batchQueueMemoryBudgetSB->get_value_as_int();
+    moptions.exportMemoryBudget = exportMemoryBudgetSB->get_value_as_int();
     moptions.rtSettings.thumbnail_inspector_mode = static_cast<rtengine::Settings::ThumbnailInspectorMode>(thumbnailInspectorMode->get_active_row_number());
 
 // Sounds only on Windows and Linux
@@ -2011,6 +2038,8 @@ void Preferences::fillPreferences ()
     ckbAutoSaveTpOpen->set_active (moptions.autoSaveTpOpen);
 
     threadsSpinBtn->set_value (moptions.rgbDenoiseThreadLimit);
+    denoiseMemoryBudgetSB->set_value (moptions.rgbDenoiseMemoryBudget);
+    denoiseHalfFloatCB->set_active (moptions.rgbDenoiseHalfFloatWavelets);
     clutCacheSizeSB->set_value (moptions.clutCacheSize);
     measureCB->set_active (moptions.measure);
     chunkSizeAMSB->set_value (moptions.chunkSizeAMAZE);
@@ -2019,6 +2048,9 @@ void Preferences::fillPreferences ()
     chunkSizeRCDSB->set_value (moptions.chunkSizeRCD);
     chunkSizeXTSB->set_value (moptions.chunkSizeXT);
     maxInspectorBuffersSB->set_value (moptions.maxInspectorBuffers);
+    batchQueueMaxJobsSB->set_value (moptions.batchQueueMaxJobs);
+    batchQueueMemoryBudgetSB->set_value (moptions.batchQueueMemoryBudget);
+    exportMemoryBudgetSB->set_value (moptions.exportMemoryBudget);
     thumbnailInspectorMode->set_active(int(moptions.rtSettings.thumbnail_inspector_mode));
 
     darkFrameDir->set_current_folder ( moptions.rtSettings.darkFramesPath );
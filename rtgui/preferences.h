@@ -168,6 +168,8 @@ class Preferences final :
     Gtk::CheckButton* sameThumbSize;
 
     Gtk::SpinButton*  threadsSpinBtn;
+    Gtk::SpinButton*  denoiseMemoryBudgetSB;
+    Gtk::CheckButton* denoiseHalfFloatCB;
     Gtk::SpinButton*  clutCacheSizeSB;
     Gtk::CheckButton* measureCB;
     Gtk::SpinButton*  chunkSizeAMSB;
@@ -176,6 +178,9 @@ class Preferences final :
     Gtk::SpinButton*  chunkSizeRGBSB;
     Gtk::SpinButton*  chunkSizeXTSB;
     Gtk::SpinButton*  maxInspectorBuffersSB;
+    Gtk::SpinButton*  batchQueueMaxJobsSB;
+    Gtk::SpinButton*  batchQueueMemoryBudgetSB;
+    Gtk::SpinButton*  exportMemoryBudgetSB;
     Gtk::ComboBoxText *thumbnailInspectorMode;
 
     Gtk::CheckButton* ckbmenuGroupRank;
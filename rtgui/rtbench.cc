@@ -0,0 +1,699 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* rtbench: times the hot kernels of rtengine at fixed sizes and thread counts and writes the results as JSON.
+ *
+ * The kernels run on synthetic Bayer, X-Trans, RGB and Lab images of the requested size, and the demosaicers
+ * additionally on the raw files given on the command line. The output only depends on the kernels, the sizes, the
+ * thread counts and the timings, so that the results of several releases or CPU models can be compared. */
+
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <giomm.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <glib/gstdio.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "options.h"
+#include "version.h"
+
+#include "../rtengine/cJSON.h"
+#include "../rtengine/curves.h"
+#include "../rtengine/gauss.h"
+#include "../rtengine/image16.h"
+#include "../rtengine/imagefloat.h"
+#include "../rtengine/improcfun.h"
+#include "../rtengine/labimage.h"
+#include "../rtengine/procparams.h"
+#include "../rtengine/rawimage.h"
+#include "../rtengine/rawimagesource.h"
+#include "../rtengine/utils.h"
+
+Glib::ustring argv0;
+Glib::ustring argv1;
+
+namespace rtengine
+{
+
+// Raw image without file, with a regular colour filter array and an identity camera matrix
+class SyntheticRawImage final :
+    public RawImage
+{
+public:
+    SyntheticRawImage (int w, int h, bool xtrans) :
+        RawImage ("")
+    {
+        static const int xtransPattern[6][6] = {
+            {1, 1, 0, 1, 1, 2},
+            {1, 1, 2, 1, 1, 0},
+            {2, 0, 1, 0, 2, 1},
+            {1, 1, 2, 1, 1, 0},
+            {1, 1, 0, 1, 1, 2},
+            {0, 2, 1, 2, 0, 1}
+        };
+
+        width = w;
+        height = h;
+        colors = 3;
+        filters = xtrans ? 9 : 0x94949494;
+
+        for (int i = 0; i < 6; ++i) {
+            for (int j = 0; j < 6; ++j) {
+                this->xtrans[i][j] = xtransPattern[i][j];
+            }
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                rgb_cam[i][j] = i == j ? 1.f : 0.f;
+            }
+        }
+    }
+};
+
+// Access to the demosaicers of RawImageSource, which are not part of the ImageSource interface
+class RawKernelBench
+{
+public:
+    static RawImageSource* createSynthetic (int w, int h, bool xtrans)
+    {
+        RawImageSource* const src = new RawImageSource;
+        RawImage* const ri = new SyntheticRawImage (w, h, xtrans);
+        src->ri = ri;
+        src->riFrames[0] = ri;
+        src->numFrames = 1;
+        src->W = w;
+        src->H = h;
+        src->initialGain = 1.0;
+        src->rawData (w, h);
+        src->red (w, h);
+        src->green (w, h);
+        src->blue (w, h);
+
+        unsigned int seed = 12345;
+
+        for (int i = 0; i < h; ++i) {
+            for (int j = 0; j < w; ++j) {
+                seed = seed * 1103515245 + 12345;
+                const float noise = static_cast<float> ((seed >> 16) & 0x7fff) / 32768.f;
+                const unsigned int c = xtrans ? ri->XTRANSFC (i, j) : ri->FC (i, j);
+                const float base = 0.25f + 0.2f * (c + 1) * (i + j) / (w + h);
+                const float texture = 0.15f * std::sin (0.05f * j + 0.5f * c) * std::cos (0.03f * i);
+                src->rawData[i][j] = std::max (0.f, 65535.f * (base + texture) * (0.95f + 0.1f * noise));
+            }
+        }
+
+        return src;
+    }
+
+    static RawImageSource* load (const Glib::ustring& fname)
+    {
+        RawImageSource* const src = new RawImageSource;
+
+        if (src->load (fname, true)) {
+            delete src;
+            return nullptr;
+        }
+
+        procparams::ProcParams params;
+        src->preprocess (params.raw, params.lensProf, params.coarse, false);
+        return src;
+    }
+
+    static bool isXtrans (const RawImageSource* src)
+    {
+        return src->ri->getSensorType() == ST_FUJI_XTRANS;
+    }
+
+    static int width (const RawImageSource* src)
+    {
+        return src->W;
+    }
+
+    static int height (const RawImageSource* src)
+    {
+        return src->H;
+    }
+
+    static array2D<float>& rawData (RawImageSource* src)
+    {
+        return src->rawData;
+    }
+
+    static void amaze (RawImageSource* src)
+    {
+        src->amaze_demosaic_RT (0, 0, src->W, src->H, src->rawData, src->red, src->green, src->blue, options.chunkSizeAMAZE, false);
+    }
+
+    static void rcd (RawImageSource* src)
+    {
+        src->rcd_demosaic (options.chunkSizeRCD, false);
+    }
+
+    static void lmmse (RawImageSource* src)
+    {
+        src->lmmse_interpolate_omp (src->W, src->H, src->rawData, src->red, src->green, src->blue, 2);
+    }
+
+    static void xtrans (RawImageSource* src, int passes)
+    {
+        src->xtrans_interpolate (passes, passes > 1, options.chunkSizeXT, false);
+    }
+
+    static void dual (RawImageSource* src)
+    {
+        procparams::RAWParams raw;
+        raw.bayersensor.method = procparams::RAWParams::BayerSensor::getMethodString (procparams::RAWParams::BayerSensor::Method::AMAZEVNG4);
+        raw.xtranssensor.method = procparams::RAWParams::XTransSensor::getMethodString (procparams::RAWParams::XTransSensor::Method::FOUR_PASS);
+        double contrast = isXtrans (src) ? raw.xtranssensor.dualDemosaicContrast : raw.bayersensor.dualDemosaicContrast;
+        src->dual_demosaic_RT (!isXtrans (src), raw, src->W, src->H, src->rawData, src->red, src->green, src->blue, contrast, false);
+    }
+
+    static void caCorrect (RawImageSource* src, array2D<float>& data)
+    {
+        src->CA_correct_RT (true, 2, 0.0, 0.0, true, data, nullptr, false, false, nullptr, true, options.chunkSizeCA, false);
+    }
+};
+
+}
+
+namespace
+{
+
+using namespace rtengine;
+
+struct Benchmark {
+    std::string kernel;
+    std::string variant;
+    std::string input;
+    int width;
+    int height;
+    std::function<void ()> prepare; // untimed, restores the input of in-place kernels
+    std::function<void ()> run;
+};
+
+struct BenchSettings {
+    int width = 6000;
+    int height = 4000;
+    int runs = 3;
+    std::vector<int> threads;
+    std::vector<std::string> kernels;
+    Glib::ustring outputFile;
+    std::vector<Glib::ustring> rawFiles;
+};
+
+bool selected (const BenchSettings& settings, const std::string& kernel)
+{
+    return settings.kernels.empty() || std::find (settings.kernels.begin(), settings.kernels.end(), kernel) != settings.kernels.end();
+}
+
+std::vector<std::string> split (const std::string& list)
+{
+    std::vector<std::string> items;
+    std::string::size_type start = 0;
+
+    while (start <= list.size()) {
+        const std::string::size_type end = std::min (list.find (',', start), list.size());
+
+        if (end > start) {
+            items.push_back (list.substr (start, end - start));
+        }
+
+        start = end + 1;
+    }
+
+    return items;
+}
+
+void fillRGB (Imagefloat* img)
+{
+    const int w = img->getWidth();
+    const int h = img->getHeight();
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+
+    for (int i = 0; i < h; ++i) {
+        for (int j = 0; j < w; ++j) {
+            const float texture = 0.5f + 0.25f * std::sin (0.05f * j) * std::cos (0.03f * i);
+            img->r (i, j) = 65535.f * texture * (0.3f + 0.6f * j / w);
+            img->g (i, j) = 65535.f * texture * 0.5f;
+            img->b (i, j) = 65535.f * texture * (0.3f + 0.6f * i / h);
+        }
+    }
+}
+
+void fillLab (LabImage* lab)
+{
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+
+    for (int i = 0; i < lab->H; ++i) {
+        for (int j = 0; j < lab->W; ++j) {
+            lab->L[i][j] = 32768.f * (0.5f + 0.4f * std::sin (0.05f * j) * std::cos (0.03f * i));
+            lab->a[i][j] = 8000.f * std::sin (0.002f * j);
+            lab->b[i][j] = 8000.f * std::cos (0.002f * i);
+        }
+    }
+}
+
+void addRawBenchmarks (std::vector<Benchmark>& benchmarks, const BenchSettings& settings, RawImageSource* src, const std::string& input)
+{
+    const int w = RawKernelBench::width (src);
+    const int h = RawKernelBench::height (src);
+
+    if (RawKernelBench::isXtrans (src)) {
+        if (selected (settings, "xtrans_interpolate")) {
+            benchmarks.push_back ({"xtrans_interpolate", "1-pass", input, w, h, nullptr, [src]() { RawKernelBench::xtrans (src, 1); }});
+            benchmarks.push_back ({"xtrans_interpolate", "3-pass", input, w, h, nullptr, [src]() { RawKernelBench::xtrans (src, 3); }});
+        }
+
+        if (selected (settings, "dual_demosaic_RT")) {
+            benchmarks.push_back ({"dual_demosaic_RT", "4-pass", input, w, h, nullptr, [src]() { RawKernelBench::dual (src); }});
+        }
+
+        return;
+    }
+
+    if (selected (settings, "amaze_demosaic_RT")) {
+        benchmarks.push_back ({"amaze_demosaic_RT", "", input, w, h, nullptr, [src]() { RawKernelBench::amaze (src); }});
+    }
+
+    if (selected (settings, "rcd_demosaic")) {
+        benchmarks.push_back ({"rcd_demosaic", "", input, w, h, nullptr, [src]() { RawKernelBench::rcd (src); }});
+    }
+
+    if (selected (settings, "lmmse_interpolate_omp")) {
+        benchmarks.push_back ({"lmmse_interpolate_omp", "2 iterations", input, w, h, nullptr, [src]() { RawKernelBench::lmmse (src); }});
+    }
+
+    if (selected (settings, "dual_demosaic_RT")) {
+        benchmarks.push_back ({"dual_demosaic_RT", "AMaZE+VNG4", input, w, h, nullptr, [src]() { RawKernelBench::dual (src); }});
+    }
+
+    if (selected (settings, "CA_correct_RT")) {
+        // the correction is applied in place, each run gets the original raw data
+        const std::shared_ptr<array2D<float>> data = std::make_shared<array2D<float>> (w, h);
+        const array2D<float>& original = RawKernelBench::rawData (src);
+        benchmarks.push_back ({"CA_correct_RT", "auto, 2 iterations", input, w, h,
+            [data, &original, w, h]() {
+                for (int i = 0; i < h; ++i) {
+                    std::copy (original[i], original[i] + w, (*data)[i]);
+                }
+            },
+            [src, data]() { RawKernelBench::caCorrect (src, *data); }
+        });
+    }
+}
+
+// Kernels working on developed images, they share the synthetic RGB and Lab images and the processing parameters
+struct ImageKernels {
+    explicit ImageKernels (int w, int h) :
+        width (w),
+        height (h),
+        rgb (new Imagefloat (w, h)),
+        work (new Imagefloat (w, h)),
+        lab (new LabImage (w, h)),
+        labWork (new LabImage (w, h)),
+        plane (w, h),
+        blurred (w, h),
+        metadata (FramesMetaData::fromFile ("", nullptr, true))
+    {
+        fillRGB (rgb.get());
+        fillLab (lab.get());
+
+        for (int i = 0; i < h; ++i) {
+            for (int j = 0; j < w; ++j) {
+                plane[i][j] = rgb->g (i, j);
+            }
+        }
+
+        params.dirpyrDenoise.enabled = true;
+        params.dirpyrDenoise.luma = 30.0;
+        params.dirpyrDenoise.chroma = 15.0;
+        params.wavelet.enabled = true;
+        params.wavelet.expcontrast = true;
+
+        for (int i = 0; i < 4; ++i) {
+            params.wavelet.c[i] = 30 - 5 * i;
+        }
+
+        params.fattal.enabled = true;
+        params.fattal.threshold = 30;
+        params.fattal.amount = 20;
+        params.rotate.degree = 2.5;
+    }
+
+    void copyRGB ()
+    {
+        for (int i = 0; i < height; ++i) {
+            std::copy (rgb->r (i), rgb->r (i) + width, work->r (i));
+            std::copy (rgb->g (i), rgb->g (i) + width, work->g (i));
+            std::copy (rgb->b (i), rgb->b (i) + width, work->b (i));
+        }
+    }
+
+    void denoise ()
+    {
+        ImProcFunctions ipf (&params, true);
+        int numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip;
+        ipf.Tile_calc (1024, 128, 2, width, height, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
+        std::vector<float> ch_M (std::max (numtiles_W * numtiles_H, 9));
+        std::vector<float> max_r (ch_M.size());
+        std::vector<float> max_b (ch_M.size());
+        NoiseCurve noiseLCurve, noiseCCurve;
+        float nresi, highresi;
+        ipf.RGB_denoise (2, work.get(), work.get(), nullptr, ch_M.data(), max_r.data(), max_b.data(), true, params.dirpyrDenoise, 0.0, noiseLCurve, noiseCCurve, nresi, highresi);
+    }
+
+    void wavelet ()
+    {
+        ImProcFunctions ipf (&params, true);
+        WavCurve wavCLVCurve;
+        WavOpacityCurveRG waOpacityCurveRG;
+        WavOpacityCurveBY waOpacityCurveBY;
+        WavOpacityCurveW waOpacityCurveW;
+        WavOpacityCurveWL waOpacityCurveWL;
+        LUTf wavclCurve (65536, 0);
+        bool wavcontlutili = false;
+        params.wavelet.getCurves (wavCLVCurve, waOpacityCurveRG, waOpacityCurveBY, waOpacityCurveW, waOpacityCurveWL);
+        CurveFactory::curveWavContL (wavcontlutili, params.wavelet.wavclCurve, wavclCurve, 1);
+        ipf.ip_wavelet (labWork.get(), labWork.get(), 2, params.wavelet, wavCLVCurve, waOpacityCurveRG, waOpacityCurveBY, waOpacityCurveW, waOpacityCurveWL, wavclCurve, 1);
+    }
+
+    void lanczos ()
+    {
+        ImProcFunctions ipf (&params, true);
+        LabImage resized (width / 2, height / 2);
+        ipf.Lanczos (lab.get(), &resized, 0.5f);
+    }
+
+    void transform ()
+    {
+        ImProcFunctions ipf (&params, true);
+        ipf.transform (rgb.get(), work.get(), 0, 0, 0, 0, width, height, width, height, metadata.get(), 0, true);
+    }
+
+    void fattal ()
+    {
+        ImProcFunctions ipf (&params, true);
+        ipf.ToneMapFattal02 (work.get());
+    }
+
+    void save (bool jpeg)
+    {
+        const std::unique_ptr<Image16> img (rgb->to16());
+        const Glib::ustring fname = Glib::build_filename (Glib::get_tmp_dir(), jpeg ? "rtbench.jpg" : "rtbench.tif");
+
+        if (jpeg) {
+            img->saveJPEG (fname, 92, 3);
+        } else {
+            img->saveTIFF (fname, 16, false, true);
+        }
+
+        g_remove (fname.c_str());
+    }
+
+    const int width;
+    const int height;
+    const std::unique_ptr<Imagefloat> rgb;
+    const std::unique_ptr<Imagefloat> work;
+    const std::unique_ptr<LabImage> lab;
+    const std::unique_ptr<LabImage> labWork;
+    array2D<float> plane;
+    array2D<float> blurred;
+    const std::unique_ptr<FramesMetaData> metadata;
+    procparams::ProcParams params;
+};
+
+void addImageBenchmarks (std::vector<Benchmark>& benchmarks, const BenchSettings& settings, ImageKernels* k)
+{
+    const std::string input = "synthetic-rgb";
+    const int w = k->width;
+    const int h = k->height;
+
+    if (selected (settings, "RGB_denoise")) {
+        benchmarks.push_back ({"RGB_denoise", "luma 30, chroma 15", input, w, h, [k]() { k->copyRGB(); }, [k]() { k->denoise(); }});
+    }
+
+    if (selected (settings, "ip_wavelet")) {
+        benchmarks.push_back ({"ip_wavelet", "contrast, 4 levels", "synthetic-lab", w, h, [k]() { k->labWork->CopyFrom (k->lab.get()); }, [k]() { k->wavelet(); }});
+    }
+
+    if (selected (settings, "gaussianBlur")) {
+        benchmarks.push_back ({"gaussianBlur", "sigma 10", input, w, h, nullptr, [k]() { gaussianBlur (k->plane, k->blurred, k->width, k->height, 10.0); }});
+    }
+
+    if (selected (settings, "Lanczos")) {
+        benchmarks.push_back ({"Lanczos", "scale 0.5", "synthetic-lab", w, h, nullptr, [k]() { k->lanczos(); }});
+    }
+
+    if (selected (settings, "transformGeneral")) {
+        benchmarks.push_back ({"transformGeneral", "rotate 2.5", input, w, h, nullptr, [k]() { k->transform(); }});
+    }
+
+    if (selected (settings, "ToneMapFattal02")) {
+        benchmarks.push_back ({"ToneMapFattal02", "threshold 30, amount 20", input, w, h, [k]() { k->copyRGB(); }, [k]() { k->fattal(); }});
+    }
+
+    if (selected (settings, "saveJPEG")) {
+        benchmarks.push_back ({"saveJPEG", "quality 92, 4:4:4", input, w, h, nullptr, [k]() { k->save (true); }});
+    }
+
+    if (selected (settings, "saveTIFF")) {
+        benchmarks.push_back ({"saveTIFF", "16 bit, uncompressed", input, w, h, nullptr, [k]() { k->save (false); }});
+    }
+}
+
+void setThreads (int threads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads (threads);
+#endif
+}
+
+cJSON* runBenchmark (const Benchmark& benchmark, int threads, int runs)
+{
+    setThreads (threads);
+    std::vector<double> times;
+
+    for (int i = 0; i < runs; ++i) {
+        if (benchmark.prepare) {
+            benchmark.prepare();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        benchmark.run();
+        times.push_back (std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort (times.begin(), times.end());
+    const double best = times.front();
+    const double median = times[times.size() / 2];
+    const auto rounded = [](double value) {
+        return std::round (value * 1000.0) / 1000.0;
+    };
+
+    cJSON* const result = cJSON_CreateObject();
+    cJSON_AddStringToObject (result, "kernel", benchmark.kernel.c_str());
+    cJSON_AddStringToObject (result, "variant", benchmark.variant.c_str());
+    cJSON_AddStringToObject (result, "input", benchmark.input.c_str());
+    cJSON_AddNumberToObject (result, "width", benchmark.width);
+    cJSON_AddNumberToObject (result, "height", benchmark.height);
+    cJSON_AddNumberToObject (result, "threads", threads);
+    cJSON_AddNumberToObject (result, "best_ms", rounded (best));
+    cJSON_AddNumberToObject (result, "median_ms", rounded (median));
+    cJSON_AddNumberToObject (result, "mpix_per_s", rounded (best > 0.0 ? static_cast<double> (benchmark.width) * benchmark.height / (best * 1000.0) : 0.0));
+
+    std::cerr << benchmark.kernel << (benchmark.variant.empty() ? "" : " (" + benchmark.variant + ")") << ", " << benchmark.input
+              << ", " << threads << " threads: " << rounded (best) << " ms" << std::endl;
+
+    return result;
+}
+
+void printHelp (const char* name)
+{
+    std::cout << "Usage: " << Glib::path_get_basename (name) << " [-s <width>x<height>] [-t <threads,...>] [-r <runs>] [-k <kernel,...>] [-o <file>] [raw files...]" << std::endl;
+    std::cout << "  -s <W>x<H>       Size of the synthetic images (default: 6000x4000)." << std::endl;
+    std::cout << "  -t <n,...>       Thread counts to measure, 0 meaning all the available threads (default: 1,0)." << std::endl;
+    std::cout << "  -r <runs>        Number of timed runs per kernel and thread count (default: 3)." << std::endl;
+    std::cout << "  -k <kernel,...>  Only run the given kernels, e.g. amaze_demosaic_RT,RGB_denoise." << std::endl;
+    std::cout << "  -o <file>        Write the JSON results to the given file instead of stdout." << std::endl;
+    std::cout << "The demosaicers and CA_correct_RT also run on the raw files given on the command line." << std::endl;
+}
+
+bool parseArguments (int argc, char** argv, BenchSettings& settings)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "-s" && hasValue) {
+            if (sscanf (argv[++i], "%dx%d", &settings.width, &settings.height) != 2 || settings.width < 64 || settings.height < 64) {
+                std::cerr << "Error: invalid size \"" << argv[i] << "\"." << std::endl;
+                return false;
+            }
+        } else if (arg == "-t" && hasValue) {
+            settings.threads.clear();
+
+            for (const auto& item : split (argv[++i])) {
+                settings.threads.push_back (std::max (0, atoi (item.c_str())));
+            }
+        } else if (arg == "-r" && hasValue) {
+            settings.runs = std::max (1, atoi (argv[++i]));
+        } else if (arg == "-k" && hasValue) {
+            settings.kernels = split (argv[++i]);
+        } else if (arg == "-o" && hasValue) {
+            settings.outputFile = Glib::filename_to_utf8 (argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            printHelp (argv[0]);
+            exit (0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Error: unknown option \"" << arg << "\"." << std::endl;
+            printHelp (argv[0]);
+            return false;
+        } else {
+            settings.rawFiles.push_back (Glib::filename_to_utf8 (arg));
+        }
+    }
+
+    if (settings.threads.empty()) {
+        settings.threads = {1, 0};
+    }
+
+    return true;
+}
+
+}
+
+int main (int argc, char** argv)
+{
+    setlocale (LC_ALL, "");
+    setlocale (LC_NUMERIC, "C"); // to set decimal point to "."
+
+    Gio::init ();
+
+    if (Glib::path_is_absolute (DATA_SEARCH_PATH)) {
+        argv0 = DATA_SEARCH_PATH;
+    } else {
+        argv0 = Glib::build_filename (Glib::path_get_dirname (argv[0]), DATA_SEARCH_PATH);
+    }
+
+    options.rtSettings.lensfunDbDirectory = LENSFUN_DB_PATH;
+
+    BenchSettings settings;
+
+    if (!parseArguments (argc, argv, settings)) {
+        return -3;
+    }
+
+    try {
+        Options::load (true);
+    } catch (Options::Error &e) {
+        std::cerr << "FATAL ERROR:" << std::endl << e.get_msg() << std::endl;
+        return -2;
+    }
+
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+#else
+    const int maxThreads = 1;
+#endif
+
+    for (auto& threads : settings.threads) {
+        threads = threads == 0 ? maxThreads : std::min (threads, maxThreads);
+    }
+
+    settings.threads.erase (std::unique (settings.threads.begin(), settings.threads.end()), settings.threads.end());
+
+    std::vector<Benchmark> benchmarks;
+    std::vector<std::unique_ptr<RawImageSource>> sources;
+
+    sources.emplace_back (RawKernelBench::createSynthetic (settings.width, settings.height, false));
+    addRawBenchmarks (benchmarks, settings, sources.back().get(), "synthetic-bayer");
+    sources.emplace_back (RawKernelBench::createSynthetic (settings.width, settings.height, true));
+    addRawBenchmarks (benchmarks, settings, sources.back().get(), "synthetic-xtrans");
+
+    for (const auto& fname : settings.rawFiles) {
+        RawImageSource* const src = RawKernelBench::load (fname);
+
+        if (!src) {
+            std::cerr << "Error: \"" << fname << "\" can't be loaded as a raw file." << std::endl;
+            continue;
+        }
+
+        sources.emplace_back (src);
+        addRawBenchmarks (benchmarks, settings, src, Glib::path_get_basename (fname));
+    }
+
+    const std::unique_ptr<ImageKernels> imageKernels (new ImageKernels (settings.width, settings.height));
+    addImageBenchmarks (benchmarks, settings, imageKernels.get());
+
+    cJSON* const root = cJSON_CreateObject();
+    cJSON_AddNumberToObject (root, "schema", 1);
+    cJSON_AddStringToObject (root, "version", RTVERSION);
+    cJSON_AddStringToObject (root, "cpu", getCPUModel().c_str());
+    cJSON_AddNumberToObject (root, "max_threads", maxThreads);
+    cJSON_AddNumberToObject (root, "runs", settings.runs);
+    cJSON* const results = cJSON_AddArrayToObject (root, "results");
+
+    for (const auto& benchmark : benchmarks) {
+        for (const int threads : settings.threads) {
+            cJSON_AddItemToArray (results, runBenchmark (benchmark, threads, settings.runs));
+        }
+    }
+
+    setThreads (maxThreads);
+
+    char* const text = cJSON_Print (root);
+    int ret = 0;
+
+    if (settings.outputFile.empty()) {
+        std::cout << text << std::endl;
+    } else {
+        FILE* const f = g_fopen (settings.outputFile.c_str(), "w");
+
+        if (f) {
+            fprintf (f, "%s\n", text);
+            fclose (f);
+        } else {
+            std::cerr << "Error: \"" << settings.outputFile << "\" can't be written." << std::endl;
+            ret = -1;
+        }
+    }
+
+    cJSON_free (text);
+    cJSON_Delete (root);
+    return ret;
+}